@@ -0,0 +1,169 @@
+#include "BlackboxBurstCapture.h"
+
+#include <cmath>
+#include <cstdio>
+
+
+BlackboxBurstCapture::BlackboxBurstCapture(uint32_t sampleRateHz, size_t motorCount) :
+    BlackboxBurstCapture(sampleRateHz, motorCount, DEFAULT_CONFIG)
+{
+}
+
+BlackboxBurstCapture::BlackboxBurstCapture(uint32_t sampleRateHz, size_t motorCount, const config_t& config) :
+    _config(config),
+    _sampleRateHz(sampleRateHz),
+    _motorCount(motorCount < MAX_MOTOR_COUNT ? motorCount : static_cast<size_t>(MAX_MOTOR_COUNT)),
+    _sampleWordCount(0),
+    _capacity(0)
+{
+    setConfig(config);
+}
+
+/*!
+Must not be called while capturing, since it changes the layout of the samples.
+*/
+void BlackboxBurstCapture::setConfig(const config_t& config)
+{
+    _config = config;
+    if (_config.preTriggerPercent > 100) {
+        _config.preTriggerPercent = 100;
+    }
+    _sampleWordCount = 3 + (_config.captureAcc ? 3 : 0) + (_config.captureMotorFrequencies ? _motorCount : 0);
+    _capacity = WORD_COUNT / _sampleWordCount;
+    _postTriggerSampleCount = _capacity * (100 - _config.preTriggerPercent) / 100;
+    // the baseline throttle rises at a rate such that it recovers by throttlePunchThreshold in throttlePunchSeconds
+    _throttleBaselineRecoveryPerSample = _config.throttlePunchThreshold / (_config.throttlePunchSeconds * static_cast<float>(_sampleRateHz));
+    restart();
+}
+
+void BlackboxBurstCapture::restart()
+{
+    _head = 0;
+    _sampleCount = 0;
+    _samplesRemaining = 0;
+    _triggerIndex = 0;
+    _throttleBaseline = 1.0F;
+    _triggerRequested.store(false, std::memory_order_relaxed);
+    _state.store(STATE_CAPTURING, std::memory_order_release);
+}
+
+void BlackboxBurstCapture::trigger()
+{
+    _triggerRequested.store(true, std::memory_order_relaxed);
+}
+
+static inline int16_t quantize(float value)
+{
+    return static_cast<int16_t>(std::lroundf(value < -32767.0F ? -32767.0F : value > 32767.0F ? 32767.0F : value));
+}
+
+/*!
+Called from within the AHRS task (ie the main IMU/PID loop) at the IMU sample rate, and so needs to be FAST.
+*/
+void BlackboxBurstCapture::capture(const xyz_t& gyroRPS_unfiltered, const xyz_t& acc, const motor_frequencies_t& motorFrequenciesHz, float throttle)
+{
+    const state_e state = _state.load(std::memory_order_relaxed);
+    if (state != STATE_CAPTURING && state != STATE_TRIGGERED) {
+        // capture is complete and waiting to be written
+        return;
+    }
+
+    constexpr float radiansToDegrees {180.0F / static_cast<float>(M_PI)};
+    constexpr float gyroScale {radiansToDegrees * 10.0F};
+
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-constant-array-index,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    int16_t* sample = &_words[_head * _sampleWordCount];
+    *sample++ = quantize(gyroRPS_unfiltered.x * gyroScale);
+    *sample++ = quantize(gyroRPS_unfiltered.y * gyroScale);
+    *sample++ = quantize(gyroRPS_unfiltered.z * gyroScale);
+    if (_config.captureAcc) {
+        *sample++ = quantize(acc.x * 4096.0F);
+        *sample++ = quantize(acc.y * 4096.0F);
+        *sample++ = quantize(acc.z * 4096.0F);
+    }
+    if (_config.captureMotorFrequencies) {
+        for (size_t ii = 0; ii < _motorCount; ++ii) {
+            *sample++ = quantize(motorFrequenciesHz[ii] * 10.0F);
+        }
+    }
+    // NOLINTEND(cppcoreguidelines-pro-bounds-constant-array-index,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    const size_t position = _head;
+    _head = (_head + 1 == _capacity) ? 0 : _head + 1;
+    if (_sampleCount < _capacity) {
+        ++_sampleCount;
+    }
+
+    if (state == STATE_CAPTURING) {
+        _throttleBaseline = throttle < _throttleBaseline + _throttleBaselineRecoveryPerSample ? throttle : _throttleBaseline + _throttleBaselineRecoveryPerSample;
+        const bool throttlePunch = _config.throttlePunchTriggerEnabled && (throttle - _throttleBaseline > _config.throttlePunchThreshold);
+        if (!throttlePunch && !_triggerRequested.load(std::memory_order_relaxed)) {
+            return;
+        }
+        _triggerIndex = position;
+        _samplesRemaining = _postTriggerSampleCount;
+        _state.store(STATE_TRIGGERED, std::memory_order_relaxed);
+    }
+    if (_samplesRemaining == 0 || --_samplesRemaining == 0) {
+        // convert the position of the trigger sample in the ring into an index from the oldest sample
+        const size_t oldest = (_head + _capacity - _sampleCount) % _capacity;
+        _triggerIndex = (_triggerIndex + _capacity - oldest) % _capacity;
+        _state.store(STATE_COMPLETE, std::memory_order_release);
+    }
+}
+
+bool BlackboxBurstCapture::beginWrite()
+{
+    state_e expected = STATE_COMPLETE;
+    return _state.compare_exchange_strong(expected, STATE_WRITING, std::memory_order_acq_rel);
+}
+
+const int16_t* BlackboxBurstCapture::getSample(size_t index) const
+{
+    const size_t oldest = (_head + _capacity - _sampleCount) % _capacity;
+    return &_words[((oldest + index) % _capacity) * _sampleWordCount]; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+}
+
+/*!
+Line 0 is a comment giving the sample rate, the trigger index, and the units. Line 1 gives the column names.
+The remaining lines are the samples, oldest first.
+*/
+size_t BlackboxBurstCapture::formatCSV_Line(char* buf, size_t bufSize, size_t lineIndex) const
+{
+    // NOLINTBEGIN(cppcoreguidelines-pro-type-vararg,hicpp-vararg,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    int length = 0;
+    auto append = [&](const char* format, auto value) {
+        if (length >= 0 && static_cast<size_t>(length) < bufSize) {
+            const int count = snprintf(buf + length, bufSize - static_cast<size_t>(length), format, value);
+            length = count < 0 ? count : length + count;
+        }
+    };
+    if (lineIndex == 0) {
+        append("# burst capture, sample_rate_hz=%u", static_cast<unsigned int>(_sampleRateHz));
+        append(", trigger_index=%u", static_cast<unsigned int>(_triggerIndex));
+        append("%s", ", units: gyro deci-degrees/s, acc 1/4096 g, motor deci-Hz\n");
+    } else if (lineIndex == 1) {
+        append("%s", "sample,gyroX,gyroY,gyroZ");
+        if (_config.captureAcc) {
+            append("%s", ",accX,accY,accZ");
+        }
+        if (_config.captureMotorFrequencies) {
+            for (size_t ii = 0; ii < _motorCount; ++ii) {
+                append(",motorHz%u", static_cast<unsigned int>(ii));
+            }
+        }
+        append("%s", "\n");
+    } else if (lineIndex < getCSV_LineCount()) {
+        const size_t sampleIndex = lineIndex - CSV_HEADER_LINE_COUNT;
+        const int16_t* sample = getSample(sampleIndex);
+        append("%u", static_cast<unsigned int>(sampleIndex));
+        for (size_t ii = 0; ii < _sampleWordCount; ++ii) {
+            append(",%d", static_cast<int>(sample[ii]));
+        }
+        append("%s", "\n");
+    }
+    // NOLINTEND(cppcoreguidelines-pro-type-vararg,hicpp-vararg,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    if (length < 0) {
+        return 0;
+    }
+    return static_cast<size_t>(length) < bufSize ? static_cast<size_t>(length) : bufSize - 1;
+}
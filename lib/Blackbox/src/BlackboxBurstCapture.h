@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <xyz_type.h>
+
+#if !defined(BLACKBOX_BURST_CAPTURE_SIZE)
+// size in bytes of the RAM used to hold the capture, 64kB holds about 10 seconds of gyro only data at 1kHz, but only 1.4 seconds at 8kHz
+// 8kHz targets should set this (in build_flags) to at least 96kB, for a 2 second window
+#define BLACKBOX_BURST_CAPTURE_SIZE 65536
+#endif
+
+
+/*!
+High rate capture of unfiltered gyro (and optionally accelerometer and motor frequency) for filter design.
+
+Normal blackbox logging cannot sustain the full IMU sample rate, but filter design needs full bandwidth spectra.
+So the samples are stored, at the full sample rate, in a RAM ring buffer. When a trigger occurs (by default a throttle punch)
+capturing continues for the post-trigger part of the window and then stops, so the buffer holds a window of samples around the trigger.
+After landing the capture is written out as CSV, by BlackboxBurstCaptureWriter, and capture restarts.
+
+capture() is called from the AHRS task at the IMU sample rate, so it does no floating point division and no system calls.
+Samples are quantized to int16_t: gyro in deci-degrees per second, acc in units of 1/4096 g, and motor frequency in deci-Hz.
+*/
+class BlackboxBurstCapture {
+public:
+#if defined(USE_EIGHT_MOTORS)
+    enum { MAX_MOTOR_COUNT = 8 };
+#else
+    enum { MAX_MOTOR_COUNT = 4 };
+#endif
+    enum { WORD_COUNT = BLACKBOX_BURST_CAPTURE_SIZE / sizeof(int16_t) };
+    enum { CSV_HEADER_LINE_COUNT = 2, CSV_MAX_LINE_LENGTH = 128 };
+    enum state_e { STATE_CAPTURING, STATE_TRIGGERED, STATE_COMPLETE, STATE_WRITING };
+    struct config_t {
+        uint8_t preTriggerPercent; //!< percentage of the window that is before the trigger
+        uint8_t captureAcc;
+        uint8_t captureMotorFrequencies;
+        uint8_t throttlePunchTriggerEnabled;
+        float throttlePunchThreshold; //!< throttle rise, in the range [0, 1], that triggers the capture
+        float throttlePunchSeconds; //!< the throttle must rise by throttlePunchThreshold within this time to trigger the capture
+    };
+    static constexpr config_t DEFAULT_CONFIG {
+        .preTriggerPercent = 25,
+        .captureAcc = false,
+        .captureMotorFrequencies = false,
+        .throttlePunchTriggerEnabled = true,
+        .throttlePunchThreshold = 0.4F,
+        .throttlePunchSeconds = 0.2F
+    };
+    typedef std::array<float, MAX_MOTOR_COUNT> motor_frequencies_t;
+public:
+    BlackboxBurstCapture(uint32_t sampleRateHz, size_t motorCount);
+    BlackboxBurstCapture(uint32_t sampleRateHz, size_t motorCount, const config_t& config);
+public:
+    void setConfig(const config_t& config);
+    const config_t& getConfig() const { return _config; }
+    uint32_t getSampleRateHz() const { return _sampleRateHz; }
+    size_t getMotorCount() const { return _motorCount; }
+    size_t getSampleWordCount() const { return _sampleWordCount; } //!< number of int16_t values in each sample
+    size_t getCapacity() const { return _capacity; } //!< maximum number of samples in the window
+
+    //! called from the AHRS task for every IMU sample
+    void capture(const xyz_t& gyroRPS_unfiltered, const xyz_t& acc, const motor_frequencies_t& motorFrequenciesHz, float throttle);
+    //! triggers the capture (eg from a switch), does nothing if the capture has already been triggered
+    void trigger();
+
+    state_e getState() const { return _state.load(std::memory_order_acquire); }
+    bool isComplete() const { return getState() == STATE_COMPLETE; }
+
+    // functions used by the writer, valid only when the capture is complete
+
+    //! marks the capture as being written, returns false if the capture is not complete
+    bool beginWrite();
+    //! number of samples in the completed capture
+    size_t getSampleCount() const { return _sampleCount; }
+    //! index, within the completed capture, of the sample at which the trigger occurred
+    size_t getTriggerIndex() const { return _triggerIndex; }
+    //! returns a pointer to the values of sample index, where index 0 is the oldest sample in the window
+    const int16_t* getSample(size_t index) const;
+    //! number of lines in the CSV representation of the completed capture, including the header lines
+    size_t getCSV_LineCount() const { return CSV_HEADER_LINE_COUNT + _sampleCount; }
+    //! formats a line of the CSV representation of the completed capture into buf, returns the length of the line
+    size_t formatCSV_Line(char* buf, size_t bufSize, size_t lineIndex) const;
+    //! discards the capture and restarts capturing
+    void restart();
+private:
+    config_t _config;
+    uint32_t _sampleRateHz;
+    size_t _motorCount;
+    size_t _sampleWordCount;
+    size_t _capacity;
+    size_t _postTriggerSampleCount {0};
+    float _throttleBaselineRecoveryPerSample {0.0F};
+    float _throttleBaseline {0.0F};
+    std::atomic<state_e> _state {STATE_CAPTURING};
+    std::atomic<bool> _triggerRequested {false};
+    size_t _head {0}; //!< index of the next sample to be written
+    size_t _sampleCount {0};
+    size_t _samplesRemaining {0}; //!< number of samples still to be captured after the trigger
+    size_t _triggerIndex {0};
+    std::array<int16_t, WORD_COUNT> _words {};
+};
@@ -0,0 +1,59 @@
+#include "BlackboxBurstCaptureWriter.h"
+
+#include <BlackboxSerialDevice.h>
+#include <FlightController.h>
+
+
+bool BlackboxBurstCaptureWriter::update(uint32_t timeMicroSeconds, bool deviceFree)
+{
+    const bool motorsOn = _flightController.motorsIsOn();
+    if (motorsOn || _motorsWereOn) {
+        _motorsOffTimeMicroSeconds = timeMicroSeconds;
+    }
+    _motorsWereOn = motorsOn;
+
+    switch (_state) {
+    case STATE_IDLE:
+        if (motorsOn || !deviceFree || timeMicroSeconds - _motorsOffTimeMicroSeconds < SETTLE_TIME_MICROSECONDS || !_burstCapture.beginWrite()) {
+            return false;
+        }
+        _state = STATE_BEGIN_LOG;
+        [[fallthrough]];
+    case STATE_BEGIN_LOG:
+        if (!_serialDevice.beginLog()) {
+            return true;
+        }
+        _lineIndex = 0;
+        _lineLength = 0;
+        _state = STATE_WRITING;
+        [[fallthrough]];
+    case STATE_WRITING:
+        for (size_t ii = 0; ii < MAX_LINES_PER_UPDATE && !motorsOn && _lineIndex < _burstCapture.getCSV_LineCount(); ++ii) {
+            if (_lineLength == 0) {
+                _lineLength = _burstCapture.formatCSV_Line(&_line[0], _line.size(), _lineIndex);
+            }
+            if (_serialDevice.reserveBufferSpace(_lineLength) != BlackboxSerialDevice::BLACKBOX_RESERVE_SUCCESS) {
+                // try again on the next update
+                _serialDevice.flush();
+                return true;
+            }
+            _serialDevice.write(reinterpret_cast<const uint8_t*>(&_line[0]), _lineLength); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+            _lineLength = 0;
+            ++_lineIndex;
+        }
+        _serialDevice.flush();
+        if (!motorsOn && _lineIndex < _burstCapture.getCSV_LineCount()) {
+            return true;
+        }
+        _state = STATE_END_LOG;
+        [[fallthrough]];
+    case STATE_END_LOG:
+        if (!_serialDevice.endLog(true)) {
+            return true;
+        }
+        _burstCapture.restart();
+        _state = STATE_IDLE;
+        return false;
+    }
+    return false;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "BlackboxBurstCapture.h"
+
+#include <array>
+
+class BlackboxSerialDevice;
+class FlightController;
+
+
+/*!
+Writes a completed BlackboxBurstCapture to the blackbox serial device, as a separate CSV log.
+
+update() is called from the Blackbox task (by BlackboxProtoFlight::update()), so the writer and the normal blackbox log
+never use the serial device at the same time. Writing starts only when the device is free (no log is being written) and the motors
+have been off for SETTLE_TIME_MICROSECONDS. If the motors are switched on while writing, the write is cut short so the device is free
+for the normal blackbox log. update() writes a limited number of lines on each call and never waits for the device.
+*/
+class BlackboxBurstCaptureWriter {
+public:
+    enum { SETTLE_TIME_MICROSECONDS = 2000000, MAX_LINES_PER_UPDATE = 32 };
+    enum state_e { STATE_IDLE, STATE_BEGIN_LOG, STATE_WRITING, STATE_END_LOG };
+public:
+    BlackboxBurstCaptureWriter(BlackboxBurstCapture& burstCapture, BlackboxSerialDevice& serialDevice, const FlightController& flightController) :
+        _burstCapture(burstCapture),
+        _serialDevice(serialDevice),
+        _flightController(flightController)
+        {}
+public:
+    //! called periodically, returns true while the capture is being written, during which time the caller must not use the device
+    bool update(uint32_t timeMicroSeconds, bool deviceFree);
+    state_e getState() const { return _state; }
+    bool isWriting() const { return _state != STATE_IDLE; }
+private:
+    BlackboxBurstCapture& _burstCapture;
+    BlackboxSerialDevice& _serialDevice;
+    const FlightController& _flightController;
+    state_e _state {STATE_IDLE};
+    uint32_t _motorsOffTimeMicroSeconds {0};
+    bool _motorsWereOn {false};
+    size_t _lineIndex {0};
+    size_t _lineLength {0}; //!< length of the formatted line waiting to be written
+    std::array<char, BlackboxBurstCapture::CSV_MAX_LINE_LENGTH> _line {};
+};
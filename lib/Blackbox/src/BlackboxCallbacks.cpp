@@ -1,12 +1,20 @@
 #include "BlackboxCallbacks.h"
+#include "BlackboxEventQueue.h"
 #include "BlackboxMessageQueue.h"
+#include "BlackboxMessageQueueAHRS.h"
+#include "BlackboxProtoFlight.h"
+#include "BlackboxRateController.h"
+#include "BlackboxSerialDeviceBuffered.h"
+#include "BlackboxSerialDeviceFlash.h"
+#include "BlackboxSerialDeviceStream.h"
 
 #include <AHRS.h>
 #include <Debug.h>
 #include <FlightController.h>
 #include <RadioController.h>
 #include <ReceiverBase.h>
-#include <cmath>
+#include <algorithm>
+#include <iterator>
 
 
 bool BlackboxCallbacks::isArmed() const
@@ -53,83 +61,110 @@ void BlackboxCallbacks::loadSlowState(blackboxSlowState_t& slowState)
     slowState.rxFlightChannelsValid = (slowState.failsafePhase == RadioController::FAILSAFE_IDLE);
 }
 
-void BlackboxCallbacks::loadMainState(blackboxMainState_t& mainState, uint32_t currentTimeUs)
+/*!
+Sets the decimation used by the AHRS task, so the log rate adapts to what the log device can sustain.
+The rate controller is fed the message queue fill level and the backpressure from whichever log device is set.
+*/
+void BlackboxCallbacks::updateDecimation(uint32_t timeMicroSeconds, uint32_t droppedCount)
 {
+    if (!_rateController) {
+        return;
+    }
+    BlackboxRateController::input_t input {
+        .queueFillPercent = _messageQueue.getFillPercent(),
+        .deviceFillPercent = 0,
+        .writeLatencyMicroSeconds = 0,
+        .droppedCount = droppedCount
+    };
+    uint32_t deviceDroppedByteCount = 0;
+    if (_bufferedDevice) {
+        const BlackboxSerialDeviceBuffered::double_buffer_t::stats_t stats = _bufferedDevice->getStats();
+        input.deviceFillPercent = _bufferedDevice->getFillPercent();
+        input.writeLatencyMicroSeconds = stats.lastLatencyMicroSeconds;
+        deviceDroppedByteCount = stats.droppedByteCount;
+    } else if (_streamDevice) {
+        input.deviceFillPercent = _streamDevice->getFillPercent();
+        deviceDroppedByteCount = _streamDevice->getStats().droppedByteCount;
+    } else if (_flashDevice) {
+        input.deviceFillPercent = _flashDevice->getFillPercent();
+        deviceDroppedByteCount = _flashDevice->getDroppedByteCount();
+    }
+    if (deviceDroppedByteCount >= _deviceDroppedByteCount) { // the count is reset when a log is started
+        input.droppedCount += deviceDroppedByteCount - _deviceDroppedByteCount;
+    }
+    _deviceDroppedByteCount = deviceDroppedByteCount;
+
+    _rateController->update(timeMicroSeconds, input);
+    const uint32_t decimation = _rateController->getDecimation();
+    if (decimation != _messageQueue.getDecimation()) {
+        _messageQueue.setDecimation(decimation);
+        if (_blackbox) {
+            _blackbox->logDecimationChange(decimation);
+        }
+    }
+}
 
-    xyz_t gyroRPS;
-    xyz_t gyroRPS_unfiltered;
-    xyz_t acc;
+/*!
+Copy the main state snapshot into the blackbox main state.
+
+The snapshot is captured and quantized in the AHRS task, so this just copies integer values.
+*/
+void BlackboxCallbacks::loadMainState(blackboxMainState_t& mainState, uint32_t currentTimeUs)
+{
+    BlackboxMessageQueue::queue_item_t queueItem; // NOLINT(cppcoreguidelines-pro-type-member-init)
     if (_useMessageQueue) {
         (void)currentTimeUs;
-        BlackboxMessageQueue::queue_item_t queueItem;
-        _messageQueue.RECEIVE(queueItem);
-        mainState.time = queueItem.timeMicroSeconds;
-        gyroRPS = queueItem.gyroRPS;
-        gyroRPS_unfiltered = queueItem.gyroRPS_unfiltered;
-        acc = queueItem.acc;
+        uint32_t droppedCount {};
+        _messageQueue.RECEIVE(queueItem, droppedCount);
+        if (droppedCount != 0 && _blackbox) {
+            _blackbox->logQueueOverflow(droppedCount, _messageQueue.getOverflowCount());
+        }
+        updateDecimation(queueItem.timeMicroSeconds, droppedCount);
     } else {
-        mainState.time = currentTimeUs;
         const AHRS::data_t ahrsData = _ahrs.getAhrsDataForInstrumentationUsingLock();
-        gyroRPS = ahrsData.gyroRPS;
-        gyroRPS_unfiltered = ahrsData.gyroRPS_unfiltered;
-        acc = ahrsData.acc;
+        BlackboxMessageQueueAHRS::captureState(queueItem, currentTimeUs, ahrsData.gyroRPS, ahrsData.gyroRPS_unfiltered, ahrsData.acc, _flightController, _receiver, _debug, _messageQueue.getFieldScale());
+    }
+    if (_eventQueue && _blackbox) {
+        BlackboxEventQueue::event_t event {};
+        while (_eventQueue->pop(event)) {
+            _blackbox->logTimedEvent(event.type, event.value, event.timeMicroSeconds);
+        }
     }
 
-// NOLINTBEGIN(cppcoreguidelines-pro-bounds-constant-array-index)
+    mainState.time = queueItem.timeMicroSeconds;
 
-    constexpr float radiansToDegrees {180.0F / static_cast<float>(M_PI)};
-    constexpr float gyroScale {radiansToDegrees * 10.0F};
-
-    mainState.gyroADC[0] = static_cast<int16_t>(std::lroundf(gyroRPS.x * gyroScale));
-    mainState.gyroADC[1] = static_cast<int16_t>(std::lroundf(gyroRPS.y * gyroScale));
-    mainState.gyroADC[2] = static_cast<int16_t>(std::lroundf(gyroRPS.z * gyroScale));
-    mainState.gyroUnfiltered[0] = static_cast<int16_t>(std::lroundf(gyroRPS_unfiltered.x * gyroScale));
-    mainState.gyroUnfiltered[1] = static_cast<int16_t>(std::lroundf(gyroRPS_unfiltered.y * gyroScale));
-    mainState.gyroUnfiltered[2] = static_cast<int16_t>(std::lroundf(gyroRPS_unfiltered.z * gyroScale));
-    // just truncate for gyro
-    mainState.accADC[0] = static_cast<int16_t>(acc.x * 4096);
-    mainState.accADC[1] = static_cast<int16_t>(acc.y * 4096);
-    mainState.accADC[2] = static_cast<int16_t>(acc.z * 4096);
-
-    // iterate through roll, pitch, and yaw PIDs
-    for (int ii = 0; ii < blackboxMainState_t::XYZ_AXIS_COUNT; ++ii) {
-        const auto pidIndex = static_cast<FlightController::pid_index_e>(ii);
-        const PIDF& pid = _flightController.getPID(pidIndex);
-        const PIDF::error_t pidError = pid.getError();
-        mainState.axisPID_P[ii] = std::lroundf(pidError.P);
-        mainState.axisPID_I[ii] = std::lroundf(pidError.I);
-        mainState.axisPID_D[ii] = std::lroundf(pidError.D);
-        mainState.axisPID_F[ii] = std::lroundf(pidError.F);
-        //mainState.axisPID_S[ii] = std::lroundf(pidError.S);
-        mainState.setpoint[ii] = static_cast<int16_t>(std::lroundf(pid.getSetpoint()));
+// NOLINTBEGIN(cppcoreguidelines-pro-bounds-constant-array-index)
+    for (size_t ii = 0; ii < blackboxMainState_t::XYZ_AXIS_COUNT; ++ii) {
+        mainState.gyroADC[ii] = queueItem.gyroADC[ii];
+        mainState.gyroUnfiltered[ii] = queueItem.gyroUnfiltered[ii];
+        mainState.accADC[ii] = queueItem.accADC[ii];
+        mainState.axisPID_P[ii] = queueItem.axisPID_P[ii];
+        mainState.axisPID_I[ii] = queueItem.axisPID_I[ii];
+        mainState.axisPID_D[ii] = queueItem.axisPID_D[ii];
+        mainState.axisPID_F[ii] = queueItem.axisPID_F[ii];
 #if defined(USE_MAG)
         mainState.magADC[ii] = static_cast<int16_t>(mag.magADC.v[ii]);
 #endif
     }
-    // log the final throttle value used in the mixer
-    mainState.setpoint[3] = static_cast<int16_t>(std::lroundf(_flightController.getMixer().getThrottleCommand() * 1000.0F));
-
-    // interval [1000,2000] for THROTTLE and [-500,+500] for ROLL/PITCH/YAW
-    const ReceiverBase::controls_pwm_t controls = _receiver.getControlsPWM(); // returns controls in range [1000, 2000]
-    mainState.rcCommand[0] = static_cast<int16_t>(controls.roll - ReceiverBase::CHANNEL_MIDDLE);
-    mainState.rcCommand[1] = static_cast<int16_t>(controls.pitch - ReceiverBase::CHANNEL_MIDDLE);
-    mainState.rcCommand[2] = static_cast<int16_t>(controls.yaw - ReceiverBase::CHANNEL_MIDDLE);
-    mainState.rcCommand[3] = controls.throttle;
-
-    static_assert(static_cast<int>(blackboxMainState_t::DEBUG_VALUE_COUNT) == static_cast<int>(Debug::VALUE_COUNT));
-    for (int ii = 0; ii < blackboxMainState_t::DEBUG_VALUE_COUNT; ++ii) {
-        mainState.debug[ii] = _debug.get(ii);
+    for (size_t ii = 0; ii < std::size(queueItem.setpoint); ++ii) {
+        mainState.setpoint[ii] = queueItem.setpoint[ii];
+        mainState.rcCommand[ii] = queueItem.rcCommand[ii];
     }
 
-    const MotorMixerBase& mixer = _flightController.getMixer();
-    for (size_t ii = 0; ii < mixer.getMotorCount(); ++ ii) {
-        mainState.motor[ii] = static_cast<int16_t>(std::lroundf(mixer.getMotorOutput(ii)));
+    static_assert(static_cast<int>(blackboxMainState_t::DEBUG_VALUE_COUNT) == static_cast<int>(BlackboxMessageQueue::DEBUG_VALUE_COUNT));
+    for (size_t ii = 0; ii < blackboxMainState_t::DEBUG_VALUE_COUNT; ++ii) {
+        mainState.debug[ii] = queueItem.debug[ii];
+    }
+
+    const size_t motorCount = std::min(queueItem.motor.size(), std::size(mainState.motor));
+    for (size_t ii = 0; ii < motorCount; ++ ii) {
+        mainState.motor[ii] = queueItem.motor[ii];
 #if defined(USE_DSHOT_TELEMETRY)
-        mainState.erpm[ii] = static_cast<int16_t>(mixer.getMotorRPM(ii));
+        mainState.erpm[ii] = queueItem.erpm[ii];
 #endif
     }
-    mainState.vbatLatest = static_cast<uint16_t>(_flightController.getBatteryVoltage()*10.0F);
-    mainState.amperageLatest = static_cast<uint16_t>(_flightController.getAmperage()*10.0F);
+    mainState.vbatLatest = queueItem.vbatLatest;
+    mainState.amperageLatest = queueItem.amperageLatest;
 
 #if defined(USE_BARO)
     mainState.baroAlt = baro.altitude;
@@ -143,13 +178,10 @@ void BlackboxCallbacks::loadMainState(blackboxMainState_t& mainState, uint32_t c
     mainState.rssi = 0;//getRssi();
 
 #if defined(USE_SERVOS)
-    mainState.servo[0] = 1527;
-    mainState.servo[1] = 1473;
-    mainState.servo[2] = 1620;
-    mainState.servo[4] = 1750;
-    //for (size_t ii = 0; ii < blackboxMainState_t::MAX_SUPPORTED_SERVO_COUNT; ++ii) {
-    //    mainState.servo[ii] = 1527;
-    //}
+    const size_t servoCount = std::min(queueItem.servo.size(), std::size(mainState.servo));
+    for (size_t ii = 0; ii < servoCount; ++ii) {
+        mainState.servo[ii] = queueItem.servo[ii];
+    }
 #endif
 // NOLINTEND(cppcoreguidelines-pro-bounds-constant-array-index)
 }
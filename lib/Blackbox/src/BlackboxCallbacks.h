@@ -3,7 +3,13 @@
 #include "BlackboxCallbacksBase.h"
 
 class AHRS;
+class BlackboxEventQueue;
 class BlackboxMessageQueue;
+class BlackboxProtoFlight;
+class BlackboxRateController;
+class BlackboxSerialDeviceBuffered;
+class BlackboxSerialDeviceFlash;
+class BlackboxSerialDeviceStream;
 class Debug;
 class FlightController;
 class RadioControllerBase;
@@ -31,6 +37,14 @@ public:
     virtual bool areMotorsRunning() const override;
     virtual uint32_t rcModeActivationMask() const override;
     void setUseMessageQueue(bool useMessageQueue) { _useMessageQueue = useMessageQueue; }
+    void setBlackbox(BlackboxProtoFlight* blackbox) { _blackbox = blackbox; } //!< used to record queue overflows in the log
+    void setEventQueue(BlackboxEventQueue* eventQueue) { _eventQueue = eventQueue; } //!< events in the queue are written to the log before each main frame
+    //! the device's write buffer fill level and dropped bytes (and for the SD card the write latency) are inputs to the rate controller
+    void setRateController(BlackboxRateController* rateController, const BlackboxSerialDeviceBuffered* bufferedDevice) { _rateController = rateController; _bufferedDevice = bufferedDevice; }
+    void setRateController(BlackboxRateController* rateController, const BlackboxSerialDeviceStream* streamDevice) { _rateController = rateController; _streamDevice = streamDevice; }
+    void setRateController(BlackboxRateController* rateController, const BlackboxSerialDeviceFlash* flashDevice) { _rateController = rateController; _flashDevice = flashDevice; }
+private:
+    void updateDecimation(uint32_t timeMicroSeconds, uint32_t droppedCount);
 private:
     BlackboxMessageQueue& _messageQueue;
     const AHRS& _ahrs;
@@ -38,5 +52,12 @@ private:
     const RadioControllerBase& _radioController;
     const ReceiverBase& _receiver;
     const Debug& _debug;
+    BlackboxProtoFlight* _blackbox {nullptr};
+    BlackboxEventQueue* _eventQueue {nullptr};
+    BlackboxRateController* _rateController {nullptr};
+    const BlackboxSerialDeviceBuffered* _bufferedDevice {nullptr};
+    const BlackboxSerialDeviceStream* _streamDevice {nullptr};
+    const BlackboxSerialDeviceFlash* _flashDevice {nullptr};
+    uint32_t _deviceDroppedByteCount {0};
     uint32_t _useMessageQueue {false};
 };
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+
+/*!
+Double buffer between the Blackbox encoder (the producer) and the storage writer (the consumer).
+
+The encoder fills one buffer while the other is being written (eg by SD card DMA), so a slow write does not stall the encoder.
+Buffers are handed to the writer only when full, and BUFFER_SIZE is a multiple of the SD card sector size, so every write
+starts on a sector boundary and is a whole number of sectors. This allows the file system to write directly from the buffer,
+rather than doing read-modify-write of partial sectors. Only the last buffer of a log may be partially filled.
+
+Bytes written while both buffers are full are dropped and counted, as are bytes the writer failed to write to the device.
+
+Statistics are kept so buffer sizes can be chosen for each SD card:
+the write latency histogram has buckets of doubling width, bucket 0 is [0, 128us), bucket 1 is [128us, 256us), and so on,
+with the last bucket holding all longer writes. The high water mark is the maximum number of bytes waiting to be written.
+The producer and the consumer each update only their own counters, and getStats() combines them.
+*/
+template <size_t BUFFER_SIZE>
+class BlackboxDoubleBuffer {
+public:
+    enum { SECTOR_SIZE = 512, BUFFER_COUNT = 2 };
+    static_assert(BUFFER_SIZE >= SECTOR_SIZE && BUFFER_SIZE % SECTOR_SIZE == 0, "BUFFER_SIZE must be a multiple of the sector size");
+    enum { LATENCY_HISTOGRAM_BUCKET_COUNT = 12 };
+    static constexpr uint32_t LATENCY_HISTOGRAM_FIRST_BUCKET_MICROSECONDS = 128;
+    enum state_e : uint8_t { FREE, FULL };
+    struct stats_t {
+        std::array<uint32_t, LATENCY_HISTOGRAM_BUCKET_COUNT> latencyHistogram;
+        uint32_t maxLatencyMicroSeconds;
+        uint32_t lastLatencyMicroSeconds;
+        uint32_t bufferWriteCount;
+        uint32_t highWaterMark; //!< maximum number of bytes waiting to be written
+        uint32_t droppedByteCount; //!< bytes dropped because both buffers were full, plus bytes the writer failed to write
+    };
+private:
+    struct producer_stats_t {
+        uint32_t highWaterMark;
+        uint32_t droppedByteCount;
+    };
+    struct consumer_stats_t {
+        std::array<uint32_t, LATENCY_HISTOGRAM_BUCKET_COUNT> latencyHistogram;
+        uint32_t maxLatencyMicroSeconds;
+        uint32_t lastLatencyMicroSeconds;
+        uint32_t bufferWriteCount;
+        uint32_t unwrittenByteCount;
+    };
+public:
+    BlackboxDoubleBuffer() = default;
+    BlackboxDoubleBuffer(const BlackboxDoubleBuffer&) = delete;
+    BlackboxDoubleBuffer& operator=(const BlackboxDoubleBuffer&) = delete;
+    static constexpr size_t getBufferSize() { return BUFFER_SIZE; }
+public:
+    // producer functions, called from the Blackbox task
+
+    //! copies data into the fill buffer, handing it to the writer when it is full, returns the number of bytes accepted
+    inline size_t write(const uint8_t* data, size_t length) {
+        size_t accepted = 0;
+        while (accepted < length) {
+            if (_fillLength == BUFFER_SIZE && !commitFillBuffer()) {
+                break;
+            }
+            const size_t count = (length - accepted < BUFFER_SIZE - _fillLength) ? length - accepted : BUFFER_SIZE - _fillLength;
+            memcpy(&_buffers[_fillIndex][_fillLength], data + accepted, count); // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            _fillLength += count;
+            accepted += count;
+            if (_fillLength == BUFFER_SIZE) {
+                commitFillBuffer();
+            }
+        }
+        _producerStats.droppedByteCount += static_cast<uint32_t>(length - accepted);
+        updateHighWaterMark();
+        return accepted;
+    }
+    inline size_t write(uint8_t value) { return write(&value, 1); }
+
+    //! number of bytes that can be written without any being dropped
+    inline size_t getFreeSpace() const {
+        const size_t fillFree = BUFFER_SIZE - _fillLength;
+        const size_t otherIndex = _fillIndex ^ 1U;
+        return _states[otherIndex].load(std::memory_order_acquire) == FREE ? fillFree + BUFFER_SIZE : fillFree; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    }
+
+    //! percentage of the buffers holding data waiting to be written
+    inline uint32_t getFillPercent() const {
+        return static_cast<uint32_t>(100 - getFreeSpace() * 100 / (BUFFER_SIZE * BUFFER_COUNT));
+    }
+
+    //! hands a partially filled buffer to the writer, eg at the end of a log, returns false if the writer is still busy with the other buffer
+    inline bool commitPartialBuffer() {
+        return _fillLength == 0 || commitFillBuffer();
+    }
+
+    //! returns true if all data has been handed to the writer and written
+    inline bool isEmpty() const {
+        return _fillLength == 0 && _states[0].load(std::memory_order_acquire) == FREE && _states[1].load(std::memory_order_acquire) == FREE;
+    }
+
+    // consumer functions, called from the writer task
+
+    //! returns the next full buffer and sets length, or returns nullptr if no buffer is ready for writing
+    inline const uint8_t* acquireFullBuffer(size_t& length) const {
+        if (_states[_writeIndex].load(std::memory_order_acquire) != FULL) { // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+            length = 0;
+            return nullptr;
+        }
+        length = _lengths[_writeIndex]; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+        return &_buffers[_writeIndex][0]; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    }
+
+    /*!
+    Returns the buffer acquired with acquireFullBuffer() to the encoder, and records how long it took to write.
+    unwrittenByteCount is the number of bytes of the buffer that the device did not accept, these are counted as dropped.
+    */
+    inline void releaseBuffer(uint32_t writeLatencyMicroSeconds, size_t unwrittenByteCount = 0) {
+        _states[_writeIndex].store(FREE, std::memory_order_release); // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+        _writeIndex ^= 1U;
+
+        size_t bucket = 0;
+        for (uint32_t limit = LATENCY_HISTOGRAM_FIRST_BUCKET_MICROSECONDS; writeLatencyMicroSeconds >= limit && bucket < LATENCY_HISTOGRAM_BUCKET_COUNT - 1; limit <<= 1U) {
+            ++bucket;
+        }
+        ++_consumerStats.latencyHistogram[bucket]; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+        _consumerStats.lastLatencyMicroSeconds = writeLatencyMicroSeconds;
+        if (writeLatencyMicroSeconds > _consumerStats.maxLatencyMicroSeconds) {
+            _consumerStats.maxLatencyMicroSeconds = writeLatencyMicroSeconds;
+        }
+        ++_consumerStats.bufferWriteCount;
+        _consumerStats.unwrittenByteCount += static_cast<uint32_t>(unwrittenByteCount);
+    }
+
+    stats_t getStats() const {
+        return stats_t {
+            .latencyHistogram = _consumerStats.latencyHistogram,
+            .maxLatencyMicroSeconds = _consumerStats.maxLatencyMicroSeconds,
+            .lastLatencyMicroSeconds = _consumerStats.lastLatencyMicroSeconds,
+            .bufferWriteCount = _consumerStats.bufferWriteCount,
+            .highWaterMark = _producerStats.highWaterMark,
+            .droppedByteCount = _producerStats.droppedByteCount + _consumerStats.unwrittenByteCount
+        };
+    }
+    //! resets the statistics, must not be called while the writer is writing a buffer
+    void resetStats() { _producerStats = {}; _consumerStats = {}; }
+private:
+    inline bool commitFillBuffer() {
+        const size_t otherIndex = _fillIndex ^ 1U;
+        if (_states[otherIndex].load(std::memory_order_acquire) != FREE) { // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+            // the writer is still busy with the other buffer
+            return false;
+        }
+        _lengths[_fillIndex] = _fillLength; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+        _states[_fillIndex].store(FULL, std::memory_order_release); // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+        _fillIndex = otherIndex;
+        _fillLength = 0;
+        return true;
+    }
+    inline void updateHighWaterMark() {
+        const size_t otherIndex = _fillIndex ^ 1U;
+        const size_t pending = _fillLength + (_states[otherIndex].load(std::memory_order_relaxed) == FULL ? _lengths[otherIndex] : 0); // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+        if (pending > _producerStats.highWaterMark) {
+            _producerStats.highWaterMark = static_cast<uint32_t>(pending);
+        }
+    }
+private:
+    // written by the producer
+    size_t _fillIndex {0};
+    size_t _fillLength {0};
+    std::array<size_t, BUFFER_COUNT> _lengths {};
+    producer_stats_t _producerStats {};
+    // written by the consumer
+    size_t _writeIndex {0};
+    consumer_stats_t _consumerStats {};
+    // written by both
+    std::array<std::atomic<state_e>, BUFFER_COUNT> _states {};
+    // DMA requires word aligned buffers
+    alignas(4) std::array<std::array<uint8_t, BUFFER_SIZE>, BUFFER_COUNT> _buffers {};
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#if !defined(BLACKBOX_EVENT_QUEUE_LENGTH)
+// must be a power of two
+#define BLACKBOX_EVENT_QUEUE_LENGTH 32
+#endif
+
+
+/*!
+Queue of timestamped events, posted from any task, that are written to the blackbox log as E frames.
+
+Slow frames record the flight mode and failsafe phase only at the slow frame rate, and give no indication of loop overruns
+or of parameter changes, so it is hard to correlate a glitch in the log with its cause. Events are timestamped when they are
+posted, and the Blackbox task writes them to the log before the next main frame.
+
+This is a lock-free bounded multiple producer, single consumer (MPSC) queue: each slot has a sequence number, so a producer
+claims a slot with a single compare-and-swap and publishes it by updating the slot's sequence number.
+post() never blocks and makes no system call, so it may be called from the AHRS task. If the queue is full the event is
+dropped and counted.
+*/
+class BlackboxEventQueue {
+public:
+    enum { QUEUE_LENGTH = BLACKBOX_EVENT_QUEUE_LENGTH };
+    static_assert(QUEUE_LENGTH >= 2 && (QUEUE_LENGTH & (QUEUE_LENGTH - 1)) == 0, "BLACKBOX_EVENT_QUEUE_LENGTH must be a power of two");
+    enum : uint32_t { MASK = QUEUE_LENGTH - 1 };
+    enum { CACHE_LINE_SIZE = 64 };
+    enum event_type_e : uint8_t {
+        EVENT_LOOP_OVERRUN = 0, //!< value is the AHRS loop interval in microseconds
+        EVENT_QUEUE_DROP = 1, //!< samples have started to be dropped from the message queue, value is the total dropped so far
+        EVENT_TELEMETRY_LOSS = 2, //!< value is the bitmask of motors with no valid ESC telemetry, zero when telemetry is restored
+        EVENT_FAILSAFE = 3, //!< value is the new failsafe phase
+        EVENT_CONTROL_MODE = 4, //!< value is the new control mode, eg rate, angle, or altitude hold
+        EVENT_RATES_CHANGE = 5, //!< the rates profile has been changed, value is the rates type
+        EVENT_PID_CHANGE = 6, //!< value is packed by pidChangeValue()
+        EVENT_TYPE_COUNT = 7
+    };
+    enum pid_term_e : uint8_t { PID_TERM_P = 0, PID_TERM_I = 1, PID_TERM_D = 2, PID_TERM_F = 3 };
+    struct event_t {
+        uint32_t timeMicroSeconds;
+        int32_t value;
+        event_type_e type;
+    };
+public:
+    BlackboxEventQueue() {
+        for (uint32_t ii = 0; ii < QUEUE_LENGTH; ++ii) {
+            _slots[ii].sequence.store(ii, std::memory_order_relaxed); // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+        }
+    }
+    BlackboxEventQueue(const BlackboxEventQueue&) = delete;
+    BlackboxEventQueue& operator=(const BlackboxEventQueue&) = delete;
+public:
+    static constexpr int32_t pidChangeValue(size_t pidIndex, pid_term_e term, uint16_t valueMSP) {
+        return static_cast<int32_t>((static_cast<uint32_t>(pidIndex) << 24U) | (static_cast<uint32_t>(term) << 16U) | valueMSP);
+    }
+
+    //! may be called from any task, returns false if the queue is full
+    inline bool post(event_type_e type, int32_t value, uint32_t timeMicroSeconds) {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        slot_t* slot {};
+        while (true) {
+            slot = &_slots[head & MASK]; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+            const uint32_t sequence = slot->sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<int32_t>(sequence - head);
+            if (difference == 0) {
+                // the slot is free, so try to claim it, on failure head is updated to the current value
+                if (_head.compare_exchange_weak(head, head + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                // the slot still holds an event that has not been read, so the queue is full
+                _overflowCount.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                // another producer has claimed the slot
+                head = _head.load(std::memory_order_relaxed);
+            }
+        }
+        slot->event = event_t { .timeMicroSeconds = timeMicroSeconds, .value = value, .type = type };
+        slot->sequence.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! called only by the Blackbox task, returns false if the queue is empty
+    inline bool pop(event_t& event) {
+        slot_t& slot = _slots[_tail & MASK]; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+        if (slot.sequence.load(std::memory_order_acquire) != _tail + 1) {
+            return false;
+        }
+        event = slot.event;
+        // make the slot available to the producers on their next pass round the queue
+        slot.sequence.store(_tail + QUEUE_LENGTH, std::memory_order_release);
+        ++_tail;
+        return true;
+    }
+
+    //! total number of events dropped because the queue was full
+    inline uint32_t getOverflowCount() const { return _overflowCount.load(std::memory_order_relaxed); }
+private:
+    struct slot_t {
+        std::atomic<uint32_t> sequence;
+        event_t event;
+    };
+    // written by the producers
+    alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> _head {0};
+    std::atomic<uint32_t> _overflowCount {0};
+    // written by the consumer
+    alignas(CACHE_LINE_SIZE) uint32_t _tail {0};
+    alignas(CACHE_LINE_SIZE) std::array<slot_t, QUEUE_LENGTH> _slots {};
+};
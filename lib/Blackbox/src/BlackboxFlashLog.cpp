@@ -0,0 +1,304 @@
+#include "BlackboxFlashLog.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+
+BlackboxFlashLog::BlackboxFlashLog(FlashBase& flash) :
+    _flash(flash)
+{
+}
+
+/*!
+The flash geometry is read here (rather than in the constructor), since the flash chip may not have been initialized
+when the BlackboxFlashLog is constructed.
+*/
+bool BlackboxFlashLog::init()
+{
+    const FlashBase::geometry_t& geometry = _flash.getGeometry();
+    _pageSize = geometry.pageSize;
+    _bufferPageSize = std::min(geometry.pageSize, static_cast<uint32_t>(MAX_PAGE_SIZE));
+    _sectorSize = geometry.sectorSize;
+    _dataStartAddress = geometry.sectorSize * INDEX_SECTOR_COUNT;
+    _capacity = _flash.getCapacity();
+    _maxLogCount = geometry.sectorSize * INDEX_SECTOR_COUNT / sizeof(index_entry_t);
+    if (_capacity <= _dataStartAddress) {
+        // no flash chip
+        _indexValid = false;
+        return false;
+    }
+
+    while (!_flash.isReady()) {}
+
+    _indexValid = false;
+    _state = STATE_IDLE;
+    _logCount = 0;
+    _nextLogNumber = 1;
+    _writeAddress = _dataStartAddress;
+    // the state of the data sectors is unknown, so they are all erased before they are programmed
+    _erasedEndAddress = _dataStartAddress;
+
+    index_entry_t lastEntry {};
+    for (size_t ii = 0; ii < _maxLogCount; ++ii) {
+        const index_entry_t entry = readIndexEntry(ii);
+        if (entry.magic == ERASED_WORD) {
+            break;
+        }
+        if (entry.magic != INDEX_ENTRY_MAGIC || entry.startAddress < _dataStartAddress || entry.startAddress >= _capacity
+            || (entry.endAddress != ERASED_WORD && (entry.endAddress < entry.startAddress || entry.endAddress > _capacity))) {
+            // index is corrupt, flash needs to be erased
+            return false;
+        }
+        lastEntry = entry;
+        _logCount = ii + 1;
+        _nextLogNumber = entry.logNumber + 1;
+    }
+
+    if (_logCount > 0) {
+        if (lastEntry.endAddress == ERASED_WORD) {
+            // power was lost while logging, so find the end of the log and complete its index entry
+            lastEntry.endAddress = recoverEndAddress(lastEntry.startAddress);
+            _flash.programPage(indexEntryAddress(_logCount - 1) + offsetof(index_entry_t, endAddress), reinterpret_cast<const uint8_t*>(&lastEntry.endAddress), sizeof(lastEntry.endAddress)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+            while (!_flash.isReady()) {}
+        }
+        _writeAddress = lastEntry.endAddress;
+        // the rest of the sector containing the end of the last log has not been programmed since it was erased
+        _erasedEndAddress = std::min(roundUp(_writeAddress, _sectorSize), _capacity);
+    }
+    _indexValid = true;
+    return true;
+}
+
+bool BlackboxFlashLog::eraseAll()
+{
+    if (_state != STATE_IDLE || !_flash.isReady()) {
+        return false;
+    }
+    // erase just the index, the data sectors are erased ahead of the write address as they are needed
+    _flash.eraseSector(0);
+    _logCount = 0;
+    _nextLogNumber = 1;
+    _writeAddress = _dataStartAddress;
+    _erasedEndAddress = _dataStartAddress;
+    _indexValid = true;
+    return true;
+}
+
+bool BlackboxFlashLog::beginLog()
+{
+    if (!_indexValid || _state != STATE_IDLE || _logCount >= _maxLogCount || !_flash.isReady()) {
+        return false;
+    }
+    // logs start on a page boundary
+    const uint32_t startAddress = roundUp(_writeAddress, _pageSize);
+    if (startAddress >= _capacity) {
+        return false;
+    }
+    _writeAddress = startAddress;
+
+    const index_entry_t entry { .magic = INDEX_ENTRY_MAGIC, .logNumber = _nextLogNumber, .startAddress = startAddress, .endAddress = ERASED_WORD };
+    _flash.programPage(indexEntryAddress(_logCount), reinterpret_cast<const uint8_t*>(&entry), sizeof(entry)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+
+    _logStartAddress = startAddress;
+    ++_logCount;
+    ++_nextLogNumber;
+    _droppedByteCount = 0;
+    _state = STATE_LOGGING;
+    return true;
+}
+
+bool BlackboxFlashLog::endLog()
+{
+    if (_state == STATE_IDLE) {
+        return true;
+    }
+    _state = STATE_ENDING;
+    if (!flush() || !_flash.isReady()) {
+        return false;
+    }
+    const uint32_t endAddress = _writeAddress;
+    _flash.programPage(indexEntryAddress(_logCount - 1) + offsetof(index_entry_t, endAddress), reinterpret_cast<const uint8_t*>(&endAddress), sizeof(endAddress)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+    _state = STATE_IDLE;
+    return true;
+}
+
+void BlackboxFlashLog::commitPage()
+{
+    const size_t pageIndex = (_pageTail + _pageCount) % PAGE_BUFFER_COUNT;
+    _pageLengths[pageIndex] = _fillLength; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    _fillLength = 0;
+    ++_pageCount;
+}
+
+size_t BlackboxFlashLog::write(const uint8_t* data, size_t length)
+{
+    if (_state != STATE_LOGGING) {
+        return 0;
+    }
+    size_t accepted = 0;
+    bool pageCommitted = false;
+    while (accepted < length && _pageCount < PAGE_BUFFER_COUNT) {
+        const size_t capacityRemaining = _capacity - _writeAddress - _bufferedByteCount;
+        const size_t count = std::min({ length - accepted, _bufferPageSize - _fillLength, capacityRemaining });
+        if (count == 0) {
+            break;
+        }
+        const size_t pageIndex = (_pageTail + _pageCount) % PAGE_BUFFER_COUNT;
+        memcpy(&_pages[pageIndex][_fillLength], data + accepted, count); // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        _fillLength += count;
+        _bufferedByteCount += static_cast<uint32_t>(count);
+        accepted += count;
+        if (_fillLength == _bufferPageSize) {
+            commitPage();
+            pageCommitted = true;
+        }
+    }
+    _droppedByteCount += static_cast<uint32_t>(length - accepted);
+    if (pageCommitted) {
+        update();
+    }
+    return accepted;
+}
+
+bool BlackboxFlashLog::flush()
+{
+    if (_fillLength > 0 && _pageCount < PAGE_BUFFER_COUNT) {
+        commitPage();
+    }
+    update();
+    return _bufferedByteCount == 0;
+}
+
+/*!
+Called from write() whenever a page is filled, and from flush().
+
+Does at most one flash operation and does not wait for it to complete.
+A program operation must not cross a flash page boundary, so a page buffer may take two operations to program.
+Data is only programmed if the flash page after it is erased: this guarantees that the end of a log
+can be found by searching for the first erased page, if power is lost before the log is ended.
+*/
+void BlackboxFlashLog::update()
+{
+    if (!_indexValid || !_flash.isReady()) {
+        return;
+    }
+    if (_pageCount > 0) {
+        const size_t remaining = _pageLengths[_pageTail] - _programmedLength; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+        const size_t count = std::min(remaining, static_cast<size_t>(_pageSize - _writeAddress % _pageSize));
+        if (std::min(_writeAddress + static_cast<uint32_t>(count) + _pageSize, _capacity) <= _erasedEndAddress) {
+            _flash.programPage(_writeAddress, &_pages[_pageTail][_programmedLength], count); // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+            _writeAddress += static_cast<uint32_t>(count);
+            _bufferedByteCount -= static_cast<uint32_t>(count);
+            _programmedLength += count;
+            if (_programmedLength == _pageLengths[_pageTail]) { // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+                _programmedLength = 0;
+                _pageTail = (_pageTail + 1) % PAGE_BUFFER_COUNT;
+                --_pageCount;
+            }
+            return;
+        }
+    }
+    // nothing can be programmed, so erase ahead of the write address
+    if (_erasedEndAddress < _capacity && _erasedEndAddress < _writeAddress + ERASE_AHEAD_SECTOR_COUNT * _sectorSize) {
+        _flash.eraseSector(_erasedEndAddress);
+        _erasedEndAddress += _sectorSize;
+    }
+}
+
+size_t BlackboxFlashLog::getFreeBufferSpace() const
+{
+    if (_state != STATE_LOGGING || _pageCount == PAGE_BUFFER_COUNT) {
+        return 0;
+    }
+    const size_t bufferFree = (PAGE_BUFFER_COUNT - _pageCount) * _bufferPageSize - _fillLength;
+    return std::min(bufferFree, static_cast<size_t>(_capacity - _writeAddress - _bufferedByteCount));
+}
+
+uint32_t BlackboxFlashLog::getBufferFillPercent() const
+{
+    const uint32_t bufferSize = PAGE_BUFFER_COUNT * _bufferPageSize;
+    return bufferSize == 0 ? 0 : _bufferedByteCount * 100 / bufferSize;
+}
+
+bool BlackboxFlashLog::isFull() const
+{
+    return _logCount >= _maxLogCount || roundUp(_writeAddress + _bufferedByteCount, _pageSize) >= _capacity;
+}
+
+BlackboxFlashLog::log_info_t BlackboxFlashLog::getLogInfo(size_t index)
+{
+    if (index >= _logCount) {
+        return log_info_t {};
+    }
+    const index_entry_t entry = readIndexEntry(index);
+    const uint32_t endAddress = (index == _logCount - 1 && _state != STATE_IDLE) ? _writeAddress : entry.endAddress;
+    return log_info_t { .logNumber = entry.logNumber, .startAddress = entry.startAddress, .size = endAddress - entry.startAddress };
+}
+
+size_t BlackboxFlashLog::readLog(size_t index, uint32_t offset, uint8_t* data, size_t length)
+{
+    if (_state != STATE_IDLE || index >= _logCount) {
+        return 0;
+    }
+    const log_info_t logInfo = getLogInfo(index);
+    if (offset >= logInfo.size) {
+        return 0;
+    }
+    length = std::min(length, static_cast<size_t>(logInfo.size - offset));
+    while (!_flash.isReady()) {}
+    _flash.read(logInfo.startAddress + offset, data, length);
+    return length;
+}
+
+BlackboxFlashLog::index_entry_t BlackboxFlashLog::readIndexEntry(size_t index)
+{
+    while (!_flash.isReady()) {}
+    index_entry_t entry {};
+    _flash.read(indexEntryAddress(index), reinterpret_cast<uint8_t*>(&entry), sizeof(entry)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+    return entry;
+}
+
+bool BlackboxFlashLog::isPageErased(uint32_t address)
+{
+    std::array<uint8_t, 64> buf {};
+    for (uint32_t offset = 0; offset < _pageSize; offset += static_cast<uint32_t>(buf.size())) {
+        const size_t length = std::min(buf.size(), static_cast<size_t>(_pageSize - offset));
+        _flash.read(address + offset, &buf[0], length);
+        if (std::any_of(buf.begin(), buf.begin() + static_cast<std::ptrdiff_t>(length), [](uint8_t value) { return value != FlashBase::ERASED_BYTE; })) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*!
+Find the end of a log that was not ended, because power was lost.
+
+Data is only programmed if the page after it has been erased (see update()), so the end of the log is in the page
+before the first erased page. Any trailing 0xFF bytes at the very end of the log are indistinguishable from erased flash and are lost.
+*/
+uint32_t BlackboxFlashLog::recoverEndAddress(uint32_t startAddress)
+{
+    uint32_t address = startAddress;
+    while (address < _capacity && !isPageErased(address)) {
+        address += _pageSize;
+    }
+    if (address == startAddress) {
+        return startAddress;
+    }
+    // find the last programmed byte in the previous page
+    const uint32_t pageAddress = address - _pageSize;
+    std::array<uint8_t, MAX_PAGE_SIZE> buf {};
+    uint32_t endAddress = pageAddress;
+    for (uint32_t offset = 0; offset < _pageSize; offset += static_cast<uint32_t>(buf.size())) {
+        const size_t length = std::min(buf.size(), static_cast<size_t>(_pageSize - offset));
+        _flash.read(pageAddress + offset, &buf[0], length);
+        for (size_t ii = 0; ii < length; ++ii) {
+            if (buf[ii] != FlashBase::ERASED_BYTE) { // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+                endAddress = pageAddress + offset + static_cast<uint32_t>(ii) + 1;
+            }
+        }
+    }
+    return endAddress;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "FlashBase.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+
+/*!
+Log-structured, append-only, storage of blackbox logs on NOR flash.
+
+Layout: the first sector is an index of the logs, the remaining sectors hold the log data.
+Each log is stored contiguously, starting on a page boundary immediately after the previous log.
+Each index entry is programmed when its log is started, and its end address is programmed when the log is ended.
+Since NOR flash can program erased bytes without an erase, the index is updated without ever rewriting a sector.
+
+Writes are buffered in a ring of pages, and write() never waits for the flash.
+update() advances a non-blocking state machine: when the flash is ready it either programs the next buffered page,
+or, if there is nothing to program, starts erasing a sector ahead of the write address.
+So the (slow) sector erases happen in the background and writes are not stalled waiting for them.
+eraseAll() erases just the index sector, the data sectors are erased lazily ahead of the write address.
+
+Data is only programmed once the page after it has been erased, so the end of the written data is always followed by an erased page.
+If power is lost while logging, the log's end address is not programmed, and init() recovers the log by finding the
+first erased page after the log's start address.
+*/
+class BlackboxFlashLog {
+public:
+    enum { MAX_PAGE_SIZE = 256 };
+    enum { PAGE_BUFFER_COUNT = 16 }; //!< 4kB of buffering, enough to cover a sector erase at typical logging rates
+    enum { ERASE_AHEAD_SECTOR_COUNT = 2 };
+    enum { INDEX_SECTOR_COUNT = 1 };
+    static constexpr uint32_t INDEX_ENTRY_MAGIC = 0x474F4C42; // "BLOG"
+    static constexpr uint32_t ERASED_WORD = 0xFFFFFFFF;
+    struct index_entry_t {
+        uint32_t magic;
+        uint32_t logNumber;
+        uint32_t startAddress;
+        uint32_t endAddress; //!< ERASED_WORD until the log is ended
+    };
+    struct log_info_t {
+        uint32_t logNumber;
+        uint32_t startAddress;
+        uint32_t size;
+    };
+    enum state_e { STATE_IDLE, STATE_LOGGING, STATE_ENDING };
+public:
+    explicit BlackboxFlashLog(FlashBase& flash);
+public:
+    //! reads the index and recovers any log that was not ended, returns false if the index is invalid and the flash needs to be erased
+    bool init();
+    bool isIndexValid() const { return _indexValid; }
+    //! erases the index, returns false if the flash is busy
+    bool eraseAll();
+
+    //! starts a new log, returns false (and may be retried) if the flash is busy, returns false if the flash is full
+    bool beginLog();
+    //! ends the current log, returns false until all buffered data has been programmed and the index entry has been completed
+    bool endLog();
+    state_e getState() const { return _state; }
+
+    //! copies data into the page buffers, never waits for the flash, returns the number of bytes accepted
+    size_t write(const uint8_t* data, size_t length);
+    size_t write(uint8_t value) { return write(&value, 1); }
+    //! commits any partially filled page for programming, returns true when all buffered data has been programmed
+    bool flush();
+    //! advances the program/erase state machine, programs only full pages, does not block
+    void update();
+
+    size_t getFreeBufferSpace() const;
+    //! percentage of the page buffers waiting to be programmed
+    uint32_t getBufferFillPercent() const;
+    bool isFull() const;
+    uint32_t getDroppedByteCount() const { return _droppedByteCount; }
+    uint32_t getWriteAddress() const { return _writeAddress; }
+    uint32_t getErasedEndAddress() const { return _erasedEndAddress; }
+
+    size_t getLogCount() const { return _logCount; }
+    log_info_t getLogInfo(size_t index);
+    //! blocking read of log data, returns the number of bytes read
+    size_t readLog(size_t index, uint32_t offset, uint8_t* data, size_t length);
+private:
+    void commitPage();
+    uint32_t indexEntryAddress(size_t index) const { return static_cast<uint32_t>(index * sizeof(index_entry_t)); }
+    index_entry_t readIndexEntry(size_t index);
+    bool isPageErased(uint32_t address);
+    uint32_t recoverEndAddress(uint32_t startAddress);
+    static uint32_t roundUp(uint32_t value, uint32_t multiple) { return ((value + multiple - 1) / multiple) * multiple; }
+private:
+    FlashBase& _flash;
+    uint32_t _pageSize {0};
+    uint32_t _bufferPageSize {0}; //!< size of each page buffer, may be less than the flash page size
+    uint32_t _sectorSize {0};
+    uint32_t _dataStartAddress {0};
+    uint32_t _capacity {0};
+    size_t _maxLogCount {0};
+    state_e _state {STATE_IDLE};
+    bool _indexValid {false};
+    size_t _logCount {0};
+    uint32_t _nextLogNumber {1};
+    uint32_t _logStartAddress {0};
+    uint32_t _writeAddress {0}; //!< flash address of the next byte to be programmed
+    uint32_t _erasedEndAddress {0}; //!< flash is erased in the range [_writeAddress, _erasedEndAddress)
+    uint32_t _bufferedByteCount {0}; //!< bytes in the page buffers that have not yet been programmed
+    uint32_t _droppedByteCount {0};
+    // ring of page buffers, _pageTail is the next page to be programmed, the page after the committed pages is being filled
+    size_t _pageTail {0};
+    size_t _pageCount {0}; //!< number of full (committed) pages waiting to be programmed
+    size_t _fillLength {0}; //!< bytes in the page being filled
+    size_t _programmedLength {0}; //!< bytes of the tail page that have already been programmed
+    std::array<size_t, PAGE_BUFFER_COUNT> _pageLengths {};
+    std::array<std::array<uint8_t, MAX_PAGE_SIZE>, PAGE_BUFFER_COUNT> _pages {};
+};
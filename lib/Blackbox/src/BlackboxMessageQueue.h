@@ -1,57 +1,123 @@
 #pragma once
 
 #include <BlackboxMessageQueueBase.h>
+#include <BlackboxRingBuffer.h>
 
+#include <algorithm>
 #include <array>
-#include <xyz_type.h>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
 
 #if defined(FRAMEWORK_USE_FREERTOS)
 #include <freertos/FreeRTOS.h>
-#include <freertos/queue.h>
+#include <freertos/task.h>
 #endif
 
+#if !defined(BLACKBOX_MESSAGE_QUEUE_LENGTH)
+// must be a power of two, at 8kHz 64 items buffers 8ms of SD card latency
+#define BLACKBOX_MESSAGE_QUEUE_LENGTH 64
+#endif
+
+/*!
+Queue of samples from the AHRS task to the Blackbox task.
+
+Each item is a snapshot of the whole main state, captured in the AHRS (IMU/PID) task and already quantized to the
+integer units used in the log. So every logged frame is time-coherent (the gyro, PID terms, setpoints, and motor outputs
+all come from the same loop iteration) and the Blackbox task does no float to integer conversion.
+
+Uses a lock-free ring buffer, so the AHRS task sends without making a system call.
+If the Blackbox task falls behind (eg because of SD card latency) samples are dropped, and the number dropped is
+reported by RECEIVE() with the next sample, so that the loss can be recorded in the log.
+*/
 class BlackboxMessageQueue : public BlackboxMessageQueueBase {
 public:
+#if defined(USE_EIGHT_MOTORS)
+    enum { MAX_MOTOR_COUNT = 8 };
+#else
+    enum { MAX_MOTOR_COUNT = 4 };
+#endif
+#if defined(USE_SERVOS)
+    enum { MAX_SERVO_COUNT = 8 };
+#endif
+    enum { AXIS_COUNT = 3, DEBUG_VALUE_COUNT = 8 };
     struct queue_item_t {
         uint32_t timeMicroSeconds;
-        xyz_t gyroRPS;
-        xyz_t gyroRPS_unfiltered;
-        xyz_t acc;
+        std::array<int16_t, AXIS_COUNT> gyroADC; //!< deci-degrees per second
+        std::array<int16_t, AXIS_COUNT> gyroUnfiltered; //!< deci-degrees per second
+        std::array<int16_t, AXIS_COUNT> accADC; //!< 4096 per g
+        std::array<int16_t, AXIS_COUNT> axisPID_P;
+        std::array<int16_t, AXIS_COUNT> axisPID_I;
+        std::array<int16_t, AXIS_COUNT> axisPID_D;
+        std::array<int16_t, AXIS_COUNT> axisPID_F;
+        std::array<int16_t, 4> setpoint; //!< roll, pitch, and yaw setpoints, and throttle in the range [0, 1000]
+        std::array<int16_t, 4> rcCommand; //!< [-500, +500] for roll, pitch, and yaw, [1000, 2000] for throttle
+        std::array<int16_t, DEBUG_VALUE_COUNT> debug;
+        std::array<int16_t, MAX_MOTOR_COUNT> motor;
+        std::array<int16_t, MAX_MOTOR_COUNT> erpm;
+#if defined(USE_SERVOS)
+        std::array<int16_t, MAX_SERVO_COUNT> servo;
+#endif
+        uint16_t vbatLatest; //!< tenths of a volt
+        uint16_t amperageLatest; //!< tenths of an amp
     };
+    enum { QUEUE_LENGTH = BLACKBOX_MESSAGE_QUEUE_LENGTH };
+    /*!
+    Fixed point scaling of the PID and motor fields. The scaling is written in the log header (the motorOutput range is used by
+    Blackbox Explorer to render the motors), so must not be changed while logging.
+    The scaled values are small integers that change slowly, so they remain compact with the variable byte encodings of P frames.
+    */
+    struct field_scale_t {
+        uint16_t pid; //!< PID terms are logged as term * pid
+        uint16_t motorOutputHigh; //!< motor outputs in the range [0, 1] are logged in the range [MOTOR_OUTPUT_LOW, motorOutputHigh]
+    };
+    enum { MOTOR_OUTPUT_LOW = 158 };
+    static constexpr field_scale_t FIELD_SCALE_STANDARD { .pid = 1, .motorOutputHigh = 2047 };
+    //! for tuning sessions: 0.1 resolution for the PID terms, and 15 bit resolution for the motor outputs
+    static constexpr field_scale_t FIELD_SCALE_HIGH_PRECISION { .pid = 10, .motorOutputHigh = 32767 };
 public:
+    BlackboxMessageQueue() = default;
+    static inline int16_t scalePID(float term, const field_scale_t& fieldScale) {
+        const long value = std::lroundf(term * static_cast<float>(fieldScale.pid));
+        return static_cast<int16_t>(std::clamp(value, static_cast<long>(INT16_MIN), static_cast<long>(INT16_MAX)));
+    }
+    static inline int16_t scaleMotorOutput(float output, const field_scale_t& fieldScale) {
+        const float range = static_cast<float>(fieldScale.motorOutputHigh - MOTOR_OUTPUT_LOW);
+        return static_cast<int16_t>(MOTOR_OUTPUT_LOW + std::lroundf(std::clamp(output, 0.0F, 1.0F) * range));
+    }
 #if defined(FRAMEWORK_USE_FREERTOS)
-    BlackboxMessageQueue()
-        : _queue(xQueueCreateStatic(QUEUE_LENGTH, sizeof(_queueItem), &_queueStorageArea[0], &_queueStatic))
-    {}
     virtual int32_t WAIT_IF_EMPTY(uint32_t& timeMicroSeconds) const override {
-        const int32_t ret = xQueuePeek(_queue, &_queueItem, portMAX_DELAY);
-        if (ret) {
-            timeMicroSeconds = _queueItem.timeMicroSeconds;
+        // the producer does not signal the consumer (since that would require a system call), so poll
+        while (!_ringBuffer.peek(_queueItem)) {
+            vTaskDelay(1);
         }
-        return ret;
+        timeMicroSeconds = _queueItem.timeMicroSeconds;
+        return 1;
     }
-    inline int32_t RECEIVE(queue_item_t& queueItem) const { return xQueueReceive(_queue, &queueItem, portMAX_DELAY); }
-    inline void SEND(const queue_item_t& queueItem) const { xQueueSend(_queue, &queueItem, portMAX_DELAY); }
-    inline bool SEND_IF_NOT_FULL(const queue_item_t& queueItem) const {
-        if (uxQueueSpacesAvailable(_queue)) {
-            xQueueSend(_queue, &queueItem, portMAX_DELAY);
-            return true;
+#else
+    virtual int32_t WAIT_IF_EMPTY(uint32_t& timeMicroSeconds) const override {
+        if (_ringBuffer.peek(_queueItem)) {
+            timeMicroSeconds = _queueItem.timeMicroSeconds;
+            return 1;
         }
-        return false;
+        timeMicroSeconds = 0;
+        return 0;
     }
-#else
-    BlackboxMessageQueue() = default;
-    virtual int32_t WAIT_IF_EMPTY(uint32_t& timeMicroSeconds) const override { timeMicroSeconds = 0; return 0; }
-    inline int32_t RECEIVE(queue_item_t& queueItem) const { queueItem = {}; return 0; }
-    inline void SEND(const queue_item_t& queueItem) const { (void)queueItem; }
-    inline bool SEND_IF_NOT_FULL(const queue_item_t& queueItem) const { (void)queueItem; return false; } // cppcheck-suppress knownConditionTrueFalse
 #endif // USE_FREERTOS
+    //! droppedCount is set to the number of items dropped, because the queue was full, immediately before this item
+    inline int32_t RECEIVE(queue_item_t& queueItem, uint32_t& droppedCount) { return _ringBuffer.pop(queueItem, droppedCount); }
+    inline int32_t RECEIVE(queue_item_t& queueItem) { return _ringBuffer.pop(queueItem); }
+    inline bool SEND_IF_NOT_FULL(const queue_item_t& queueItem) { return _ringBuffer.push(queueItem); }
+    inline uint32_t getOverflowCount() const { return _ringBuffer.getOverflowCount(); }
+    inline uint32_t getFillPercent() const { return static_cast<uint32_t>(_ringBuffer.size() * 100 / QUEUE_LENGTH); }
+    //! set by the Blackbox task when the log device cannot keep up, the AHRS task then sends only one sample in every decimation
+    inline void setDecimation(uint32_t decimation) { _decimation.store(decimation, std::memory_order_relaxed); }
+    inline uint32_t getDecimation() const { return _decimation.load(std::memory_order_relaxed); }
+    void setFieldScale(const field_scale_t& fieldScale) { _fieldScale = fieldScale; }
+    const field_scale_t& getFieldScale() const { return _fieldScale; }
 private:
-    mutable queue_item_t _queueItem {}; // this is just a dummy item whose value is not used
-    enum { QUEUE_LENGTH = 8 };
-    std::array<uint8_t, QUEUE_LENGTH * sizeof(_queueItem)> _queueStorageArea {};
-#if defined(FRAMEWORK_USE_FREERTOS)
-    StaticQueue_t _queueStatic {};
-    QueueHandle_t _queue {};
-#endif
+    mutable queue_item_t _queueItem {}; // used by WAIT_IF_EMPTY to peek at the next item
+    BlackboxRingBuffer<queue_item_t, QUEUE_LENGTH> _ringBuffer {};
+    std::atomic<uint32_t> _decimation {1};
+    field_scale_t _fieldScale {FIELD_SCALE_STANDARD};
 };
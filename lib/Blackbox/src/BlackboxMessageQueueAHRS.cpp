@@ -1,15 +1,152 @@
 #include "BlackboxMessageQueueAHRS.h"
+#include <BlackboxBurstCapture.h>
+#include <BlackboxEventQueue.h>
 #include <BlackboxMessageQueue.h>
 
+#include <Debug.h>
+#include <FlightController.h>
+#include <ReceiverBase.h>
+#include <algorithm>
+#include <cmath>
+
 
 uint32_t BlackboxMessageQueueAHRS::append(uint32_t timeMicroSeconds, const xyz_t& gyroRPS, const xyz_t& gyroRPS_unfiltered, const xyz_t& acc)
 {
-    struct BlackboxMessageQueue::queue_item_t queueItem {
-        timeMicroSeconds,
-        gyroRPS,
-        gyroRPS_unfiltered,
-        acc
-    };
-
-    return _blackboxMessageQueue.SEND_IF_NOT_FULL(queueItem); // cppcheck-suppress knownConditionTrueFalse
+    if (_burstCapture) {
+        const MotorMixerBase& mixer = _flightController.getMixer();
+        BlackboxBurstCapture::motor_frequencies_t motorFrequenciesHz {};
+        if (_burstCapture->getConfig().captureMotorFrequencies) {
+            for (size_t ii = 0; ii < _burstCapture->getMotorCount(); ++ii) {
+                motorFrequenciesHz[ii] = mixer.getMotorFrequencyHz(ii); // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+            }
+        }
+        _burstCapture->capture(gyroRPS_unfiltered, acc, motorFrequenciesHz, mixer.getThrottleCommand());
+    }
+    if (_eventQueue) {
+        postEvents(timeMicroSeconds);
+    }
+
+    // skip samples if the Blackbox task has reduced the log rate, the skipped samples show as a gap in the logged time
+    if (++_decimationCounter < _blackboxMessageQueue.getDecimation()) {
+        return 0;
+    }
+    _decimationCounter = 0;
+
+    BlackboxMessageQueue::queue_item_t queueItem; // NOLINT(cppcoreguidelines-pro-type-member-init) all fields set by captureState
+    captureState(queueItem, timeMicroSeconds, gyroRPS, gyroRPS_unfiltered, acc, _flightController, _receiver, _debug, _blackboxMessageQueue.getFieldScale());
+
+    // does not block: if the queue is full the item is dropped, and the drop is recorded in the log by the Blackbox task
+    const bool sent = _blackboxMessageQueue.SEND_IF_NOT_FULL(queueItem);
+    if (_eventQueue) {
+        // post only the first drop of a run, the number dropped is recorded by the Blackbox task when the queue drains
+        if (!sent && !_isDropping) {
+            _eventQueue->post(BlackboxEventQueue::EVENT_QUEUE_DROP, static_cast<int32_t>(_blackboxMessageQueue.getOverflowCount()), timeMicroSeconds);
+        }
+        _isDropping = !sent;
+    }
+    return sent;
+}
+
+/*!
+Posts events for conditions detected in the AHRS task: loop overruns and, when the motors are on, loss of ESC telemetry.
+*/
+void BlackboxMessageQueueAHRS::postEvents(uint32_t timeMicroSeconds)
+{
+    // an overrun is a loop interval of more than twice the expected interval, ie at least one whole loop was missed
+    const uint32_t loopInterval = timeMicroSeconds - _previousTimeMicroSeconds;
+    if (_previousTimeMicroSeconds != 0 && loopInterval > 2 * _loopIntervalMicroSeconds) {
+        _eventQueue->post(BlackboxEventQueue::EVENT_LOOP_OVERRUN, static_cast<int32_t>(loopInterval), timeMicroSeconds);
+    }
+    _previousTimeMicroSeconds = timeMicroSeconds;
+
+#if defined(USE_DSHOT_TELEMETRY)
+    const MotorMixerBase& mixer = _flightController.getMixer();
+    uint32_t telemetryLostMask = 0;
+    if (mixer.motorsIsOn()) {
+        for (size_t ii = 0; ii < mixer.getMotorCount(); ++ii) {
+            if (mixer.getMotorFrequencyWeight(ii) <= 0.0F) {
+                telemetryLostMask |= 1U << ii;
+            }
+        }
+    }
+    if (telemetryLostMask != _telemetryLostMask) {
+        _telemetryLostMask = telemetryLostMask;
+        _eventQueue->post(BlackboxEventQueue::EVENT_TELEMETRY_LOSS, static_cast<int32_t>(telemetryLostMask), timeMicroSeconds);
+    }
+#endif
+}
+
+/*!
+Fill in queueItem with the main state, quantized to the units used in the blackbox log.
+
+This is called from within the AHRS task (ie the main IMU/PID loop) so all the values are from the same loop iteration.
+*/
+void BlackboxMessageQueueAHRS::captureState(BlackboxMessageQueue::queue_item_t& queueItem, uint32_t timeMicroSeconds, const xyz_t& gyroRPS, const xyz_t& gyroRPS_unfiltered, const xyz_t& acc, // NOLINT(readability-function-cognitive-complexity)
+    const FlightController& flightController, const ReceiverBase& receiver, const Debug& debug, const BlackboxMessageQueue::field_scale_t& fieldScale)
+{
+    queueItem.timeMicroSeconds = timeMicroSeconds;
+
+// NOLINTBEGIN(cppcoreguidelines-pro-bounds-constant-array-index)
+    constexpr float radiansToDegrees {180.0F / static_cast<float>(M_PI)};
+    constexpr float gyroScale {radiansToDegrees * 10.0F};
+
+    queueItem.gyroADC[0] = static_cast<int16_t>(std::lroundf(gyroRPS.x * gyroScale));
+    queueItem.gyroADC[1] = static_cast<int16_t>(std::lroundf(gyroRPS.y * gyroScale));
+    queueItem.gyroADC[2] = static_cast<int16_t>(std::lroundf(gyroRPS.z * gyroScale));
+    queueItem.gyroUnfiltered[0] = static_cast<int16_t>(std::lroundf(gyroRPS_unfiltered.x * gyroScale));
+    queueItem.gyroUnfiltered[1] = static_cast<int16_t>(std::lroundf(gyroRPS_unfiltered.y * gyroScale));
+    queueItem.gyroUnfiltered[2] = static_cast<int16_t>(std::lroundf(gyroRPS_unfiltered.z * gyroScale));
+    // just truncate for acc
+    queueItem.accADC[0] = static_cast<int16_t>(acc.x * 4096);
+    queueItem.accADC[1] = static_cast<int16_t>(acc.y * 4096);
+    queueItem.accADC[2] = static_cast<int16_t>(acc.z * 4096);
+
+    // iterate through roll, pitch, and yaw PIDs
+    for (size_t ii = 0; ii < BlackboxMessageQueue::AXIS_COUNT; ++ii) {
+        const PIDF& pid = flightController.getPID(static_cast<FlightController::pid_index_e>(ii));
+        const PIDF::error_t pidError = pid.getError();
+        queueItem.axisPID_P[ii] = BlackboxMessageQueue::scalePID(pidError.P, fieldScale);
+        queueItem.axisPID_I[ii] = BlackboxMessageQueue::scalePID(pidError.I, fieldScale);
+        queueItem.axisPID_D[ii] = BlackboxMessageQueue::scalePID(pidError.D, fieldScale);
+        queueItem.axisPID_F[ii] = BlackboxMessageQueue::scalePID(pidError.F, fieldScale);
+        queueItem.setpoint[ii] = static_cast<int16_t>(std::lroundf(pid.getSetpoint()));
+    }
+    const MotorMixerBase& mixer = flightController.getMixer();
+    // log the final throttle value used in the mixer
+    queueItem.setpoint[3] = static_cast<int16_t>(std::lroundf(mixer.getThrottleCommand() * 1000.0F));
+
+    // interval [1000,2000] for THROTTLE and [-500,+500] for ROLL/PITCH/YAW
+    const ReceiverBase::controls_pwm_t controls = receiver.getControlsPWM(); // returns controls in range [1000, 2000]
+    queueItem.rcCommand[0] = static_cast<int16_t>(controls.roll - ReceiverBase::CHANNEL_MIDDLE);
+    queueItem.rcCommand[1] = static_cast<int16_t>(controls.pitch - ReceiverBase::CHANNEL_MIDDLE);
+    queueItem.rcCommand[2] = static_cast<int16_t>(controls.yaw - ReceiverBase::CHANNEL_MIDDLE);
+    queueItem.rcCommand[3] = static_cast<int16_t>(controls.throttle);
+
+    static_assert(static_cast<int>(BlackboxMessageQueue::DEBUG_VALUE_COUNT) == static_cast<int>(Debug::VALUE_COUNT));
+    for (size_t ii = 0; ii < BlackboxMessageQueue::DEBUG_VALUE_COUNT; ++ii) {
+        queueItem.debug[ii] = debug.get(ii);
+    }
+
+    queueItem.motor.fill(0);
+    queueItem.erpm.fill(0);
+    const size_t motorCount = std::min(mixer.getMotorCount(), static_cast<size_t>(BlackboxMessageQueue::MAX_MOTOR_COUNT));
+    for (size_t ii = 0; ii < motorCount; ++ ii) {
+        // motor outputs are in the range [0, 1], so must be scaled before conversion to an integer
+        queueItem.motor[ii] = BlackboxMessageQueue::scaleMotorOutput(mixer.getMotorOutput(ii), fieldScale);
+#if defined(USE_DSHOT_TELEMETRY)
+        queueItem.erpm[ii] = static_cast<int16_t>(mixer.getMotorRPM(ii));
+#endif
+    }
+#if defined(USE_SERVOS)
+    // servo outputs are in the range [-1.0, 1.0], convert to microseconds centered on 1500
+    queueItem.servo.fill(1500);
+    const size_t servoCount = std::min(mixer.getServoCount(), static_cast<size_t>(BlackboxMessageQueue::MAX_SERVO_COUNT));
+    for (size_t ii = 0; ii < servoCount; ++ii) {
+        queueItem.servo[ii] = static_cast<int16_t>(1500 + std::lroundf(500.0F*mixer.getServoOutput(ii)));
+    }
+#endif
+// NOLINTEND(cppcoreguidelines-pro-bounds-constant-array-index)
+
+    queueItem.vbatLatest = static_cast<uint16_t>(flightController.getBatteryVoltage()*10.0F);
+    queueItem.amperageLatest = static_cast<uint16_t>(flightController.getAmperage()*10.0F);
 }
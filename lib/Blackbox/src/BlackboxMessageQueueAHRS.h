@@ -3,12 +3,42 @@
 #include <AHRS_MessageQueueBase.h>
 #include <BlackboxMessageQueue.h>
 
+class BlackboxBurstCapture;
+class BlackboxEventQueue;
+class Debug;
+class FlightController;
+class ReceiverBase;
 
+
+/*!
+Called by the AHRS task, immediately after the PIDs have been updated, to capture a snapshot of the main state
+and push it to the Blackbox task.
+*/
 class BlackboxMessageQueueAHRS : public AHRS_MessageQueueBase {
 public:
-    explicit BlackboxMessageQueueAHRS(BlackboxMessageQueue& blackboxMessageQueue) :
-        _blackboxMessageQueue(blackboxMessageQueue) {}
+    BlackboxMessageQueueAHRS(BlackboxMessageQueue& blackboxMessageQueue, const FlightController& flightController, const ReceiverBase& receiver, const Debug& debug) :
+        _blackboxMessageQueue(blackboxMessageQueue),
+        _flightController(flightController),
+        _receiver(receiver),
+        _debug(debug)
+        {}
+    void setBurstCapture(BlackboxBurstCapture* burstCapture) { _burstCapture = burstCapture; }
+    //! loop overruns, message queue drops, and ESC telemetry loss are posted to eventQueue
+    void setEventQueue(BlackboxEventQueue* eventQueue, uint32_t loopIntervalMicroSeconds) { _eventQueue = eventQueue; _loopIntervalMicroSeconds = loopIntervalMicroSeconds; }
     virtual uint32_t append(uint32_t timeMicroSeconds, const xyz_t& gyroRPS, const xyz_t& gyroRPS_unfiltered, const xyz_t& acc) override;
+    void postEvents(uint32_t timeMicroSeconds);
+    static void captureState(BlackboxMessageQueue::queue_item_t& queueItem, uint32_t timeMicroSeconds, const xyz_t& gyroRPS, const xyz_t& gyroRPS_unfiltered, const xyz_t& acc,
+        const FlightController& flightController, const ReceiverBase& receiver, const Debug& debug, const BlackboxMessageQueue::field_scale_t& fieldScale);
 private:
-    BlackboxMessageQueue _blackboxMessageQueue;
+    BlackboxMessageQueue& _blackboxMessageQueue;
+    const FlightController& _flightController;
+    const ReceiverBase& _receiver;
+    const Debug& _debug;
+    BlackboxBurstCapture* _burstCapture {nullptr}; //!< optional high rate capture of unfiltered gyro
+    uint32_t _decimationCounter {0};
+    BlackboxEventQueue* _eventQueue {nullptr};
+    uint32_t _loopIntervalMicroSeconds {0};
+    uint32_t _previousTimeMicroSeconds {0};
+    uint32_t _telemetryLostMask {0};
+    bool _isDropping {false};
 };
@@ -1,3 +1,4 @@
+#include "BlackboxBurstCaptureWriter.h"
 #include "BlackboxProtoFlight.h"
 #include "IMU_Filters.h"
 #include "RadioController.h"
@@ -17,6 +18,21 @@
 // NOLINTEND(cppcoreguidelines-macro-usage)
 
 
+/*!
+Called by the Blackbox task.
+
+A completed burst capture is written only while no log is being written. Once the writer has started it has sole use of the
+serial device, so the next log is not started until the capture has been written (or cut short because the motors were switched on).
+*/
+uint32_t BlackboxProtoFlight::update(uint32_t currentTimeUs)
+{
+    if (_burstCaptureWriter && _burstCaptureWriter->update(currentTimeUs, _state == Blackbox::STATE_STOPPED || _state == Blackbox::STATE_DISABLED)) {
+        return _state;
+    }
+    _state = Blackbox::update(currentTimeUs);
+    return _state;
+}
+
 /*!
 Transmit a portion of the system information headers. Call the first time with xmitState.headerIndex == 0.
 Returns true iff transmission is complete, otherwise call again later to continue transmission.
@@ -41,6 +57,8 @@ Blackbox::write_e BlackboxProtoFlight::writeSystemInformation()
 
     const IMU_Filters::config_t imuFiltersConfig = _imuFilters.getConfig();
 
+    const BlackboxMessageQueue::field_scale_t& fieldScale = _messageQueue.getFieldScale();
+
     const DynamicIdleController* dynamicIdleController = _flightController.getMixer().getDynamicIdleController();
     const DynamicIdleController::config_t* dynamicIdleControllerConfig = dynamicIdleController ? &dynamicIdleController->getConfig() : nullptr;
 
@@ -86,7 +104,8 @@ Blackbox::write_e BlackboxProtoFlight::writeSystemInformation()
 // match Baseflight so we can use Baseflight's IMU for both:
 // sysConfig.gyroScale * (Math.PI / 180.0) * 0.000001
         BLACKBOX_PRINT_HEADER_LINE("gyro_scale","0x%x",                     BlackboxEncoder::castFloatBytesToInt(0.000001F / gyroScale));
-        BLACKBOX_PRINT_HEADER_LINE("motorOutput", "%d,%d",                  158,2047);
+        BLACKBOX_PRINT_HEADER_LINE("motorOutput", "%d,%d",                  BlackboxMessageQueue::MOTOR_OUTPUT_LOW, fieldScale.motorOutputHigh);
+        BLACKBOX_PRINT_HEADER_LINE("pid_scale", "%d",                       fieldScale.pid); // PID terms are logged multiplied by pid_scale
         BLACKBOX_PRINT_HEADER_LINE("acc_1G", "%u",                          4096);
 
 /*
@@ -256,3 +275,54 @@ H features:541130760
     _xmitState.headerIndex++;
     return WRITE_NOT_COMPLETE;
 }
+
+/*!
+Record in the log that samples were dropped because the message queue from the AHRS task was full.
+
+Written as in-flight adjustment events, since Blackbox Explorer displays these in its event list without affecting the parsing of the main frames.
+An integer adjustment carries only one value, so two events are written: the first gives the total dropped so far,
+and the second gives the number of samples dropped immediately before the next frame.
+*/
+void BlackboxProtoFlight::logQueueOverflow(uint32_t droppedCount, uint32_t totalDroppedCount)
+{
+    log_event_data_u eventData {};
+    eventData.inflightAdjustment.adjustmentFunction = ADJUSTMENT_BLACKBOX_QUEUE_OVERFLOW_TOTAL;
+    eventData.inflightAdjustment.floatFlag = false;
+    eventData.inflightAdjustment.newValue = static_cast<int32_t>(totalDroppedCount);
+    logEvent(LOG_EVENT_INFLIGHT_ADJUSTMENT, &eventData);
+
+    eventData.inflightAdjustment.adjustmentFunction = ADJUSTMENT_BLACKBOX_QUEUE_OVERFLOW;
+    eventData.inflightAdjustment.newValue = static_cast<int32_t>(droppedCount);
+    logEvent(LOG_EVENT_INFLIGHT_ADJUSTMENT, &eventData);
+}
+
+/*!
+Record in the log that the streaming device has changed the log rate, so that one sample in every decimation is logged.
+*/
+void BlackboxProtoFlight::logDecimationChange(uint32_t decimation)
+{
+    log_event_data_u eventData {};
+    eventData.inflightAdjustment.adjustmentFunction = ADJUSTMENT_BLACKBOX_DECIMATION;
+    eventData.inflightAdjustment.floatFlag = false;
+    eventData.inflightAdjustment.newValue = static_cast<int32_t>(decimation);
+    logEvent(LOG_EVENT_INFLIGHT_ADJUSTMENT, &eventData);
+}
+
+/*!
+Record an event from the BlackboxEventQueue in the log.
+
+Written as two in-flight adjustment events: the first gives the time the event occurred, since E frames are not otherwise timestamped,
+and the second gives the event type (as an offset from ADJUSTMENT_BLACKBOX_EVENT_BASE) and its value.
+*/
+void BlackboxProtoFlight::logTimedEvent(uint8_t eventType, int32_t value, uint32_t timeMicroSeconds)
+{
+    log_event_data_u eventData {};
+    eventData.inflightAdjustment.adjustmentFunction = ADJUSTMENT_BLACKBOX_EVENT_TIME;
+    eventData.inflightAdjustment.floatFlag = false;
+    eventData.inflightAdjustment.newValue = static_cast<int32_t>(timeMicroSeconds);
+    logEvent(LOG_EVENT_INFLIGHT_ADJUSTMENT, &eventData);
+
+    eventData.inflightAdjustment.adjustmentFunction = static_cast<uint8_t>(ADJUSTMENT_BLACKBOX_EVENT_BASE + eventType);
+    eventData.inflightAdjustment.newValue = value;
+    logEvent(LOG_EVENT_INFLIGHT_ADJUSTMENT, &eventData);
+}
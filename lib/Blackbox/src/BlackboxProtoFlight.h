@@ -1,8 +1,10 @@
 #pragma once
 
 #include <Blackbox.h>
+#include <BlackboxMessageQueue.h>
 #include <FlightController.h>
 
+class BlackboxBurstCaptureWriter;
 class IMU_Filters;
 class RadioController;
 
@@ -11,16 +13,32 @@ Class to write out the Blackbox header, written in blackboxWriteSysinfo()
 */
 class BlackboxProtoFlight : public Blackbox {
 public:
-    BlackboxProtoFlight(BlackboxCallbacksBase& callbacks, BlackboxMessageQueueBase& messageQueue, BlackboxSerialDevice& serialDevice, const FlightController& flightController, const RadioController& radioController, const IMU_Filters& imuFilters) :
+    enum { ADJUSTMENT_BLACKBOX_QUEUE_OVERFLOW = 127 }; //!< not a real adjustment function, used to record dropped samples in the log
+    enum { ADJUSTMENT_BLACKBOX_DECIMATION = 126 }; //!< not a real adjustment function, used to record changes in the log rate
+    enum { ADJUSTMENT_BLACKBOX_EVENT_TIME = 125 }; //!< not a real adjustment function, gives the time of the event that follows it
+    enum { ADJUSTMENT_BLACKBOX_QUEUE_OVERFLOW_TOTAL = 124 }; //!< not a real adjustment function, gives the total dropped samples for the queue overflow event that follows it
+    enum { ADJUSTMENT_BLACKBOX_EVENT_BASE = 96 }; //!< events from the BlackboxEventQueue are recorded as adjustment function ADJUSTMENT_BLACKBOX_EVENT_BASE + event type
+public:
+    BlackboxProtoFlight(BlackboxCallbacksBase& callbacks, BlackboxMessageQueue& messageQueue, BlackboxSerialDevice& serialDevice, const FlightController& flightController, const RadioController& radioController, const IMU_Filters& imuFilters) :
         Blackbox(flightController.getTaskIntervalMicroSeconds(), callbacks, messageQueue, serialDevice),
+        _messageQueue(messageQueue),
         _flightController(flightController),
         _radioController(radioController),
         _imuFilters(imuFilters)
         {}
 public:
     virtual Blackbox::write_e writeSystemInformation() override;
+    virtual uint32_t update(uint32_t currentTimeUs) override;
+    //! the burst capture writer is run from update(), so it is in the Blackbox task and has sole use of the serial device while writing
+    void setBurstCaptureWriter(BlackboxBurstCaptureWriter* burstCaptureWriter) { _burstCaptureWriter = burstCaptureWriter; }
+    void logQueueOverflow(uint32_t droppedCount, uint32_t totalDroppedCount);
+    void logDecimationChange(uint32_t decimation);
+    void logTimedEvent(uint8_t eventType, int32_t value, uint32_t timeMicroSeconds);
 private:
+    const BlackboxMessageQueue& _messageQueue; //!< gives the field scaling, for the header
     const FlightController& _flightController;
     const RadioController& _radioController;
     const IMU_Filters& _imuFilters;
+    BlackboxBurstCaptureWriter* _burstCaptureWriter {nullptr};
+    uint32_t _state {Blackbox::STATE_DISABLED}; //!< state returned by the last call to Blackbox::update()
 };
@@ -0,0 +1,66 @@
+#include "BlackboxRateController.h"
+
+
+BlackboxRateController::BlackboxRateController() :
+    BlackboxRateController(DEFAULT_CONFIG)
+{
+}
+
+BlackboxRateController::BlackboxRateController(const config_t& config) :
+    _config(config)
+{
+    reset();
+}
+
+void BlackboxRateController::reset()
+{
+    _decimation = 1;
+    _increaseTimeMicroSeconds = 0;
+    _lowStartTimeMicroSeconds = 0;
+    _isLow = false;
+    _stats = stats_t { .increaseCount = 0, .decreaseCount = 0, .maxDecimation = 1 };
+}
+
+bool BlackboxRateController::update(uint32_t timeMicroSeconds, const input_t& input)
+{
+    const bool isHigh = input.droppedCount > 0
+        || input.queueFillPercent >= _config.queueFillHighPercent
+        || input.deviceFillPercent >= _config.deviceFillHighPercent
+        || input.writeLatencyMicroSeconds >= _config.writeLatencyHighMicroSeconds;
+    const bool isLow = input.queueFillPercent <= _config.queueFillLowPercent
+        && input.deviceFillPercent <= _config.deviceFillLowPercent
+        && input.writeLatencyMicroSeconds <= _config.writeLatencyLowMicroSeconds;
+
+    if (isHigh) {
+        _isLow = false;
+        // time differences are used, so the comparisons are correct when the time wraps
+        const bool holdOffExpired = _stats.increaseCount == 0 || timeMicroSeconds - _increaseTimeMicroSeconds >= _config.holdOffMicroSeconds;
+        if (_decimation < MAX_DECIMATION && holdOffExpired) {
+            _decimation *= 2;
+            _increaseTimeMicroSeconds = timeMicroSeconds;
+            ++_stats.increaseCount;
+            if (_decimation > _stats.maxDecimation) {
+                _stats.maxDecimation = _decimation;
+            }
+            return true;
+        }
+        return false;
+    }
+    if (!isLow || _decimation == 1) {
+        _isLow = false;
+        return false;
+    }
+    if (!_isLow) {
+        _isLow = true;
+        _lowStartTimeMicroSeconds = timeMicroSeconds;
+        return false;
+    }
+    if (timeMicroSeconds - _lowStartTimeMicroSeconds >= _config.decreaseDelayMicroSeconds) {
+        _decimation /= 2;
+        // start timing again, so each halving needs a further period below the low levels
+        _lowStartTimeMicroSeconds = timeMicroSeconds;
+        ++_stats.decreaseCount;
+        return true;
+    }
+    return false;
+}
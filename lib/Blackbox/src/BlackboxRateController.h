@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+
+
+/*!
+Adapts the blackbox log rate to what the storage device can sustain.
+
+blackbox.init() sets a fixed sample rate, but the highest rate a device can sustain depends on the device: SD cards vary
+widely in write latency, and so do flash chips in erase time. Rather than choosing a conservative fixed rate, the log runs at
+the full rate and this controller watches for backpressure: the fill level of the message queue from the AHRS task,
+the fill level of the device's write buffers, the device write latency, and any dropped data.
+
+Under backpressure the decimation is doubled, so the AHRS task sends only one sample in every 2, 4, 8, or 16.
+After an increase there is a hold off, to give the reduced rate time to drain the buffers before deciding to increase again.
+The decimation is halved only after the inputs have stayed below their low levels for a while, so the rate does not oscillate.
+
+update() is called by the Blackbox task once per logged frame, and each change is recorded in the log as an in-flight
+adjustment event. The logged time field shows the resulting gap between frames, so decoders need no special handling.
+*/
+class BlackboxRateController {
+public:
+    enum { MAX_DECIMATION = 16 };
+    struct config_t {
+        uint8_t queueFillHighPercent;
+        uint8_t queueFillLowPercent;
+        uint8_t deviceFillHighPercent;
+        uint8_t deviceFillLowPercent;
+        uint32_t writeLatencyHighMicroSeconds;
+        uint32_t writeLatencyLowMicroSeconds;
+        uint32_t holdOffMicroSeconds; //!< time after an increase before the decimation can increase again
+        uint32_t decreaseDelayMicroSeconds; //!< time all inputs must be below their low levels before the decimation is reduced
+    };
+    static constexpr config_t DEFAULT_CONFIG {
+        .queueFillHighPercent = 50,
+        .queueFillLowPercent = 10,
+        .deviceFillHighPercent = 75,
+        .deviceFillLowPercent = 50,
+        .writeLatencyHighMicroSeconds = 20000,
+        .writeLatencyLowMicroSeconds = 5000,
+        .holdOffMicroSeconds = 100000,
+        .decreaseDelayMicroSeconds = 2000000
+    };
+    struct input_t {
+        uint32_t queueFillPercent;
+        uint32_t deviceFillPercent; //!< percentage of the device write buffers waiting to be written, zero if not known
+        uint32_t writeLatencyMicroSeconds; //!< latency of the most recent device write, zero if not known
+        uint32_t droppedCount; //!< samples or bytes dropped since the previous update
+    };
+    struct stats_t {
+        uint32_t increaseCount;
+        uint32_t decreaseCount;
+        uint32_t maxDecimation;
+    };
+public:
+    BlackboxRateController();
+    explicit BlackboxRateController(const config_t& config);
+public:
+    void setConfig(const config_t& config) { _config = config; }
+    const config_t& getConfig() const { return _config; }
+    //! restores the full rate
+    void reset();
+    //! returns true if the decimation has changed
+    bool update(uint32_t timeMicroSeconds, const input_t& input);
+    uint32_t getDecimation() const { return _decimation; }
+    const stats_t& getStats() const { return _stats; }
+private:
+    config_t _config;
+    uint32_t _decimation {1};
+    uint32_t _increaseTimeMicroSeconds {0};
+    uint32_t _lowStartTimeMicroSeconds {0};
+    bool _isLow {false};
+    stats_t _stats {};
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+
+/*!
+Lock-free single producer, single consumer (SPSC) ring buffer.
+
+The producer (the AHRS task) and the consumer (the Blackbox task) may run on different cores.
+Neither push() nor pop() makes a system call or takes a lock, so the producer is never blocked by the consumer.
+
+LENGTH must be a power of two, so the indices can be wrapped with a mask.
+The head and tail indices are on separate cache lines, so the producer and consumer do not contend for the same line.
+
+When the buffer is full the item is dropped and counted. The number of items dropped since the previous successful push()
+is returned by pop(), so the consumer knows exactly where, and how much, data was lost.
+*/
+template <typename T, size_t LENGTH>
+class BlackboxRingBuffer {
+public:
+    static_assert(LENGTH >= 2 && (LENGTH & (LENGTH - 1)) == 0, "LENGTH must be a power of two");
+    enum { CACHE_LINE_SIZE = 64 };
+    enum : uint32_t { MASK = LENGTH - 1 };
+public:
+    BlackboxRingBuffer() = default;
+    BlackboxRingBuffer(const BlackboxRingBuffer&) = delete;
+    BlackboxRingBuffer& operator=(const BlackboxRingBuffer&) = delete;
+public:
+    //! called only by the producer, returns false if the buffer is full
+    inline bool push(const T& item) {
+        const uint32_t head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) >= LENGTH) {
+            ++_droppedCount;
+            _overflowCount.store(_overflowCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+        _items[head & MASK] = item;
+        _droppedCounts[head & MASK] = _droppedCount;
+        _droppedCount = 0;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! called only by the consumer, returns false if the buffer is empty
+    inline bool pop(T& item, uint32_t& droppedCount) {
+        const uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = _items[tail & MASK];
+        droppedCount = _droppedCounts[tail & MASK];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    inline bool pop(T& item) { uint32_t droppedCount {}; return pop(item, droppedCount); }
+
+    //! called only by the consumer, returns false if the buffer is empty
+    inline bool peek(T& item) const {
+        const uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = _items[tail & MASK];
+        return true;
+    }
+
+    inline bool isEmpty() const { return _tail.load(std::memory_order_relaxed) == _head.load(std::memory_order_acquire); }
+    inline size_t size() const { return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire); }
+    static constexpr size_t capacity() { return LENGTH; }
+    //! total number of items dropped because the buffer was full
+    inline uint32_t getOverflowCount() const { return _overflowCount.load(std::memory_order_relaxed); }
+private:
+    // written by the producer
+    alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> _head {0};
+    uint32_t _droppedCount {0}; //!< items dropped since the last successful push
+    std::atomic<uint32_t> _overflowCount {0};
+    // written by the consumer
+    alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> _tail {0};
+    // items, written by the producer before _head is released
+    alignas(CACHE_LINE_SIZE) std::array<T, LENGTH> _items {};
+    std::array<uint32_t, LENGTH> _droppedCounts {};
+};
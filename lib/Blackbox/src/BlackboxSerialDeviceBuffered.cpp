@@ -0,0 +1,195 @@
+#include "BlackboxSerialDeviceBuffered.h"
+
+#include <TimeMicroSeconds.h>
+
+
+/*!
+Writes the whole buffer, calling the serial device's write() again if it accepts only part of the buffer.
+If the device stops accepting data (eg it is full or has failed) the rest of the buffer is counted as dropped.
+*/
+bool BlackboxSerialDeviceBuffered::writeFullBuffer()
+{
+    size_t length {};
+    const uint8_t* buffer = _doubleBuffer.acquireFullBuffer(length);
+    if (buffer == nullptr) {
+        return false;
+    }
+    const uint32_t timeMicroSeconds = timeUs();
+    size_t writtenLength = 0;
+    while (writtenLength < length) {
+        const size_t count = _serialDevice.write(buffer + writtenLength, length - writtenLength); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        if (count == 0) {
+            break;
+        }
+        writtenLength += count;
+    }
+    _serialDevice.flush();
+    _doubleBuffer.releaseBuffer(timeUs() - timeMicroSeconds, length - writtenLength);
+    return true;
+}
+
+int32_t BlackboxSerialDeviceBuffered::executeCommand(command_e command)
+{
+    switch (command) {
+    case COMMAND_INIT:
+        return _serialDevice.init();
+    case COMMAND_OPEN:
+        return _serialDevice.open() ? 1 : 0;
+    case COMMAND_CLOSE:
+        _serialDevice.close();
+        return 0;
+    case COMMAND_ERASE_ALL:
+        _serialDevice.eraseAll();
+        return 0;
+    case COMMAND_BEGIN_LOG:
+        return _serialDevice.beginLog() ? 1 : 0;
+    case COMMAND_END_LOG:
+        return _serialDevice.endLog(false) ? 1 : 0;
+    case COMMAND_END_LOG_RETAIN:
+        return _serialDevice.endLog(true) ? 1 : 0;
+    case COMMAND_FLUSH_FORCE_COMPLETE:
+        return _serialDevice.flushForceComplete() ? 1 : 0;
+    case COMMAND_NONE:
+        break;
+    }
+    return 0;
+}
+
+int32_t BlackboxSerialDeviceBuffered::runCommand(command_e command)
+{
+#if defined(FRAMEWORK_USE_FREERTOS)
+    if (_writerTaskHandle != nullptr) {
+        _command.store(command, std::memory_order_release);
+        xTaskNotifyGive(_writerTaskHandle);
+        xSemaphoreTake(_commandComplete, portMAX_DELAY);
+        return _commandResult;
+    }
+#endif
+    return executeCommand(command);
+}
+
+bool BlackboxSerialDeviceBuffered::isErased()
+{
+#if defined(FRAMEWORK_USE_FREERTOS)
+    if (_writerTaskHandle != nullptr) {
+        return _erased.load(std::memory_order_acquire);
+    }
+#endif
+    return _serialDevice.isErased();
+}
+
+bool BlackboxSerialDeviceBuffered::isDeviceFull()
+{
+#if defined(FRAMEWORK_USE_FREERTOS)
+    if (_writerTaskHandle != nullptr) {
+        return _deviceFull.load(std::memory_order_acquire);
+    }
+#endif
+    return _serialDevice.isDeviceFull();
+}
+
+bool BlackboxSerialDeviceBuffered::isDeviceReady()
+{
+#if defined(FRAMEWORK_USE_FREERTOS)
+    if (_writerTaskHandle != nullptr) {
+        return _deviceReady.load(std::memory_order_acquire);
+    }
+#endif
+    return _serialDevice.isDeviceReady();
+}
+
+/*!
+Called regularly by the Blackbox task.
+*/
+bool BlackboxSerialDeviceBuffered::flush()
+{
+#if defined(FRAMEWORK_USE_FREERTOS)
+    if (_writerTaskHandle == nullptr) {
+        writeFullBuffer();
+    }
+#else
+    writeFullBuffer();
+#endif
+    return true;
+}
+
+bool BlackboxSerialDeviceBuffered::flushForce()
+{
+    _doubleBuffer.commitPartialBuffer();
+    flush();
+    return _doubleBuffer.isEmpty();
+}
+
+bool BlackboxSerialDeviceBuffered::flushForceComplete()
+{
+    return flushForce() && runCommand(COMMAND_FLUSH_FORCE_COMPLETE) != 0;
+}
+
+/*!
+All buffered data must be written before the log is ended, so returns false (and is retried) until the buffers are empty.
+*/
+bool BlackboxSerialDeviceBuffered::endLog(bool retainLog)
+{
+    if (!flushForce()) {
+        return false;
+    }
+    return runCommand(retainLog ? COMMAND_END_LOG_RETAIN : COMMAND_END_LOG) != 0;
+}
+
+BlackboxSerialDevice::blackboxBufferReserveStatus_e BlackboxSerialDeviceBuffered::reserveBufferSpace(size_t bytes)
+{
+    if (bytes <= _doubleBuffer.getFreeSpace()) {
+        return BLACKBOX_RESERVE_SUCCESS;
+    }
+    // space becomes available when the writer has finished writing the other buffer
+    return bytes <= double_buffer_t::getBufferSize() ? BLACKBOX_RESERVE_TEMPORARY_FAILURE : BLACKBOX_RESERVE_PERMANENT_FAILURE;
+}
+
+#if defined(FRAMEWORK_USE_FREERTOS)
+void BlackboxSerialDeviceBuffered::updateDeviceStatus()
+{
+    _erased.store(_serialDevice.isErased(), std::memory_order_release);
+    _deviceFull.store(_serialDevice.isDeviceFull(), std::memory_order_release);
+    _deviceReady.store(_serialDevice.isDeviceReady(), std::memory_order_release);
+}
+
+/*!
+The writer task blocks in the serial device's write() while the Blackbox task continues encoding into the other buffer.
+*/
+void BlackboxSerialDeviceBuffered::startWriterTask(UBaseType_t priority, BaseType_t core)
+{
+    _commandComplete = xSemaphoreCreateBinaryStatic(&_commandCompleteBuffer);
+    // set the status before the writer task takes ownership of the device
+    updateDeviceStatus();
+#if defined(FRAMEWORK_ESPIDF) || defined(FRAMEWORK_ARDUINO_ESP32)
+    _writerTaskHandle = xTaskCreateStaticPinnedToCore(writerTask, "BlackboxWriter", WRITER_TASK_STACK_DEPTH, this, priority, &_writerTaskStack[0], &_writerTaskBuffer, core);
+#else
+    (void)core;
+    _writerTaskHandle = xTaskCreateStatic(writerTask, "BlackboxWriter", WRITER_TASK_STACK_DEPTH, this, priority, &_writerTaskStack[0], &_writerTaskBuffer);
+#endif
+}
+
+/*!
+Commands take priority over writing buffers, so the Blackbox task is blocked for at most one buffer write.
+When there is nothing to do the task waits for a command notification, or for one tick, whichever is sooner.
+*/
+[[noreturn]] void BlackboxSerialDeviceBuffered::writerTask(void* arg)
+{
+    auto* self = static_cast<BlackboxSerialDeviceBuffered*>(arg);
+    while (true) {
+        const command_e command = self->_command.load(std::memory_order_acquire);
+        if (command != COMMAND_NONE) {
+            self->_commandResult = self->executeCommand(command);
+            self->updateDeviceStatus();
+            self->_command.store(COMMAND_NONE, std::memory_order_release);
+            xSemaphoreGive(self->_commandComplete);
+            continue;
+        }
+        const bool bufferWritten = self->writeFullBuffer();
+        self->updateDeviceStatus();
+        if (!bufferWritten) {
+            ulTaskNotifyTake(pdTRUE, 1);
+        }
+    }
+}
+#endif
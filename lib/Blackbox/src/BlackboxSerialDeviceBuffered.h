@@ -0,0 +1,103 @@
+#pragma once
+
+#include "BlackboxDoubleBuffer.h"
+
+#include <BlackboxSerialDevice.h>
+
+#if defined(FRAMEWORK_USE_FREERTOS)
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#endif
+#include <atomic>
+
+#if !defined(BLACKBOX_WRITE_BUFFER_SIZE)
+// must be a multiple of the SD card sector size (512 bytes)
+#define BLACKBOX_WRITE_BUFFER_SIZE 4096
+#endif
+
+
+/*!
+Blackbox serial device that double buffers writes to another serial device (typically an SD card).
+
+The Blackbox task encodes into one buffer while the other buffer is written to the device by a separate writer task,
+so SD card write latency spikes do not stall the Blackbox task and cause dropped frames.
+Without FreeRTOS there is no writer task, and full buffers are written from flush().
+
+Once the writer task is started it is the only task that accesses the serial device:
+the other device functions (eg beginLog(), endLog()) are passed to the writer task as commands, and the calling task
+blocks until the writer task has executed the command. The device status (full, ready, erased) is polled by the writer task,
+so checking it does not block the Blackbox task. Commands must only be issued from the Blackbox task.
+
+The write latency histogram and the buffer high water mark are available from getStats(), to allow the buffer size
+(set by BLACKBOX_WRITE_BUFFER_SIZE) to be chosen for a given card.
+*/
+class BlackboxSerialDeviceBuffered : public BlackboxSerialDevice {
+public:
+    typedef BlackboxDoubleBuffer<BLACKBOX_WRITE_BUFFER_SIZE> double_buffer_t;
+    enum { WRITER_TASK_STACK_DEPTH = 4096 };
+public:
+    explicit BlackboxSerialDeviceBuffered(BlackboxSerialDevice& serialDevice) : _serialDevice(serialDevice) {}
+public:
+    enum command_e : uint8_t {
+        COMMAND_NONE,
+        COMMAND_INIT,
+        COMMAND_OPEN,
+        COMMAND_CLOSE,
+        COMMAND_ERASE_ALL,
+        COMMAND_BEGIN_LOG,
+        COMMAND_END_LOG,
+        COMMAND_END_LOG_RETAIN,
+        COMMAND_FLUSH_FORCE_COMPLETE
+    };
+public:
+    virtual int32_t init() override { return runCommand(COMMAND_INIT); }
+    virtual bool open() override { return runCommand(COMMAND_OPEN) != 0; }
+    virtual void close() override { runCommand(COMMAND_CLOSE); }
+    virtual bool flush() override;
+    virtual bool flushForce() override;
+    virtual bool flushForceComplete() override;
+    virtual void eraseAll() override { runCommand(COMMAND_ERASE_ALL); }
+    virtual bool isErased() override;
+    virtual bool isDeviceFull() override;
+    virtual bool isDeviceReady() override;
+    virtual bool beginLog() override { return runCommand(COMMAND_BEGIN_LOG) != 0; }
+    virtual bool endLog(bool retainLog) override;
+    virtual blackboxBufferReserveStatus_e reserveBufferSpace(size_t bytes) override;
+    virtual size_t write(uint8_t value) override { return _doubleBuffer.write(value); }
+    virtual size_t write(const uint8_t* buf, size_t length) override { return _doubleBuffer.write(buf, length); }
+
+    double_buffer_t::stats_t getStats() const { return _doubleBuffer.getStats(); }
+    void resetStats() { _doubleBuffer.resetStats(); }
+    uint32_t getFillPercent() const { return _doubleBuffer.getFillPercent(); }
+#if defined(FRAMEWORK_USE_FREERTOS)
+    void startWriterTask(UBaseType_t priority, BaseType_t core);
+#endif
+private:
+    //! writes a full buffer to the serial device, if one is available, returns true if a buffer was written
+    bool writeFullBuffer();
+    //! executes the command on the serial device, in the task that owns the device
+    int32_t executeCommand(command_e command);
+    //! executes the command in the writer task, if it is running, otherwise in the calling task
+    int32_t runCommand(command_e command);
+#if defined(FRAMEWORK_USE_FREERTOS)
+    void updateDeviceStatus();
+    [[noreturn]] static void writerTask(void* arg);
+#endif
+private:
+    BlackboxSerialDevice& _serialDevice;
+    double_buffer_t _doubleBuffer {};
+#if defined(FRAMEWORK_USE_FREERTOS)
+    // device status, updated by the writer task
+    std::atomic<bool> _erased {false};
+    std::atomic<bool> _deviceFull {false};
+    std::atomic<bool> _deviceReady {false};
+    std::atomic<command_e> _command {COMMAND_NONE};
+    int32_t _commandResult {0};
+    SemaphoreHandle_t _commandComplete {nullptr};
+    StaticSemaphore_t _commandCompleteBuffer {};
+    TaskHandle_t _writerTaskHandle {nullptr};
+    StaticTask_t _writerTaskBuffer {};
+    std::array<StackType_t, WRITER_TASK_STACK_DEPTH> _writerTaskStack {};
+#endif
+};
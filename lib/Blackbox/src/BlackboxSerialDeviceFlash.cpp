@@ -0,0 +1,100 @@
+#include "BlackboxSerialDeviceFlash.h"
+
+
+int32_t BlackboxSerialDeviceFlash::init()
+{
+    return _flashLog.init() ? 1 : 0;
+}
+
+bool BlackboxSerialDeviceFlash::open()
+{
+    return _flashLog.isIndexValid() && !_flashLog.isFull();
+}
+
+void BlackboxSerialDeviceFlash::close()
+{
+    // the log is completed by endLog(), and all data has been programmed by then
+}
+
+/*!
+Called regularly by the Blackbox, programs full pages and erases ahead, but does not program partially filled pages.
+*/
+bool BlackboxSerialDeviceFlash::flush()
+{
+    _flashLog.update();
+    return true;
+}
+
+bool BlackboxSerialDeviceFlash::flushForce()
+{
+    return _flashLog.flush();
+}
+
+bool BlackboxSerialDeviceFlash::flushForceComplete()
+{
+    return _flashLog.flush();
+}
+
+void BlackboxSerialDeviceFlash::eraseAll()
+{
+    _erasing = true;
+    if (_flashLog.eraseAll()) {
+        _erasing = false;
+    }
+}
+
+bool BlackboxSerialDeviceFlash::isErased()
+{
+    if (_erasing && _flashLog.eraseAll()) {
+        _erasing = false;
+    }
+    return !_erasing && _flashLog.getLogCount() == 0;
+}
+
+bool BlackboxSerialDeviceFlash::isDeviceFull()
+{
+    return _flashLog.isFull();
+}
+
+bool BlackboxSerialDeviceFlash::isDeviceReady()
+{
+    return _flashLog.isIndexValid() && !_erasing;
+}
+
+bool BlackboxSerialDeviceFlash::beginLog()
+{
+    // returns false while the flash is busy, the Blackbox retries on its next update
+    return _flashLog.beginLog();
+}
+
+/*!
+Flash logs are always retained, they are removed by eraseAll().
+*/
+bool BlackboxSerialDeviceFlash::endLog(bool retainLog)
+{
+    (void)retainLog;
+    return _flashLog.endLog();
+}
+
+BlackboxSerialDevice::blackboxBufferReserveStatus_e BlackboxSerialDeviceFlash::reserveBufferSpace(size_t bytes)
+{
+    if (bytes <= _flashLog.getFreeBufferSpace()) {
+        return BLACKBOX_RESERVE_SUCCESS;
+    }
+    // the page buffers are emptied in the background, so the space may become available later
+    if (bytes <= static_cast<size_t>(BlackboxFlashLog::PAGE_BUFFER_COUNT) * BlackboxFlashLog::MAX_PAGE_SIZE && !_flashLog.isFull()) {
+        _flashLog.update();
+        return BLACKBOX_RESERVE_TEMPORARY_FAILURE;
+    }
+    return BLACKBOX_RESERVE_PERMANENT_FAILURE;
+}
+
+size_t BlackboxSerialDeviceFlash::write(uint8_t value)
+{
+    return _flashLog.write(value);
+}
+
+size_t BlackboxSerialDeviceFlash::write(const uint8_t* buf, size_t length)
+{
+    return _flashLog.write(buf, length);
+}
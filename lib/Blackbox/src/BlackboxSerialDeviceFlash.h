@@ -0,0 +1,41 @@
+#pragma once
+
+#include "BlackboxFlashLog.h"
+
+#include <BlackboxSerialDevice.h>
+
+
+/*!
+Blackbox serial device that writes to onboard NOR flash, using a BlackboxFlashLog.
+
+Unlike an SD card, writes never block: data is buffered in RAM and programmed to the flash page by page,
+with sectors erased in the background ahead of the write address.
+*/
+class BlackboxSerialDeviceFlash : public BlackboxSerialDevice {
+public:
+    explicit BlackboxSerialDeviceFlash(FlashBase& flash) : _flashLog(flash) {}
+public:
+    virtual int32_t init() override;
+    virtual bool open() override;
+    virtual void close() override;
+    virtual bool flush() override;
+    virtual bool flushForce() override;
+    virtual bool flushForceComplete() override;
+    virtual void eraseAll() override;
+    virtual bool isErased() override;
+    virtual bool isDeviceFull() override;
+    virtual bool isDeviceReady() override;
+    virtual bool beginLog() override;
+    virtual bool endLog(bool retainLog) override;
+    virtual blackboxBufferReserveStatus_e reserveBufferSpace(size_t bytes) override;
+    virtual size_t write(uint8_t value) override;
+    virtual size_t write(const uint8_t* buf, size_t length) override;
+
+    BlackboxFlashLog& getFlashLog() { return _flashLog; }
+    //! percentage of the write queue waiting to be programmed, an input to the BlackboxRateController
+    uint32_t getFillPercent() const { return _flashLog.getBufferFillPercent(); }
+    uint32_t getDroppedByteCount() const { return _flashLog.getDroppedByteCount(); }
+private:
+    BlackboxFlashLog _flashLog;
+    bool _erasing {false};
+};
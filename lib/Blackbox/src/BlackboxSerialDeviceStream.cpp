@@ -0,0 +1,204 @@
+#include "BlackboxSerialDeviceStream.h"
+
+#include <algorithm>
+
+#if defined(FRAMEWORK_RPI_PICO)
+#include <hardware/gpio.h>
+#include <hardware/uart.h>
+#include <tusb.h>
+#elif defined(FRAMEWORK_ESPIDF)
+#elif defined(FRAMEWORK_TEST)
+#else // defaults to FRAMEWORK_ARDUINO
+#include <Arduino.h>
+#endif
+
+
+BlackboxSerialDeviceStream::BlackboxSerialDeviceStream(port_e port, const uart_pins_t& pins, uint32_t baudRate) :
+    _port(port),
+    _pins(pins),
+    _baudRate(baudRate)
+{
+}
+
+BlackboxSerialDeviceStream::BlackboxSerialDeviceStream(port_e port) :
+    BlackboxSerialDeviceStream(port, uart_pins_t{.tx=PIN_NOT_USED,.cts=PIN_NOT_USED}, 0)
+{
+}
+
+/*!
+Configures a UART, if pins were given. USB CDC is run by the framework, so needs no configuration.
+*/
+int32_t BlackboxSerialDeviceStream::init()
+{
+    if (_port == PORT_USB_CDC || _pins.tx == PIN_NOT_USED) {
+        return 0;
+    }
+#if defined(FRAMEWORK_RPI_PICO)
+    uart_inst_t* uart = _port == PORT_UART0 ? uart0 : uart1; // NOLINT(cppcoreguidelines-pro-type-cstyle-cast,performance-no-int-to-ptr)
+    uart_init(uart, _baudRate);
+    gpio_set_function(_pins.tx, GPIO_FUNC_UART);
+    if (_pins.cts != PIN_NOT_USED) {
+        gpio_set_function(_pins.cts, GPIO_FUNC_UART);
+        uart_set_hw_flow(uart, true, false);
+    }
+#elif defined(FRAMEWORK_ESPIDF)
+#elif defined(FRAMEWORK_TEST)
+#else // defaults to FRAMEWORK_ARDUINO
+#if defined(ARDUINO_ARCH_ESP32)
+    HardwareSerial& uart = _port == PORT_UART0 ? Serial1 : Serial2;
+    uart.begin(_baudRate, SERIAL_8N1, -1, _pins.tx);
+    if (_pins.cts != PIN_NOT_USED) {
+        uart.setPins(-1, _pins.tx, _pins.cts, -1);
+        uart.setHwFlowCtrlMode(UART_HW_FLOWCTRL_CTS);
+    }
+#elif defined(ARDUINO_ARCH_RP2040)
+    SerialUART& uart = _port == PORT_UART0 ? Serial1 : Serial2;
+    uart.setTX(_pins.tx);
+    if (_pins.cts != PIN_NOT_USED) {
+        uart.setCTS(_pins.cts);
+    }
+    uart.begin(_baudRate);
+#else
+    // only one UART is supported, on its default pins
+    Serial1.begin(_baudRate);
+#endif
+#endif
+    return 0;
+}
+
+bool BlackboxSerialDeviceStream::isDeviceReady()
+{
+    return isPortConnected();
+}
+
+/*!
+For USB CDC returns true only when a host has opened the port.
+A UART cannot detect whether a host is listening, so returns true for a UART.
+*/
+bool BlackboxSerialDeviceStream::isPortConnected() const
+{
+#if defined(FRAMEWORK_RPI_PICO)
+    return _port == PORT_USB_CDC ? tud_cdc_connected() : true;
+#elif defined(FRAMEWORK_ESPIDF)
+    return false;
+#elif defined(FRAMEWORK_TEST)
+    return true;
+#else // defaults to FRAMEWORK_ARDUINO
+    // on boards with native USB, Serial is true only when the host has asserted DTR
+    return _port == PORT_USB_CDC ? static_cast<bool>(Serial) : true;
+#endif
+}
+
+size_t BlackboxSerialDeviceStream::writeToPort(const uint8_t* data, size_t length)
+{
+#if defined(FRAMEWORK_RPI_PICO)
+    if (_port == PORT_USB_CDC) {
+        const size_t count = std::min(length, static_cast<size_t>(tud_cdc_write_available()));
+        if (count == 0) {
+            return 0;
+        }
+        const size_t written = tud_cdc_write(data, static_cast<uint32_t>(count));
+        tud_cdc_write_flush();
+        return written;
+    }
+    uart_inst_t* uart = _port == PORT_UART0 ? uart0 : uart1; // NOLINT(cppcoreguidelines-pro-type-cstyle-cast,performance-no-int-to-ptr)
+    size_t count = 0;
+    // only write as many bytes as fit in the UART FIFO, which does not drain while CTS is deasserted
+    while (count < length && uart_is_writable(uart)) {
+        uart_putc_raw(uart, static_cast<char>(data[count])); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        ++count;
+    }
+    return count;
+#elif defined(FRAMEWORK_ESPIDF)
+    (void)data;
+    (void)length;
+    return 0;
+#elif defined(FRAMEWORK_TEST)
+    (void)data;
+    return length;
+#else // defaults to FRAMEWORK_ARDUINO
+#if defined(ARDUINO_ARCH_ESP32) || defined(ARDUINO_ARCH_RP2040)
+    Print& port = _port == PORT_USB_CDC ? static_cast<Print&>(Serial) : _port == PORT_UART0 ? static_cast<Print&>(Serial1) : static_cast<Print&>(Serial2);
+#else
+    Print& port = _port == PORT_USB_CDC ? static_cast<Print&>(Serial) : static_cast<Print&>(Serial1);
+#endif
+    const int available = port.availableForWrite();
+    if (available <= 0) {
+        return 0;
+    }
+    return port.write(data, std::min(length, static_cast<size_t>(available)));
+#endif
+}
+
+bool BlackboxSerialDeviceStream::beginLog()
+{
+    _head = 0;
+    _tail = 0;
+    _stats = stats_t {};
+    return true;
+}
+
+/*!
+All buffered data must be sent before the log is ended, so returns false (and is retried) until the buffer is empty.
+*/
+bool BlackboxSerialDeviceStream::endLog(bool retainLog)
+{
+    (void)retainLog;
+    return flushForce();
+}
+
+BlackboxSerialDevice::blackboxBufferReserveStatus_e BlackboxSerialDeviceStream::reserveBufferSpace(size_t bytes)
+{
+    if (bytes <= BUFFER_SIZE - getBufferedByteCount()) {
+        return BLACKBOX_RESERVE_SUCCESS;
+    }
+    return bytes <= BUFFER_SIZE ? BLACKBOX_RESERVE_TEMPORARY_FAILURE : BLACKBOX_RESERVE_PERMANENT_FAILURE;
+}
+
+size_t BlackboxSerialDeviceStream::write(uint8_t value)
+{
+    if (_head - _tail >= BUFFER_SIZE) {
+        ++_stats.droppedByteCount;
+        return 0;
+    }
+    _buffer[_head & (BUFFER_SIZE - 1)] = value; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    ++_head;
+    return 1;
+}
+
+size_t BlackboxSerialDeviceStream::write(const uint8_t* buf, size_t length)
+{
+    const size_t count = std::min(length, BUFFER_SIZE - getBufferedByteCount());
+    for (size_t ii = 0; ii < count; ++ii) {
+        _buffer[(_head + ii) & (BUFFER_SIZE - 1)] = buf[ii]; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    }
+    _head += static_cast<uint32_t>(count);
+    _stats.droppedByteCount += static_cast<uint32_t>(length - count);
+    return count;
+}
+
+/*!
+Called regularly by the Blackbox task. Sends as much buffered data as the port will accept.
+*/
+bool BlackboxSerialDeviceStream::flush()
+{
+    _stats.highWaterMark = std::max(_stats.highWaterMark, static_cast<uint32_t>(getBufferedByteCount()));
+    while (_tail != _head) {
+        // send the contiguous run of data up to the end of the buffer, then (on the next iteration) the data that has wrapped
+        const uint32_t offset = _tail & (BUFFER_SIZE - 1);
+        const size_t length = std::min(static_cast<size_t>(_head - _tail), static_cast<size_t>(BUFFER_SIZE - offset));
+        const size_t written = writeToPort(&_buffer[offset], length); // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+        _tail += static_cast<uint32_t>(written);
+        _stats.byteCount += static_cast<uint32_t>(written);
+        if (written < length) {
+            break;
+        }
+    }
+    return true;
+}
+
+bool BlackboxSerialDeviceStream::flushForce()
+{
+    flush();
+    return _tail == _head;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <BlackboxSerialDevice.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#if !defined(BLACKBOX_STREAM_BUFFER_SIZE)
+// must be a power of two, at 2Mbaud 8kB buffers about 40ms of data
+#define BLACKBOX_STREAM_BUFFER_SIZE 8192
+#endif
+
+
+/*!
+Blackbox serial device that streams the log live over a serial port (USB CDC or UART), so bench tests can capture logs
+directly on a computer. The log format is self delimiting, so the host just saves the stream to a file, and
+BlackboxDecoder::findLogs() splits it into logs.
+
+The port should be dedicated to the log: on Arduino USB CDC is Serial, which is also used for printf and MSP,
+so a UART (with a USB to serial adapter on the host) is normally used.
+A UART is configured by init(), with CTS flow control if a CTS pin is given.
+
+isDeviceReady() is true for USB CDC only when a host has opened the port. A UART cannot detect whether a host is listening,
+so for a UART isDeviceReady() is always true, and the host must start capturing before the log is started.
+
+Writes never block: data is buffered and flush() sends only as much as the port can accept without waiting.
+Flow control comes from the port: USB CDC only accepts data when the host is reading, and a UART should have CTS enabled.
+
+When the link cannot keep up the buffer fills. BlackboxCallbacks passes getFillPercent() and the dropped byte count to the
+BlackboxRateController, which reduces the log rate, and restores it when the buffer drains.
+Data is dropped only if the buffer fills even so, and the decoder resynchronizes on the next I frame.
+*/
+class BlackboxSerialDeviceStream : public BlackboxSerialDevice {
+public:
+    enum { BUFFER_SIZE = BLACKBOX_STREAM_BUFFER_SIZE };
+    static_assert((BUFFER_SIZE & (BUFFER_SIZE - 1)) == 0, "BLACKBOX_STREAM_BUFFER_SIZE must be a power of two");
+    enum port_e : uint8_t { PORT_USB_CDC, PORT_UART0, PORT_UART1 };
+    enum { PIN_NOT_USED = 0xFF };
+    struct uart_pins_t {
+        uint8_t tx;
+        uint8_t cts; //!< PIN_NOT_USED for no flow control
+    };
+    static constexpr uint32_t DEFAULT_BAUD_RATE = 2000000;
+    struct stats_t {
+        uint32_t byteCount;
+        uint32_t droppedByteCount;
+        uint32_t highWaterMark;
+    };
+public:
+    //! pins and baudRate are used only for a UART
+    BlackboxSerialDeviceStream(port_e port, const uart_pins_t& pins, uint32_t baudRate);
+    //! for USB CDC, or for a UART that is configured by the caller
+    explicit BlackboxSerialDeviceStream(port_e port);
+    virtual ~BlackboxSerialDeviceStream() = default;
+    BlackboxSerialDeviceStream(const BlackboxSerialDeviceStream&) = delete;
+    BlackboxSerialDeviceStream& operator=(const BlackboxSerialDeviceStream&) = delete;
+    BlackboxSerialDeviceStream(BlackboxSerialDeviceStream&&) = delete;
+    BlackboxSerialDeviceStream& operator=(BlackboxSerialDeviceStream&&) = delete;
+public:
+    virtual int32_t init() override;
+    virtual bool open() override { return true; }
+    virtual void close() override {}
+    virtual bool flush() override;
+    virtual bool flushForce() override;
+    virtual bool flushForceComplete() override { return flushForce(); }
+    virtual void eraseAll() override {}
+    virtual bool isErased() override { return true; }
+    virtual bool isDeviceFull() override { return false; }
+    virtual bool isDeviceReady() override;
+    virtual bool beginLog() override;
+    virtual bool endLog(bool retainLog) override;
+    virtual blackboxBufferReserveStatus_e reserveBufferSpace(size_t bytes) override;
+    virtual size_t write(uint8_t value) override;
+    virtual size_t write(const uint8_t* buf, size_t length) override;
+
+    port_e getPort() const { return _port; }
+    size_t getBufferedByteCount() const { return _head - _tail; }
+    //! percentage of the buffer waiting to be sent, an input to the BlackboxRateController
+    uint32_t getFillPercent() const { return static_cast<uint32_t>(getBufferedByteCount() * 100 / BUFFER_SIZE); }
+    const stats_t& getStats() const { return _stats; }
+protected:
+    //! writes as much of data as the port can accept without blocking, returns the number of bytes written
+    virtual size_t writeToPort(const uint8_t* data, size_t length);
+    virtual bool isPortConnected() const;
+private:
+    port_e _port;
+    uart_pins_t _pins;
+    uint32_t _baudRate;
+    uint32_t _head {0}; //!< index of next byte to be written into the buffer
+    uint32_t _tail {0}; //!< index of next byte to be sent to the port
+    stats_t _stats {};
+    std::array<uint8_t, BUFFER_SIZE> _buffer {};
+};
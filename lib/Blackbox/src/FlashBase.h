@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+
+/*!
+Abstract NOR flash chip.
+
+eraseSector() and programPage() start the operation and return immediately, the caller polls isReady() to find out
+when the operation has completed. This allows a sector erase (which can take tens of milliseconds) to proceed in the
+background while the caller continues to buffer data.
+
+NOR flash semantics: erasing sets all the bytes in a sector to 0xFF, programming can only change bits from 1 to 0.
+A program operation must not cross a page boundary.
+*/
+class FlashBase {
+public:
+    struct geometry_t {
+        uint32_t pageSize;
+        uint32_t sectorSize;
+        uint32_t sectorCount;
+    };
+    static constexpr uint8_t ERASED_BYTE = 0xFF;
+public:
+    virtual ~FlashBase() = default;
+    FlashBase() = default;
+    FlashBase(const FlashBase&) = delete;
+    FlashBase& operator=(const FlashBase&) = delete;
+    FlashBase(FlashBase&&) = delete;
+    FlashBase& operator=(FlashBase&&) = delete;
+public:
+    const geometry_t& getGeometry() const { return _geometry; }
+    uint32_t getCapacity() const { return _geometry.sectorSize * _geometry.sectorCount; }
+
+    //! returns false if the flash is busy erasing or programming
+    virtual bool isReady() = 0;
+    //! starts erasing the sector containing address
+    virtual void eraseSector(uint32_t address) = 0;
+    //! starts programming length bytes, the range [address, address + length) must be within one page
+    virtual void programPage(uint32_t address, const uint8_t* data, size_t length) = 0;
+    //! blocking read, must only be called when the flash is ready
+    virtual void read(uint32_t address, uint8_t* data, size_t length) = 0;
+protected:
+    geometry_t _geometry {};
+};
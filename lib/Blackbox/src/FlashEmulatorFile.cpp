@@ -0,0 +1,92 @@
+#include "FlashEmulatorFile.h"
+
+#include <vector>
+
+
+FlashEmulatorFile::FlashEmulatorFile(const char* path, const geometry_t& geometry)
+{
+    _geometry = geometry;
+    _file = std::fopen(path, "r+b"); // NOLINT(cppcoreguidelines-owning-memory)
+    if (_file == nullptr) {
+        _file = std::fopen(path, "w+b"); // NOLINT(cppcoreguidelines-owning-memory)
+        if (_file == nullptr) {
+            return;
+        }
+    }
+    // extend the file to the capacity of the flash, new contents are erased
+    std::fseek(_file, 0, SEEK_END);
+    const long fileSize = std::ftell(_file);
+    const long capacity = static_cast<long>(getCapacity());
+    if (fileSize < capacity) {
+        const std::vector<uint8_t> erased(static_cast<size_t>(capacity - fileSize), ERASED_BYTE);
+        std::fwrite(erased.data(), 1, erased.size(), _file);
+        std::fflush(_file);
+    }
+}
+
+FlashEmulatorFile::~FlashEmulatorFile()
+{
+    if (_file != nullptr) {
+        std::fclose(_file); // NOLINT(cppcoreguidelines-owning-memory)
+    }
+}
+
+bool FlashEmulatorFile::isReady()
+{
+    if (_busyCount == 0) {
+        return true;
+    }
+    --_busyCount;
+    return false;
+}
+
+void FlashEmulatorFile::eraseSector(uint32_t address)
+{
+    if (_busyCount != 0) {
+        ++_busyErrorCount;
+    }
+    const uint32_t sectorAddress = address - address % _geometry.sectorSize;
+    const std::vector<uint8_t> erased(_geometry.sectorSize, ERASED_BYTE);
+    std::fseek(_file, static_cast<long>(sectorAddress), SEEK_SET);
+    std::fwrite(erased.data(), 1, erased.size(), _file);
+    std::fflush(_file);
+    ++_eraseCount;
+    _busyCount = _eraseBusyCount;
+}
+
+void FlashEmulatorFile::programPage(uint32_t address, const uint8_t* data, size_t length)
+{
+    if (_busyCount != 0) {
+        ++_busyErrorCount;
+    }
+    const uint32_t pageAddress = address - address % _geometry.pageSize;
+    std::vector<uint8_t> page(_geometry.pageSize);
+    std::fseek(_file, static_cast<long>(pageAddress), SEEK_SET);
+    std::fread(page.data(), 1, page.size(), _file);
+
+    uint32_t offset = address - pageAddress;
+    for (size_t ii = 0; ii < length; ++ii) {
+        const uint8_t value = data[ii]; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        if ((page[offset] & value) != value) {
+            ++_programErrorCount;
+        }
+        page[offset] &= value;
+        // wrap to the start of the page, as real chips do
+        offset = (offset + 1) % _geometry.pageSize;
+    }
+
+    std::fseek(_file, static_cast<long>(pageAddress), SEEK_SET);
+    std::fwrite(page.data(), 1, page.size(), _file);
+    std::fflush(_file);
+    ++_programCount;
+    _busyCount = _programBusyCount;
+}
+
+void FlashEmulatorFile::read(uint32_t address, uint8_t* data, size_t length)
+{
+    if (_busyCount != 0) {
+        ++_busyErrorCount;
+    }
+    std::fseek(_file, static_cast<long>(address), SEEK_SET);
+    std::fread(data, 1, length, _file);
+}
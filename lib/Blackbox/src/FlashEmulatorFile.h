@@ -0,0 +1,49 @@
+#pragma once
+
+#include "FlashBase.h"
+
+#include <cstdio>
+
+
+/*!
+NOR flash emulated using a file, for host testing.
+
+The contents persist in the file, so a test can "power cycle" the flash by creating a new emulator on the same file.
+
+The emulator enforces NOR semantics: programming ANDs the data into the existing contents, and a program that
+crosses a page boundary wraps to the start of the page (as real chips do). Attempts to change a bit from 0 to 1,
+and accesses made while the flash is busy, are counted as errors so tests can check they never happen.
+
+Erase and program operations keep the flash busy for a configurable number of calls to isReady(),
+to emulate the latency of real chips.
+*/
+class FlashEmulatorFile : public FlashBase {
+public:
+    FlashEmulatorFile(const char* path, const geometry_t& geometry);
+    virtual ~FlashEmulatorFile() override;
+    FlashEmulatorFile(const FlashEmulatorFile&) = delete;
+    FlashEmulatorFile& operator=(const FlashEmulatorFile&) = delete;
+    FlashEmulatorFile(FlashEmulatorFile&&) = delete;
+    FlashEmulatorFile& operator=(FlashEmulatorFile&&) = delete;
+public:
+    virtual bool isReady() override;
+    virtual void eraseSector(uint32_t address) override;
+    virtual void programPage(uint32_t address, const uint8_t* data, size_t length) override;
+    virtual void read(uint32_t address, uint8_t* data, size_t length) override;
+
+    void setBusyCounts(uint32_t eraseBusyCount, uint32_t programBusyCount) { _eraseBusyCount = eraseBusyCount; _programBusyCount = programBusyCount; }
+    bool isOpen() const { return _file != nullptr; }
+    uint32_t getEraseCount() const { return _eraseCount; }
+    uint32_t getProgramCount() const { return _programCount; }
+    uint32_t getProgramErrorCount() const { return _programErrorCount; } //!< number of attempts to change a bit from 0 to 1
+    uint32_t getBusyErrorCount() const { return _busyErrorCount; } //!< number of operations started while the flash was busy
+private:
+    std::FILE* _file {nullptr};
+    uint32_t _busyCount {0};
+    uint32_t _eraseBusyCount {0};
+    uint32_t _programBusyCount {0};
+    uint32_t _eraseCount {0};
+    uint32_t _programCount {0};
+    uint32_t _programErrorCount {0};
+    uint32_t _busyErrorCount {0};
+};
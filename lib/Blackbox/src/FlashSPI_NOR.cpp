@@ -0,0 +1,162 @@
+#include "FlashSPI_NOR.h"
+
+#include <array>
+
+#if defined(FRAMEWORK_RPI_PICO)
+#include <hardware/gpio.h>
+#endif
+
+
+FlashSPI_NOR::FlashSPI_NOR(const pins_t& pins) :
+    _pins(pins)
+{
+#if defined(FRAMEWORK_RPI_PICO)
+    // the SPI instance is determined by the SCK pin: GPIOs 0-7 and 16-23 are SPI0, GPIOs 8-15 and 24-29 are SPI1
+    _spi = ((_pins.sck >> 3U) & 1U) ? spi1 : spi0;
+    spi_init(_spi, SPI_FREQUENCY_HZ);
+    gpio_set_function(_pins.sck, GPIO_FUNC_SPI);
+    gpio_set_function(_pins.cipo, GPIO_FUNC_SPI);
+    gpio_set_function(_pins.copi, GPIO_FUNC_SPI);
+    gpio_init(_pins.cs);
+    gpio_set_dir(_pins.cs, GPIO_OUT);
+    gpio_put(_pins.cs, true);
+#elif defined(FRAMEWORK_ARDUINO)
+    _spi = &SPI;
+#if defined(FRAMEWORK_ARDUINO_ESP32)
+    _spi->begin(static_cast<int8_t>(_pins.sck), static_cast<int8_t>(_pins.cipo), static_cast<int8_t>(_pins.copi), static_cast<int8_t>(_pins.cs));
+#else
+    _spi->begin();
+#endif
+    pinMode(_pins.cs, OUTPUT);
+    digitalWrite(_pins.cs, HIGH);
+#endif
+}
+
+void FlashSPI_NOR::select()
+{
+#if defined(FRAMEWORK_RPI_PICO)
+    gpio_put(_pins.cs, false);
+#elif defined(FRAMEWORK_ARDUINO)
+    _spi->beginTransaction(SPISettings(SPI_FREQUENCY_HZ, MSBFIRST, SPI_MODE0));
+    digitalWrite(_pins.cs, LOW);
+#endif
+}
+
+void FlashSPI_NOR::deselect()
+{
+#if defined(FRAMEWORK_RPI_PICO)
+    gpio_put(_pins.cs, true);
+#elif defined(FRAMEWORK_ARDUINO)
+    digitalWrite(_pins.cs, HIGH);
+    _spi->endTransaction();
+#endif
+}
+
+void FlashSPI_NOR::transfer(const uint8_t* data, size_t length)
+{
+#if defined(FRAMEWORK_RPI_PICO)
+    spi_write_blocking(_spi, data, length);
+#elif defined(FRAMEWORK_ARDUINO)
+    for (size_t ii = 0; ii < length; ++ii) {
+        _spi->transfer(data[ii]); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    }
+#else
+    (void)data;
+    (void)length;
+#endif
+}
+
+void FlashSPI_NOR::transferAddress(uint8_t command, uint32_t address)
+{
+    const std::array<uint8_t, 4> buf = {
+        command,
+        static_cast<uint8_t>(address >> 16U),
+        static_cast<uint8_t>(address >> 8U),
+        static_cast<uint8_t>(address)
+    };
+    transfer(&buf[0], buf.size());
+}
+
+void FlashSPI_NOR::writeEnable()
+{
+    const uint8_t command = CMD_WRITE_ENABLE;
+    select();
+    transfer(&command, 1);
+    deselect();
+}
+
+uint32_t FlashSPI_NOR::init()
+{
+    std::array<uint8_t, 3> id {};
+    const uint8_t command = CMD_JEDEC_ID;
+    select();
+    transfer(&command, 1);
+#if defined(FRAMEWORK_RPI_PICO)
+    spi_read_blocking(_spi, 0, &id[0], id.size());
+#elif defined(FRAMEWORK_ARDUINO)
+    for (auto& value : id) {
+        value = _spi->transfer(0);
+    }
+#endif
+    deselect();
+
+    const uint32_t jedecID = (static_cast<uint32_t>(id[0]) << 16U) | (static_cast<uint32_t>(id[1]) << 8U) | id[2];
+    // the third byte of the JEDEC ID is log2 of the capacity in bytes, eg 0x18 for a 16MB W25Q128
+    // 3 byte addressing is used, so capacity is limited to 16MB
+    const uint8_t capacityLog2 = id[2];
+    if (jedecID == 0 || jedecID == 0xFFFFFF || capacityLog2 < 16 || capacityLog2 > 24) {
+        _geometry = {};
+        return 0;
+    }
+    _geometry = { .pageSize = PAGE_SIZE, .sectorSize = SECTOR_SIZE, .sectorCount = (1U << capacityLog2) / SECTOR_SIZE };
+    return jedecID;
+}
+
+bool FlashSPI_NOR::isReady()
+{
+    const uint8_t command = CMD_READ_STATUS_REGISTER_1;
+    uint8_t status = 0;
+    select();
+    transfer(&command, 1);
+#if defined(FRAMEWORK_RPI_PICO)
+    spi_read_blocking(_spi, 0, &status, 1);
+#elif defined(FRAMEWORK_ARDUINO)
+    status = _spi->transfer(0);
+#endif
+    deselect();
+    return (status & STATUS_BUSY) == 0;
+}
+
+void FlashSPI_NOR::eraseSector(uint32_t address)
+{
+    writeEnable();
+    select();
+    transferAddress(CMD_SECTOR_ERASE, address);
+    deselect();
+}
+
+void FlashSPI_NOR::programPage(uint32_t address, const uint8_t* data, size_t length)
+{
+    writeEnable();
+    select();
+    transferAddress(CMD_PAGE_PROGRAM, address);
+    transfer(data, length);
+    deselect();
+}
+
+void FlashSPI_NOR::read(uint32_t address, uint8_t* data, size_t length)
+{
+    select();
+    transferAddress(CMD_READ_DATA, address);
+#if defined(FRAMEWORK_RPI_PICO)
+    spi_read_blocking(_spi, 0, data, length);
+#elif defined(FRAMEWORK_ARDUINO)
+    for (size_t ii = 0; ii < length; ++ii) {
+        data[ii] = _spi->transfer(0); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    }
+#else
+    (void)data;
+    (void)length;
+#endif
+    deselect();
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "FlashBase.h"
+
+#if defined(FRAMEWORK_RPI_PICO)
+#include <hardware/spi.h>
+#elif defined(FRAMEWORK_ARDUINO)
+#include <SPI.h>
+#endif
+
+
+/*!
+JEDEC compatible SPI NOR flash chip, eg Winbond W25Qxx, Macronix MX25Lxx, GigaDevice GD25Qxx.
+
+Uses 4kB sector erase and 256 byte page program. The capacity is read from the JEDEC ID.
+*/
+class FlashSPI_NOR : public FlashBase {
+public:
+    struct pins_t {
+        uint8_t cs;
+        uint8_t sck;
+        uint8_t cipo; // RX, CIPO = Controller In Peripheral Out
+        uint8_t copi; // TX, COPI = Controller Out Peripheral In
+        uint8_t irq;
+    };
+    enum { PAGE_SIZE = 256, SECTOR_SIZE = 4096 };
+    enum { CMD_WRITE_ENABLE = 0x06, CMD_READ_STATUS_REGISTER_1 = 0x05, CMD_PAGE_PROGRAM = 0x02, CMD_SECTOR_ERASE = 0x20, CMD_READ_DATA = 0x03, CMD_JEDEC_ID = 0x9F };
+    enum { STATUS_BUSY = 0x01 };
+    static constexpr uint32_t SPI_FREQUENCY_HZ = 20000000;
+public:
+    explicit FlashSPI_NOR(const pins_t& pins);
+public:
+    //! reads the JEDEC ID and sets the geometry, returns the JEDEC ID (zero if no chip was found)
+    uint32_t init();
+    virtual bool isReady() override;
+    virtual void eraseSector(uint32_t address) override;
+    virtual void programPage(uint32_t address, const uint8_t* data, size_t length) override;
+    virtual void read(uint32_t address, uint8_t* data, size_t length) override;
+private:
+    void select();
+    void deselect();
+    void transfer(const uint8_t* data, size_t length);
+    void transferAddress(uint8_t command, uint32_t address);
+    void writeEnable();
+private:
+    pins_t _pins;
+#if defined(FRAMEWORK_RPI_PICO)
+    spi_inst_t* _spi {};
+#elif defined(FRAMEWORK_ARDUINO)
+    SPIClass* _spi {};
+#endif
+};
@@ -0,0 +1,594 @@
+#include "BlackboxDecoder.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+
+static constexpr std::string_view logStartMarker {"H Product:Blackbox flight data recorder by Nicholas Sherlock\n"};
+static constexpr std::string_view logEndMessage {"End of log"};
+
+// NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic,cppcoreguidelines-pro-bounds-constant-array-index)
+
+std::vector<size_t> BlackboxDecoder::findLogs(const uint8_t* data, size_t size)
+{
+    std::vector<size_t> offsets;
+    const std::string_view text(reinterpret_cast<const char*>(data), size); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+    for (size_t pos = text.find(logStartMarker); pos != std::string_view::npos; pos = text.find(logStartMarker, pos + logStartMarker.size())) {
+        offsets.push_back(pos);
+    }
+    return offsets;
+}
+
+static int32_t parseInt(std::string_view value)
+{
+    int32_t result = 0;
+    bool negative = false;
+    size_t ii = 0;
+    if (!value.empty() && value[0] == '-') {
+        negative = true;
+        ++ii;
+    }
+    for (; ii < value.size() && value[ii] >= '0' && value[ii] <= '9'; ++ii) {
+        result = result * 10 + (value[ii] - '0');
+    }
+    return negative ? -result : result;
+}
+
+template <typename T>
+static void parseList(std::string_view value, std::vector<T>& list)
+{
+    list.clear();
+    while (!value.empty()) {
+        const size_t comma = value.find(',');
+        const std::string_view item = value.substr(0, comma);
+        if constexpr (std::is_same_v<T, std::string_view>) {
+            list.push_back(item);
+        } else {
+            list.push_back(static_cast<T>(parseInt(item)));
+        }
+        if (comma == std::string_view::npos) {
+            break;
+        }
+        value.remove_prefix(comma + 1);
+    }
+}
+
+bool BlackboxDecoder::parseHeader(const uint8_t* begin, const uint8_t* end)
+{
+    _logBegin = begin;
+    _logEnd = end;
+    _headers.clear();
+    for (frame_def_t& frameDef : _frameDefs) {
+        frameDef = frame_def_t {};
+    }
+    _sysConfig = sys_config_t {
+        .dataVersion = 2,
+        .IInterval = 32,
+        .PIntervalNum = 1,
+        .PIntervalDenom = 1,
+        .minthrottle = 1150,
+        .minmotor = 1150,
+        .maxmotor = 2047,
+        .vbatref = 4095,
+        .pidScale = 1
+    };
+
+    const uint8_t* pos = begin;
+    while (end - pos >= 2 && pos[0] == 'H' && pos[1] == ' ') {
+        const uint8_t* lineEnd = static_cast<const uint8_t*>(std::memchr(pos, '\n', static_cast<size_t>(end - pos)));
+        if (lineEnd == nullptr) {
+            return false;
+        }
+        const std::string_view line(reinterpret_cast<const char*>(pos + 2), static_cast<size_t>(lineEnd - pos - 2)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+        const size_t colon = line.find(':');
+        if (colon != std::string_view::npos) {
+            _headers.emplace_back(line.substr(0, colon), line.substr(colon + 1));
+            parseHeaderLine(line.substr(0, colon), line.substr(colon + 1));
+        }
+        pos = lineEnd + 1;
+    }
+    _dataBegin = pos;
+
+    // P frames have the same fields as I frames, only the predictors and encodings differ
+    frame_def_t& interDef = _frameDefs[DEF_INTER];
+    interDef.names = _frameDefs[DEF_INTRA].names;
+    interDef.isSigned = _frameDefs[DEF_INTRA].isSigned;
+
+    for (frame_def_t& frameDef : _frameDefs) {
+        const size_t fieldCount = frameDef.fieldCount();
+        if (fieldCount > MAX_FIELD_COUNT) {
+            return false;
+        }
+        // missing properties default to zero, ie unsigned fields with no prediction, signed variable byte encoded
+        frameDef.isSigned.resize(fieldCount, 0);
+        frameDef.predictors.resize(fieldCount, PREDICT_0);
+        frameDef.encodings.resize(fieldCount, ENCODING_SIGNED_VB);
+    }
+    if (_frameDefs[DEF_INTRA].fieldCount() == 0) {
+        return false;
+    }
+    _motor0Index = getMainFieldIndex("motor[0]");
+    _loopIterationIndex = getMainFieldIndex("loopIteration");
+    _timeIndex = getMainFieldIndex("time");
+    buildFieldGroups();
+    return true;
+}
+
+void BlackboxDecoder::parseHeaderLine(std::string_view name, std::string_view value)
+{
+    static constexpr std::string_view fieldPrefix {"Field "};
+    if (name.substr(0, fieldPrefix.size()) == fieldPrefix && name.size() > fieldPrefix.size() + 2) {
+        frame_def_t* frameDef = nullptr;
+        switch (name[fieldPrefix.size()]) {
+        case FRAME_INTRA: frameDef = &_frameDefs[DEF_INTRA]; break;
+        case FRAME_INTER: frameDef = &_frameDefs[DEF_INTER]; break;
+        case FRAME_SLOW: frameDef = &_frameDefs[DEF_SLOW]; break;
+        case FRAME_GPS: frameDef = &_frameDefs[DEF_GPS]; break;
+        case FRAME_GPS_HOME: frameDef = &_frameDefs[DEF_GPS_HOME]; break;
+        default: return;
+        }
+        const std::string_view property = name.substr(fieldPrefix.size() + 2);
+        if (property == "name") {
+            parseList(value, frameDef->names);
+        } else if (property == "signed") {
+            parseList(value, frameDef->isSigned);
+        } else if (property == "predictor") {
+            parseList(value, frameDef->predictors);
+        } else if (property == "encoding") {
+            parseList(value, frameDef->encodings);
+        }
+        return;
+    }
+    if (name == "Data version") {
+        _sysConfig.dataVersion = static_cast<uint32_t>(parseInt(value));
+    } else if (name == "I interval") {
+        _sysConfig.IInterval = static_cast<uint32_t>(std::max(parseInt(value), 1));
+    } else if (name == "P interval") {
+        // either "num/denom" or, for newer logs, just the denominator
+        const size_t slash = value.find('/');
+        if (slash == std::string_view::npos) {
+            _sysConfig.PIntervalNum = 1;
+            _sysConfig.PIntervalDenom = static_cast<uint32_t>(std::max(parseInt(value), 1));
+        } else {
+            _sysConfig.PIntervalNum = static_cast<uint32_t>(std::max(parseInt(value.substr(0, slash)), 1));
+            _sysConfig.PIntervalDenom = static_cast<uint32_t>(std::max(parseInt(value.substr(slash + 1)), 1));
+        }
+    } else if (name == "minthrottle") {
+        _sysConfig.minthrottle = parseInt(value);
+    } else if (name == "motorOutput") {
+        // "min,max"
+        _sysConfig.minmotor = parseInt(value);
+        const size_t comma = value.find(',');
+        if (comma != std::string_view::npos) {
+            _sysConfig.maxmotor = parseInt(value.substr(comma + 1));
+        }
+    } else if (name == "vbatref") {
+        _sysConfig.vbatref = parseInt(value);
+    } else if (name == "pid_scale") {
+        _sysConfig.pidScale = std::max(parseInt(value), 1);
+    }
+}
+
+std::string_view BlackboxDecoder::getHeaderValue(std::string_view name) const
+{
+    for (const header_t& header : _headers) {
+        if (header.first == name) {
+            return header.second;
+        }
+    }
+    return {};
+}
+
+int BlackboxDecoder::getMainFieldIndex(std::string_view name) const
+{
+    const std::vector<std::string_view>& names = _frameDefs[DEF_INTRA].names;
+    const auto it = std::find(names.begin(), names.end(), name);
+    return it == names.end() ? -1 : static_cast<int>(it - names.begin());
+}
+
+/*!
+The tagged encodings encode several consecutive fields together, so precompute the groups of fields for each frame type.
+This keeps the per-frame decoding loop free of encoding lookahead.
+*/
+void BlackboxDecoder::buildFieldGroups()
+{
+    for (size_t defIndex = 0; defIndex < DEF_COUNT; ++defIndex) {
+        const frame_def_t& frameDef = _frameDefs[defIndex];
+        std::vector<field_group_t>& groups = _fieldGroups[defIndex];
+        groups.clear();
+        const size_t fieldCount = frameDef.fieldCount();
+        for (size_t ii = 0; ii < fieldCount;) {
+            const auto encoding = static_cast<encoding_e>(frameDef.encodings[ii]);
+            size_t groupCount = 1;
+            switch (encoding) {
+            case ENCODING_TAG8_8SVB:
+                while (groupCount < 8 && ii + groupCount < fieldCount && frameDef.encodings[ii + groupCount] == ENCODING_TAG8_8SVB) {
+                    ++groupCount;
+                }
+                break;
+            case ENCODING_TAG2_3S32:
+            case ENCODING_TAG2_3SVARIABLE:
+                groupCount = std::min(static_cast<size_t>(3), fieldCount - ii);
+                break;
+            case ENCODING_TAG8_4S16:
+                groupCount = std::min(static_cast<size_t>(4), fieldCount - ii);
+                break;
+            default:
+                break;
+            }
+            groups.push_back(field_group_t { .encoding = encoding, .firstField = static_cast<uint8_t>(ii), .fieldCount = static_cast<uint8_t>(groupCount) });
+            ii += groupCount;
+        }
+    }
+}
+
+bool BlackboxDecoder::isFrameMarker(int c) const
+{
+    switch (c) {
+    case FRAME_INTRA:
+    case FRAME_INTER:
+    case FRAME_EVENT:
+        return true;
+    case FRAME_SLOW:
+        return _frameDefs[DEF_SLOW].fieldCount() > 0;
+    case FRAME_GPS:
+        return _frameDefs[DEF_GPS].fieldCount() > 0;
+    case FRAME_GPS_HOME:
+        return _frameDefs[DEF_GPS_HOME].fieldCount() > 0;
+    default:
+        return false;
+    }
+}
+
+/*!
+Returns the number of loop iterations, after the last main frame, that were intentionally not logged because of the P interval.
+*/
+uint32_t BlackboxDecoder::countSkippedFrames(uint32_t iteration) const
+{
+    const uint32_t IInterval = _sysConfig.IInterval;
+    const uint32_t PIntervalNum = _sysConfig.PIntervalNum;
+    const uint32_t PIntervalDenom = _sysConfig.PIntervalDenom;
+    uint32_t count = 0;
+    for (uint32_t frameIndex = iteration + 1; count < IInterval; ++frameIndex, ++count) {
+        if ((frameIndex % IInterval + PIntervalNum - 1) % PIntervalDenom < PIntervalNum) {
+            break;
+        }
+    }
+    return count;
+}
+
+void BlackboxDecoder::decodeFields(BlackboxDecoderStream& stream, frame_def_index_e defIndex, values_t& current, const int32_t* previous, const int32_t* previous2, uint32_t skippedFrames)
+{
+    const frame_def_t& frameDef = _frameDefs[defIndex];
+    std::array<int32_t, 8> values {};
+    size_t homeCoordIndex = 0;
+
+    for (const field_group_t& group : _fieldGroups[defIndex]) {
+        switch (group.encoding) {
+        case ENCODING_SIGNED_VB:
+            values[0] = stream.readSignedVB();
+            break;
+        case ENCODING_UNSIGNED_VB:
+            values[0] = static_cast<int32_t>(stream.readUnsignedVB());
+            break;
+        case ENCODING_NEG_14BIT:
+            values[0] = -BlackboxDecoderStream::signExtend(stream.readUnsignedVB(), 14);
+            break;
+        case ENCODING_TAG8_8SVB:
+            stream.readTag8_8SVB(&values[0], group.fieldCount);
+            break;
+        case ENCODING_TAG2_3S32:
+            stream.readTag2_3S32(&values[0]);
+            break;
+        case ENCODING_TAG2_3SVARIABLE:
+            stream.readTag2_3SVariable(&values[0]);
+            break;
+        case ENCODING_TAG8_4S16:
+            stream.readTag8_4S16(&values[0]);
+            break;
+        case ENCODING_NULL:
+            values[0] = 0;
+            break;
+        default:
+            // unknown encoding, so the remainder of the frame cannot be decoded
+            stream.setPos(stream.end());
+            stream.readByte(); // sets eof
+            return;
+        }
+        for (size_t ii = 0; ii < group.fieldCount; ++ii) {
+            const size_t fieldIndex = group.firstField + ii;
+            // predictions are calculated using wrap-around unsigned arithmetic, as on the flight controller
+            auto value = static_cast<uint32_t>(values[ii]);
+            switch (frameDef.predictors[fieldIndex]) {
+            case PREDICT_0:
+                break;
+            case PREDICT_PREVIOUS:
+                if (previous) {
+                    value += static_cast<uint32_t>(previous[fieldIndex]);
+                }
+                break;
+            case PREDICT_STRAIGHT_LINE:
+                if (previous) {
+                    value += 2 * static_cast<uint32_t>(previous[fieldIndex]) - static_cast<uint32_t>(previous2[fieldIndex]);
+                }
+                break;
+            case PREDICT_AVERAGE_2:
+                if (previous) {
+                    if (frameDef.isSigned[fieldIndex]) {
+                        value += static_cast<uint32_t>((static_cast<int64_t>(previous[fieldIndex]) + previous2[fieldIndex]) / 2);
+                    } else {
+                        value += static_cast<uint32_t>((static_cast<uint64_t>(static_cast<uint32_t>(previous[fieldIndex])) + static_cast<uint32_t>(previous2[fieldIndex])) / 2);
+                    }
+                }
+                break;
+            case PREDICT_MINTHROTTLE:
+                value += static_cast<uint32_t>(_sysConfig.minthrottle);
+                break;
+            case PREDICT_MOTOR_0:
+                if (_motor0Index >= 0) {
+                    value += static_cast<uint32_t>(current[static_cast<size_t>(_motor0Index)]);
+                }
+                break;
+            case PREDICT_INC:
+                value += skippedFrames + 1;
+                if (previous) {
+                    value += static_cast<uint32_t>(previous[fieldIndex]);
+                }
+                break;
+            case PREDICT_HOME_COORD:
+                if (_gpsHomeValid && homeCoordIndex < 2) {
+                    value += static_cast<uint32_t>(_gpsHome[homeCoordIndex]);
+                }
+                ++homeCoordIndex;
+                break;
+            case PREDICT_1500:
+                value += 1500;
+                break;
+            case PREDICT_VBATREF:
+                value += static_cast<uint32_t>(_sysConfig.vbatref);
+                break;
+            case PREDICT_LAST_MAIN_FRAME_TIME:
+                value += _lastMainFrameTime;
+                break;
+            case PREDICT_MINMOTOR:
+                value += static_cast<uint32_t>(_sysConfig.minmotor);
+                break;
+            default:
+                break;
+            }
+            current[fieldIndex] = static_cast<int32_t>(value);
+        }
+    }
+}
+
+bool BlackboxDecoder::decodeEvent(BlackboxDecoderStream& stream, event_t& event)
+{
+    event.type = static_cast<event_type_e>(stream.readByte());
+    switch (event.type) {
+    case EVENT_SYNC_BEEP:
+    case EVENT_DISARM:
+        event.data0 = stream.readUnsignedVB();
+        return true;
+    case EVENT_INFLIGHT_ADJUSTMENT: {
+        const uint8_t adjustmentFunction = stream.readByte();
+        if (adjustmentFunction & INFLIGHT_ADJUSTMENT_FLOAT_FLAG) {
+            event.data0 = adjustmentFunction & ~static_cast<uint32_t>(INFLIGHT_ADJUSTMENT_FLOAT_FLAG);
+            const uint32_t bits = stream.readU32();
+            std::memcpy(&event.floatValue, &bits, sizeof(float));
+        } else {
+            event.data0 = adjustmentFunction;
+            event.value = stream.readSignedVB();
+        }
+        return true;
+    }
+    case EVENT_LOGGING_RESUME:
+    case EVENT_FLIGHT_MODE:
+        event.data0 = stream.readUnsignedVB();
+        event.data1 = stream.readUnsignedVB();
+        return true;
+    case EVENT_LOG_END:
+        for (const char c : logEndMessage) {
+            if (stream.readByte() != static_cast<uint8_t>(c)) {
+                return false;
+            }
+        }
+        return stream.readByte() == 0;
+    default:
+        return false;
+    }
+}
+
+void BlackboxDecoder::toOutput(frame_def_index_e defIndex, const values_t& values)
+{
+    const frame_def_t& frameDef = _frameDefs[defIndex];
+    const size_t fieldCount = frameDef.fieldCount();
+    for (size_t ii = 0; ii < fieldCount; ++ii) {
+        _output[ii] = frameDef.isSigned[ii] ? static_cast<int64_t>(values[ii]) : static_cast<int64_t>(static_cast<uint32_t>(values[ii]));
+    }
+}
+
+/*!
+Decodes the frames following the header. Each frame is decoded in full and checked, by looking for a valid frame marker
+immediately after it, before it is passed to the sink, so the sink never sees a frame decoded from corrupt data.
+*/
+BlackboxDecoder::stats_t BlackboxDecoder::decode(BlackboxDecoderSink& sink)
+{
+    stats_t stats {};
+    stats.maxDecimation = 1;
+    stats.byteCount = static_cast<size_t>(_logEnd - _logBegin);
+
+    // the main frame history is held in three buffers, rotated to avoid copying
+    std::array<values_t, 3> history {};
+    size_t currentIndex = 0;
+    size_t previousIndex = 0;
+    size_t previous2Index = 0;
+    bool mainStreamValid = false;
+    _gpsHomeValid = false;
+    _lastMainFrameValid = false;
+    _lastMainFrameIteration = 0;
+    _lastMainFrameTime = 0;
+    values_t slowValues {};
+    values_t gpsValues {};
+    uint32_t eventTime = 0;
+    bool eventTimeValid = false;
+    uint32_t droppedTotal = 0;
+    bool droppedTotalValid = false;
+
+    const size_t mainFieldCount = _frameDefs[DEF_INTRA].fieldCount();
+    sink.logBegin(*this);
+
+    BlackboxDecoderStream stream(_dataBegin, _logEnd);
+    while (!stream.atEnd() && !stats.logEndFound) {
+        const uint8_t* frameStart = stream.pos();
+        const uint8_t frameType = stream.readByte();
+        event_t event {};
+        bool valid = true;
+
+        switch (frameType) {
+        case FRAME_INTRA:
+            decodeFields(stream, DEF_INTRA, history[currentIndex], mainStreamValid ? &history[previousIndex][0] : nullptr, mainStreamValid ? &history[previous2Index][0] : nullptr, 0);
+            break;
+        case FRAME_INTER: {
+            const uint32_t skippedFrames = _lastMainFrameValid ? countSkippedFrames(_lastMainFrameIteration) : 0;
+            decodeFields(stream, DEF_INTER, history[currentIndex], &history[previousIndex][0], &history[previous2Index][0], skippedFrames);
+            break;
+        }
+        case FRAME_SLOW:
+            if (_frameDefs[DEF_SLOW].fieldCount() == 0) {
+                valid = false;
+            } else {
+                decodeFields(stream, DEF_SLOW, slowValues, nullptr, nullptr, 0);
+            }
+            break;
+        case FRAME_GPS:
+            if (_frameDefs[DEF_GPS].fieldCount() == 0) {
+                valid = false;
+            } else {
+                decodeFields(stream, DEF_GPS, gpsValues, nullptr, nullptr, 0);
+            }
+            break;
+        case FRAME_GPS_HOME:
+            if (_frameDefs[DEF_GPS_HOME].fieldCount() == 0) {
+                valid = false;
+            } else {
+                decodeFields(stream, DEF_GPS_HOME, _gpsHome, nullptr, nullptr, 0);
+            }
+            break;
+        case FRAME_EVENT:
+            event.offset = static_cast<size_t>(frameStart - _logBegin);
+            valid = decodeEvent(stream, event);
+            break;
+        default:
+            valid = false;
+            break;
+        }
+
+        // the frame must be complete and be followed by the next frame marker (or the end of the log)
+        if (!valid || stream.eof() || (!stream.atEnd() && !isFrameMarker(stream.peekByte()) && !(frameType == FRAME_EVENT && event.type == EVENT_LOG_END))) {
+            if (isFrameMarker(frameType)) {
+                ++stats.corruptFrameCount;
+            }
+            ++stats.corruptByteCount;
+            mainStreamValid = false;
+            _lastMainFrameValid = false;
+            // resynchronize on the next frame marker
+            stream.setPos(frameStart + 1);
+            while (!stream.atEnd() && !isFrameMarker(stream.peekByte())) {
+                stream.readByte();
+                ++stats.corruptByteCount;
+            }
+            continue;
+        }
+
+        switch (frameType) {
+        case FRAME_INTRA:
+        case FRAME_INTER: {
+            const bool isIntraFrame = frameType == FRAME_INTRA;
+            if (!isIntraFrame && !mainStreamValid) {
+                ++stats.skippedInterFrameCount;
+                break;
+            }
+            const values_t& current = history[currentIndex];
+            if (_loopIterationIndex >= 0) {
+                _lastMainFrameIteration = static_cast<uint32_t>(current[static_cast<size_t>(_loopIterationIndex)]);
+            }
+            if (_timeIndex >= 0) {
+                _lastMainFrameTime = static_cast<uint32_t>(current[static_cast<size_t>(_timeIndex)]);
+            }
+            _lastMainFrameValid = true;
+            toOutput(isIntraFrame ? DEF_INTRA : DEF_INTER, current);
+            sink.mainFrame(&_output[0], mainFieldCount, isIntraFrame);
+            if (isIntraFrame) {
+                ++stats.intraFrameCount;
+                mainStreamValid = true;
+                previousIndex = currentIndex;
+                previous2Index = currentIndex;
+            } else {
+                ++stats.interFrameCount;
+                previous2Index = previousIndex;
+                previousIndex = currentIndex;
+            }
+            // the next frame is decoded into the buffer that is not part of the history
+            currentIndex = 0;
+            while (currentIndex == previousIndex || currentIndex == previous2Index) {
+                ++currentIndex;
+            }
+            break;
+        }
+        case FRAME_SLOW:
+            ++stats.slowFrameCount;
+            toOutput(DEF_SLOW, slowValues);
+            sink.slowFrame(&_output[0], _frameDefs[DEF_SLOW].fieldCount());
+            break;
+        case FRAME_GPS:
+            ++stats.gpsFrameCount;
+            toOutput(DEF_GPS, gpsValues);
+            sink.gpsFrame(&_output[0], _frameDefs[DEF_GPS].fieldCount());
+            break;
+        case FRAME_GPS_HOME:
+            ++stats.gpsHomeFrameCount;
+            _gpsHomeValid = true;
+            break;
+        case FRAME_EVENT:
+            if (event.type == EVENT_INFLIGHT_ADJUSTMENT && event.data0 == ADJUSTMENT_BLACKBOX_EVENT_TIME) {
+                // hold the time for the timed event that follows
+                eventTime = static_cast<uint32_t>(event.value);
+                eventTimeValid = true;
+                break;
+            }
+            if (event.type == EVENT_INFLIGHT_ADJUSTMENT && event.data0 == ADJUSTMENT_BLACKBOX_QUEUE_OVERFLOW_TOTAL) {
+                // hold the total for the queue overflow event that follows
+                droppedTotal = static_cast<uint32_t>(event.value);
+                droppedTotalValid = true;
+                break;
+            }
+            ++stats.eventCount;
+            if (event.type == EVENT_LOGGING_RESUME) {
+                _lastMainFrameIteration = event.data0;
+                _lastMainFrameTime = event.data1;
+            } else if (event.type == EVENT_LOG_END) {
+                stats.logEndFound = true;
+            } else if (event.type == EVENT_INFLIGHT_ADJUSTMENT && event.data0 == ADJUSTMENT_BLACKBOX_DECIMATION) {
+                ++stats.decimationChangeCount;
+                stats.maxDecimation = std::max(stats.maxDecimation, static_cast<uint32_t>(event.value));
+            } else if (event.type == EVENT_INFLIGHT_ADJUSTMENT && event.data0 == ADJUSTMENT_BLACKBOX_QUEUE_OVERFLOW) {
+                // older logs have no total, so accumulate the dropped counts
+                stats.droppedSampleCount = droppedTotalValid ? droppedTotal : stats.droppedSampleCount + static_cast<uint32_t>(event.value);
+                event.data1 = stats.droppedSampleCount;
+            } else if (event.type == EVENT_INFLIGHT_ADJUSTMENT && event.data0 >= ADJUSTMENT_BLACKBOX_EVENT_BASE && event.data0 < ADJUSTMENT_BLACKBOX_QUEUE_OVERFLOW_TOTAL && eventTimeValid) {
+                ++stats.timedEventCount;
+                event.data1 = eventTime;
+            }
+            eventTimeValid = false;
+            droppedTotalValid = false;
+            sink.event(event);
+            break;
+        default:
+            break;
+        }
+    }
+    sink.logEnd(stats);
+    return stats;
+}
+// NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic,cppcoreguidelines-pro-bounds-constant-array-index)
@@ -0,0 +1,203 @@
+#pragma once
+
+#include "BlackboxDecoderStream.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+class BlackboxDecoderSink;
+
+
+/*!
+Host side decoder for Blackbox logs, as written by BlackboxProtoFlight (and by Betaflight).
+
+A log consists of text header lines (written by BlackboxProtoFlight::writeSystemInformation and the Blackbox library),
+followed by binary frames:
+I (intra) frames hold the main state, encoded without reference to previous frames.
+P (inter) frames hold the main state, encoded as differences from predictions based on the previous two main frames.
+S (slow) frames hold slowly changing state, eg flight mode flags.
+G and H frames hold GPS data and the GPS home position.
+E frames hold events, eg in-flight adjustments and the end of the log.
+
+The decoder works directly on the log data (typically a memory mapped file, see BlackboxMappedFile), so nothing is copied:
+header names and values are string_views into the data. Decoded frames are streamed to a BlackboxDecoderSink.
+
+Corrupt frames are detected by checking that each frame is followed by a valid frame marker. When a corrupt frame is found
+the decoder resynchronizes on the next frame marker and discards P frames until the next I frame.
+
+If the log device cannot keep up, the logger reduces its rate (recording each change as an in-flight adjustment event).
+No special decoding is needed, since the time field records the gap between frames, but the changes are counted in the stats.
+
+Timed events are written as a pair of in-flight adjustment events, the first giving the time. The decoder merges each pair,
+so the sink receives a single event with the event type in data0 (offset by ADJUSTMENT_BLACKBOX_EVENT_BASE) and the time in data1.
+Similarly each queue overflow event is preceded by an event giving the total number of samples dropped so far,
+which the decoder passes to the sink in the queue overflow event's data1.
+
+See https://github.com/betaflight/blackbox-log-viewer/blob/master/src/flightlog_parser.js for the reference implementation.
+*/
+class BlackboxDecoder {
+public:
+    enum { MAX_FIELD_COUNT = 128 };
+    enum frame_type_e : uint8_t {
+        FRAME_INTRA = 'I',
+        FRAME_INTER = 'P',
+        FRAME_SLOW = 'S',
+        FRAME_GPS = 'G',
+        FRAME_GPS_HOME = 'H',
+        FRAME_EVENT = 'E'
+    };
+    enum predictor_e : uint8_t {
+        PREDICT_0 = 0,
+        PREDICT_PREVIOUS = 1,
+        PREDICT_STRAIGHT_LINE = 2,
+        PREDICT_AVERAGE_2 = 3,
+        PREDICT_MINTHROTTLE = 4,
+        PREDICT_MOTOR_0 = 5,
+        PREDICT_INC = 6,
+        PREDICT_HOME_COORD = 7,
+        PREDICT_1500 = 8,
+        PREDICT_VBATREF = 9,
+        PREDICT_LAST_MAIN_FRAME_TIME = 10,
+        PREDICT_MINMOTOR = 11
+    };
+    enum encoding_e : uint8_t {
+        ENCODING_SIGNED_VB = 0,
+        ENCODING_UNSIGNED_VB = 1,
+        ENCODING_NEG_14BIT = 3,
+        ENCODING_TAG8_8SVB = 6,
+        ENCODING_TAG2_3S32 = 7,
+        ENCODING_TAG8_4S16 = 8,
+        ENCODING_NULL = 9,
+        ENCODING_TAG2_3SVARIABLE = 10
+    };
+    enum event_type_e : uint8_t {
+        EVENT_SYNC_BEEP = 0,
+        EVENT_INFLIGHT_ADJUSTMENT = 13,
+        EVENT_LOGGING_RESUME = 14,
+        EVENT_DISARM = 15,
+        EVENT_FLIGHT_MODE = 30,
+        EVENT_LOG_END = 255
+    };
+    enum { INFLIGHT_ADJUSTMENT_FLOAT_FLAG = 0x80 };
+    //! in-flight adjustment functions used by BlackboxProtoFlight to record changes in the log, rather than real adjustments
+    enum { ADJUSTMENT_BLACKBOX_DECIMATION = 126, ADJUSTMENT_BLACKBOX_QUEUE_OVERFLOW = 127 };
+    //! timed events (loop overruns, failsafe, mode and PID changes) use functions from ADJUSTMENT_BLACKBOX_EVENT_BASE, each preceded by an event time adjustment
+    enum { ADJUSTMENT_BLACKBOX_EVENT_BASE = 96, ADJUSTMENT_BLACKBOX_EVENT_TIME = 125 };
+    //! each queue overflow event is preceded by an adjustment giving the total number of dropped samples
+    enum { ADJUSTMENT_BLACKBOX_QUEUE_OVERFLOW_TOTAL = 124 };
+    enum frame_def_index_e { DEF_INTRA, DEF_INTER, DEF_SLOW, DEF_GPS, DEF_GPS_HOME, DEF_COUNT };
+    struct frame_def_t {
+        std::vector<std::string_view> names;
+        std::vector<uint8_t> isSigned;
+        std::vector<uint8_t> predictors;
+        std::vector<uint8_t> encodings;
+        size_t fieldCount() const { return names.size(); }
+    };
+    struct sys_config_t {
+        uint32_t dataVersion;
+        uint32_t IInterval;
+        uint32_t PIntervalNum; //!< P frames are logged for PIntervalNum out of every PIntervalDenom loop iterations
+        uint32_t PIntervalDenom;
+        int32_t minthrottle;
+        int32_t minmotor;
+        int32_t maxmotor;
+        int32_t vbatref;
+        int32_t pidScale; //!< PID terms are logged multiplied by pidScale, so divide by pidScale to recover the terms
+    };
+    struct event_t {
+        size_t offset; //!< offset of the event frame from the start of the log
+        event_type_e type;
+        uint32_t data0; //!< sync beep time, adjustment function, resume iteration, disarm reason, or new flight mode flags
+        uint32_t data1; //!< resume time, previous flight mode flags, the time of a timed event, or the total dropped samples of a queue overflow
+        int32_t value; //!< in-flight adjustment integer value
+        float floatValue; //!< in-flight adjustment float value
+    };
+    struct stats_t {
+        size_t byteCount;
+        uint32_t intraFrameCount;
+        uint32_t interFrameCount;
+        uint32_t slowFrameCount;
+        uint32_t gpsFrameCount;
+        uint32_t gpsHomeFrameCount;
+        uint32_t eventCount;
+        uint32_t corruptFrameCount;
+        uint32_t skippedInterFrameCount; //!< P frames discarded because there was no valid I frame to base them on
+        uint32_t decimationChangeCount; //!< number of times the logger changed its rate because the log device could not keep up
+        uint32_t maxDecimation; //!< lowest log rate was one sample in every maxDecimation
+        uint32_t droppedSampleCount; //!< total number of samples dropped because the logger's message queue overflowed
+        uint32_t timedEventCount;
+        size_t corruptByteCount;
+        bool logEndFound;
+    };
+    typedef std::pair<std::string_view, std::string_view> header_t;
+public:
+    //! returns the offsets of the start of each log in data, a file may hold several logs
+    static std::vector<size_t> findLogs(const uint8_t* data, size_t size);
+    //! parses the header of the log that occupies [begin, end), returns false if there is no valid header
+    bool parseHeader(const uint8_t* begin, const uint8_t* end);
+    //! decodes the frames of the log, passing them to sink, parseHeader must have been called first
+    stats_t decode(BlackboxDecoderSink& sink);
+
+    const std::vector<header_t>& getHeaders() const { return _headers; }
+    std::string_view getHeaderValue(std::string_view name) const;
+    const sys_config_t& getSysConfig() const { return _sysConfig; }
+    const frame_def_t& getFrameDef(frame_def_index_e index) const { return _frameDefs[index]; }
+    //! index of the named main frame field, or -1 if there is no such field
+    int getMainFieldIndex(std::string_view name) const;
+private:
+    struct field_group_t {
+        encoding_e encoding;
+        uint8_t firstField;
+        uint8_t fieldCount;
+    };
+    typedef std::array<int32_t, MAX_FIELD_COUNT> values_t;
+    void parseHeaderLine(std::string_view name, std::string_view value);
+    void buildFieldGroups();
+    bool isFrameMarker(int c) const;
+    void decodeFields(BlackboxDecoderStream& stream, frame_def_index_e defIndex, values_t& current, const int32_t* previous, const int32_t* previous2, uint32_t skippedFrames);
+    bool decodeEvent(BlackboxDecoderStream& stream, event_t& event);
+    uint32_t countSkippedFrames(uint32_t iteration) const;
+    void toOutput(frame_def_index_e defIndex, const values_t& values);
+private:
+    const uint8_t* _logBegin {nullptr};
+    const uint8_t* _dataBegin {nullptr}; //!< start of the binary frames, ie end of the header
+    const uint8_t* _logEnd {nullptr};
+    std::vector<header_t> _headers;
+    sys_config_t _sysConfig {};
+    std::array<frame_def_t, DEF_COUNT> _frameDefs;
+    std::array<std::vector<field_group_t>, DEF_COUNT> _fieldGroups;
+    int _motor0Index {-1};
+    int _loopIterationIndex {-1};
+    int _timeIndex {-1};
+    // decoding state
+    values_t _current {};
+    values_t _previous {};
+    values_t _previous2 {};
+    values_t _gpsHome {};
+    bool _gpsHomeValid {false};
+    uint32_t _lastMainFrameIteration {0};
+    uint32_t _lastMainFrameTime {0};
+    bool _lastMainFrameValid {false};
+    std::array<int64_t, MAX_FIELD_COUNT> _output {};
+};
+
+
+/*!
+Receives frames from BlackboxDecoder::decode().
+
+Values are passed as int64_t so that both signed and unsigned 32-bit fields are represented exactly.
+*/
+class BlackboxDecoderSink {
+public:
+    virtual ~BlackboxDecoderSink() = default;
+    virtual void logBegin(const BlackboxDecoder& decoder) { (void)decoder; }
+    virtual void mainFrame(const int64_t* values, size_t valueCount, bool isIntraFrame) = 0;
+    virtual void slowFrame(const int64_t* values, size_t valueCount) { (void)values; (void)valueCount; }
+    virtual void gpsFrame(const int64_t* values, size_t valueCount) { (void)values; (void)valueCount; }
+    virtual void event(const BlackboxDecoder::event_t& event) { (void)event; }
+    virtual void logEnd(const BlackboxDecoder::stats_t& stats) { (void)stats; }
+};
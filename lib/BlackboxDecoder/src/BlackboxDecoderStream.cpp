@@ -0,0 +1,155 @@
+#include "BlackboxDecoderStream.h"
+
+// NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+/*!
+Three values, packed into 2, 4, or 6 bits each, or with a selector byte giving the size in bytes (1 to 4) of each value.
+*/
+void BlackboxDecoderStream::readTag2_3S32(int32_t* values)
+{
+    const uint8_t leadByte = readByte();
+
+    switch (leadByte >> 6U) {
+    case 0: // 2 bits per field
+        values[0] = signExtend(leadByte >> 4U, 2);
+        values[1] = signExtend(leadByte >> 2U, 2);
+        values[2] = signExtend(leadByte, 2);
+        break;
+    case 1: { // 4 bits per field
+        values[0] = signExtend(leadByte, 4);
+        const uint8_t byte1 = readByte();
+        values[1] = signExtend(byte1 >> 4U, 4);
+        values[2] = signExtend(byte1, 4);
+        break;
+    }
+    case 2: // 6 bits per field
+        values[0] = signExtend(leadByte, 6);
+        values[1] = signExtend(readByte(), 6);
+        values[2] = signExtend(readByte(), 6);
+        break;
+    default: { // 8, 16, 24, or 32 bits per field, little endian
+        uint32_t selector = leadByte;
+        for (size_t ii = 0; ii < 3; ++ii, selector >>= 2U) {
+            const uint32_t byteCount = (selector & 0x03U) + 1;
+            uint32_t value = 0;
+            for (uint32_t jj = 0; jj < byteCount; ++jj) {
+                value |= static_cast<uint32_t>(readByte()) << (jj * 8);
+            }
+            values[ii] = byteCount == 4 ? static_cast<int32_t>(value) : signExtend(value, byteCount * 8);
+        }
+        break;
+    }
+    }
+}
+
+/*!
+As readTag2_3S32, but with the 2 and 3 byte forms splitting their bits unequally between the fields (5,5,4 and 8,7,7 bits).
+*/
+void BlackboxDecoderStream::readTag2_3SVariable(int32_t* values)
+{
+    const uint8_t leadByte = readByte();
+
+    switch (leadByte >> 6U) {
+    case 0: // 2 bits per field
+        values[0] = signExtend(leadByte >> 4U, 2);
+        values[1] = signExtend(leadByte >> 2U, 2);
+        values[2] = signExtend(leadByte, 2);
+        break;
+    case 1: { // 5, 5, and 4 bits
+        values[0] = signExtend(leadByte >> 1U, 5);
+        const uint8_t byte1 = readByte();
+        values[1] = signExtend((static_cast<uint32_t>(leadByte & 0x01U) << 4U) | (byte1 >> 4U), 5);
+        values[2] = signExtend(byte1, 4);
+        break;
+    }
+    case 2: { // 8, 7, and 7 bits
+        const uint8_t byte1 = readByte();
+        values[0] = signExtend((static_cast<uint32_t>(leadByte & 0x3FU) << 2U) | (byte1 >> 6U), 8);
+        const uint8_t byte2 = readByte();
+        values[1] = signExtend((static_cast<uint32_t>(byte1 & 0x3FU) << 1U) | (byte2 >> 7U), 7);
+        values[2] = signExtend(byte2, 7);
+        break;
+    }
+    default: {
+        uint32_t selector = leadByte;
+        for (size_t ii = 0; ii < 3; ++ii, selector >>= 2U) {
+            const uint32_t byteCount = (selector & 0x03U) + 1;
+            uint32_t value = 0;
+            for (uint32_t jj = 0; jj < byteCount; ++jj) {
+                value |= static_cast<uint32_t>(readByte()) << (jj * 8);
+            }
+            values[ii] = byteCount == 4 ? static_cast<int32_t>(value) : signExtend(value, byteCount * 8);
+        }
+        break;
+    }
+    }
+}
+
+/*!
+Four values, with a selector byte giving the size of each value (0, 4, 8, or 16 bits).
+Values are packed as a big endian stream of nibbles, so an 8 or 16 bit value may start half way through a byte.
+*/
+void BlackboxDecoderStream::readTag8_4S16(int32_t* values)
+{
+    enum { FIELD_ZERO = 0, FIELD_4BIT = 1, FIELD_8BIT = 2, FIELD_16BIT = 3 };
+
+    uint32_t selector = readByte();
+    bool halfByte = false; // true if the low nibble of buffer has not yet been consumed
+    uint32_t buffer = 0;
+
+    for (size_t ii = 0; ii < 4; ++ii, selector >>= 2U) {
+        switch (selector & 0x03U) {
+        case FIELD_ZERO:
+            values[ii] = 0;
+            break;
+        case FIELD_4BIT:
+            if (halfByte) {
+                values[ii] = signExtend(buffer, 4);
+                halfByte = false;
+            } else {
+                buffer = readByte();
+                values[ii] = signExtend(buffer >> 4U, 4);
+                halfByte = true;
+            }
+            break;
+        case FIELD_8BIT:
+            if (halfByte) {
+                const uint32_t byte1 = readByte();
+                values[ii] = signExtend(((buffer & 0x0FU) << 4U) | (byte1 >> 4U), 8);
+                buffer = byte1;
+            } else {
+                values[ii] = signExtend(readByte(), 8);
+            }
+            break;
+        default: // FIELD_16BIT
+            if (halfByte) {
+                const uint32_t byte1 = readByte();
+                const uint32_t byte2 = readByte();
+                values[ii] = signExtend(((buffer & 0x0FU) << 12U) | (byte1 << 4U) | (byte2 >> 4U), 16);
+                buffer = byte2;
+            } else {
+                const uint32_t byte1 = readByte();
+                const uint32_t byte2 = readByte();
+                values[ii] = signExtend((byte1 << 8U) | byte2, 16);
+            }
+            break;
+        }
+    }
+}
+
+/*!
+Up to 8 values, with a header byte flagging which values are non-zero, followed by the non-zero values as signed variable bytes.
+A single value is written without a header byte.
+*/
+void BlackboxDecoderStream::readTag8_8SVB(int32_t* values, size_t valueCount)
+{
+    if (valueCount == 1) {
+        values[0] = readSignedVB();
+        return;
+    }
+    uint32_t header = readByte();
+    for (size_t ii = 0; ii < valueCount; ++ii, header >>= 1U) {
+        values[ii] = (header & 0x01U) ? readSignedVB() : 0;
+    }
+}
+// NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
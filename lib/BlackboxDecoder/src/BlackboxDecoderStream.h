@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+
+/*!
+Reader for the variable byte and tagged encodings used in Blackbox logs.
+
+Reads directly from the (typically memory mapped) log data, so no data is copied.
+Reading past the end of the data returns zero bytes and sets the end of stream flag, rather than reading out of bounds,
+so the decoder can check for truncated frames once, at the end of each frame, rather than on every byte.
+
+See https://github.com/betaflight/blackbox-log-viewer/blob/master/src/decoders.js for the reference implementation.
+*/
+class BlackboxDecoderStream {
+public:
+    BlackboxDecoderStream(const uint8_t* begin, const uint8_t* end) : _begin(begin), _pos(begin), _end(end) {}
+public:
+    const uint8_t* begin() const { return _begin; }
+    const uint8_t* end() const { return _end; }
+    const uint8_t* pos() const { return _pos; }
+    size_t offset() const { return static_cast<size_t>(_pos - _begin); }
+    void setPos(const uint8_t* pos) { _pos = pos; _eof = false; }
+    bool eof() const { return _eof; }
+    bool atEnd() const { return _pos >= _end; }
+
+    inline int peekByte() const { return _pos < _end ? *_pos : -1; }
+    inline uint8_t readByte() {
+        if (_pos < _end) {
+            return *_pos++; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        }
+        _eof = true;
+        return 0;
+    }
+    inline uint32_t readU32() {
+        uint32_t value = readByte();
+        value |= static_cast<uint32_t>(readByte()) << 8U;
+        value |= static_cast<uint32_t>(readByte()) << 16U;
+        value |= static_cast<uint32_t>(readByte()) << 24U;
+        return value;
+    }
+    inline uint32_t readUnsignedVB() {
+        // 7 bits per byte, least significant first, top bit set on all bytes except the last, at most 5 bytes
+        uint32_t value = 0;
+        for (uint32_t shift = 0; shift < 35; shift += 7) {
+            const uint8_t c = readByte();
+            value |= static_cast<uint32_t>(c & 0x7FU) << shift;
+            if ((c & 0x80U) == 0) {
+                return value;
+            }
+        }
+        // more than 5 bytes, so the stream is corrupt
+        _eof = true;
+        return 0;
+    }
+    inline int32_t readSignedVB() {
+        // zigzag encoded
+        const uint32_t value = readUnsignedVB();
+        return static_cast<int32_t>((value >> 1U) ^ (~(value & 1U) + 1U));
+    }
+
+    void readTag2_3S32(int32_t* values);
+    void readTag2_3SVariable(int32_t* values);
+    void readTag8_4S16(int32_t* values);
+    void readTag8_8SVB(int32_t* values, size_t valueCount);
+
+    static inline int32_t signExtend(uint32_t value, uint32_t bits) {
+        const uint32_t signBit = 1U << (bits - 1);
+        value &= (signBit << 1U) - 1U;
+        return static_cast<int32_t>((value ^ signBit) - signBit);
+    }
+private:
+    const uint8_t* _begin;
+    const uint8_t* _pos;
+    const uint8_t* _end;
+    bool _eof {false};
+};
@@ -0,0 +1,107 @@
+#include "BlackboxExporterCSV.h"
+
+#include <algorithm>
+#include <cstring>
+
+// NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic,cppcoreguidelines-pro-bounds-constant-array-index)
+
+void BlackboxExporterCSV::flush()
+{
+    std::fwrite(&_buffer[0], 1, _length, _file);
+    _length = 0;
+}
+
+void BlackboxExporterCSV::append(const char* text)
+{
+    // text is at most a field name, so always fits in an empty buffer
+    const size_t length = std::strlen(text);
+    if (_length + length > _buffer.size()) {
+        flush();
+    }
+    std::memcpy(&_buffer[_length], text, length);
+    _length += length;
+}
+
+void BlackboxExporterCSV::append(int64_t value)
+{
+    // format backwards into a small buffer, avoids the overhead of snprintf for every value
+    std::array<char, 24> digits {};
+    size_t pos = digits.size();
+    uint64_t magnitude = value < 0 ? static_cast<uint64_t>(0) - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    do {
+        digits[--pos] = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (value < 0) {
+        digits[--pos] = '-';
+    }
+    const size_t length = digits.size() - pos;
+    if (_length + length > _buffer.size()) {
+        flush();
+    }
+    std::memcpy(&_buffer[_length], &digits[pos], length);
+    _length += length;
+}
+
+void BlackboxExporterCSV::logBegin(const BlackboxDecoder& decoder)
+{
+    _length = 0;
+    _slowValid = false;
+    const BlackboxDecoder::frame_def_t& mainDef = decoder.getFrameDef(BlackboxDecoder::DEF_INTRA);
+    const BlackboxDecoder::frame_def_t& slowDef = decoder.getFrameDef(BlackboxDecoder::DEF_SLOW);
+    _slowFieldCount = slowDef.fieldCount();
+
+    std::array<char, 256> name {};
+    bool first = true;
+    for (const std::string_view fieldName : mainDef.names) {
+        const size_t length = std::min(fieldName.size(), name.size() - 1);
+        std::memcpy(&name[0], fieldName.data(), length);
+        name[length] = 0;
+        append(first ? "" : ",");
+        append(&name[0]);
+        first = false;
+    }
+    for (const std::string_view fieldName : slowDef.names) {
+        const size_t length = std::min(fieldName.size(), name.size() - 1);
+        std::memcpy(&name[0], fieldName.data(), length);
+        name[length] = 0;
+        append(",");
+        append(&name[0]);
+    }
+    append("\n");
+}
+
+void BlackboxExporterCSV::mainFrame(const int64_t* values, size_t valueCount, bool isIntraFrame)
+{
+    (void)isIntraFrame;
+    if (_length + MAX_LINE_LENGTH > _buffer.size()) {
+        flush();
+    }
+    for (size_t ii = 0; ii < valueCount; ++ii) {
+        if (ii > 0) {
+            _buffer[_length++] = ',';
+        }
+        append(values[ii]);
+    }
+    for (size_t ii = 0; ii < _slowFieldCount; ++ii) {
+        _buffer[_length++] = ',';
+        if (_slowValid) {
+            append(_slowValues[ii]);
+        }
+    }
+    _buffer[_length++] = '\n';
+}
+
+void BlackboxExporterCSV::slowFrame(const int64_t* values, size_t valueCount)
+{
+    std::memcpy(&_slowValues[0], values, valueCount * sizeof(int64_t));
+    _slowValid = true;
+}
+
+void BlackboxExporterCSV::logEnd(const BlackboxDecoder::stats_t& stats)
+{
+    (void)stats;
+    flush();
+    std::fflush(_file);
+}
+// NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic,cppcoreguidelines-pro-bounds-constant-array-index)
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "BlackboxDecoder.h"
+
+#include <array>
+#include <cstdio>
+
+
+/*!
+Writes decoded main frames as CSV, one row per main frame.
+
+The most recent values of the slow frame fields are appended to each row, so each row is self contained.
+Rows are formatted into a large buffer, without using printf, and the buffer is written to the file when it is nearly full.
+*/
+class BlackboxExporterCSV : public BlackboxDecoderSink {
+public:
+    enum { BUFFER_SIZE = 65536, MAX_LINE_LENGTH = 12 * 2 * BlackboxDecoder::MAX_FIELD_COUNT };
+public:
+    explicit BlackboxExporterCSV(std::FILE* file) : _file(file) {}
+public:
+    virtual void logBegin(const BlackboxDecoder& decoder) override;
+    virtual void mainFrame(const int64_t* values, size_t valueCount, bool isIntraFrame) override;
+    virtual void slowFrame(const int64_t* values, size_t valueCount) override;
+    virtual void logEnd(const BlackboxDecoder::stats_t& stats) override;
+private:
+    void append(const char* text);
+    void append(int64_t value);
+    void flush();
+private:
+    std::FILE* _file;
+    size_t _length {0};
+    size_t _slowFieldCount {0};
+    bool _slowValid {false};
+    std::array<int64_t, BlackboxDecoder::MAX_FIELD_COUNT> _slowValues {};
+    std::array<char, BUFFER_SIZE> _buffer {};
+};
@@ -0,0 +1,82 @@
+#include "BlackboxExporterColumnar.h"
+
+#include <cstring>
+
+// NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic,cppcoreguidelines-pro-bounds-constant-array-index)
+
+void BlackboxExporterColumnar::writeU32(uint32_t value)
+{
+    const std::array<uint8_t, 4> bytes { static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8U), static_cast<uint8_t>(value >> 16U), static_cast<uint8_t>(value >> 24U) };
+    std::fwrite(&bytes[0], 1, bytes.size(), _file);
+}
+
+void BlackboxExporterColumnar::logBegin(const BlackboxDecoder& decoder)
+{
+    const BlackboxDecoder::frame_def_t& mainDef = decoder.getFrameDef(BlackboxDecoder::DEF_INTRA);
+    const BlackboxDecoder::frame_def_t& slowDef = decoder.getFrameDef(BlackboxDecoder::DEF_SLOW);
+    _mainFieldCount = mainDef.fieldCount();
+    _columnCount = _mainFieldCount + slowDef.fieldCount();
+    _rowCount = 0;
+    _slowValues.fill(0);
+    _columns.assign(_columnCount * ROW_GROUP_SIZE, 0);
+
+    std::fwrite(&MAGIC[0], 1, MAGIC.size(), _file);
+    writeU32(static_cast<uint32_t>(_columnCount));
+    for (const BlackboxDecoder::frame_def_t* frameDef : { &mainDef, &slowDef }) {
+        for (size_t ii = 0; ii < frameDef->fieldCount(); ++ii) {
+            const std::string_view name = frameDef->names[ii];
+            const std::array<uint8_t, 2> nameLength { static_cast<uint8_t>(name.size()), static_cast<uint8_t>(name.size() >> 8U) };
+            std::fwrite(&nameLength[0], 1, nameLength.size(), _file);
+            std::fwrite(name.data(), 1, name.size(), _file);
+            std::fputc(frameDef->isSigned[ii] ? 1 : 0, _file);
+        }
+    }
+}
+
+void BlackboxExporterColumnar::mainFrame(const int64_t* values, size_t valueCount, bool isIntraFrame)
+{
+    (void)isIntraFrame;
+    for (size_t ii = 0; ii < valueCount; ++ii) {
+        _columns[ii * ROW_GROUP_SIZE + _rowCount] = static_cast<int32_t>(values[ii]);
+    }
+    for (size_t ii = _mainFieldCount; ii < _columnCount; ++ii) {
+        _columns[ii * ROW_GROUP_SIZE + _rowCount] = _slowValues[ii - _mainFieldCount];
+    }
+    ++_rowCount;
+    if (_rowCount == ROW_GROUP_SIZE) {
+        writeRowGroup();
+    }
+}
+
+void BlackboxExporterColumnar::slowFrame(const int64_t* values, size_t valueCount)
+{
+    for (size_t ii = 0; ii < valueCount; ++ii) {
+        _slowValues[ii] = static_cast<int32_t>(values[ii]);
+    }
+}
+
+void BlackboxExporterColumnar::writeRowGroup()
+{
+    writeU32(static_cast<uint32_t>(_rowCount));
+    for (size_t ii = 0; ii < _columnCount; ++ii) {
+        int32_t* column = &_columns[ii * ROW_GROUP_SIZE];
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+        for (size_t jj = 0; jj < _rowCount; ++jj) {
+            column[jj] = static_cast<int32_t>(__builtin_bswap32(static_cast<uint32_t>(column[jj])));
+        }
+#endif
+        std::fwrite(column, sizeof(int32_t), _rowCount, _file);
+    }
+    _rowCount = 0;
+}
+
+void BlackboxExporterColumnar::logEnd(const BlackboxDecoder::stats_t& stats)
+{
+    (void)stats;
+    if (_rowCount > 0) {
+        writeRowGroup();
+    }
+    writeU32(0);
+    std::fflush(_file);
+}
+// NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic,cppcoreguidelines-pro-bounds-constant-array-index)
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "BlackboxDecoder.h"
+
+#include <array>
+#include <cstdio>
+#include <vector>
+
+
+/*!
+Writes decoded main frames in a simple columnar binary format, for fast loading into analysis tools (eg numpy.fromfile).
+
+Like Parquet, rows are grouped, and within each row group the values of each column are stored contiguously.
+Unlike Parquet there is no compression or encoding, so the format has no external dependencies.
+As with BlackboxExporterCSV, the most recent values of the slow frame fields are appended to each row.
+
+All integers are little endian.
+    header:     "BBCOL001", uint32_t columnCount, then for each column: uint16_t nameLength, name, uint8_t isSigned
+    row group:  uint32_t rowCount, then for each column: rowCount int32_t values (interpret as uint32_t if not isSigned)
+    end:        uint32_t 0, ie an empty row group
+*/
+class BlackboxExporterColumnar : public BlackboxDecoderSink {
+public:
+    enum { ROW_GROUP_SIZE = 16384 };
+    static constexpr std::array<char, 8> MAGIC { 'B', 'B', 'C', 'O', 'L', '0', '0', '1' };
+public:
+    explicit BlackboxExporterColumnar(std::FILE* file) : _file(file) {}
+public:
+    virtual void logBegin(const BlackboxDecoder& decoder) override;
+    virtual void mainFrame(const int64_t* values, size_t valueCount, bool isIntraFrame) override;
+    virtual void slowFrame(const int64_t* values, size_t valueCount) override;
+    virtual void logEnd(const BlackboxDecoder::stats_t& stats) override;
+private:
+    void writeU32(uint32_t value);
+    void writeRowGroup();
+private:
+    std::FILE* _file;
+    size_t _mainFieldCount {0};
+    size_t _columnCount {0};
+    size_t _rowCount {0};
+    std::array<int32_t, BlackboxDecoder::MAX_FIELD_COUNT> _slowValues {};
+    std::vector<int32_t> _columns; //!< column major, column c of row r is at c * ROW_GROUP_SIZE + r
+};
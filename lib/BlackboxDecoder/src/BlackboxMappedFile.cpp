@@ -0,0 +1,60 @@
+#include "BlackboxMappedFile.h"
+
+#include <cstdio>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define BLACKBOX_USE_MMAP
+#endif
+
+
+BlackboxMappedFile::BlackboxMappedFile(const char* path)
+{
+#if defined(BLACKBOX_USE_MMAP)
+    const int fd = ::open(path, O_RDONLY); // NOLINT(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+    if (fd < 0) {
+        return;
+    }
+    struct stat fileStat {};
+    if (::fstat(fd, &fileStat) == 0 && fileStat.st_size > 0) {
+        _size = static_cast<size_t>(fileStat.st_size);
+        void* data = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) { // NOLINT(cppcoreguidelines-pro-type-cstyle-cast,performance-no-int-to-ptr)
+            // the decoder reads the file from start to end
+            ::madvise(data, _size, MADV_SEQUENTIAL);
+            _data = static_cast<const uint8_t*>(data);
+            _mapped = true;
+        }
+    }
+    ::close(fd);
+    if (_mapped) {
+        return;
+    }
+    _size = 0;
+#endif
+    std::FILE* file = std::fopen(path, "rb"); // NOLINT(cppcoreguidelines-owning-memory)
+    if (file == nullptr) {
+        return;
+    }
+    std::fseek(file, 0, SEEK_END);
+    const long fileSize = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+    if (fileSize > 0) {
+        _buffer.resize(static_cast<size_t>(fileSize));
+        _size = std::fread(_buffer.data(), 1, _buffer.size(), file);
+        _data = _buffer.data();
+    }
+    std::fclose(file); // NOLINT(cppcoreguidelines-owning-memory)
+}
+
+BlackboxMappedFile::~BlackboxMappedFile()
+{
+#if defined(BLACKBOX_USE_MMAP)
+    if (_mapped) {
+        ::munmap(const_cast<uint8_t*>(_data), _size); // NOLINT(cppcoreguidelines-pro-type-const-cast)
+    }
+#endif
+}
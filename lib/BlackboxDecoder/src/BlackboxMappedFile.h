@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+/*!
+Read only view of a file, for decoding Blackbox logs on the host.
+
+On POSIX systems the file is memory mapped, so long logs are decoded without first being read into memory,
+and pages are only brought in as the decoder reaches them. Elsewhere the file is read into a buffer.
+*/
+class BlackboxMappedFile {
+public:
+    explicit BlackboxMappedFile(const char* path);
+    ~BlackboxMappedFile();
+    BlackboxMappedFile(const BlackboxMappedFile&) = delete;
+    BlackboxMappedFile& operator=(const BlackboxMappedFile&) = delete;
+    BlackboxMappedFile(BlackboxMappedFile&&) = delete;
+    BlackboxMappedFile& operator=(BlackboxMappedFile&&) = delete;
+public:
+    bool isOpen() const { return _data != nullptr; }
+    const uint8_t* data() const { return _data; }
+    size_t size() const { return _size; }
+private:
+    const uint8_t* _data {nullptr};
+    size_t _size {0};
+    bool _mapped {false};
+    std::vector<uint8_t> _buffer; //!< holds the file contents when memory mapping is not available
+};
@@ -2,6 +2,7 @@
 
 #include <AHRS.h>
 #include <Blackbox.h> // just needed for //_blackbox->finish() and endlog()
+#include <BlackboxEventQueue.h>
 
 #if !defined(UNIT_TEST_BUILD)
 //#define SERIAL_OUTPUT
@@ -12,6 +13,7 @@
 #include <RadioController.h>
 #include <ReceiverBase.h>
 #include <TimeMicroSeconds.h>
+#include <algorithm>
 
 #if defined(FRAMEWORK_ARDUINO_ESP32)
 #include <esp32-hal.h>
@@ -47,8 +49,62 @@ Integration is switched off, so that there is no integral windup before takeoff.
 */
 void FlightController::setPID_Constants(pid_index_e pidIndex, const PIDF::PIDF_t& pid)
 {
+    const PIDF_uint16_t previous = _eventQueue ? getPID_MSP(pidIndex) : PIDF_uint16_t {};
     _PIDS[pidIndex].setPID(pid);
     _PIDS[pidIndex].switchIntegrationOff();
+    postPID_Changes(pidIndex, previous);
+}
+
+void FlightController::setPID_P_MSP(pid_index_e pidIndex, uint16_t kp)
+{
+    const PIDF_uint16_t previous = _eventQueue ? getPID_MSP(pidIndex) : PIDF_uint16_t {};
+    _PIDS[pidIndex].setP(kp * _scaleFactors[pidIndex].kp);
+    postPID_Changes(pidIndex, previous);
+}
+
+void FlightController::setPID_I_MSP(pid_index_e pidIndex, uint16_t ki)
+{
+    const PIDF_uint16_t previous = _eventQueue ? getPID_MSP(pidIndex) : PIDF_uint16_t {};
+    _PIDS[pidIndex].setI(ki * _scaleFactors[pidIndex].ki);
+    postPID_Changes(pidIndex, previous);
+}
+
+void FlightController::setPID_D_MSP(pid_index_e pidIndex, uint16_t kd)
+{
+    const PIDF_uint16_t previous = _eventQueue ? getPID_MSP(pidIndex) : PIDF_uint16_t {};
+    _PIDS[pidIndex].setD(kd * _scaleFactors[pidIndex].kd);
+    postPID_Changes(pidIndex, previous);
+}
+
+void FlightController::setPID_F_MSP(pid_index_e pidIndex, uint16_t kf)
+{
+    const PIDF_uint16_t previous = _eventQueue ? getPID_MSP(pidIndex) : PIDF_uint16_t {};
+    _PIDS[pidIndex].setF(kf * _scaleFactors[pidIndex].kf);
+    postPID_Changes(pidIndex, previous);
+}
+
+/*!
+Posts an event to the blackbox for each term of the PID that differs from previous, so in-flight tuning changes are recorded in the log.
+*/
+void FlightController::postPID_Changes(pid_index_e pidIndex, const PIDF_uint16_t& previous)
+{
+    if (_eventQueue == nullptr) {
+        return;
+    }
+    const uint32_t timeMicroSeconds = timeUs();
+    const PIDF_uint16_t current = getPID_MSP(pidIndex);
+    if (current.kp != previous.kp) {
+        _eventQueue->post(BlackboxEventQueue::EVENT_PID_CHANGE, BlackboxEventQueue::pidChangeValue(pidIndex, BlackboxEventQueue::PID_TERM_P, current.kp), timeMicroSeconds);
+    }
+    if (current.ki != previous.ki) {
+        _eventQueue->post(BlackboxEventQueue::EVENT_PID_CHANGE, BlackboxEventQueue::pidChangeValue(pidIndex, BlackboxEventQueue::PID_TERM_I, current.ki), timeMicroSeconds);
+    }
+    if (current.kd != previous.kd) {
+        _eventQueue->post(BlackboxEventQueue::EVENT_PID_CHANGE, BlackboxEventQueue::pidChangeValue(pidIndex, BlackboxEventQueue::PID_TERM_D, current.kd), timeMicroSeconds);
+    }
+    if (current.kf != previous.kf) {
+        _eventQueue->post(BlackboxEventQueue::EVENT_PID_CHANGE, BlackboxEventQueue::pidChangeValue(pidIndex, BlackboxEventQueue::PID_TERM_F, current.kf), timeMicroSeconds);
+    }
 }
 
 uint32_t FlightController::getOutputPowerTimeMicroSeconds() const
@@ -143,6 +199,9 @@ void FlightController::setControlMode(control_mode_e controlMode)
         return;
     }
     _controlMode = controlMode;
+    if (_eventQueue) {
+        _eventQueue->post(BlackboxEventQueue::EVENT_CONTROL_MODE, controlMode, timeUs());
+    }
     // reset the PID integral values when we change control mode
     for (auto& pid : _PIDS) {
         pid.resetIntegral();
@@ -209,7 +268,9 @@ flight_controller_quadcopter_telemetry_t FlightController::getTelemetryData() co
 {
     flight_controller_quadcopter_telemetry_t telemetry;
 
-    for (size_t ii = 0; ii < _mixer.getMotorCount(); ++ ii) {
+    // telemetry only has space for the first MOTOR_COUNT motors
+    const size_t motorCount = std::min(_mixer.getMotorCount(), telemetry.motors.size());
+    for (size_t ii = 0; ii < motorCount; ++ ii) {
         telemetry.motors[ii].power = _mixer.getMotorOutput(ii);
         telemetry.motors[ii].rpm = _mixer.getMotorRPM(ii);
     }
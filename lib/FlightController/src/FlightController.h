@@ -13,6 +13,7 @@
 
 class AHRS;
 class Blackbox;
+class BlackboxEventQueue;
 class Debug;
 class RadioControllerBase;
 class Quaternion;
@@ -128,6 +129,8 @@ public:
     void motorsToggleOnOff();
     inline bool motorsIsDisabled() const { return _mixer.motorsIsDisabled(); }
     void setBlackbox(Blackbox& blackbox) { _blackbox = &blackbox; }
+    //! control mode and PID changes are posted to eventQueue, so they are recorded in the blackbox log
+    void setBlackboxEventQueue(BlackboxEventQueue* eventQueue) { _eventQueue = eventQueue; }
 
     inline control_mode_e getControlMode() const { return _controlMode; }
     void setControlMode(control_mode_e controlMode);
@@ -153,10 +156,10 @@ public:
     void setPID_Constants(pid_index_e pidIndex, const PIDF::PIDF_t& pid);
 
     virtual PIDF_uint16_t getPID_MSP(size_t index) const override;
-    void setPID_P_MSP(pid_index_e pidIndex, uint16_t kp) { _PIDS[pidIndex].setP(kp * _scaleFactors[pidIndex].kp); }
-    void setPID_I_MSP(pid_index_e pidIndex, uint16_t ki) { _PIDS[pidIndex].setI(ki * _scaleFactors[pidIndex].ki); }
-    void setPID_D_MSP(pid_index_e pidIndex, uint16_t kd) { _PIDS[pidIndex].setD(kd * _scaleFactors[pidIndex].kd); }
-    void setPID_F_MSP(pid_index_e pidIndex, uint16_t kf) { _PIDS[pidIndex].setF(kf * _scaleFactors[pidIndex].kf); }
+    void setPID_P_MSP(pid_index_e pidIndex, uint16_t kp);
+    void setPID_I_MSP(pid_index_e pidIndex, uint16_t ki);
+    void setPID_D_MSP(pid_index_e pidIndex, uint16_t kd);
+    void setPID_F_MSP(pid_index_e pidIndex, uint16_t kf);
 
     inline float getPID_Setpoint(pid_index_e pidIndex) const { return _PIDS[pidIndex].getSetpoint(); }
     void setPID_Setpoint(pid_index_e pidIndex, float setpoint) { _PIDS[pidIndex].setSetpoint(setpoint); }
@@ -186,12 +189,14 @@ public:
     virtual void outputToMixer(float deltaT, uint32_t tickCount, const VehicleControllerMessageQueue::queue_item_t& queueItem) override;
 private:
     MotorMixerBase& motorMixer(uint32_t taskIntervalMicroSeconds);
+    void postPID_Changes(pid_index_e pidIndex, const PIDF_uint16_t& previous);
 private:
     static constexpr float degreesToRadians { static_cast<float>(M_PI) / 180.0F };
     MotorMixerBase& _mixer;
     RadioControllerBase& _radioController;
     Debug& _debug;
     Blackbox* _blackbox {nullptr};
+    BlackboxEventQueue* _eventQueue {nullptr};
     const uint32_t _taskDenominator;
     uint32_t _taskSignalledCount {0};
     control_mode_e _controlMode {CONTROL_MODE_RATE};
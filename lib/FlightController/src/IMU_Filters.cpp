@@ -1,6 +1,7 @@
 #include "IMU_Filters.h"
 #include <MotorMixerBase.h>
 #include <RPM_Filters.h>
+#include <algorithm>
 
 
 IMU_Filters::IMU_Filters(const MotorMixerBase& motorMixer, float looptimeSeconds) :
@@ -13,6 +14,8 @@ IMU_Filters::IMU_Filters(const MotorMixerBase& motorMixer, float looptimeSeconds
 void IMU_Filters::setRPM_Filters(RPM_Filters* rpmFilters)
 {
     _rpmFilters = rpmFilters;
+    // the RPM filters may support fewer motors than the mixer (see RPM_Filters::MAX_MOTOR_COUNT)
+    _motorCount = std::min(_motorMixer.getMotorCount(), _rpmFilters->getMotorCount());
     constexpr float defaultQ = 5.0F;
     _rpmFilters->init(RPM_Filters::USE_FUNDAMENTAL_ONLY, defaultQ);
     _rpmFilters->setMinimumFrequencyHz(_config.rpm_filter_min_hz);
@@ -83,7 +86,7 @@ Execution time varies, however, and may take up to about 50 microseconds.
 void IMU_Filters::setFilters()
 {
     if (_rpmFilters && _filterFromAHRS) {
-        _rpmFilters->setFrequencyHz(_motorIndex, _motorMixer.getMotorFrequencyHz(_motorIndex));
+        _rpmFilters->setFrequencyHz(_motorIndex, _motorMixer.getMotorFrequencyHz(_motorIndex), _motorMixer.getMotorFrequencyWeight(_motorIndex));
         ++_motorIndex;
         if (_motorIndex==_motorCount) {
             _motorIndex = 0;
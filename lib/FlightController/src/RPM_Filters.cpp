@@ -29,14 +29,18 @@ void RPM_Filters::init(uint32_t harmonicToUse, float Q)
 
 /*!
 This is called from withing AHRS::readIMUandUpdateOrientation() (ie the main IMU/PID loop) and so needs to be FAST.
+
+telemetryWeight is in the range [0, 1] and is used to fade out the filters when the motor's RPM telemetry is stale or unreliable.
 */
-void RPM_Filters::setFrequencyHz(size_t motorIndex, float frequencyHz)
+void RPM_Filters::setFrequencyHz(size_t motorIndex, float frequencyHz, float telemetryWeight)
 {
     const float frequencyHzUnclipped = frequencyHz;
     frequencyHz = clip(frequencyHz, _minFrequencyHz, _maxFrequencyHz);
 
     const float marginFrequencyHz = frequencyHz - _minFrequencyHz;
-    const float weightMultiplier = (marginFrequencyHz < _fadeRangeHz) ? marginFrequencyHz / _fadeRangeHz : 1.0F;
+    const float weightMultiplier = telemetryWeight * ((marginFrequencyHz < _fadeRangeHz) ? marginFrequencyHz / _fadeRangeHz : 1.0F);
+    _frequenciesHz[motorIndex] = frequencyHz; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    _weightMultipliers[motorIndex] = weightMultiplier; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
 
     BiquadFilterT<xyz_t>& rpmFilter = _filters[motorIndex][FUNDAMENTAL]; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
 
@@ -61,7 +65,7 @@ void RPM_Filters::setFrequencyHz(size_t motorIndex, float frequencyHz)
         return;
     }
 
-    rpmFilter = _filters[motorIndex][HARMONIC]; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    BiquadFilterT<xyz_t>& rpmFilterHarmonic = _filters[motorIndex][HARMONIC]; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
 
     if (_harmonicToUse == USE_FUNDAMENTAL_AND_SECOND_HARMONIC) {
         if (frequencyHzUnclipped > _halfOfMaxFrequencyHz) { // ie 2.0F * frequencyHzUnclipped > _maxFrequencyHz
@@ -76,7 +80,7 @@ void RPM_Filters::setFrequencyHz(size_t motorIndex, float frequencyHz)
         const float two_cos_2Omega = two_cosOmega * two_cosOmega - 2.0F;
         weight = _weights[HARMONIC]*weightMultiplier;
         LOCK_FILTERS();
-        rpmFilter.setNotchFrequencyWeighted(sin_2Omega, two_cos_2Omega, weight);
+        rpmFilterHarmonic.setNotchFrequencyWeighted(sin_2Omega, two_cos_2Omega, weight);
         UNLOCK_FILTERS();
         return;
     }
@@ -99,7 +103,7 @@ void RPM_Filters::setFrequencyHz(size_t motorIndex, float frequencyHz)
     const float two_cos_3Omega = two_cosOmega * (four_cosSquaredOmega - 3.0F);
     weight = _weights[HARMONIC]*weightMultiplier;
     LOCK_FILTERS();
-    rpmFilter.setNotchFrequencyWeighted(sin_3Omega, two_cos_3Omega, weight);
+    rpmFilterHarmonic.setNotchFrequencyWeighted(sin_3Omega, two_cos_3Omega, weight);
     UNLOCK_FILTERS();
 }
 
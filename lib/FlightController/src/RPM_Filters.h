@@ -32,14 +32,21 @@ for 3-bladed propellors.
 class RPM_Filters {
 public:
     enum { FUNDAMENTAL = 0, HARMONIC = 1, MAX_HARMONICS_COUNT = 2 };
+#if defined(USE_EIGHT_MOTORS)
+    enum { MAX_MOTOR_COUNT = 8 };
+#else
     enum { MAX_MOTOR_COUNT = 4 };
+#endif
     enum { USE_FUNDAMENTAL_ONLY = 0, USE_FUNDAMENTAL_AND_SECOND_HARMONIC = 1, USE_FUNDAMENTAL_AND_THIRD_HARMONIC = 2 };
 public:
-    RPM_Filters(size_t motorCount, float looptimeSeconds) : _motorCount(motorCount), _looptimeSeconds(looptimeSeconds) {}
+    RPM_Filters(size_t motorCount, float looptimeSeconds) : _motorCount(motorCount < MAX_MOTOR_COUNT ? motorCount : static_cast<size_t>(MAX_MOTOR_COUNT)), _looptimeSeconds(looptimeSeconds) {}
     void init(uint32_t harmonicToUse, float Q);
     void setHarmonicToUse(uint8_t harmonicToUse) {_harmonicToUse = harmonicToUse; }
     void setMinimumFrequencyHz(float minFrequencyHz) { _minFrequencyHz = minFrequencyHz; }
-    void setFrequencyHz(size_t motorIndex, float frequencyHz);
+    void setFrequencyHz(size_t motorIndex, float frequencyHz, float telemetryWeight);
+    void setFrequencyHz(size_t motorIndex, float frequencyHz) { setFrequencyHz(motorIndex, frequencyHz, 1.0F); }
+    float getFrequencyHz(size_t motorIndex) const { return _frequenciesHz[motorIndex]; } // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    float getWeight(size_t motorIndex) const { return _weightMultipliers[motorIndex]; } // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
     void filter(xyz_t& input, size_t motorIndex);
     size_t getMotorCount() const { return _motorCount; }
 
@@ -58,6 +65,8 @@ private:
     float _thirdOfMaxFrequencyHz {};
     float _fadeRangeHz { 50.0F };
     float _Q { 0.0F };
+    std::array<float, MAX_MOTOR_COUNT> _frequenciesHz {}; //!< fundamental frequency of each motor's notch filters, after clipping
+    std::array<float, MAX_MOTOR_COUNT> _weightMultipliers {}; //!< weight multiplier of each motor's notch filters
     BiquadFilterT<xyz_t> _filters[MAX_MOTOR_COUNT][MAX_HARMONICS_COUNT];
 #if defined(FRAMEWORK_USE_FREERTOS)
 #if false
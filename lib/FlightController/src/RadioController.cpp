@@ -1,5 +1,7 @@
 #include "FlightController.h"
 #include "RadioController.h"
+#include <BlackboxEventQueue.h>
+#include <TimeMicroSeconds.h>
 #include <cmath>
 
 RadioController::RadioController(ReceiverBase& receiver, const rates_t& rates) :
@@ -17,10 +19,12 @@ void RadioController::setFlightController(FlightController* flightController)
 
 void RadioController::setRatesToPassThrough()
 {
-    _rates.rcRates = { 100, 100, 100 }; // center sensitivity
-    _rates.rcExpos = { 0, 0, 0}; // movement sensitivity, nonlinear
-    _rates.rates   = { 0, 0, 0 }; // movement sensitivity, linear
-    _rates.ratesType = RATES_TYPE_ACTUAL;
+    rates_t rates = _rates;
+    rates.rcRates = { 100, 100, 100 }; // center sensitivity
+    rates.rcExpos = { 0, 0, 0}; // movement sensitivity, nonlinear
+    rates.rates   = { 0, 0, 0 }; // movement sensitivity, linear
+    rates.ratesType = RATES_TYPE_ACTUAL;
+    setRates(rates);
 }
 
 inline float constrain(float value, int16_t limit)
@@ -64,7 +68,7 @@ void RadioController::updateControls(const controls_t& controls)
 {
     // failsafe handling
     _receiverInUse = true;
-    _failsafePhase = FAILSAFE_IDLE; // we've received a packet, so exit failsafe if we were in it
+    setFailsafePhase(FAILSAFE_IDLE); // we've received a packet, so exit failsafe if we were in it
 
     // handle the on/off switch
     if (_receiver.getSwitch(ReceiverBase::MOTOR_ON_OFF_SWITCH)) {
@@ -104,6 +108,37 @@ void RadioController::setFailsafe(const failsafe_t& failsafe)
     _failsafe = failsafe;
 }
 
+/*!
+Failsafe transitions are posted to the blackbox event queue, so the exact time of loss and recovery of the receiver is in the log.
+*/
+void RadioController::setFailsafePhase(failsafe_phase_e failsafePhase)
+{
+    if (failsafePhase == _failsafePhase) {
+        return;
+    }
+    _failsafePhase = failsafePhase;
+    if (_eventQueue) {
+        _eventQueue->post(BlackboxEventQueue::EVENT_FAILSAFE, failsafePhase, timeUs());
+    }
+}
+
+/*!
+Rates changes are posted to the blackbox event queue, setting the rates to their current values is not a change and is not posted.
+*/
+void RadioController::setRates(const rates_t& rates)
+{
+    if (rates.rateLimits == _rates.rateLimits && rates.rcRates == _rates.rcRates && rates.rcExpos == _rates.rcExpos && rates.rates == _rates.rates
+        && rates.throttleMidpoint == _rates.throttleMidpoint && rates.throttleExpo == _rates.throttleExpo
+        && rates.throttleLimitType == _rates.throttleLimitType && rates.throttleLimitPercent == _rates.throttleLimitPercent
+        && rates.ratesType == _rates.ratesType) {
+        return;
+    }
+    _rates = rates;
+    if (_eventQueue) {
+        _eventQueue->post(BlackboxEventQueue::EVENT_RATES_CHANGE, rates.ratesType, timeUs());
+    }
+}
+
 void RadioController::checkFailsafe(uint32_t tickCount)
 {
     _flightController->detectCrashOrSpin();
@@ -112,7 +147,7 @@ void RadioController::checkFailsafe(uint32_t tickCount)
         // _receiverInUse is initialized to false, so the motors won't turn off it the transmitter hasn't been turned on yet.
         // We've had 1500 ticks (1.5 seconds) without a packet, so we seem to have lost contact with the transmitter,
         // so enter failsafe mode.
-        _failsafePhase = FAILSAFE_RX_LOSS_DETECTED;
+        setFailsafePhase(FAILSAFE_RX_LOSS_DETECTED);
         if ((tickCount - _failsafeTickCount > _failsafeTickCountSwitchOffThreshold)) {
             _flightController->motorsSwitchOff();
             _receiverInUse = false; // set to false to allow us to switch the motors on again if we regain a signal
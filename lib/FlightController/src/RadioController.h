@@ -6,6 +6,7 @@
 #include <cstddef>
 #include <cstdint>
 
+class BlackboxEventQueue;
 class FlightController;
 
 class RadioController : public RadioControllerBase {
@@ -47,6 +48,8 @@ public:
     RadioController(ReceiverBase& receiver, const rates_t& rates);
 
     void setFlightController(FlightController* flightController);
+    //! failsafe transitions and rates changes are posted to eventQueue, so they are recorded in the blackbox log
+    void setBlackboxEventQueue(BlackboxEventQueue* eventQueue) { _eventQueue = eventQueue; }
 
     virtual void updateControls(const controls_t& controls) override;
     virtual uint32_t getFailsafePhase() const override;
@@ -56,12 +59,15 @@ public:
     void setFailsafe(const failsafe_t& failsafe);
 
     rates_t getRates() const { return _rates; }
-    void setRates(const rates_t& rates) { _rates = rates; }
+    void setRates(const rates_t& rates);
     void setRatesToPassThrough();
     float applyRates(size_t axis, float rcCommand) const;
     float mapThrottle(float throttle) const;
+private:
+    void setFailsafePhase(failsafe_phase_e failsafePhase);
 private:
     FlightController* _flightController {};
+    BlackboxEventQueue* _eventQueue {nullptr};
     rates_t _rates;
     int32_t _onOffSwitchPressed {false}; // on/off switch debouncing
     float _maxRollAngleDegrees { 60.0F }; // used for angle mode
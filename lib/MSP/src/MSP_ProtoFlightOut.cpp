@@ -12,6 +12,7 @@
 #include <MSP_protocol.h>
 #include <RadioController.h>
 #include <ReceiverBase.h>
+#include <algorithm>
 
 const char* const targetName = "TARGETNAME";
 
@@ -206,6 +207,23 @@ MSP_Base::result_e MSP_ProtoFlight::processOutCommand(int16_t cmdMSP, StreamBuf&
         }
         break;
 
+    case MSP_MOTOR_TELEMETRY: {
+        const MotorMixerBase& mixer = _flightController.getMixer();
+        enum { MAX_SUPPORTED_MOTORS = 8 };
+        const auto motorCount = static_cast<uint8_t>(std::min(mixer.getMotorCount(), static_cast<size_t>(MAX_SUPPORTED_MOTORS)));
+        dst.writeU8(motorCount);
+        for (size_t ii = 0; ii < motorCount; ++ii) {
+            const esc_telemetry_t telemetry = mixer.getMotorTelemetry(ii);
+            dst.writeU32(static_cast<uint32_t>(telemetry.rpm));
+            dst.writeU16(telemetry.invalidPercent());
+            dst.writeU8(telemetry.temperatureCelsius);
+            dst.writeU16(telemetry.voltageCentiVolts);
+            dst.writeU16(telemetry.currentCentiAmps);
+            dst.writeU16(0); // consumption in mAh, not available
+        }
+        break;
+    }
+
     case MSP_RC: {
         const ReceiverBase::controls_pwm_t controls = _receiver.getControlsPWM();
         dst.writeU16(controls.throttle);
@@ -8,10 +8,22 @@
 #if defined(LIBRARY_RECEIVER_USE_ESPNOW)
 #include <BackchannelTransceiverESPNOW.h>
 #endif
+#include <BlackboxBurstCapture.h>
+#include <BlackboxBurstCaptureWriter.h>
 #include <BlackboxCallbacks.h>
+#include <BlackboxEventQueue.h>
 #include <BlackboxMessageQueueAHRS.h>
 #include <BlackboxProtoFlight.h>
+#include <BlackboxRateController.h>
+#if defined(USE_BLACKBOX_FLASH)
+#include <BlackboxSerialDeviceFlash.h>
+#include <FlashSPI_NOR.h>
+#elif defined(USE_BLACKBOX_STREAM)
+#include <BlackboxSerialDeviceStream.h>
+#else
+#include <BlackboxSerialDeviceBuffered.h>
 #include <BlackboxSerialDeviceSDCard.h>
+#endif
 #include <BlackboxTask.h>
 #if defined(M5_UNIFIED)
 #include <ButtonsM5.h>
@@ -26,11 +38,13 @@
 #include <MSP_ProtoFlight.h>
 #include <MSP_Serial.h>
 #include <MSP_Task.h>
+#include <MotorMixerMatrixDShot.h>
 #include <MotorMixerQuadX_DShot.h>
 #include <MotorMixerQuadX_DShotBitbang.h>
 #include <MotorMixerQuadX_PWM.h>
 #include <NonVolatileStorage.h>
 #include <RPM_Filters.h>
+#include <RPM_Limiter.h>
 #include <RadioController.h>
 #include <ReceiverAtomJoyStick.h>
 #include <ReceiverNull.h>
@@ -66,6 +80,10 @@ void Main::setup()
 
     // Statically allocate the debug object
     static Debug debug;
+#if defined(DEBUG_MODE)
+    // set before anything is logged, and before the mode is written in the blackbox header
+    debug.setMode(DEBUG_MODE);
+#endif
     static NonVolatileStorage nvs;
     nvs.init();
 
@@ -117,7 +135,20 @@ void Main::setup()
 
     // Statically allocate the MotorMixer object as defined by the build flags.
 #if defined(USE_MOTOR_MIXER_QUAD_X_PWM)
+#if defined(USE_MOTOR_PROTOCOL_ONESHOT125) || defined(USE_MOTOR_PROTOCOL_ONESHOT42)
+    static_assert(MotorMixerQuadX_PWM::ONESHOT_IMPLEMENTED, "Oneshot is only implemented for RPI Pico and for Arduino on ESP32");
+#elif defined(USE_MOTOR_PROTOCOL_MULTISHOT)
+    static_assert(MotorMixerQuadX_PWM::MULTISHOT_IMPLEMENTED, "Multishot is only implemented for RPI Pico");
+#endif
+#if defined(USE_MOTOR_PROTOCOL_ONESHOT125)
+    static MotorMixerQuadX_PWM motorMixer(debug, MotorMixerQuadX_Base::MOTOR_PINS, MotorMixerQuadX_PWM::PROTOCOL_ONESHOT125);
+#elif defined(USE_MOTOR_PROTOCOL_ONESHOT42)
+    static MotorMixerQuadX_PWM motorMixer(debug, MotorMixerQuadX_Base::MOTOR_PINS, MotorMixerQuadX_PWM::PROTOCOL_ONESHOT42);
+#elif defined(USE_MOTOR_PROTOCOL_MULTISHOT)
+    static MotorMixerQuadX_PWM motorMixer(debug, MotorMixerQuadX_Base::MOTOR_PINS, MotorMixerQuadX_PWM::PROTOCOL_MULTISHOT);
+#else
     static MotorMixerQuadX_PWM motorMixer(debug, MotorMixerQuadX_Base::MOTOR_PINS);
+#endif
 #elif defined(USE_MOTOR_MIXER_QUAD_X_DSHOT)
     enum { MOTOR_COUNT = 4 };
     static RPM_Filters rpmFilters(MOTOR_COUNT, AHRS_TASK_INTERVAL_MICROSECONDS);
@@ -125,8 +156,41 @@ void Main::setup()
 #if defined(FRAMEWORK_ARDUINO_STM32)
     static MotorMixerQuadX_DShotBitbang motorMixer(debug, MotorMixerQuadX_Base::MOTOR_PINS, rpmFilters, dynamicIdleController);
 #else
+#if !defined(USE_DSHOT_RPI_PICO_PIO) && !defined(USE_DSHOT_ESP32_RMT)
+    static_assert(ESC_DShotBatch::OUTPUT_IMPLEMENTED, "unidirectional DShot is only implemented for RPI Pico, for ESP32 define USE_DSHOT_ESP32_RMT");
+#endif
     static MotorMixerQuadX_DShot motorMixer(debug, MotorMixerQuadX_Base::MOTOR_PINS, rpmFilters, dynamicIdleController);
 #endif
+#if defined(USE_MOTOR_RPM_CONTROL)
+    // mixer outputs are per-motor RPM targets, requires bidirectional DShot
+    motorMixer.setRPM_ControlEnabled(true, decltype(motorMixer)::DEFAULT_MAX_MOTOR_HZ);
+#endif
+#if defined(USE_RPM_LIMITER)
+    static RPM_Limiter rpmLimiter(nvs.RPM_LimiterConfigLoad(), AHRS_taskIntervalMicroSeconds / FC_TASK_DENOMINATOR, debug);
+    motorMixer.setRPM_Limiter(&rpmLimiter);
+#endif
+#if defined(USE_DYNAMIC_IDLE)
+    motorMixer.setMotorOutputMin(0.0F);
+#else
+    motorMixer.setMotorOutputMin(0.055F); // 5.5%
+#endif
+#elif defined(USE_MOTOR_MIXER_MATRIX_DSHOT)
+    // MOTOR_MIXER_MATRIX is one of the MotorMixMatrices, eg MotorMixMatrices::HEX_X, and MOTOR_MIXER_MATRIX_PINS lists its motor pins
+    typedef MotorMixerMatrixDShot<decltype(MOTOR_MIXER_MATRIX)::MOTOR_COUNT, decltype(MOTOR_MIXER_MATRIX)::SERVO_COUNT> motor_mixer_t;
+#if !defined(USE_DSHOT_RPI_PICO_PIO) && !defined(USE_DSHOT_ESP32_RMT)
+    static_assert(ESC_DShotBatch::OUTPUT_IMPLEMENTED, "unidirectional DShot is only implemented for RPI Pico, for ESP32 define USE_DSHOT_ESP32_RMT");
+#endif
+    static RPM_Filters rpmFilters(decltype(MOTOR_MIXER_MATRIX)::MOTOR_COUNT, AHRS_TASK_INTERVAL_MICROSECONDS);
+    static DynamicIdleController dynamicIdleController(nvs.DynamicIdleControllerConfigLoad(), AHRS_taskIntervalMicroSeconds / FC_TASK_DENOMINATOR, debug);
+    static motor_mixer_t motorMixer(MOTOR_MIXER_MATRIX, debug, motor_mixer_t::pins_t MOTOR_MIXER_MATRIX_PINS, rpmFilters, dynamicIdleController);
+#if defined(USE_MOTOR_RPM_CONTROL)
+    // mixer outputs are per-motor RPM targets, requires bidirectional DShot
+    motorMixer.setRPM_ControlEnabled(true, motor_mixer_t::DEFAULT_MAX_MOTOR_HZ);
+#endif
+#if defined(USE_RPM_LIMITER)
+    static RPM_Limiter rpmLimiter(nvs.RPM_LimiterConfigLoad(), AHRS_taskIntervalMicroSeconds / FC_TASK_DENOMINATOR, debug);
+    motorMixer.setRPM_Limiter(&rpmLimiter);
+#endif
 #if defined(USE_DYNAMIC_IDLE)
     motorMixer.setMotorOutputMin(0.0F);
 #else
@@ -139,7 +203,7 @@ void Main::setup()
     // statically allocate the IMU_Filters
     static IMU_Filters imuFilters(motorMixer, AHRS_taskIntervalMicroSeconds);
     imuFilters.setConfig(nvs.ImuFiltersConfigLoad());
-#if defined(USE_MOTOR_MIXER_QUAD_X_DSHOT)
+#if defined(USE_MOTOR_MIXER_QUAD_X_DSHOT) || defined(USE_MOTOR_MIXER_MATRIX_DSHOT)
     imuFilters.setRPM_Filters(&rpmFilters);
 #endif
 
@@ -164,17 +228,69 @@ void Main::setup()
     // Statically allocate the Blackbox and associated objects
 #if defined(USE_BLACKBOX) || defined(USE_BLACKBOX_DEBUG)
     static BlackboxMessageQueue         blackboxMessageQueue;
+#if defined(USE_BLACKBOX_HIGH_PRECISION)
+    // log PID terms and motor outputs at higher resolution, for tuning sessions
+    blackboxMessageQueue.setFieldScale(BlackboxMessageQueue::FIELD_SCALE_HIGH_PRECISION);
+#endif
     static BlackboxCallbacks            blackboxCallbacks(blackboxMessageQueue, ahrs, flightController, radioController, receiver, debug);
-    static BlackboxSerialDeviceSDCard   blackboxSerialDevice(BlackboxSerialDeviceSDCard::SDCARD_SPI_PINS);
+    // events posted from any task (loop overruns, failsafe, mode and PID changes) are written to the log with their time
+    static BlackboxEventQueue           blackboxEventQueue;
+    blackboxCallbacks.setEventQueue(&blackboxEventQueue);
+    flightController.setBlackboxEventQueue(&blackboxEventQueue);
+    radioController.setBlackboxEventQueue(&blackboxEventQueue);
+    // log at the full rate, reducing the rate only if the log device cannot keep up
+    static BlackboxRateController       blackboxRateController;
+#if defined(USE_BLACKBOX_FLASH)
+    static FlashSPI_NOR                 flash(FlashSPI_NOR::FLASH_SPI_PINS);
+    flash.init();
+    static BlackboxSerialDeviceFlash    blackboxSerialDevice(flash);
+    blackboxSerialDevice.init();
+    blackboxCallbacks.setRateController(&blackboxRateController, &blackboxSerialDevice);
+#elif defined(USE_BLACKBOX_STREAM)
+    // stream the log live, over a UART dedicated to the log by default, since USB is used for printf and MSP
+#if !defined(BLACKBOX_STREAM_PORT)
+    static_assert(false && "BLACKBOX_STREAM_PORT not specified");
+#elif defined(BLACKBOX_STREAM_UART_PINS)
+    static BlackboxSerialDeviceStream   blackboxSerialDevice(BlackboxSerialDeviceStream::BLACKBOX_STREAM_PORT, BlackboxSerialDeviceStream::BLACKBOX_STREAM_UART_PINS, BlackboxSerialDeviceStream::DEFAULT_BAUD_RATE);
+#else
+    static BlackboxSerialDeviceStream   blackboxSerialDevice(BlackboxSerialDeviceStream::BLACKBOX_STREAM_PORT);
+#endif
+    blackboxSerialDevice.init();
+    blackboxCallbacks.setRateController(&blackboxRateController, &blackboxSerialDevice);
+#else
+    static BlackboxSerialDeviceSDCard   blackboxSerialDeviceSDCard(BlackboxSerialDeviceSDCard::SDCARD_SPI_PINS);
+    // double buffer the SD card, so SD card write latency does not stall the Blackbox task
+    static BlackboxSerialDeviceBuffered blackboxSerialDevice(blackboxSerialDeviceSDCard);
+    blackboxCallbacks.setRateController(&blackboxRateController, &blackboxSerialDevice);
+#endif
     static BlackboxProtoFlight          blackbox(blackboxCallbacks, blackboxMessageQueue, blackboxSerialDevice, flightController, radioController, imuFilters);
+    blackboxCallbacks.setBlackbox(&blackbox);
 
-    static BlackboxMessageQueueAHRS     blackboxMessageQueueAHRS(blackboxMessageQueue);
+    static BlackboxMessageQueueAHRS     blackboxMessageQueueAHRS(blackboxMessageQueue, flightController, receiver, debug);
+    blackboxMessageQueueAHRS.setEventQueue(&blackboxEventQueue, AHRS_taskIntervalMicroSeconds);
     ahrs.setMessageQueue(&blackboxMessageQueueAHRS);
+#if defined(USE_BLACKBOX_BURST_CAPTURE)
+    // capture unfiltered gyro at the full AHRS rate around a throttle punch, written to the blackbox device after landing
+#if !defined(USE_AHRS_TASK_INTERRUPT_DRIVEN_SCHEDULING)
+    // a gyro only sample is 3 int16_t values, at 8kHz a 2 second window needs a BLACKBOX_BURST_CAPTURE_SIZE of 96kB
+    static_assert(static_cast<uint32_t>(BlackboxBurstCapture::WORD_COUNT) / 3 >= 2 * 1000000 / AHRS_TASK_INTERVAL_MICROSECONDS, "burst capture window is less than 2 seconds, increase BLACKBOX_BURST_CAPTURE_SIZE in build_flags");
+#endif
+    static BlackboxBurstCapture         blackboxBurstCapture(1000000 / AHRS_taskIntervalMicroSeconds, flightController.getMixer().getMotorCount());
+    blackboxMessageQueueAHRS.setBurstCapture(&blackboxBurstCapture);
+    static BlackboxBurstCaptureWriter   blackboxBurstCaptureWriter(blackboxBurstCapture, blackboxSerialDevice, flightController);
+    blackbox.setBurstCaptureWriter(&blackboxBurstCaptureWriter);
+#endif
 
     flightController.setBlackbox(blackbox);
     blackbox.init({
         .sample_rate = Blackbox::RATE_ONE,
+#if defined(USE_BLACKBOX_FLASH)
+        .device = Blackbox::DEVICE_FLASH,
+#elif defined(USE_BLACKBOX_STREAM)
+        .device = Blackbox::DEVICE_SERIAL,
+#else
         .device = Blackbox::DEVICE_SDCARD,
+#endif
         //.device = Blackbox::DEVICE_NONE,
         .mode = Blackbox::MODE_NORMAL // logging starts on arming, file is saved when disarmed
         //.mode = Blackbox::MODE_ALWAYS_ON
@@ -245,6 +361,9 @@ void Main::setup()
     blackboxCallbacks.setUseMessageQueue(true);
     _tasks.blackboxTask = BlackboxTask::createTask(taskInfo, blackbox, BLACKBOX_TASK_PRIORITY, BLACKBOX_TASK_CORE, BLACKBOX_TASK_INTERVAL_MICROSECONDS);
     printTaskInfo(taskInfo, BLACKBOX_TASK_INTERVAL_MICROSECONDS);
+#if defined(FRAMEWORK_USE_FREERTOS) && !defined(USE_BLACKBOX_FLASH) && !defined(USE_BLACKBOX_STREAM)
+    blackboxSerialDevice.startWriterTask(BLACKBOX_WRITER_TASK_PRIORITY, BLACKBOX_TASK_CORE);
+#endif
     //vTaskResume(taskInfo.taskHandle);
 #endif
 
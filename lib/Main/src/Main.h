@@ -62,7 +62,8 @@ enum {
     MOTORS_TASK_PRIORITY = 4,
     BACKCHANNEL_TASK_PRIORITY = 3,
     MSP_TASK_PRIORITY = 2,
-    BLACKBOX_TASK_PRIORITY = 3
+    BLACKBOX_TASK_PRIORITY = 3,
+    BLACKBOX_WRITER_TASK_PRIORITY = 2 // lower than the Blackbox task, so encoding is not held up by writing
 };
 
 #if !defined(PRO_CPU_NUM)
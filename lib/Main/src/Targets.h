@@ -24,6 +24,9 @@ Targets
     #define IMU_I2C_PINS        pins_t{.sda=38,.scl=39,.irq=16}
 
     #define USE_MOTOR_MIXER_QUAD_X_PWM
+    //#define USE_MOTOR_PROTOCOL_ONESHOT125 // for brushless ESCs that do not support DShot
+    //#define USE_MOTOR_MIXER_QUAD_X_DSHOT
+    //#define USE_DSHOT_ESP32_RMT
     #define MOTOR_PINS          pins_t{.br=0xFF,.fr=0xFF,.bl=0xFF,.fl=0xFF}
 #endif
 
@@ -39,6 +42,9 @@ Targets
     #define IMU_I2C_PINS        pins_t{.sda=45,.scl=0,.irq=16}
 
     #define USE_MOTOR_MIXER_QUAD_X_PWM
+    //#define USE_MOTOR_PROTOCOL_ONESHOT125 // for brushless ESCs that do not support DShot
+    //#define USE_MOTOR_MIXER_QUAD_X_DSHOT
+    //#define USE_DSHOT_ESP32_RMT
     #define MOTOR_PINS          pins_t{.br=0xFF,.fr=0xFF,.bl=0xFF,.fl=0xFF}
 
     #define USE_SCREEN
@@ -109,8 +115,22 @@ Targets
     //#define USE_MOTOR_MIXER_QUAD_X_PWM
     #define USE_MOTOR_MIXER_QUAD_X_DSHOT
     #define USE_DSHOT_RPI_PICO_PIO
+    //#define USE_MOTOR_RPM_CONTROL // closed-loop per-motor RPM control using bidirectional DShot telemetry
+    //#define USE_RPM_LIMITER // limit average motor RPM, for spec classes with RPM caps
     #define MOTOR_PINS          pins_t{.br=0xFF,.fr=0xFF,.bl=0xFF,.fl=0xFF}
     //#define MOTOR_PINS          pins_t{.br=2,.fr=3,.bl=4,.fl=5}
+
+    //#define USE_BLACKBOX
+    //#define USE_BLACKBOX_FLASH // log to onboard SPI NOR flash rather than SD card
+    //#define USE_BLACKBOX_STREAM // stream the log live over a serial port rather than to SD card, for bench tests
+    //#define USE_BLACKBOX_BURST_CAPTURE // capture unfiltered gyro at the full IMU rate around a throttle punch, for filter design
+    //#define USE_BLACKBOX_HIGH_PRECISION // log PID terms and motor outputs at higher resolution, for tuning sessions
+    #define FLASH_SPI_PINS      pins_t{.cs=13,.sck=10,.cipo=12,.copi=11,.irq=0xFF}
+    // uart0 is used by the receiver and USB by printf, so the stream has uart1 to itself
+    #define BLACKBOX_STREAM_PORT        PORT_UART1
+    #define BLACKBOX_STREAM_UART_PINS   uart_pins_t{.tx=8,.cts=10}
+    //#define BLACKBOX_STREAM_PORT        PORT_USB_CDC // only if printf is not sent over USB
+    //#define DEBUG_MODE          DEBUG_RPM_LIMIT // values logged in the blackbox debug fields, eg DEBUG_DYN_IDLE, DEBUG_ESC_SENSOR_RPM
 #endif
 
 #if defined(TARGET_SEED_XIAO_NRF52840_SENSE)
@@ -86,47 +86,34 @@ uint32_t DShotCodec::decodeSamples(uint64_t value, telemetry_type_e& telemetryTy
         return 0;
     }
 
-    uint32_t consecutiveBitCount = 1;  // we always start with the MSB
-    uint32_t currentBit = 0;
-    int bitCount = 0;
+    // Rather than testing the samples one bit at a time, jump from run to run:
+    // inverting the samples when the current run is of 1s means the length of the current run is the count of leading zeros.
+    // The loop is executed once per run (about 15 times for a typical frame) rather than 63 times.
     uint32_t gcr_result = 0;
-    // starting at 2nd bit since we know our data starts with a 0
-    // 56 samples @ 0.917us sample rate = 51.33us sampled
-    // loop the mask from 2nd MSB to  LSB
-    for (uint64_t mask = 0x4000000000000000; mask != 0; mask >>= 1) {
-        if (((value & mask) != 0) != currentBit) {
-            // if the masked bit doesn't match the current string of bits then end the current string and flip currentBit
-            // bitshift gcr_result by N, and
-            gcr_result = gcr_result << gcrBitLengths[consecutiveBitCount];
-            // then set N bits in gcr_result, if currentBit is 1
-            if (currentBit) {
-                gcr_result |= gcrSetBits[gcrBitLengths[consecutiveBitCount]];
-            }
-            bitCount += gcrBitLengths[consecutiveBitCount];
-            // invert currentBit, and reset consecutiveBitCount
-            currentBit = !currentBit;
-            consecutiveBitCount = 1;  // first bit found in the string is the one we just processed
-        } else {
-            // otherwise increment consecutiveBitCount
-            ++consecutiveBitCount;
-            if (consecutiveBitCount > 16) {
-                // invalid run length at the current sample rate (outside of gcrBitLengths table)
-                telemetryType = TELEMETRY_INVALID;
-                return 0;
-            }
+    uint32_t bitCount = 0;
+    uint32_t samplesRemaining = 64;
+    uint64_t currentBitMask = 0; // all 0s if current bit is 0, all 1s if current bit is 1
+    while (samplesRemaining != 0) {
+        const uint64_t run = value ^ currentBitMask;
+        // zeros are shifted in as the samples are consumed, so clip the run length to the number of remaining samples
+        uint32_t consecutiveBitCount = (run == 0) ? 64 : static_cast<uint32_t>(__builtin_clzll(run));
+        if (consecutiveBitCount > samplesRemaining) {
+            consecutiveBitCount = samplesRemaining;
         }
+        if (consecutiveBitCount > 16) {
+            // invalid run length at the current sample rate (outside of gcrBitLengths table)
+            telemetryType = TELEMETRY_INVALID;
+            return 0;
+        }
+        // bitshift gcr_result by N, and then set N bits in gcr_result, if currentBit is 1
+        const uint32_t gcrBitLength = gcrBitLengths[consecutiveBitCount];
+        gcr_result = (gcr_result << gcrBitLength) | (gcrSetBits[gcrBitLength] & static_cast<uint32_t>(currentBitMask));
+        bitCount += gcrBitLength;
+        value <<= consecutiveBitCount;
+        samplesRemaining -= consecutiveBitCount;
+        currentBitMask = ~currentBitMask;
     }
 
-    // outside the loop, we still need to account for the final bits if the string ends with 1s
-    // bitshift gcr_result by N, and
-    gcr_result <<= gcrBitLengths[consecutiveBitCount];
-    // then set set N bits in gcr_result, if currentBit is 1
-    if (currentBit) {
-        gcr_result |= gcrSetBits[gcrBitLengths[consecutiveBitCount]];
-    }
-    // count bitCount (for debugging)
-    bitCount += gcrBitLengths[consecutiveBitCount];
-
     // GCR data should be 21 bits
     if (bitCount < 21) {
         telemetryType = TELEMETRY_INVALID;
@@ -209,10 +196,10 @@ uint16_t DShotCodec::GCR20_to_eRPM(uint32_t value)
 
 uint32_t DShotCodec::eRPM_to_GCR20(uint16_t value)
 {
-    uint32_t ret = nibbleToQuintet[value & 0x1F];
-    ret |= nibbleToQuintet[(value >> 4) & 0x1F] << 5;
-    ret |= nibbleToQuintet[(value >> 8) & 0x1F] << 10;
-    ret |= nibbleToQuintet[(value >> 12) & 0x1F] << 15;
+    uint32_t ret = nibbleToQuintet[value & 0x0F];
+    ret |= nibbleToQuintet[(value >> 4) & 0x0F] << 5;
+    ret |= nibbleToQuintet[(value >> 8) & 0x0F] << 10;
+    ret |= nibbleToQuintet[(value >> 12) & 0x0F] << 15;
     return ret;
 }
 
@@ -236,4 +223,19 @@ uint32_t DShotCodec::GR20_to_GCR21(uint32_t value)
     return ret;
 }
 
+/*!
+Convert 21-bit GCR to samples, as returned by the Raspberry Pi PIO implementation, ie each bit sampled 3 times.
+
+This is the inverse of decodeSamples(uint64_t), and is used for testing and emulation.
+*/
+uint64_t DShotCodec::GCR21_to_samples(uint32_t value)
+{
+    uint64_t ret = 0;
+    for (uint32_t mask = 1U << 20; mask != 0; mask >>= 1U) {
+        ret = (ret << 3) | ((value & mask) ? 0b111 : 0b000);
+    }
+    // 21*3 = 63 samples, so the final sample repeats the last bit
+    return (ret << 1) | (value & 0x01);
+}
+
 // NOLINTEND(hicpp-signed-bitwise)
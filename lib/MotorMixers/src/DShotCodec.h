@@ -60,12 +60,14 @@ public:
     static inline uint16_t checksumBidirectional(uint16_t value) { return(~(value ^ (value >> 4) ^ (value >> 8))) & 0x0F; }
     static inline bool checksumBidirectionalIsOK(uint16_t value) { return checksumBidirectional(value>>4) == (value & 0x0F); }
 
+    // OR'd with a value to set the telemetry request bit in its frame, special commands must be sent with this bit set
+    enum { TELEMETRY_REQUEST = 0x0800 };
     static inline uint16_t frameUnidirectional(uint16_t value) {
-        value <<= 1;
+        value = static_cast<uint16_t>(((value & 0x07FFU) << 1U) | (value >> 11U));
         return (value << 4) | checksumUnidirectional(value);
     }
     static inline uint16_t frameBidirectional(uint16_t value) {
-        value <<= 1;
+        value = static_cast<uint16_t>(((value & 0x07FFU) << 1U) | (value >> 11U));
         return (value << 4) | checksumBidirectional(value);
     }
 
@@ -80,6 +82,7 @@ public:
     static uint32_t GR20_to_GCR21(uint32_t value);
     static inline uint32_t GCR21_to_GCR20(uint32_t value) { return (value ^ (value >> 1U)); }
     static uint16_t GCR20_to_eRPM(uint32_t value);
+    static uint64_t GCR21_to_samples(uint32_t value);
 public:
     static const std::array<uint32_t, 17> gcrBitLengths;
     static const std::array<uint32_t, 6> gcrSetBits;
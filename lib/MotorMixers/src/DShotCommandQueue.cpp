@@ -0,0 +1,112 @@
+#include "DShotCommandQueue.h"
+
+
+/*!
+Adds a command to the queue.
+
+Returns false if the queue is full.
+*/
+bool DShotCommandQueue::enqueue(command_e command, uint8_t motorIndex)
+{
+    if (_count == QUEUE_LENGTH) {
+        return false;
+    }
+
+    item_t item { .command = command, .motorIndex = motorIndex, .repeats = 1, .delayAfterMicroSeconds = COMMAND_DELAY_MICROSECONDS };
+    switch (command) {
+    case DSHOT_CMD_BEACON1:
+        [[fallthrough]];
+    case DSHOT_CMD_BEACON2:
+        [[fallthrough]];
+    case DSHOT_CMD_BEACON3:
+        [[fallthrough]];
+    case DSHOT_CMD_BEACON4:
+        [[fallthrough]];
+    case DSHOT_CMD_BEACON5:
+        item.delayAfterMicroSeconds = BEACON_DELAY_MICROSECONDS;
+        break;
+    case DSHOT_CMD_ESC_INFO:
+        item.delayAfterMicroSeconds = ESC_INFO_DELAY_MICROSECONDS;
+        break;
+    case DSHOT_CMD_SPIN_DIRECTION_1:
+        [[fallthrough]];
+    case DSHOT_CMD_SPIN_DIRECTION_2:
+        [[fallthrough]];
+    case DSHOT_CMD_3D_MODE_OFF:
+        [[fallthrough]];
+    case DSHOT_CMD_3D_MODE_ON:
+        [[fallthrough]];
+    case DSHOT_CMD_SAVE_SETTINGS:
+        [[fallthrough]];
+    case DSHOT_CMD_EXTENDED_TELEMETRY_ENABLE:
+        [[fallthrough]];
+    case DSHOT_CMD_EXTENDED_TELEMETRY_DISABLE:
+        [[fallthrough]];
+    case DSHOT_CMD_SPIN_DIRECTION_NORMAL:
+        [[fallthrough]];
+    case DSHOT_CMD_SPIN_DIRECTION_REVERSED:
+        // settings commands must be repeated before the ESC acts on them
+        item.repeats = SETTINGS_COMMAND_REPEATS;
+        break;
+    default:
+        break;
+    }
+
+    _queue[(_head + _count) % QUEUE_LENGTH] = item; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    ++_count;
+    return true;
+}
+
+void DShotCommandQueue::clear()
+{
+    _count = 0;
+    _state = IDLE;
+}
+
+/*!
+Advances the queue by one output cycle, elapsedMicroSeconds is the time since the previous call.
+
+Returns true if a command should be sent in this output cycle, in which case the command is given by getCommand().
+Otherwise DSHOT_CMD_MOTOR_STOP should be sent.
+
+Must only be called when the motors are switched off.
+*/
+bool DShotCommandQueue::update(uint32_t elapsedMicroSeconds)
+{
+    _delayRemainingMicroSeconds = (elapsedMicroSeconds < _delayRemainingMicroSeconds) ? _delayRemainingMicroSeconds - elapsedMicroSeconds : 0;
+
+    switch (_state) {
+    case IDLE:
+        if (_count == 0) {
+            return false;
+        }
+        // make sure the motors have been stopped for long enough before sending the first command
+        _state = INITIAL_DELAY;
+        _delayRemainingMicroSeconds = INITIAL_DELAY_MICROSECONDS;
+        return false;
+    case INITIAL_DELAY:
+        [[fallthrough]];
+    case DELAY_AFTER:
+        if (_delayRemainingMicroSeconds > 0) {
+            return false;
+        }
+        if (_count == 0) {
+            _state = IDLE;
+            return false;
+        }
+        _current = _queue[_head]; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+        _head = (_head + 1) % QUEUE_LENGTH;
+        --_count;
+        _state = SENDING;
+        [[fallthrough]];
+    case SENDING:
+        --_current.repeats;
+        if (_current.repeats == 0) {
+            _state = DELAY_AFTER;
+            _delayRemainingMicroSeconds = _current.delayAfterMicroSeconds;
+        }
+        return true;
+    default:
+        return false;
+    }
+}
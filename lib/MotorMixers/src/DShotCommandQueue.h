@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+
+/*!
+Queue of DShot special commands.
+
+DShot values 1 to 47 are reserved for special commands, for example to make the motors beep, to set the spin direction,
+or to enable Extended DShot Telemetry (EDT).
+Commands are only accepted by the ESC when the motors are stopped, and most must be repeated several times before
+the ESC acts on them.
+
+The queue is processed by the motor mixer only while the motors are switched off. When the motors are on the queue is not
+touched at all, so it has no effect on the output timing.
+
+Timings and repetition counts are the same as Betaflight.
+*/
+class DShotCommandQueue {
+public:
+    enum command_e : uint8_t {
+        DSHOT_CMD_MOTOR_STOP = 0,
+        DSHOT_CMD_BEACON1,
+        DSHOT_CMD_BEACON2,
+        DSHOT_CMD_BEACON3,
+        DSHOT_CMD_BEACON4,
+        DSHOT_CMD_BEACON5,
+        DSHOT_CMD_ESC_INFO, // V2 includes settings
+        DSHOT_CMD_SPIN_DIRECTION_1,
+        DSHOT_CMD_SPIN_DIRECTION_2,
+        DSHOT_CMD_3D_MODE_OFF,
+        DSHOT_CMD_3D_MODE_ON,
+        DSHOT_CMD_SETTINGS_REQUEST, // currently not implemented by ESCs
+        DSHOT_CMD_SAVE_SETTINGS,
+        DSHOT_CMD_EXTENDED_TELEMETRY_ENABLE,
+        DSHOT_CMD_EXTENDED_TELEMETRY_DISABLE,
+        DSHOT_CMD_SPIN_DIRECTION_NORMAL = 20,
+        DSHOT_CMD_SPIN_DIRECTION_REVERSED = 21,
+        DSHOT_CMD_LED0_ON, // BLHeli32 only
+        DSHOT_CMD_LED1_ON, // BLHeli32 only
+        DSHOT_CMD_LED2_ON, // BLHeli32 only
+        DSHOT_CMD_LED3_ON, // BLHeli32 only
+        DSHOT_CMD_LED0_OFF, // BLHeli32 only
+        DSHOT_CMD_LED1_OFF, // BLHeli32 only
+        DSHOT_CMD_LED2_OFF, // BLHeli32 only
+        DSHOT_CMD_LED3_OFF, // BLHeli32 only
+        DSHOT_CMD_AUDIO_STREAM_MODE_ON_OFF = 30, // KISS audio Stream mode on/Off
+        DSHOT_CMD_SILENT_MODE_ON_OFF = 31, // KISS silent Mode on/Off
+        DSHOT_CMD_MAX = 47
+    };
+    enum { ALL_MOTORS = 0xFF };
+    enum { QUEUE_LENGTH = 8 };
+    enum {
+        INITIAL_DELAY_MICROSECONDS = 10000, //!< motors must be stopped for this long before the first command is sent
+        COMMAND_DELAY_MICROSECONDS = 1000,
+        ESC_INFO_DELAY_MICROSECONDS = 12000,
+        BEACON_DELAY_MICROSECONDS = 100000
+    };
+    enum { SETTINGS_COMMAND_REPEATS = 10 };
+    struct item_t {
+        command_e command;
+        uint8_t motorIndex; //!< index of motor to send the command to, or ALL_MOTORS
+        uint8_t repeats;
+        uint32_t delayAfterMicroSeconds;
+    };
+public:
+    bool enqueue(command_e command, uint8_t motorIndex);
+    bool enqueue(command_e command) { return enqueue(command, ALL_MOTORS); }
+    inline bool isEmpty() const { return _count == 0; }
+    inline size_t getCount() const { return _count; }
+    void clear();
+
+    bool update(uint32_t elapsedMicroSeconds);
+    inline command_e getCommand() const { return _current.command; }
+    inline bool isCommandForMotor(size_t motorIndex) const { return _current.motorIndex == ALL_MOTORS || _current.motorIndex == motorIndex; }
+private:
+    enum state_e { IDLE, INITIAL_DELAY, SENDING, DELAY_AFTER };
+    std::array<item_t, QUEUE_LENGTH> _queue {};
+    size_t _head {0};
+    size_t _count {0};
+    item_t _current {};
+    state_e _state {IDLE};
+    uint32_t _delayRemainingMicroSeconds {0};
+};
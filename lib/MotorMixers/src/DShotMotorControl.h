@@ -0,0 +1,190 @@
+#pragma once
+
+#include "DynamicIdleController.h"
+
+#include <DShotCodec.h>
+#include <DShotCommandQueue.h>
+#include <MotorRPM_Controller.h>
+#include <MotorSpeedPredictor.h>
+#include <RPM_Filters.h>
+#include <RPM_Limiter.h>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+
+/*!
+Motor control shared by the DShot motor mixers, so that they all support the same features:
+
+1. DShot special commands (eg beeper, EDT enable), sent while the motors are off.
+2. Dynamic idle, using the MotorSpeedPredictor so that it reacts to throttle chops without waiting for the telemetry to catch up.
+3. An optional RPM limiter.
+4. Optional closed-loop RPM control, where the mixer outputs are RPM targets (as a fraction of maxMotorHz).
+   Motors without valid telemetry fall back to open-loop control.
+5. Fan-out of the motor speeds from bidirectional DShot telemetry to the RPM filters.
+
+The mixer owns the ESCs, and each loop:
+1. calls calculateThrottle() and mixes using the returned throttle.
+2. calls calculateValues() and writes the values to the ESCs.
+3. passes each motor's telemetry to setMotorTelemetry().
+4. calls predict().
+
+Hz is used for motor revolutions per second rather than RPS, since RPS is generally used for Radians Per Second.
+*/
+template <size_t MOTOR_COUNT>
+class DShotMotorControl {
+public:
+    static constexpr float DEFAULT_MAX_MOTOR_HZ = 500.0F; // 30000 RPM
+    typedef std::array<float, MOTOR_COUNT> values_t;
+    typedef std::array<uint16_t, MOTOR_COUNT> dshot_values_t;
+public:
+    DShotMotorControl(RPM_Filters& rpmFilters, DynamicIdleController& dynamicIdleController) :
+        _rpmFilters(rpmFilters),
+        _dynamicIdleController(dynamicIdleController)
+    {}
+public:
+    DynamicIdleController& getDynamicIdleController() const { return _dynamicIdleController; }
+    DShotCommandQueue& getCommandQueue() { return _dshotCommands; }
+    void setRPM_Limiter(RPM_Limiter* rpmLimiter) { _rpmLimiter = rpmLimiter; } //!< optional, nullptr for no RPM limit
+    bool isRPM_ControlEnabled() const { return _rpmControlEnabled; }
+    MotorRPM_Controller<MOTOR_COUNT>& getRPM_Controller() { return _rpmController; }
+    const MotorSpeedPredictor<MOTOR_COUNT>& getMotorSpeedPredictor() const { return _motorSpeedPredictor; }
+    float getMotorHz(size_t motorIndex) const { return _motorHz[motorIndex]; } // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+
+    /*!
+    Enable or disable closed-loop RPM control. Requires bidirectional DShot, since the controller uses the motor speeds reported by the ESCs.
+
+    maxMotorHz is the motor speed corresponding to a mixer output of 1.0. The MotorSpeedPredictor uses the same motor gain,
+    so the predicted speeds are consistent with the RPM controller's feedforward.
+    */
+    void setRPM_ControlEnabled(bool rpmControlEnabled, float maxMotorHz) {
+        _rpmControlEnabled = rpmControlEnabled;
+        _rpmController.setMaxMotorHz(maxMotorHz);
+        _rpmController.reset();
+        _motorSpeedPredictor.setMotorGainHz(maxMotorHz);
+    }
+
+    float calculateSlowestMotorHz() const {
+        float slowestMotorHz = _motorHz[0];
+        for (size_t ii = 1; ii < MOTOR_COUNT; ++ii) {
+            slowestMotorHz = _motorHz[ii] < slowestMotorHz ? _motorHz[ii] : slowestMotorHz;
+        }
+        return slowestMotorHz;
+    }
+
+    float calculateAverageMotorHz() const {
+        float sum = 0.0F;
+        for (float motorHz : _motorHz) {
+            sum += motorHz;
+        }
+        return sum / static_cast<float>(MOTOR_COUNT);
+    }
+
+    /*!
+    Returns the average motor speed, with each motor weighted by the validity of its telemetry.
+    weight is set to the mean of the weights, 0 if no motor has valid telemetry.
+    */
+    float calculateWeightedAverageMotorHz(float& weight) const {
+        float sum = 0.0F;
+        float weightSum = 0.0F;
+        for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+            sum += _weights[ii] * _motorHz[ii];
+            weightSum += _weights[ii];
+        }
+        weight = weightSum / static_cast<float>(MOTOR_COUNT);
+        return weightSum > 0.0F ? sum / weightSum : 0.0F;
+    }
+
+    /*!
+    Returns the throttle to be used for the mix.
+
+    The RPM limiter scales back the throttle so the average motor RPM does not exceed the limit.
+    When RPM control is enabled the DynamicIdleController minimum RPM is applied by the RPM controller, otherwise
+    the throttle is increased by the DynamicIdleController, using the predicted motor speeds.
+    */
+    float calculateThrottle(float throttle, bool motorsIsOn, float deltaT) {
+        if (!motorsIsOn) {
+            _rpmController.reset();
+            if (_rpmLimiter) {
+                _rpmLimiter->resetPID();
+            }
+            return throttle;
+        }
+        float throttleScale = 1.0F;
+        if (_rpmLimiter) {
+            // motors with stale or unreliable telemetry do not contribute to the average speed
+            float telemetryWeight {};
+            const float averageMotorHz = calculateWeightedAverageMotorHz(telemetryWeight);
+            throttleScale = _rpmLimiter->calculateThrottleScale(averageMotorHz, telemetryWeight, deltaT);
+        }
+        if (_rpmControlEnabled) {
+            return throttle * throttleScale;
+        }
+        // use the predicted motor speeds, so dynamic idle reacts to throttle chops without waiting for the telemetry to catch up
+        return throttle * throttleScale + _dynamicIdleController.calculateSpeedIncrease(_motorSpeedPredictor.calculateSlowestPredictedHz(), calculateSlowestMotorHz(), deltaT);
+    }
+
+    /*!
+    Converts the motor outputs to DShot values in the range [47,2047].
+
+    When the motors are off DSHOT_CMD_MOTOR_STOP is sent, unless there is a queued special command.
+    */
+    void calculateValues(dshot_values_t& values, const values_t& motorOutputs, bool motorsIsOn, float motorOutputMin, float deltaT) {
+        if (motorsIsOn && _rpmControlEnabled) {
+            // motors whose telemetry is stale or unreliable fall back to open-loop control
+            _rpmController.update(_outputs, motorOutputs, _motorHz, _weights, _dynamicIdleController.getMinimumAllowedMotorHz(), motorOutputMin, deltaT);
+        } else if (motorsIsOn) {
+            for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+                _outputs[ii] = clip(motorOutputs[ii], motorOutputMin, 1.0F);
+            }
+        } else {
+            _outputs.fill(0.0F);
+        }
+
+        values.fill(DShotCommandQueue::DSHOT_CMD_MOTOR_STOP);
+        if (motorsIsOn) {
+            for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+                values[ii] = static_cast<uint16_t>(std::lroundf(2000.0F*_outputs[ii]) + 47);
+            }
+        } else if (_dshotCommands.update(static_cast<uint32_t>(deltaT*1000000.0F))) {
+            // special commands must be sent with the telemetry request bit set
+            const auto command = static_cast<uint16_t>(_dshotCommands.getCommand() | DShotCodec::TELEMETRY_REQUEST);
+            for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+                if (_dshotCommands.isCommandForMotor(ii)) {
+                    values[ii] = command;
+                }
+            }
+        }
+    }
+
+    /*!
+    Called for each motor after the values have been written to the ESCs.
+
+    The RPM filters are faded out if a motor's telemetry is stale or unreliable, rather than left at a stale frequency.
+    New telemetry (received is true) corrects the MotorSpeedPredictor.
+    */
+    void setMotorTelemetry(size_t motorIndex, float motorHz, float weight, bool received) {
+        _motorHz[motorIndex] = motorHz; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+        _weights[motorIndex] = weight; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+        if (received) {
+            _motorSpeedPredictor.correct(motorIndex, motorHz);
+        }
+        _rpmFilters.setFrequencyHz(motorIndex, motorHz, weight);
+    }
+
+    //! step the MotorSpeedPredictor forward, to predict the motor speeds for the next loop
+    void predict(float deltaT) { _motorSpeedPredictor.predict(_outputs, deltaT); }
+public:
+    static inline float clip(float value, float min, float max) { return value < min ? min : value > max ? max : value; }
+private:
+    RPM_Filters& _rpmFilters;
+    DynamicIdleController& _dynamicIdleController;
+    RPM_Limiter* _rpmLimiter {nullptr};
+    DShotCommandQueue _dshotCommands;
+    bool _rpmControlEnabled {false};
+    MotorRPM_Controller<MOTOR_COUNT> _rpmController {DEFAULT_MAX_MOTOR_HZ};
+    MotorSpeedPredictor<MOTOR_COUNT> _motorSpeedPredictor {DEFAULT_MAX_MOTOR_HZ};
+    values_t _motorHz {}; //!< motor speeds from the latest telemetry
+    values_t _weights {}; //!< telemetry validity weights, used by the RPM controller
+    values_t _outputs {}; //!< the outputs sent to the motors, used to drive the MotorSpeedPredictor
+};
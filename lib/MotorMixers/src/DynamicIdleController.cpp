@@ -27,7 +27,7 @@ void DynamicIdleController::setConfig(const config_t& config, uint32_t taskInter
     _PID.setIntegralMax(_maxIncrease);
     _PID.setIntegralMin(0.0F);
 
-    _PID.setD(static_cast<float>(config.dyn_idle_i_gain) * 0.0000003F / deltaT);
+    _PID.setD(static_cast<float>(config.dyn_idle_d_gain) * 0.0000003F / deltaT);
     _DTermFilter.init(800.0F * deltaT / 20.0F); //approx 20ms D delay, arbitrarily suits many motors
 }
 
@@ -37,7 +37,11 @@ void DynamicIdleController::setMinimumAllowedMotorHz(float minimumAllowedMotorHz
     _PID.setSetpoint(_minimumAllowedMotorHz);
 }
 
-float DynamicIdleController::calculateSpeedIncrease(float slowestMotorHz, float deltaT)
+/*!
+slowestMotorHz is the speed used by the controller, this may be predicted (eg by the MotorSpeedPredictor) rather than measured.
+measuredSlowestMotorHz is used only for logging, so the predicted and measured speeds can be compared.
+*/
+float DynamicIdleController::calculateSpeedIncrease(float slowestMotorHz, float measuredSlowestMotorHz, float deltaT)
 {
     if (_minimumAllowedMotorHz == 0.0F) {
         return  0.0F;
@@ -53,6 +57,8 @@ float DynamicIdleController::calculateSpeedIncrease(float slowestMotorHz, float
         _debug.set(0, static_cast<int16_t>(std::max(-1000L, std::lroundf(error.P * 10000))));
         _debug.set(1, static_cast<int16_t>(std::lroundf(error.I * 10000)));
         _debug.set(2, static_cast<int16_t>(std::lroundf(error.D * 10000)));
+        _debug.set(3, static_cast<int16_t>(std::lroundf(slowestMotorHz * 10)));
+        _debug.set(4, static_cast<int16_t>(std::lroundf(measuredSlowestMotorHz * 10)));
     }
 
     return speedIncrease;
@@ -34,7 +34,8 @@ public:
     const config_t& getConfig() const { return _config; }
     void setMinimumAllowedMotorHz(float minimumAllowedMotorHz);
     float getMinimumAllowedMotorHz() { return _minimumAllowedMotorHz; }
-    float calculateSpeedIncrease(float slowestMotorHz, float deltaT);
+    float calculateSpeedIncrease(float slowestMotorHz, float measuredSlowestMotorHz, float deltaT);
+    float calculateSpeedIncrease(float slowestMotorHz, float deltaT) { return calculateSpeedIncrease(slowestMotorHz, slowestMotorHz, deltaT); }
     void resetPID(); //!< for test code
 public:
     static inline float clip(float value, float min, float max) { return value < min ? min : value > max ? max : value; }
@@ -1,6 +1,7 @@
 #include "DShotCodec.h"
 #include "ESC_DShot.h"
 
+#include <algorithm>
 #include <array>
 
 #if defined(FRAMEWORK_RPI_PICO)
@@ -10,7 +11,9 @@
 
 #include <hardware/dma.h>
 #include <hardware/gpio.h>
+#include <hardware/irq.h>
 #include <hardware/pwm.h>
+#include <hardware/timer.h>
 
 #elif defined(FRAMEWORK_ESPIDF)
 #elif defined(FRAMEWORK_TEST)
@@ -23,6 +26,11 @@
 
 #endif // FRAMEWORK
 
+#if defined(USE_DSHOT_ESP32_RMT)
+#include <driver/rmt_encoder.h>
+#include <esp_timer.h>
+#endif
+
 /*
 See:
 https://betaflight.com/docs/wiki/guides/current/DSHOT-RPM-Filtering
@@ -37,13 +45,18 @@ https://github.com/wjxway/ESP32-Bidirectional-DShot/blob/main/src/MotorCtrl.cpp
 
 */
 
+#if defined(USE_DSHOT_RPI_PICO_PIO)
+std::array<ESC_DShot*, ESC_DShot::MAX_ESC_COUNT> ESC_DShot::escsWithTelemetry {};
+size_t ESC_DShot::escsWithTelemetryCount {0};
+#endif
+
 ESC_DShot::ESC_DShot(protocol_e protocol, uint16_t motorPoleCount) :
     _protocol(protocol),
     _motorPoleCount(motorPoleCount)
 {
     setProtocol(protocol);
     constexpr float SECONDS_PER_MINUTE = 60.0F;
-    _eRPMtoHz = 2.0F * (100.0F / SECONDS_PER_MINUTE) / static_cast<float>(_motorPoleCount);
+    _eRPMtoHz = 2.0F / (SECONDS_PER_MINUTE * static_cast<float>(_motorPoleCount)); // eRPM = RPM * poles/2
 }
 
 void ESC_DShot::init(uint16_t pin)
@@ -68,6 +81,22 @@ void ESC_DShot::init(uint16_t pin)
         dshot_bidir_600_program_init(_pio, _pioStateMachine, _pioOffset, pin, _cpuFrequency);
     }
     // The PIO State Machine is now running, to use we push onto its TX FIFO and pull from the RX FIFO
+
+    // Telemetry is read from the RX FIFO by an interrupt handler, so the motor mixer never has to wait for the ESC to reply
+    if (escsWithTelemetryCount < MAX_ESC_COUNT) {
+        escsWithTelemetry[escsWithTelemetryCount] = this;
+        ++escsWithTelemetryCount;
+        enum { PIO_IRQ_INDEX = 0 };
+        pio_set_irqn_source_enabled(_pio, PIO_IRQ_INDEX, pio_get_rx_fifo_not_empty_interrupt_source(_pioStateMachine), true);
+        const uint irqNum = pio_get_irq_num(_pio, PIO_IRQ_INDEX);
+        // the handler is shared by all the ESCs on this PIO, so only add it once
+        static uint32_t irqHandlerAddedMask = 0;
+        if ((irqHandlerAddedMask & (1U << irqNum)) == 0) {
+            irqHandlerAddedMask |= 1U << irqNum;
+            irq_add_shared_handler(irqNum, pioIrqHandler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+            irq_set_enabled(irqNum, true);
+        }
+    }
 #else
     gpio_set_function(pin, GPIO_FUNC_PWM); // Set the pin to be PWM
 
@@ -107,6 +136,52 @@ void ESC_DShot::init(uint16_t pin)
         DONT_START_YET
     );
 #endif // USE_DSHOT_RPI_PICO_PIO
+#elif defined(USE_DSHOT_ESP32_RMT)
+    // The frame is sent by the RMT peripheral, the whole frame fits in the channel's memory, so no CPU is needed during transmission
+    rmt_tx_channel_config_t txConfig {};
+    txConfig.gpio_num = static_cast<gpio_num_t>(pin);
+    txConfig.clk_src = RMT_CLK_SRC_DEFAULT;
+    txConfig.resolution_hz = RMT_RESOLUTION_HZ;
+    txConfig.mem_block_symbols = SOC_RMT_MEM_WORDS_PER_CHANNEL;
+    txConfig.trans_queue_depth = RMT_TX_QUEUE_DEPTH;
+#if defined(USE_DSHOT_TELEMETRY)
+    // bidirectional DShot: the signal is inverted and the ESC replies on the same pin, so use open drain with loopback to the RX channel
+    txConfig.flags.invert_out = true;
+    txConfig.flags.io_loop_back = true;
+    txConfig.flags.io_od_mode = true;
+#endif
+#if SOC_RMT_SUPPORT_DMA
+    // only some RMT channels support DMA, so fall back to using the channel's memory if no DMA channel is available
+    txConfig.flags.with_dma = true;
+    if (rmt_new_tx_channel(&txConfig, &_txChannel) != ESP_OK) {
+        txConfig.flags.with_dma = false;
+        ESP_ERROR_CHECK(rmt_new_tx_channel(&txConfig, &_txChannel));
+    }
+#else
+    ESP_ERROR_CHECK(rmt_new_tx_channel(&txConfig, &_txChannel));
+#endif
+    // the frame is pre-encoded into RMT symbols by write(), so it just needs to be copied to the RMT
+    const rmt_copy_encoder_config_t copyEncoderConfig {};
+    ESP_ERROR_CHECK(rmt_new_copy_encoder(&copyEncoderConfig, &_copyEncoder));
+
+#if defined(USE_DSHOT_TELEMETRY)
+    rmt_rx_channel_config_t rxConfig {};
+    rxConfig.gpio_num = static_cast<gpio_num_t>(pin);
+    rxConfig.clk_src = RMT_CLK_SRC_DEFAULT;
+    rxConfig.resolution_hz = RMT_RESOLUTION_HZ;
+    rxConfig.mem_block_symbols = SOC_RMT_MEM_WORDS_PER_CHANNEL;
+    ESP_ERROR_CHECK(rmt_new_rx_channel(&rxConfig, &_rxChannel));
+
+    // reception is started when the transmission of the frame completes, and the telemetry is decoded when reception completes
+    rmt_tx_event_callbacks_t txCallbacks {};
+    txCallbacks.on_trans_done = rmtTxDoneCallback;
+    ESP_ERROR_CHECK(rmt_tx_register_event_callbacks(_txChannel, &txCallbacks, this));
+    rmt_rx_event_callbacks_t rxCallbacks {};
+    rxCallbacks.on_recv_done = rmtRxDoneCallback;
+    ESP_ERROR_CHECK(rmt_rx_register_event_callbacks(_rxChannel, &rxCallbacks, this));
+    ESP_ERROR_CHECK(rmt_enable(_rxChannel));
+#endif
+    ESP_ERROR_CHECK(rmt_enable(_txChannel));
 #elif defined(FRAMEWORK_ESPIDF)
 #elif defined(FRAMEWORK_TEST)
 
@@ -200,6 +275,24 @@ void ESC_DShot::setProtocol(protocol_e protocol)
         break;
     }
 
+#if defined(USE_DSHOT_ESP32_RMT)
+    // pre-encode each nibble as 4 RMT symbols, so write() encodes a frame with 4 table lookups rather than 16 bit tests
+    for (size_t nibble = 0; nibble < _nibbleToSymbols.size(); ++nibble) {
+        uint32_t maskBit = 0x08;
+        for (auto& symbol : _nibbleToSymbols[nibble]) { // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+            const uint32_t pulseWidth = (nibble & maskBit) ? _dataHighPulseWidth : _dataLowPulseWidth;
+            symbol.level0 = 1;
+            symbol.duration0 = pulseWidth & 0x7FFFU;
+            symbol.level1 = 0;
+            symbol.duration1 = (_wrapCycleCount - pulseWidth) & 0x7FFFU;
+            maskBit >>= 1U;
+        }
+    }
+    _telemetryBitTicks = _wrapCycleCount * 4 / 5;
+    // GCR has at most 3 consecutive bits at the same level, so 5 bits without an edge means the telemetry frame has ended
+    _telemetryIdleNanoSeconds = _telemetryBitTicks * 5 * (1000000000U / RMT_RESOLUTION_HZ);
+#endif
+
 #if defined(FRAMEWORK_RPI_PICO) && !defined(USE_DSHOT_RPI_PICO_PIO)
     if (_pin != PIN_NOT_SET) {
         // the pin has already been set, so we need to re-set the wrap value
@@ -237,6 +330,25 @@ void ESC_DShot::write(uint16_t value) // NOLINT(readability-make-member-function
     // use the value to create a bidirectional DShot frame and send it to the PIO state machine
     value = DShotCodec::frameBidirectional(value);
     pio_sm_put(_pio, _pioStateMachine, value);
+#elif defined(USE_DSHOT_ESP32_RMT)
+#if defined(USE_DSHOT_TELEMETRY)
+    const uint16_t frame = DShotCodec::frameBidirectional(value);
+#else
+    const uint16_t frame = DShotCodec::frameUnidirectional(value);
+#endif
+    // build the RMT symbols from the pre-encoded nibbles, in the next buffer of the ring, so frames still queued are not overwritten
+    _txSymbolsIndex = (_txSymbolsIndex + 1) % _txSymbols.size();
+    auto& txSymbols = _txSymbols[_txSymbolsIndex]; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    auto symbol = txSymbols.begin();
+    for (uint32_t shift = 12; ; shift -= 4) {
+        const auto& symbols = _nibbleToSymbols[(frame >> shift) & 0x0FU]; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+        symbol = std::copy(symbols.begin(), symbols.end(), symbol);
+        if (shift == 0) {
+            break;
+        }
+    }
+    const rmt_transmit_config_t transmitConfig {};
+    rmt_transmit(_txChannel, _copyEncoder, &txSymbols[0], sizeof(txSymbols), &transmitConfig);
 #else
     // set up a unidirectional DShot frame for sending via DMA
     const uint16_t frame = DShotCodec::frameUnidirectional(value);
@@ -267,71 +379,233 @@ void ESC_DShot::write(uint16_t value) // NOLINT(readability-make-member-function
 #endif // USE_DSHOT_RPI_PICO_PIO
 }
 
-bool ESC_DShot::read()
+#if defined(USE_DSHOT_RPI_PICO_PIO)
+/*!
+PIO interrupt handler, called when there is data in the RX FIFO of any of the state machines.
+*/
+void ESC_DShot::pioIrqHandler()
 {
-    DShotCodec::telemetry_type_e telemetryType {};
-    uint32_t value {}; // NOLINT(misc-const-correctness) false positive
+    for (size_t ii = 0; ii < escsWithTelemetryCount; ++ii) {
+        escsWithTelemetry[ii]->drainRxFifo(); // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    }
+}
 
-#if defined(USE_DSHOT_RPI_PICO_PIO)
-    const int32_t fifoCount = pio_sm_get_rx_fifo_level(_pio, _pioStateMachine);
-    if (fifoCount >= 2) {
-        // get DShot telemetry value from the PIO
-        //value = pio_sm_get(_pio, _pioStateMachine);
-        uint64_t samples = static_cast<uint64_t>(pio_sm_get_blocking(_pio, _pioStateMachine)) << 32;
-        samples |= static_cast<uint64_t>(pio_sm_get_blocking(_pio, _pioStateMachine));
-        value = DShotCodec::decodeSamples(samples, telemetryType);
-    } else {
-        return false;
+/*!
+Empty the RX FIFO, the telemetry samples are received as two 32-bit words.
+The RX FIFO must be emptied, since the interrupt remains asserted while it contains data.
+*/
+void ESC_DShot::drainRxFifo()
+{
+    while (!pio_sm_is_rx_fifo_empty(_pio, _pioStateMachine)) {
+        const uint32_t samples = pio_sm_get(_pio, _pioStateMachine);
+        if (_samplesHighReceived) {
+            _samplesHighReceived = false;
+            telemetryReceived((static_cast<uint64_t>(_samplesHigh) << 32) | samples, time_us_32());
+        } else {
+            _samplesHigh = samples;
+            _samplesHighReceived = true;
+        }
     }
-#else
-    telemetryType = DShotCodec::TELEMETRY_INVALID;
+}
+#endif
+
+#if defined(USE_DSHOT_ESP32_RMT)
+/*!
+RMT transmit done interrupt callback, starts the reception of the ESC's reply.
+
+The frame has been sent, so the RX channel will not pick up our own transmission.
+Requires CONFIG_RMT_RECV_FUNC_IN_IRAM, so that rmt_receive() may be called from an interrupt.
+*/
+bool ESC_DShot::rmtTxDoneCallback(rmt_channel_handle_t channel, const rmt_tx_done_event_data_t* eventData, void* userData)
+{
+    (void)channel;
+    (void)eventData;
+    auto* esc = static_cast<ESC_DShot*>(userData);
+
+    rmt_receive_config_t receiveConfig {};
+    receiveConfig.signal_range_min_ns = 200; // pulses shorter than this are treated as glitches
+    receiveConfig.signal_range_max_ns = esc->_telemetryIdleNanoSeconds;
+    rmt_receive(esc->_rxChannel, &esc->_rxSymbols[0], sizeof(esc->_rxSymbols), &receiveConfig);
+    return false; // no higher priority task has been woken
+}
+
+/*!
+RMT receive done interrupt callback.
+*/
+bool ESC_DShot::rmtRxDoneCallback(rmt_channel_handle_t channel, const rmt_rx_done_event_data_t* eventData, void* userData)
+{
+    (void)channel;
+    static_cast<ESC_DShot*>(userData)->rmtReceived(eventData->received_symbols, eventData->num_symbols);
+    return false; // no higher priority task has been woken
+}
+
+/*!
+The RMT gives the telemetry frame as a sequence of (level, duration) runs.
+Convert these runs into samples at 3 samples per bit, which is the same format as produced by the RPI Pico PIO implementation,
+so the telemetry can be decoded by telemetryReceived().
+*/
+void ESC_DShot::rmtReceived(const rmt_symbol_word_t* symbols, size_t count)
+{
+    enum { SAMPLE_COUNT = 64 };
+    uint64_t samples = 0;
+    uint32_t sampleCount = 0;
+    auto addRun = [&](uint32_t level, uint32_t duration) {
+        uint32_t runSampleCount = (duration * 3 + _telemetryBitTicks / 2) / _telemetryBitTicks;
+        if (runSampleCount > SAMPLE_COUNT - 1 - sampleCount) {
+            runSampleCount = SAMPLE_COUNT - 1 - sampleCount;
+        }
+        samples = (samples << runSampleCount) | (level ? ((1ULL << runSampleCount) - 1) : 0);
+        sampleCount += runSampleCount;
+    };
+    for (size_t ii = 0; ii < count; ++ii) {
+        const rmt_symbol_word_t& symbol = symbols[ii]; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        addRun(symbol.level0, symbol.duration0);
+        if (symbol.duration1 == 0) {
+            break; // end marker
+        }
+        addRun(symbol.level1, symbol.duration1);
+    }
+    if (sampleCount == 0) {
+        return;
+    }
+    // pad with the idle (high) level
+    const uint32_t padCount = SAMPLE_COUNT - sampleCount;
+    samples = (samples << padCount) | ((1ULL << padCount) - 1);
+    telemetryReceived(samples, static_cast<uint32_t>(esp_timer_get_time()));
+}
 #endif
 
+/*!
+Decode the telemetry samples and publish the result.
+
+Called from the PIO or RMT interrupt handler, so must be FAST.
+*/
+void ESC_DShot::telemetryReceived(uint64_t samples, uint32_t timeMicroSeconds)
+{
+    DShotCodec::telemetry_type_e telemetryType {};
+    const uint32_t value = DShotCodec::decodeSamples(samples, telemetryType);
+
     ++_telemetryReadCount;
     switch (telemetryType) {
     case DShotCodec::TELEMETRY_INVALID:
         ++_telemetryErrorCount;
-        return false;
+        break;
     case DShotCodec::TELEMETRY_TYPE_ERPM: {
         // Convert to eRPM * 100
         //return ((1000000 * 60 / 100) + value / 2) / value;
         enum { ONE_MINUTE_IN_MICROSECONDS = 60000000 };
         // value is eRPM period in microseconds
-        _eRPM = static_cast<int32_t>(ONE_MINUTE_IN_MICROSECONDS / value);
+        _eRPMReceived = static_cast<int32_t>(ONE_MINUTE_IN_MICROSECONDS / value);
+        _eRPMReceivedTimeMicroSeconds = timeMicroSeconds;
+        // publish the eRPM by incrementing the count, this must be done last
+        _telemetryReceivedCount = _telemetryReceivedCount + 1;
         break;
     }
     case DShotCodec::TELEMETRY_TYPE_TEMPERATURE:
-        [[fallthrough]];
+        _temperatureCelsius = static_cast<uint8_t>(value);
+        break;
     case DShotCodec::TELEMETRY_TYPE_VOLTAGE:
-        [[fallthrough]];
+        // voltage has a step size of 0.25V
+        _voltageCentiVolts = static_cast<uint16_t>(value * 25);
+        break;
     case DShotCodec::TELEMETRY_TYPE_CURRENT:
-        [[fallthrough]];
+        // current has a step size of 1A
+        _currentCentiAmps = static_cast<uint16_t>(value * 100);
+        break;
+    case DShotCodec::TELEMETRY_TYPE_STRESS_LEVEL:
+        _stressLevel = static_cast<uint8_t>(value);
+        break;
+    case DShotCodec::TELEMETRY_TYPE_STATE_EVENTS:
+        _stateEvents = static_cast<uint8_t>(value);
+        break;
     case DShotCodec::TELEMETRY_TYPE_DEBUG1:
         [[fallthrough]];
     case DShotCodec::TELEMETRY_TYPE_DEBUG2:
         [[fallthrough]];
-    case DShotCodec::TELEMETRY_TYPE_STRESS_LEVEL:
-        [[fallthrough]];
-    case DShotCodec::TELEMETRY_TYPE_STATE_EVENTS:
-        [[fallthrough]];
     default:
         break;
     }
+}
+
+/*!
+Picks up the latest eRPM decoded in the background.
+
+Does not block: returns false if no new telemetry has been received since the last call.
+*/
+bool ESC_DShot::read()
+{
+    uint32_t receivedCount = _telemetryReceivedCount;
+    if (receivedCount == _telemetryConsumedCount) {
+        ++_telemetryStaleCount;
+        _telemetryValidity.update(false, _telemetryReadCount, _telemetryErrorCount);
+        return false;
+    }
+    // the telemetry may be updated by the interrupt handler while we are reading it, so re-read until it is consistent
+    int32_t eRPM {};
+    uint32_t timeMicroSeconds {};
+    do {
+        receivedCount = _telemetryReceivedCount;
+        eRPM = _eRPMReceived;
+        timeMicroSeconds = _eRPMReceivedTimeMicroSeconds;
+    } while (receivedCount != _telemetryReceivedCount);
+
+    _telemetryConsumedCount = receivedCount;
+    _eRPM = eRPM;
+    _telemetryTimeMicroSeconds = timeMicroSeconds;
+    _telemetryValidity.update(true, _telemetryReadCount, _telemetryErrorCount);
     return true;
 }
 
+/*!
+Returns the latest telemetry.
+
+The EDT values are each read atomically, but are independent, so the set of values is not read as a single snapshot.
+*/
+esc_telemetry_t ESC_DShot::getTelemetry() const
+{
+    return esc_telemetry_t {
+        .rpm = getMotorRPM(),
+        .readCount = _telemetryReadCount,
+        .errorCount = _telemetryErrorCount,
+        .staleCount = _telemetryStaleCount,
+        .voltageCentiVolts = _voltageCentiVolts,
+        .currentCentiAmps = _currentCentiAmps,
+        .temperatureCelsius = _temperatureCelsius,
+        .stressLevel = _stressLevel,
+        .stateEvents = _stateEvents
+    };
+}
+
 void ESC_DShot::end()
 {
 #if defined(FRAMEWORK_RPI_PICO)
 #if defined(USE_DSHOT_RPI_PICO_PIO)
+    enum { PIO_IRQ_INDEX = 0 };
+    pio_set_irqn_source_enabled(_pio, PIO_IRQ_INDEX, pio_get_rx_fifo_not_empty_interrupt_source(_pioStateMachine), false);
+    for (size_t ii = 0; ii < escsWithTelemetryCount; ++ii) {
+        if (escsWithTelemetry[ii] == this) { // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+            // remove this ESC by moving the last ESC into its slot
+            --escsWithTelemetryCount;
+            escsWithTelemetry[ii] = escsWithTelemetry[escsWithTelemetryCount]; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+            break;
+        }
+    }
     if (_protocol == ESC_PROTOCOL_DSHOT300) {
         pio_remove_program_and_unclaim_sm(&dshot_bidir_300_program, _pio, _pioStateMachine, _pioOffset);
     } else {
         pio_remove_program_and_unclaim_sm(&dshot_bidir_600_program, _pio, _pioStateMachine, _pioOffset);
     }
 #endif
-#elif defined(FRAMEWORK_ESPIDF)
+#elif defined(USE_DSHOT_ESP32_RMT)
+    if (_rxChannel != nullptr) {
+        ESP_ERROR_CHECK(rmt_disable(_rxChannel));
+        ESP_ERROR_CHECK(rmt_del_channel(_rxChannel));
+        _rxChannel = nullptr;
+    }
     ESP_ERROR_CHECK(rmt_disable(_txChannel));
+    ESP_ERROR_CHECK(rmt_del_channel(_txChannel));
+    ESP_ERROR_CHECK(rmt_del_encoder(_copyEncoder));
+#elif defined(FRAMEWORK_ESPIDF)
 #elif defined(FRAMEWORK_TEST)
 #else // defaults to FRAMEWORK_ARDUINO
 #if !defined(UNIT_TEST)
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "ESC_Telemetry.h"
+
 #include <array>
 #include <cstddef>
 #include <cstdint>
@@ -11,6 +13,11 @@
 #else // defaults to FRAMEWORK_ARDUINO
 #endif // FRAMEWORK
 
+#if defined(USE_DSHOT_ESP32_RMT)
+#include <driver/rmt_rx.h>
+#include <driver/rmt_tx.h>
+#endif
+
 
 #if !defined(F_CPU)
 #define F_CPU 150000000L // CPU frequency
@@ -36,31 +43,70 @@ public:
     enum { DSHOT_BIT_COUNT = 16 };
     void setProtocol(protocol_e protocol);
     void write(uint16_t value); // value should be in the DShot range [47,2047]
-    bool read();
+    bool read(); //!< non-blocking, returns true if new telemetry has been received since the last read
+    void telemetryReceived(uint64_t samples, uint32_t timeMicroSeconds);
 
     int32_t getMotorRPM() const { return 2 * _eRPM / _motorPoleCount; } // eRPM = RPM * poles/2, /2 due to pole pairs, not poles
     float getMotorHz() const { return static_cast<float>(_eRPM) * _eRPMtoHz; }
+    uint32_t getTelemetryTimeMicroSeconds() const { return _telemetryTimeMicroSeconds; } //!< time the latest telemetry was received
+    uint32_t getTelemetryReadCount() const { return _telemetryReadCount; }
+    uint32_t getTelemetryErrorCount() const { return _telemetryErrorCount; }
+    const ESC_TelemetryValidity& getTelemetryValidity() const { return _telemetryValidity; }
+    esc_telemetry_t getTelemetry() const;
     void end();
     uint32_t nanoSecondsToCycles(uint32_t nanoSeconds) const;
+    uint32_t getWrapCycleCount() const { return _wrapCycleCount; }
 // for testing
     void setUseHighOrderBits(bool useHighOrderBits) { _useHighOrderBits = useHighOrderBits; }
     uint32_t getDataHighPulseWidth() const { return _dataHighPulseWidth; }
     uint32_t getDataLowPulseWidth() const { return _dataLowPulseWidth; }
     uint32_t getBufferItem(size_t index) const { return _dmaBuffer[index]; }
+    const uint32_t* getBuffer() const { return &_dmaBuffer[0]; }
+    size_t getBufferSize() const { return _dmaBuffer.size(); }
 protected:
+#if defined(USE_DSHOT_ESP32_RMT)
+    enum : uint32_t { RMT_RESOLUTION_HZ = 40000000 }; // 25ns RMT tick
+    uint32_t _cpuFrequency {RMT_RESOLUTION_HZ}; //!< on ESP32 the pulse widths are in RMT ticks, rather than processor cycles
+#else
     uint32_t _cpuFrequency {150000000};
+#endif
     protocol_e _protocol;
     uint32_t _useHighOrderBits = 0;
     uint32_t _wrapCycleCount {};
 #if defined(FRAMEWORK_RPI_PICO)
 #if defined(USE_DSHOT_RPI_PICO_PIO)
+    void drainRxFifo();
+    static void pioIrqHandler();
+    enum { MAX_ESC_COUNT = 8 };
+    static std::array<ESC_DShot*, MAX_ESC_COUNT> escsWithTelemetry;
+    static size_t escsWithTelemetryCount;
     PIO _pio {};
     uint _pioStateMachine {};
     uint _pioOffset {};
+    uint32_t _samplesHigh {};
+    bool _samplesHighReceived {false};
 #else
     enum { START_IMMEDIATELY = true, DONT_START_YET = false };
     uint32_t _dmaChannel {};
 #endif // USE_DSHOT_RPI_PICO_PIO
+#endif
+#if defined(USE_DSHOT_ESP32_RMT)
+    static bool rmtTxDoneCallback(rmt_channel_handle_t channel, const rmt_tx_done_event_data_t* eventData, void* userData);
+    static bool rmtRxDoneCallback(rmt_channel_handle_t channel, const rmt_rx_done_event_data_t* eventData, void* userData);
+    void rmtReceived(const rmt_symbol_word_t* symbols, size_t count);
+    enum { RMT_RX_SYMBOL_COUNT = 64 };
+    enum { RMT_TX_QUEUE_DEPTH = 4 }; //!< so rmt_transmit() does not block if the previous frame has not completed
+    rmt_channel_handle_t _txChannel {};
+    rmt_channel_handle_t _rxChannel {};
+    rmt_encoder_handle_t _copyEncoder {};
+    uint32_t _telemetryBitTicks {}; //!< telemetry is sent at 5/4 of the DShot bit rate
+    uint32_t _telemetryIdleNanoSeconds {}; //!< reception of the telemetry frame ends when the line has been idle for this long
+    std::array<std::array<rmt_symbol_word_t, 4>, 16> _nibbleToSymbols {}; //!< each nibble pre-encoded as 4 RMT symbols
+    //! the RMT reads the symbols when the transaction starts, which may be after rmt_transmit() returns, so each queued transaction
+    //! has its own buffer: there are at most RMT_TX_QUEUE_DEPTH in flight when the next frame is written, hence the extra one
+    std::array<std::array<rmt_symbol_word_t, DSHOT_BIT_COUNT>, RMT_TX_QUEUE_DEPTH + 1> _txSymbols {};
+    size_t _txSymbolsIndex {};
+    std::array<rmt_symbol_word_t, RMT_RX_SYMBOL_COUNT> _rxSymbols {};
 #endif
     uint32_t _dataHighPulseWidth {};
     uint32_t _dataLowPulseWidth {};
@@ -69,8 +115,22 @@ protected:
     uint16_t _motorPoleCount {DEFAULT_MOTOR_POLE_COUNT}; //!< number of poles the motor has, used to calculate RPM from telemetry data
     float _eRPMtoHz {};
     int32_t _eRPM {}; //!< eRPM, ie not taking into account motor pole count
+    uint32_t _telemetryTimeMicroSeconds {};
     uint32_t _telemetryReadCount {};
     uint32_t _telemetryErrorCount {};
+    // telemetry is decoded in the background (in an interrupt handler) and published using these values
+    volatile int32_t _eRPMReceived {};
+    volatile uint32_t _eRPMReceivedTimeMicroSeconds {};
+    volatile uint32_t _telemetryReceivedCount {}; //!< incremented after _eRPMReceived is published
+    uint32_t _telemetryConsumedCount {};
+    uint32_t _telemetryStaleCount {};
+    ESC_TelemetryValidity _telemetryValidity {};
+    // Extended DShot Telemetry (EDT) values, each value is written independently by the interrupt handler
+    volatile uint8_t _temperatureCelsius {};
+    volatile uint8_t _stressLevel {};
+    volatile uint8_t _stateEvents {};
+    volatile uint16_t _voltageCentiVolts {};
+    volatile uint16_t _currentCentiAmps {};
 
     enum { DMA_BUFFER_SIZE = DSHOT_BIT_COUNT + 1 }; // extra 1 for terminating zero value
     std::array<uint32_t, DMA_BUFFER_SIZE> _dmaBuffer {};
@@ -0,0 +1,166 @@
+#include "DShotCodec.h"
+#include "ESC_DShotBatch.h"
+
+#if defined(FRAMEWORK_RPI_PICO)
+
+#include <hardware/dma.h>
+#include <hardware/gpio.h>
+#include <hardware/pwm.h>
+
+#elif defined(FRAMEWORK_ESPIDF)
+#elif defined(FRAMEWORK_TEST)
+#else // defaults to FRAMEWORK_ARDUINO
+#endif // FRAMEWORK
+
+
+ESC_DShotBatch::ESC_DShotBatch(ESC_DShot::protocol_e protocol) :
+    _protocol(protocol)
+{
+    setProtocol(protocol);
+}
+
+/*!
+Sets the DShot protocol and rebuilds the byte to pulse width lookup table.
+
+Called in construction, before init().
+*/
+void ESC_DShotBatch::setProtocol(ESC_DShot::protocol_e protocol)
+{
+    _protocol = protocol;
+
+    // use ESC_DShot to calculate the pulse widths, so the timings are identical to those used for single motors
+    const ESC_DShot esc(protocol);
+    _dataHighPulseWidth = esc.getDataHighPulseWidth();
+    _dataLowPulseWidth = esc.getDataLowPulseWidth();
+    _wrapCycleCount = esc.getWrapCycleCount();
+
+    for (size_t byte = 0; byte < _byteToPulseWidths.size(); ++byte) {
+        pulse_widths_t& pulseWidths = _byteToPulseWidths[byte];
+        uint32_t maskBit = 0x80;
+        for (auto& pulseWidth : pulseWidths) {
+            pulseWidth = static_cast<uint16_t>((byte & maskBit) ? _dataHighPulseWidth : _dataLowPulseWidth);
+            maskBit >>= 1U;
+        }
+    }
+}
+
+void ESC_DShotBatch::init(const uint8_t* pins, size_t motorCount)
+{
+    _motorCount = motorCount < MAX_MOTOR_COUNT ? motorCount : static_cast<size_t>(MAX_MOTOR_COUNT);
+    _sliceCount = 0;
+
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-constant-array-index,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    for (size_t ii = 0; ii < _motorCount; ++ii) {
+        motor_t& motor = _motors[ii];
+        motor.pin = pins[ii];
+#if defined(FRAMEWORK_RPI_PICO)
+        const auto slice = static_cast<uint8_t>(pwm_gpio_to_slice_num(motor.pin));
+        const uint32_t channel = pwm_gpio_to_channel(motor.pin);
+#else
+        // use the RPI Pico mapping of pins to PWM slices and channels
+        const auto slice = static_cast<uint8_t>((motor.pin >> 1U) & 0x07U);
+        const uint32_t channel = motor.pin & 0x01U;
+#endif
+        // channel B uses high order bits
+        motor.shift = channel == 0 ? 0 : 16;
+        // find the block in the DMA buffer for this slice, allocating a new one if required
+        size_t sliceIndex = 0;
+        while (sliceIndex < _sliceCount && _slices[sliceIndex] != slice) {
+            ++sliceIndex;
+        }
+        if (sliceIndex == _sliceCount) {
+            _slices[sliceIndex] = slice;
+            ++_sliceCount;
+        }
+        motor.sliceIndex = static_cast<uint8_t>(sliceIndex);
+    }
+
+#if defined(FRAMEWORK_RPI_PICO)
+    for (size_t ii = 0; ii < _motorCount; ++ii) {
+        gpio_set_function(_motors[ii].pin, GPIO_FUNC_PWM); // Set the pin to be PWM
+    }
+    _dmaChannelMask = 0;
+    for (size_t ii = 0; ii < _sliceCount; ++ii) {
+        const uint32_t slice = _slices[ii];
+        pwm_set_wrap(slice, _wrapCycleCount);
+        pwm_set_enabled(slice, true); // start the PWM
+
+        // Setup the DMA, one DMA channel per slice
+        enum { PANIC_IF_NONE_AVAILABLE = true };
+        const uint32_t dmaChannel = dma_claim_unused_channel(PANIC_IF_NONE_AVAILABLE);
+        _dmaChannels[ii] = dmaChannel;
+        _dmaChannelMask |= 1U << dmaChannel;
+
+        dma_channel_config dmaConfig = dma_channel_get_default_config(dmaChannel); // NOLINT(cppcoreguidelines-init-variables) false positive
+        channel_config_set_dreq(&dmaConfig, pwm_get_dreq(slice)); // Set the DMA Data Request (DREQ)
+        channel_config_set_transfer_data_size(&dmaConfig, DMA_SIZE_32);
+        channel_config_set_write_increment(&dmaConfig, false);
+        channel_config_set_read_increment(&dmaConfig, true);
+
+        dma_channel_configure(
+            dmaChannel,
+            &dmaConfig,
+            &pwm_hw->slice[slice].cc, // write to PWM counter compare
+            &_dmaBuffer[ii*DMA_BLOCK_SIZE], // read from this slice's block of the DMA buffer
+            DMA_BLOCK_SIZE,
+            DONT_START_YET
+        );
+    }
+#endif
+    // NOLINTEND(cppcoreguidelines-pro-bounds-constant-array-index,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+}
+
+/*!
+Encode all the motors' frames into the DMA buffer.
+
+Each frame is encoded as two byte lookups, rather than bit by bit.
+*/
+void ESC_DShotBatch::encode(const uint16_t* values)
+{
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-constant-array-index,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    // clear the pulse widths, leaving the terminating zero value of each block untouched
+    for (size_t ii = 0; ii < _sliceCount; ++ii) {
+        uint32_t* block = &_dmaBuffer[ii*DMA_BLOCK_SIZE];
+        for (size_t jj = 0; jj < DSHOT_BIT_COUNT; ++jj) {
+            block[jj] = 0;
+        }
+    }
+    for (size_t ii = 0; ii < _motorCount; ++ii) {
+        const motor_t& motor = _motors[ii];
+        const uint16_t frame = DShotCodec::frameUnidirectional(values[ii]);
+        const pulse_widths_t& high = _byteToPulseWidths[frame >> 8U];
+        const pulse_widths_t& low = _byteToPulseWidths[frame & 0xFFU];
+        uint32_t* block = &_dmaBuffer[motor.sliceIndex*DMA_BLOCK_SIZE];
+        for (size_t jj = 0; jj < 8; ++jj) {
+            block[jj] |= static_cast<uint32_t>(high[jj]) << motor.shift;
+            block[jj + 8] |= static_cast<uint32_t>(low[jj]) << motor.shift;
+        }
+    }
+    // NOLINTEND(cppcoreguidelines-pro-bounds-constant-array-index,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+}
+
+/*!
+Start the DMA transfers for all slices with a single trigger.
+*/
+void ESC_DShotBatch::start() // NOLINT(readability-make-member-function-const)
+{
+#if defined(FRAMEWORK_RPI_PICO)
+    for (size_t ii = 0; ii < _sliceCount; ++ii) {
+        dma_channel_set_trans_count(_dmaChannels[ii], DMA_BLOCK_SIZE, DONT_START_YET); // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+        dma_channel_set_read_addr(_dmaChannels[ii], &_dmaBuffer[ii*DMA_BLOCK_SIZE], DONT_START_YET); // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    }
+    dma_start_channel_mask(_dmaChannelMask);
+#elif defined(FRAMEWORK_ESPIDF)
+#elif defined(FRAMEWORK_TEST)
+#else // defaults to FRAMEWORK_ARDUINO
+#endif // FRAMEWORK, not implemented (and rejected at compile time by the mixers) for ESP-IDF and Arduino, see OUTPUT_IMPLEMENTED
+}
+
+/*!
+values should be in the DShot range [47,2047], there should be one value for each motor.
+*/
+void ESC_DShotBatch::write(const uint16_t* values)
+{
+    encode(values);
+    start();
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "ESC_DShot.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+
+/*!
+Multi-motor unidirectional DShot output engine.
+
+Encodes the frames for all motors in a single pass into one shared DMA buffer and then starts all the transfers with a single trigger,
+so all the ESCs receive their frames at the same time.
+
+Encoding uses a 256-entry lookup table that maps a byte of the frame to the 8 pulse widths for that byte, rather than a per-bit loop.
+
+The buffer is organised for the RPI Pico PWM peripheral: each PWM slice drives two pins, channel A in the low order 16 bits of the
+counter compare register, and channel B in the high order 16 bits. So motors on the same slice (eg pins 2 and 3) share the same part
+of the buffer and the same DMA channel, ie a QuadX on pins 2, 3, 4, and 5 uses two DMA channels rather than four.
+*/
+class ESC_DShotBatch {
+public:
+#if defined(FRAMEWORK_RPI_PICO) || defined(FRAMEWORK_TEST)
+    static constexpr bool OUTPUT_IMPLEMENTED = true;
+#else
+    //! the output is only implemented for the RPI Pico PWM peripheral, on ESP32 use ESC_DShot with USE_DSHOT_ESP32_RMT
+    static constexpr bool OUTPUT_IMPLEMENTED = false;
+#endif
+    enum { MAX_MOTOR_COUNT = 8 };
+    enum { DSHOT_BIT_COUNT = ESC_DShot::DSHOT_BIT_COUNT, DMA_BLOCK_SIZE = DSHOT_BIT_COUNT + 1 }; // extra 1 for terminating zero value
+    enum { MAX_SLICE_COUNT = MAX_MOTOR_COUNT };
+    typedef std::array<uint16_t, 8> pulse_widths_t;
+public:
+    explicit ESC_DShotBatch(ESC_DShot::protocol_e protocol);
+    ESC_DShotBatch() : ESC_DShotBatch(ESC_DShot::ESC_PROTOCOL_DSHOT300) {}
+    void init(const uint8_t* pins, size_t motorCount);
+    void setProtocol(ESC_DShot::protocol_e protocol);
+    size_t getMotorCount() const { return _motorCount; }
+    size_t getSliceCount() const { return _sliceCount; }
+
+    void write(const uint16_t* values); // values should be in the DShot range [47,2047]
+// for testing
+    uint32_t getDataHighPulseWidth() const { return _dataHighPulseWidth; }
+    uint32_t getDataLowPulseWidth() const { return _dataLowPulseWidth; }
+    uint32_t getBufferItem(size_t sliceIndex, size_t index) const { return _dmaBuffer[sliceIndex*DMA_BLOCK_SIZE + index]; }
+protected:
+    void encode(const uint16_t* values);
+    void start();
+protected:
+    struct motor_t {
+        uint8_t pin;
+        uint8_t sliceIndex; //!< index of the block in the DMA buffer
+        uint8_t shift; //!< 0 for channel A, 16 for channel B
+    };
+    ESC_DShot::protocol_e _protocol;
+    size_t _motorCount {0};
+    size_t _sliceCount {0};
+    std::array<motor_t, MAX_MOTOR_COUNT> _motors {};
+    std::array<uint8_t, MAX_SLICE_COUNT> _slices {}; //!< PWM slice number for each block in the DMA buffer
+    uint32_t _dataHighPulseWidth {};
+    uint32_t _dataLowPulseWidth {};
+    uint32_t _wrapCycleCount {};
+#if defined(FRAMEWORK_RPI_PICO)
+    enum { START_IMMEDIATELY = true, DONT_START_YET = false };
+    std::array<uint32_t, MAX_SLICE_COUNT> _dmaChannels {};
+    uint32_t _dmaChannelMask {};
+#endif
+    std::array<pulse_widths_t, 256> _byteToPulseWidths {};
+    std::array<uint32_t, MAX_SLICE_COUNT*DMA_BLOCK_SIZE> _dmaBuffer {};
+};
@@ -4,11 +4,54 @@
 #include <array>
 
 #if defined(FRAMEWORK_ARDUINO_STM32)
+namespace {
+/*!
+Timer and DMA stream used by each port, allocated in the order the ports are first used by the motors.
+Only DMA2 can access the GPIO ports, and DMA2 Stream6 Channel0 and Stream2 Channel0 are triggered by TIM1_CH1 and TIM8_CH1 respectively.
+*/
+struct port_resources_t {
+    TIM_TypeDef* TIM;
+    uint32_t TIMxEN;
+    DMA_Stream_TypeDef* DMA_Stream;
+    size_t dmaStreamIndex;
+    IRQn_Type irq;
+};
+const std::array<port_resources_t, ESC_DShotBitbang::MAX_PORT_COUNT> portResources {{
+    { TIM1, RCC_APB2ENR_TIM1EN, DMA2_Stream6, 6, DMA2_Stream6_IRQn },
+    { TIM8, RCC_APB2ENR_TIM8EN, DMA2_Stream2, 2, DMA2_Stream2_IRQn }
+}};
+} // END namespace
+
+/*!
+DMA2 interrupt handler, called by DMA2_StreamN_IRQHandler.
+*/
+void ESC_DShotBitbang::DMA_IRQ_Handler(size_t dmaStreamIndex)
+{
+    // the flags for streams 0 to 3 are in LISR, those for streams 4 to 7 are in HISR, at bit offsets 0, 6, 16, and 22
+    static constexpr std::array<uint32_t, 4> flagShifts = { 0, 6, 16, 22 };
+    const uint32_t shift = flagShifts[dmaStreamIndex & 0x03U];
+    const bool highRegister = dmaStreamIndex >= 4;
+    const uint32_t flags = ((highRegister ? DMA2->HISR : DMA2->LISR) >> shift) & (DMA_LISR_TCIF0 | DMA_LISR_HTIF0 | DMA_LISR_TEIF0 | DMA_LISR_DMEIF0);
+    // clear the flags that are set
+    if (highRegister) {
+        DMA2->HIFCR = flags << shift;
+    } else {
+        DMA2->LIFCR = flags << shift;
+    }
+    if (flags & DMA_LISR_TCIF0) {
+        port_t* port = self->_dmaStreamToPort[dmaStreamIndex];
+        if (port != nullptr && port->reception) {
+            IRQ_Handler(*port);
+        }
+    }
+}
+
+/*!
+Called when the transmission of the DShot frames on a port has completed: switches the port's pins to input and starts sampling the replies.
+*/
 void ESC_DShotBitbang::IRQ_Handler(port_t& port)
 {
     // set GPIOs as inputs:
-    //port.GPIO->MODER &= ~GPIO_MODER_MODER2;
-    //port.GPIO->MODER &= ~GPIO_MODER_MODER3;
     port.GPIO->MODER &= port.GPIO_input;
     // set pull up for those pins:
     port.GPIO->PUPDR |= port.GPIO_PUPDR;
@@ -17,20 +60,25 @@ void ESC_DShotBitbang::IRQ_Handler(port_t& port)
     port.TIM->ARR = DSHOT_BB_FRAME_LENGTH * DSHOT_MODE / BDSHOT_RESPONSE_BITRATE / ESC_DShotBitbang::RESPONSE_OVERSAMPLING - 1;
     port.TIM->CCR1 = DSHOT_BB_FRAME_LENGTH * DSHOT_MODE / BDSHOT_RESPONSE_BITRATE / ESC_DShotBitbang::RESPONSE_OVERSAMPLING;
 
-    // Set DMA to copy GPIOA->IDR register value to the _dmaInputBufferA buffer).
+    // Set DMA to copy the port's IDR register value to the port's dmaInputBuffer).
     port.DMA_Stream->CR &= ~(DMA_SxCR_DIR);
-    port.DMA_Stream->PAR = reinterpret_cast<uint32_t>(&(GPIOA->IDR)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
-    port.DMA_Stream->M0AR = reinterpret_cast<uint32_t>(&ESC_DShotBitbang::self->_portA.dmaInputBuffer[0]); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+    port.DMA_Stream->PAR = reinterpret_cast<uint32_t>(&(port.GPIO->IDR)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+    port.DMA_Stream->M0AR = reinterpret_cast<uint32_t>(&port.dmaInputBuffer[0]); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
     // Main idea:
     // After sending DShot frame to ESC start receiving GPIO values.
     // Capture data (probing longer than ESC response).
     // There is ~33 [us] gap before the response so it is necessary to add more samples:
     // NDTR: number of data register
-    port.DMA_Stream->NDTR = (33 * BDSHOT_RESPONSE_BITRATE / 1000 + BDSHOT_RESPONSE_LENGTH + 1) * ESC_DShotBitbang::RESPONSE_OVERSAMPLING;
+    port.DMA_Stream->NDTR = DMA_INPUT_BUFFER_LENGTH;
 
     port.DMA_Stream->CR |= DMA_SxCR_EN;
     port.reception = false;
 }
+#else
+void ESC_DShotBitbang::IRQ_Handler(port_t& port)
+{
+    port.reception = false;
+}
 #endif
 
 ESC_DShotBitbang::ESC_DShotBitbang()
@@ -38,40 +86,75 @@ ESC_DShotBitbang::ESC_DShotBitbang()
     self = this;
 }
 
-void ESC_DShotBitbang::init()
+/*!
+Sets the motor pins, grouping the motors by GPIO port.
+
+Returns false if there are more than MAX_MOTOR_COUNT motors or the motors are on more than MAX_PORT_COUNT ports.
+*/
+bool ESC_DShotBitbang::init(const port_pin_t* motorPins, size_t motorCount)
 {
-    presetDMA_outputBuffers();
-#if defined(FRAMEWORK_ARDUINO_STM32)
+    if (motorCount > MAX_MOTOR_COUNT) {
+        return false;
+    }
+    _motorCount = motorCount;
+    _portCount = 0;
+
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-constant-array-index,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    for (size_t ii = 0; ii < motorCount; ++ii) {
+        const port_pin_t& motorPin = motorPins[ii];
+        _motorPins[ii] = motorPin;
+        size_t portIndex = 0;
+        while (portIndex < _portCount && _ports[portIndex].gpioPort != motorPin.port) {
+            ++portIndex;
+        }
+        if (portIndex == _portCount) {
+            if (_portCount == MAX_PORT_COUNT) {
+                return false;
+            }
+            _ports[portIndex] = port_t {};
+            _ports[portIndex].gpioPort = motorPin.port;
+            ++_portCount;
+        }
+        port_t& port = _ports[portIndex];
+        port.motorIndices[port.motorCount] = static_cast<uint8_t>(ii);
+        ++port.motorCount;
+        port.pinMask |= 1U << motorPin.pin;
+    }
 
-    _portA.GPIO = GPIOA;
-    _portB.GPIO_input = ~(GPIO_MODER_MODER2   | GPIO_MODER_MODER3);
-    _portA.GPIO_output =  GPIO_MODER_MODER2_0 | GPIO_MODER_MODER3_0;
-    _portA.GPIO_PUPDR =   GPIO_PUPDR_PUPDR2_0 | GPIO_PUPDR_PUPDR3_0;
-    setupGPIO(_portA.GPIO, RCC_AHB1ENR_GPIOAEN, GPIO_OSPEEDER_OSPEEDR2 | GPIO_OSPEEDER_OSPEEDR3);
-
-    _portB.GPIO = GPIOB;
-    _portB.GPIO_input = ~(GPIO_MODER_MODER0   | GPIO_MODER_MODER1);
-    _portB.GPIO_output =  GPIO_MODER_MODER0_0 | GPIO_MODER_MODER1_0;
-    _portB.GPIO_PUPDR =   GPIO_PUPDR_PUPDR0_0 | GPIO_PUPDR_PUPDR1_0;
-    setupGPIO(_portB.GPIO, RCC_AHB1ENR_GPIOBEN, GPIO_OSPEEDER_OSPEEDR0 | GPIO_OSPEEDER_OSPEEDR1);
-
-    _portA.DMA_Stream = DMA2_Stream6;
-    setupDMA(_portA.DMA_Stream, RCC_AHB1ENR_DMA1EN);
-    _portB.DMA_Stream = DMA2_Stream2;
-    setupDMA(_portB.DMA_Stream, RCC_AHB1ENR_DMA2EN);
-
-    _portA.TIM = TIM1;
-    setupTimers(_portA.TIM, RCC_APB2ENR_TIM1EN);
-    _portB.TIM = TIM8;
-    setupTimers(_portB.TIM, RCC_APB2ENR_TIM8EN);
-
-    // Nested Vectored Interrupt Controller
-    // enable DMA interrupts
-    NVIC_EnableIRQ(DMA2_Stream6_IRQn);
-    NVIC_SetPriority(DMA2_Stream6_IRQn, 13);
-    NVIC_EnableIRQ(DMA2_Stream2_IRQn);
-    NVIC_SetPriority(DMA2_Stream2_IRQn, 14);
+    for (size_t ii = 0; ii < _portCount; ++ii) {
+        port_t& port = _ports[ii];
+        presetDMA_outputBuffers(port);
+#if defined(FRAMEWORK_ARDUINO_STM32)
+        uint32_t moder = 0;
+        uint32_t ospeedr = 0;
+        for (uint32_t pin = 0; pin < 16; ++pin) {
+            if (port.pinMask & (1U << pin)) {
+                moder |= GPIO_MODER_MODER0 << (pin * 2);
+                ospeedr |= GPIO_OSPEEDER_OSPEEDR0 << (pin * 2);
+            }
+        }
+        // the GPIO ports are evenly spaced in memory
+        port.GPIO = reinterpret_cast<GPIO_TypeDef*>(GPIOA_BASE + port.gpioPort * (GPIOB_BASE - GPIOA_BASE)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,performance-no-int-to-ptr)
+        port.GPIO_input = ~moder;
+        port.GPIO_output = moder & 0x55555555U; // 01 (output) for each pin
+        port.GPIO_PUPDR = moder & 0x55555555U; // 01 (pull up) for each pin
+        setupGPIO(port.GPIO, RCC_AHB1ENR_GPIOAEN << port.gpioPort, ospeedr);
+
+        const port_resources_t& resources = portResources[ii];
+        port.DMA_Stream = resources.DMA_Stream;
+        setupDMA(port.DMA_Stream, RCC_AHB1ENR_DMA2EN);
+        port.TIM = resources.TIM;
+        setupTimers(port.TIM, resources.TIMxEN);
+        _dmaStreamToPort[resources.dmaStreamIndex] = &port;
+
+        // Nested Vectored Interrupt Controller
+        // enable DMA interrupts
+        NVIC_EnableIRQ(resources.irq);
+        NVIC_SetPriority(resources.irq, 13 + ii);
 #endif
+    }
+    // NOLINTEND(cppcoreguidelines-pro-bounds-constant-array-index,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    return true;
 }
 
 /* IMPORTANT:
@@ -140,96 +223,74 @@ void ESC_DShotBitbang::setupTimers(TIM_TypeDef* TIM, uint32_t TIMxEN)
 }
 #endif //FRAMEWORK_ARDUINO_STM32
 
-// values should be in the DShot range [47,2047]
-void ESC_DShotBitbang::outputToMotors(uint16_t m1_value, uint16_t m2_value, uint16_t m3_value, uint16_t m4_value)
+/*!
+values should be in the DShot range [47,2047], there should be one value for each motor.
+*/
+void ESC_DShotBitbang::outputToMotors(const uint16_t* values)
 {
     update_motors_rpm();
 
-    setDMA_outputBuffers(
-        DShotCodec::frameBidirectional(m1_value),
-        DShotCodec::frameBidirectional(m2_value),
-        DShotCodec::frameBidirectional(m3_value),
-        DShotCodec::frameBidirectional(m4_value)
-    );
-
-    _portA.reception = true;
-    _portB.reception = true;
+    std::array<uint16_t, MAX_MOTOR_COUNT> frames {};
+    for (size_t ii = 0; ii < _motorCount; ++ii) {
+        frames[ii] = DShotCodec::frameBidirectional(values[ii]); // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    }
+    for (size_t ii = 0; ii < _portCount; ++ii) {
+        port_t& port = _ports[ii]; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+        setDMA_outputBuffers(port, &frames[0]);
+        port.reception = true;
+    }
 
 #if defined(FRAMEWORK_ARDUINO_STM32)
-    // set GPIOs as output:
-    // MODER: GPIO port mode register
-    _portA.GPIO->MODER |= _portA.GPIO_output;
-    _portB.GPIO->MODER |= _portB.GPIO_output;
-
-    // CR:   DMA stream x configuration register
-    // NDTR: DMA stream x number of data register
-    // PAR:  DMA stream x peripheral address register
-    // M0AR: DMA stream x memory 0 address register
-    _portA.DMA_Stream->CR |= DMA_SxCR_DIR_0;
-    _portA.DMA_Stream->PAR = reinterpret_cast<uint32_t>(&(_portA.GPIO->BSRR));
-    _portA.DMA_Stream->M0AR = reinterpret_cast<uint32_t>(&_portA.dmaOutputBuffer[0]);
-    _portA.DMA_Stream->NDTR = DSHOT_BB_BUFFER_LENGTH * DSHOT_BB_FRAME_SECTIONS;
-
-    _portB.DMA_Stream->CR |= DMA_SxCR_DIR_0;
-    _portB.DMA_Stream->PAR = reinterpret_cast<uint32_t>(&(_portB.GPIO->BSRR));
-    _portB.DMA_Stream->M0AR = reinterpret_cast<uint32_t>(&_portB.dmaOutputBuffer[0]);
-    _portB.DMA_Stream->NDTR = DSHOT_BB_BUFFER_LENGTH * DSHOT_BB_FRAME_SECTIONS;
+    for (size_t ii = 0; ii < _portCount; ++ii) {
+        port_t& port = _ports[ii];
+        // set GPIOs as output:
+        // MODER: GPIO port mode register
+        port.GPIO->MODER |= port.GPIO_output;
+
+        // CR:   DMA stream x configuration register
+        // NDTR: DMA stream x number of data register
+        // PAR:  DMA stream x peripheral address register
+        // M0AR: DMA stream x memory 0 address register
+        port.DMA_Stream->CR |= DMA_SxCR_DIR_0;
+        port.DMA_Stream->PAR = reinterpret_cast<uint32_t>(&(port.GPIO->BSRR));
+        port.DMA_Stream->M0AR = reinterpret_cast<uint32_t>(&port.dmaOutputBuffer[0]);
+        port.DMA_Stream->NDTR = DMA_OUTPUT_BUFFER_LENGTH;
 
 #if defined(BIT_BANGING_V1)
-    // Main idea:
-    // Every bit frame is divided in sections and for each section DMA request is generated.
-    // After some sections (at beginning, after 0-bit time and after 1-bit time) to GPIO register can be sent value to set 1 or to set 0.
-    // For rest of the sections 0x0 is sent so GPIOs don't change values.
-    // It uses only 1 CCR on each timer.
-    // Idea for reception is the same.
-
-    // portA TIM setup:
-    _portA.TIM->CR1 &= ~TIM_CR1_CEN;
-    _portA.TIM->ARR = DSHOT_BB_FRAME_LENGTH / DSHOT_BB_FRAME_SECTIONS - 1;
-    _portA.TIM->CCR1 = DSHOT_BB_FRAME_LENGTH / DSHOT_BB_FRAME_SECTIONS;
-
-    // porB TIM setup:
-    _portB.TIM->CR1 &= ~TIM_CR1_CEN;
-    _portB.TIM->CCR1 = DSHOT_BB_FRAME_LENGTH / DSHOT_BB_FRAME_SECTIONS;
-    _portB.TIM->ARR = DSHOT_BB_FRAME_LENGTH / DSHOT_BB_FRAME_SECTIONS - 1;
-
-    // send
-    _portA.DMA_Stream->CR |= DMA_SxCR_EN;
-    _portB.DMA_Stream->CR |= DMA_SxCR_EN;
-
-    // EGR: event generation register
-    // CR: Control Register
-    _portA.TIM->EGR |= TIM_EGR_UG; // Update Generation
-    _portA.TIM->CR1 |= TIM_CR1_CEN; // Counter Enable
-    _portB.TIM->EGR |= TIM_EGR_UG;
-    _portB.TIM->CR1 |= TIM_CR1_CEN;
+        // Main idea:
+        // Every bit frame is divided in sections and for each section DMA request is generated.
+        // After some sections (at beginning, after 0-bit time and after 1-bit time) to GPIO register can be sent value to set 1 or to set 0.
+        // For rest of the sections 0x0 is sent so GPIOs don't change values.
+        // It uses only 1 CCR on each timer.
+        // Idea for reception is the same.
+        port.TIM->CR1 &= ~TIM_CR1_CEN;
+        port.TIM->ARR = DSHOT_BB_FRAME_LENGTH / DSHOT_BB_FRAME_SECTIONS - 1;
+        port.TIM->CCR1 = DSHOT_BB_FRAME_LENGTH / DSHOT_BB_FRAME_SECTIONS;
+        port.DMA_Stream->CR |= DMA_SxCR_EN;
 #elif defined(BIT_BANGING_V2)
-    // Main idea:
-    // DMA requests generated at beginning, after 0-bit time and after 1-bit time
-    // for each bit there is only 3 sections -> buffers are much smaller than in version 1
-    // but uses 3 CCR (capture/compare register) for each timer (probably not a big deal)
-    // It works for transferring but for reception it is not useful
-
-    //    TIM1 setup:
-    _portA.TIM->CCR1 = 0;
-    _portA.TIM->CCR2 = DSHOT_BB_0_LENGTH;
-    _portA.TIM->CCR3 = DSHOT_BB_1_LENGTH;
-    _portA.TIM->ARR = DSHOT_BB_FRAME_LENGTH - 1;
-
-    // TIM8 setup:
-    _portB.TIM->CCR1 = 0;
-    _portB.TIM->CCR2 = DSHOT_BB_0_LENGTH;
-    _portB.TIM->CCR3 = DSHOT_BB_1_LENGTH;
-    _portB.TIM->ARR = DSHOT_BB_FRAME_LENGTH - 1;
-
-    //  send:
-    _portA.TIM->EGR |= TIM_EGR_UG;
-    _portA.TIM->CR1 |= TIM_CR1_CEN;
-    _portB.TIM->EGR |= TIM_EGR_UG;
-    _portB.TIM->CR1 |= TIM_CR1_CEN;
-
-    _portA.DMA_Stream->CR |= DMA_SxCR_EN;
-    _portB.DMA_Stream->CR |= DMA_SxCR_EN;
+        // Main idea:
+        // DMA requests generated at beginning, after 0-bit time and after 1-bit time
+        // for each bit there is only 3 sections -> buffers are much smaller than in version 1
+        // but uses 3 CCR (capture/compare register) for each timer (probably not a big deal)
+        // It works for transferring but for reception it is not useful
+        port.TIM->CCR1 = 0;
+        port.TIM->CCR2 = DSHOT_BB_0_LENGTH;
+        port.TIM->CCR3 = DSHOT_BB_1_LENGTH;
+        port.TIM->ARR = DSHOT_BB_FRAME_LENGTH - 1;
+#endif
+    }
+    // start the timers in a separate loop, so the transmissions on all the ports start as close together as possible
+    for (size_t ii = 0; ii < _portCount; ++ii) {
+        port_t& port = _ports[ii];
+        // EGR: event generation register
+        // CR: Control Register
+        port.TIM->EGR |= TIM_EGR_UG; // Update Generation
+        port.TIM->CR1 |= TIM_CR1_CEN; // Counter Enable
+    }
+#if defined(BIT_BANGING_V2)
+    for (size_t ii = 0; ii < _portCount; ++ii) {
+        _ports[ii].DMA_Stream->CR |= DMA_SxCR_EN;
+    }
 #endif
 #endif // FRAMEWORK_ARDUINO_STM32
 }
@@ -274,13 +335,14 @@ Method 2 uses 3 sections for each bit and variable length sections
 This requires smaller buffers, has lower DMA load, has more precise timing, but requires more timer channels
 */
 
-void ESC_DShotBitbang::presetDMA_outputBuffers()
+void ESC_DShotBitbang::presetDMA_outputBuffers(port_t& port) const
 {
+    const auto setBits = static_cast<uint32_t>(GPIO_BSRR_BS_0 * port.pinMask);
+    const auto resetBits = static_cast<uint32_t>(GPIO_BSRR_BR_0 * port.pinMask);
 
     // this values are constant so they can be set once here
 #if defined(BIT_BANGING_V1)
-    _portA.dmaOutputBuffer.fill(0);
-    _portB.dmaOutputBuffer.fill(0);
+    port.dmaOutputBuffer.fill(0);
 
     // for DSHOT_BB_FRAME_SECTIONS=14, DSHOT_BB_1_LENGTH=10 we have
     // r means BR (Bit Reset) (ie set to 0)
@@ -292,8 +354,7 @@ void ESC_DShotBitbang::presetDMA_outputBuffers()
 #else
     // make 2 high frames after Dshot frame:
     for (auto i = 0; i < DSHOT_BB_FRAME_SECTIONS * 2; i++) {
-        _portA.dmaOutputBuffer[DSHOT_BUFFER_LENGTH*DSHOT_BB_FRAME_SECTIONS - i - 1] = (GPIO_BSRR_BS_0 << MOTOR_1) | (GPIO_BSRR_BS_0 << MOTOR_4);
-        _portB.dmaOutputBuffer[DSHOT_BUFFER_LENGTH*DSHOT_BB_FRAME_SECTIONS - i - 1] = (GPIO_BSRR_BS_0 << MOTOR_2) | (GPIO_BSRR_BS_0 << MOTOR_3);
+        port.dmaOutputBuffer[DSHOT_BUFFER_LENGTH*DSHOT_BB_FRAME_SECTIONS - i - 1] = setBits;
     }
     const size_t highOffset = 2;
 #endif
@@ -301,16 +362,16 @@ void ESC_DShotBitbang::presetDMA_outputBuffers()
     for (auto i = 0; i < DSHOT_BB_BUFFER_LENGTH - 2; i++) { // last 2 bits are always high (logic 0)
         const auto index = i * DSHOT_BB_FRAME_SECTIONS;
         //  first section always lower edge:
-        _portA.dmaOutputBuffer[index] = (GPIO_BSRR_BR_0 << MOTOR_1) | (GPIO_BSRR_BR_0 << MOTOR_4);
-        _portB.dmaOutputBuffer[index] = (GPIO_BSRR_BR_0 << MOTOR_2) | (GPIO_BSRR_BR_0 << MOTOR_3);
-
+        port.dmaOutputBuffer[index] = resetBits;
         // last section always rise edge:
-        _portA.dmaOutputBuffer[index + highOffset] = (GPIO_BSRR_BS_0 << MOTOR_1) | (GPIO_BSRR_BS_0 << MOTOR_4);
-        _portB.dmaOutputBuffer[index + highOffset] = (GPIO_BSRR_BS_0 << MOTOR_2) | (GPIO_BSRR_BS_0 << MOTOR_3);
+        port.dmaOutputBuffer[index + highOffset] = setBits;
     }
 }
 
-void ESC_DShotBitbang::setDMA_outputBuffers(uint16_t m1_frame, uint16_t m2_frame, uint16_t m3_frame, uint16_t m4_frame)
+/*!
+frames are indexed by motor index, only the frames of the motors on the port are used.
+*/
+void ESC_DShotBitbang::setDMA_outputBuffers(port_t& port, const uint16_t* frames) const
 {
 /*
 For each output bit DMA is transfering DSHOT_BB_FRAME_SECTIONS (14) times data into GPIO register.
@@ -328,12 +389,12 @@ In addition last 2 frame bits are set always high
 // note: bidirectional DShot is inverted so we have (eg) 0001111111111 rather than 111000000000
 // for DSHOT_BB_FRAME_SECTIONS=14, DSHOT_BB_0_LENGTH=4 we have
 //
-// in case where bit in motor frame bit is set
+// in case where bit in motor frame bit is not set
 //                      01234567890123
 //     buffer (preset): r000000000s000
 //     buffer (set):    r00s000000s000
 //     resultant GPIO:  00011111111111
-// in case where bit in motor frame bit is not set
+// in case where bit in motor frame bit is set
 //                      01234567890123
 //     buffer (preset): r00000000s0000
 //     buffer (set):    r00000000s0000
@@ -348,18 +409,39 @@ In addition last 2 frame bits are set always high
     size_t index = 1;
 #endif
     for (uint32_t bitMask = 0x8000; bitMask !=0; bitMask >>= 1) {
-        _portA.dmaOutputBuffer[index] = (bitMask & m1_frame) ? 0x00 : GPIO_BSRR_BS_0 << MOTOR_1;
-        if (bitMask & m4_frame) {
-            _portA.dmaOutputBuffer[index] |= GPIO_BSRR_BS_0 << MOTOR_4;
-        }
-        _portB.dmaOutputBuffer[index] = (bitMask & m2_frame) ? 0x00 : GPIO_BSRR_BS_0 << MOTOR_2;
-        if (bitMask & m3_frame) {
-            _portB.dmaOutputBuffer[index] |= GPIO_BSRR_BS_0 << MOTOR_3;
+        uint32_t value = 0;
+        for (size_t ii = 0; ii < port.motorCount; ++ii) {
+            const size_t motorIndex = port.motorIndices[ii];
+            if ((frames[motorIndex] & bitMask) == 0) { // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                value |= static_cast<uint32_t>(GPIO_BSRR_BS_0 << _motorPins[motorIndex].pin);
+            }
         }
+        port.dmaOutputBuffer[index] = value;
         index += DSHOT_BB_FRAME_SECTIONS;
     }
 }
 
+/*!
+Returns the sample at index, with single sample glitches removed: each pin takes the majority value of the sample and its two neighbours.
+A bit lasts RESPONSE_OVERSAMPLING samples, so this does not remove any genuine bits.
+*/
+static inline uint32_t filteredSample(const uint32_t* samples, size_t index, size_t sampleCount)
+{
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    const uint32_t sample = samples[index];
+    const uint32_t previous = index == 0 ? sample : samples[index - 1];
+    const uint32_t next = index + 1 < sampleCount ? samples[index + 1] : sample;
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    return (previous & sample) | (previous & next) | (sample & next);
+}
+
+//! Returns the number of bits in a run of sampleCount samples with the same value, rounded so that edges may be one sample early or late
+static inline uint32_t runBitCount(uint32_t sampleCount)
+{
+    const uint32_t bitCount = (sampleCount + ESC_DShotBitbang::RESPONSE_OVERSAMPLING / 2) / ESC_DShotBitbang::RESPONSE_OVERSAMPLING;
+    return (bitCount > 1) ? bitCount : 1;
+}
+
 /*!
 Decodes the samples in the raw buffer.
 
@@ -368,6 +450,8 @@ There are 5 samples per bit, so for 21 bits there are 105 samples - in the ideal
 1 is encoded as 0,0,0,0,1
 
 In actual received data these may vary because of jitter.
+Single sample glitches are removed by filteredSample(), and run lengths are rounded to the nearest whole number of bits,
+so an edge sampled one sample early or late still decodes correctly.
 
 Converts a buffer of samples (obtained from DMA) to a gcr21 value
 */
@@ -381,7 +465,7 @@ uint32_t ESC_DShotBitbang::samples_to_GCR21(const uint32_t* samples, uint32_t mo
 
     // Reception starts just after transmission, so there is a lot of HIGH samples. Find first LOW bit:
     while (i < (33 * BDSHOT_RESPONSE_BITRATE / 1000 * RESPONSE_OVERSAMPLING)) {
-        if (!(samples[i] & motorMask)) { // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        if (!(filteredSample(samples, i, DMA_INPUT_BUFFER_LENGTH) & motorMask)) {
             previous_value = 0;
             previous_i = i;
             end_i = i + BDSHOT_RESPONSE_LENGTH * RESPONSE_OVERSAMPLING;
@@ -399,10 +483,9 @@ uint32_t ESC_DShotBitbang::samples_to_GCR21(const uint32_t* samples, uint32_t mo
     uint32_t gcr21 = 0;
     while (i < end_i) {
         // then look for changes in bits values and compute BDSHOT bits:
-        const uint32_t value = samples[i] & motorMask; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        const uint32_t value = filteredSample(samples, i, DMA_INPUT_BUFFER_LENGTH) & motorMask;
         if (value != previous_value) {
-            const uint32_t rlen = (i - previous_i) / RESPONSE_OVERSAMPLING;
-            const uint32_t len = (rlen > 1) ? rlen : 1; // how many bits had the same value
+            const uint32_t len = runBitCount(i - previous_i); // how many bits had the same value
             bitCount += len;
             gcr21 <<= len;
             if (previous_value != 0) {
@@ -414,44 +497,154 @@ uint32_t ESC_DShotBitbang::samples_to_GCR21(const uint32_t* samples, uint32_t mo
         i++;
     }
     // if last bits were 1 they were not added so far
-    gcr21 <<= (BDSHOT_RESPONSE_LENGTH - bitCount);
-    gcr21 |= 0x1FFFFF >> bitCount; // 21 ones right-shifted
+    if (bitCount < BDSHOT_RESPONSE_LENGTH) {
+        gcr21 <<= (BDSHOT_RESPONSE_LENGTH - bitCount);
+        gcr21 |= 0x1FFFFF >> bitCount; // 21 ones right-shifted
+    }
 
     return gcr21;
 }
 
 /*!
-Converts gcr21 value to a buffer of samples, used for test code
+Decodes the responses of all the motors on a port in a single pass through the samples.
+
+samples_to_GCR21() scans the samples once for each motor. Here each (glitch filtered) sample word is XORed with the previous one,
+giving the edges on all the pins at once, and only pins with an edge need any further processing.
+Since a response has about 10 edges in 105 samples, most samples are dealt with by the majority filter, a single XOR and a test.
+
+The results are the same as calling samples_to_GCR21() for each pin.
+gcr21s is indexed by pin number, pins that are not in pinMask, or have no response, are set to 0xFFFFFFFF.
+*/
+void ESC_DShotBitbang::samples_to_GCR21s(const uint32_t* samples, size_t sampleCount, uint32_t pinMask, gcr21s_t& gcr21s)
+{
+    struct decoder_t {
+        uint32_t gcr21;
+        uint32_t bitCount;
+        uint32_t previousIndex;
+        uint32_t endIndex;
+        uint32_t previousValue;
+    };
+    std::array<decoder_t, PIN_COUNT> decoders {};
+
+    // Reception starts just after transmission, so there is a lot of HIGH samples: pins are waiting until their first LOW sample.
+    const size_t startSearchLimit = 33 * BDSHOT_RESPONSE_BITRATE / 1000 * RESPONSE_OVERSAMPLING;
+    uint32_t waiting = pinMask;
+    uint32_t receiving = 0;
+    uint32_t started = 0;
+    uint32_t previous = pinMask; // the lines are idle high
+
+    for (uint32_t ii = 0; ii < sampleCount; ++ii) {
+        if (ii == startSearchLimit) {
+            waiting = 0; // pins with no LOW sample yet have no response
+        }
+        const uint32_t sample = filteredSample(samples, ii, sampleCount);
+        uint32_t edges = (sample ^ previous) & (waiting | receiving);
+        previous = sample;
+        while (edges != 0) {
+            const auto pin = static_cast<uint32_t>(__builtin_ctz(edges));
+            const uint32_t pinBit = 1U << pin;
+            edges &= edges - 1; // clear lowest set bit
+            decoder_t& decoder = decoders[pin];
+            if (waiting & pinBit) {
+                // LOW edge, so start of response
+                waiting &= ~pinBit;
+                receiving |= pinBit;
+                started |= pinBit;
+                decoder.previousIndex = ii;
+                decoder.endIndex = ii + BDSHOT_RESPONSE_LENGTH * RESPONSE_OVERSAMPLING;
+                continue;
+            }
+            if (ii >= decoder.endIndex) {
+                receiving &= ~pinBit;
+                continue;
+            }
+            const uint32_t len = runBitCount(ii - decoder.previousIndex); // how many bits had the same value
+            decoder.bitCount += len;
+            decoder.gcr21 <<= len;
+            if (decoder.previousValue != 0) {
+                decoder.gcr21 |= (0x1FFFFF >> (21 - len)); // 21 ones right-shifted by 20 or less
+            }
+            decoder.previousValue = sample & pinBit;
+            decoder.previousIndex = ii;
+        }
+        if ((waiting | receiving) == 0) {
+            break;
+        }
+    }
+
+    for (uint32_t pin = 0; pin < PIN_COUNT; ++pin) {
+        if ((started & (1U << pin)) == 0) {
+            // LOW edge was not found so return incorrect motor response:
+            gcr21s[pin] = 0xFFFFFFFF;
+            continue;
+        }
+        // if last bits were 1 they were not added so far
+        const decoder_t& decoder = decoders[pin];
+        gcr21s[pin] = decoder.bitCount < BDSHOT_RESPONSE_LENGTH ?
+            (decoder.gcr21 << (BDSHOT_RESPONSE_LENGTH - decoder.bitCount)) | (0x1FFFFF >> decoder.bitCount) :
+            decoder.gcr21;
+    }
+}
+
+/*!
+Converts gcr21 value to a buffer of samples, used for test code.
+
+The response starts at startIndex, and each bit is sampled RESPONSE_OVERSAMPLING times.
+Only the motorMask bits of the samples are changed, so the responses of several motors on the same port can be combined.
+The samples must be DMA_INPUT_BUFFER_LENGTH long and should be initialized to all 1s (idle high) before the first call.
 */
-void ESC_DShotBitbang::GCR21_to_samples(uint32_t* samples, uint32_t motorMask, uint32_t gcr21)
+void ESC_DShotBitbang::GCR21_to_samples(uint32_t* samples, uint32_t motorMask, uint32_t gcr21, size_t startIndex)
 {
-    *samples = 0;
-    (void)motorMask;
-    (void)gcr21;
+    size_t index = startIndex;
+    for (uint32_t bitMask = 1U << (BDSHOT_RESPONSE_LENGTH - 1); bitMask != 0; bitMask >>= 1U) {
+        for (size_t ii = 0; ii < RESPONSE_OVERSAMPLING && index < DMA_INPUT_BUFFER_LENGTH; ++ii) {
+            if (gcr21 & bitMask) {
+                samples[index] |= motorMask;
+            } else {
+                samples[index] &= ~motorMask;
+            }
+            ++index;
+        }
+    }
 }
 
 void ESC_DShotBitbang::update_motors_rpm()
 {
     // BDshot bit banging reads whole GPIO register.
     // Now it's time to create BDshot responses from all motors (made of individual bits).
-    const std::array<uint32_t, 4> motorGCR21s  = {
-        samples_to_GCR21(&_portA.dmaInputBuffer[0], 1 << MOTOR_1),
-        samples_to_GCR21(&_portB.dmaInputBuffer[0], 1 << MOTOR_2),
-        samples_to_GCR21(&_portB.dmaInputBuffer[0], 1 << MOTOR_3),
-        samples_to_GCR21(&_portA.dmaInputBuffer[0], 1 << MOTOR_4)
-    };
-    for (size_t ii = 0; ii < motorGCR21s.size(); ++ii) {
-        const uint32_t motorGCR20 = DShotCodec::GCR21_to_GCR20(motorGCR21s[ii]);
+    for (size_t ii = 0; ii < _portCount; ++ii) {
+        decodePort(_ports[ii]);
+    }
+}
+
+void ESC_DShotBitbang::decodePort(const port_t& port)
+{
+    // decode the responses of all the motors on the port in one pass
+    gcr21s_t gcr21s; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init) initialized in samples_to_GCR21s
+    samples_to_GCR21s(&port.dmaInputBuffer[0], port.dmaInputBuffer.size(), port.pinMask, gcr21s);
+    for (size_t ii = 0; ii < port.motorCount; ++ii) {
+        const size_t motorIndex = port.motorIndices[ii];
+        const uint32_t motorGCR21 = gcr21s[_motorPins[motorIndex].pin];
+        const uint32_t motorGCR20 = DShotCodec::GCR21_to_GCR20(motorGCR21);
         const uint16_t eRPM = DShotCodec::GCR20_to_eRPM(motorGCR20);
+        ++_motorReadCounts[motorIndex];
+        bool received = false;
         if (DShotCodec::checksumBidirectionalIsOK(eRPM)) {
             DShotCodec::telemetry_type_e telemetryType {};
             const auto eRPM_periodMicroSeconds = DShotCodec::decodeTelemetryFrame(eRPM >> 4, telemetryType);
-            enum { ONE_MINUTE_IN_MICROSECONDS = 60000000 };
-            // value is eRPM period in microseconds
-            _eRPMs[ii] = static_cast<int32_t>(ONE_MINUTE_IN_MICROSECONDS / eRPM_periodMicroSeconds);
+            if (telemetryType == DShotCodec::TELEMETRY_TYPE_ERPM && eRPM_periodMicroSeconds != DShotCodec::TELEMETRY_INVALID) {
+                enum { ONE_MINUTE_IN_MICROSECONDS = 60000000 };
+                // value is eRPM period in microseconds
+                _eRPMs[motorIndex] = static_cast<int32_t>(ONE_MINUTE_IN_MICROSECONDS / eRPM_periodMicroSeconds);
+                received = true;
+            }
+        } else {
+            ++_motorErrors[motorIndex];
         }
+        // a missing or corrupted reply ages the telemetry, so the RPM filters fade out rather than sit on a stale eRPM
+        _telemetryReceived[motorIndex] = received;
+        _telemetryValidities[motorIndex].update(received, _motorReadCounts[motorIndex], _motorErrors[motorIndex]);
     }
-
 }
 
 // NOLINTEND(cppcoreguidelines-pro-bounds-constant-array-index,hicpp-signed-bitwise)
@@ -1,4 +1,7 @@
+#pragma once
+
 #include "DShotCodec.h"
+#include "ESC_Telemetry.h"
 #include <array>
 #include <cstddef>
 #include <cstdint>
@@ -11,9 +14,7 @@ Implementation ported from: https://github.com/symonb/Bidirectional-DSHOT-and-RP
 
 Explanation of code at:     https://symonb.github.io/docs/drone/ESC/ESC_prot_impl_2_2
 
-FLLF-KIWIF4 uses same pins
-
-Motor pins etc still hard coded:
+FLLF-KIWIF4 uses the following pins, motors on other pins and ports are set using init():
 # resources
 resource MOTOR 1 A03
 resource MOTOR 2 B00
@@ -41,9 +42,9 @@ dma pin A02 1
 # pin A02: DMA2 Stream 2 Channel 6
 */
 
-#if defined(FRAMEWORK_ARDUINO_STM32)
+// V1 is also used for host builds, so that tests exercise the same DMA buffer layout as STM32
 #define BIT_BANGING_V1
-#else
+#if !defined(FRAMEWORK_ARDUINO_STM32)
 #define GPIO_BSRR_BR_0 (0x1UL << (16U))
 #define GPIO_BSRR_BS_0 (0x1UL << (0U))
 #endif
@@ -67,27 +68,47 @@ enum { DSHOT_BUFFER_LENGTH = 18 };      // 16 bits of Dshot and 2 for clearing
     enum { DSHOT_BB_FRAME_LENGTH = 140 };   // how many counts of the timer gives one bit frame (must be multiple of DSHOT_BB_FRAME_SECTIONS)
 #endif
 
+/*!
+Bit-banged bidirectional DShot for any number of motors (up to MAX_MOTOR_COUNT) on up to MAX_PORT_COUNT GPIO ports.
+
+Motors are grouped by GPIO port: each port has its own timer, DMA stream, and BSRR output buffer,
+so all the motors on a port are driven by a single DMA transfer, and their replies are captured by a single DMA transfer from the port's IDR.
+*/
 class ESC_DShotBitbang {
 public:
-    enum { MOTOR_1 = 3 }; // PA3
-    enum { MOTOR_4 = 2 }; // PA2
-    enum { MOTOR_2 = 0 }; // PB0
-    enum { MOTOR_3 = 1 }; // PB1
-    enum { MOTOR_COUNT = 4 };
+    enum { MAX_MOTOR_COUNT = 8 };
+    enum { MAX_PORT_COUNT = 2 }; // limited by the number of timers (TIM1 and TIM8) whose DMA (DMA2) can access the GPIO ports
+    struct port_pin_t {
+        uint8_t port; //!< GPIO port, 0 for GPIOA, 1 for GPIOB etc
+        uint8_t pin;
+    };
 
     static constexpr uint16_t RESPONSE_OVERSAMPLING = 3;  // it has to be a factor of DSHOT_BB_FRAME_LENGTH * DSHOT_MODE / BIDIRECTIONAL_DSHOT_RESPONSE_BITRATE
+    // BDSHOT response is being sampled just after transmission. There is ~33 [us] break before response (additional sampling) and bitrate is increased by 5/4:
+    enum { DMA_INPUT_BUFFER_LENGTH = (33 * BDSHOT_RESPONSE_BITRATE / 1000 + BDSHOT_RESPONSE_LENGTH + 1) * RESPONSE_OVERSAMPLING };
+    enum { DMA_OUTPUT_BUFFER_LENGTH = DSHOT_BB_BUFFER_LENGTH * DSHOT_BB_FRAME_SECTIONS };
 
     ESC_DShotBitbang();
-    void init();
-    void presetDMA_outputBuffers();
-    void setDMA_outputBuffers(uint16_t m1_frame, uint16_t m2_frame, uint16_t m3_frame, uint16_t m4_frame);
+    bool init(const port_pin_t* motorPins, size_t motorCount);
 
-    void outputToMotors(uint16_t m1_value, uint16_t m2_value, uint16_t m3_value, uint16_t m4_value); // values should be in the DShot range [47,2047]
+    void outputToMotors(const uint16_t* values); // one value for each motor, values should be in the DShot range [47,2047]
     void update_motors_rpm();
-    int32_t getMotorERPM(size_t motorIndex) { return _eRPMs[motorIndex]; }
+    int32_t getMotorERPM(size_t motorIndex) const { return _eRPMs[motorIndex]; } // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    uint32_t getMotorErrorCount(size_t motorIndex) const { return _motorErrors[motorIndex]; } // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    uint32_t getMotorReadCount(size_t motorIndex) const { return _motorReadCounts[motorIndex]; } // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    //! true if an eRPM frame was received in the reply decoded by the latest call to update_motors_rpm()
+    bool isTelemetryReceived(size_t motorIndex) const { return _telemetryReceived[motorIndex]; } // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    const ESC_TelemetryValidity& getTelemetryValidity(size_t motorIndex) const { return _telemetryValidities[motorIndex]; } // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    size_t getMotorCount() const { return _motorCount; }
+    size_t getPortCount() const { return _portCount; }
 
+    enum { PIN_COUNT = 16 }; //!< number of pins on a GPIO port
+    enum { RESPONSE_START_INDEX = 12 }; //!< default index of the start of the response in the samples, used by GCR21_to_samples
+    typedef std::array<uint32_t, PIN_COUNT> gcr21s_t;
     static uint32_t samples_to_GCR21(const uint32_t* samples, uint32_t motorMask);
-    static void GCR21_to_samples(uint32_t* samples, uint32_t motorMask, uint32_t gcr21); // for test code
+    static void samples_to_GCR21s(const uint32_t* samples, size_t sampleCount, uint32_t pinMask, gcr21s_t& gcr21s);
+    static void GCR21_to_samples(uint32_t* samples, uint32_t motorMask, uint32_t gcr21, size_t startIndex); // for test code
+    static void GCR21_to_samples(uint32_t* samples, uint32_t motorMask, uint32_t gcr21) { GCR21_to_samples(samples, motorMask, gcr21, RESPONSE_START_INDEX); }
 public:
     static ESC_DShotBitbang* self; // alias of `this` to be used in ISR
     struct port_t {
@@ -99,20 +120,36 @@ public:
         DMA_Stream_TypeDef* DMA_Stream;
         TIM_TypeDef* TIM;
 #endif
+        uint8_t gpioPort; //!< 0 for GPIOA, 1 for GPIOB etc
+        uint8_t motorCount; //!< number of motors on this port
+        std::array<uint8_t, MAX_MOTOR_COUNT> motorIndices; //!< indices of the motors on this port
+        uint32_t pinMask; //!< mask of the pins on this port used for motors
         bool reception; // flag for reception or transmission:
-        // BDSHOT response is being sampled just after transmission. There is ~33 [us] break before response (additional sampling) and bitrate is increased by 5/4:
-        std::array<uint32_t, (int)(33 * BDSHOT_RESPONSE_BITRATE / 1000 + BDSHOT_RESPONSE_LENGTH + 1) * RESPONSE_OVERSAMPLING> dmaInputBuffer;
-        std::array<uint32_t, DSHOT_BB_BUFFER_LENGTH * DSHOT_BB_FRAME_SECTIONS> dmaOutputBuffer;
+        std::array<uint32_t, DMA_INPUT_BUFFER_LENGTH> dmaInputBuffer;
+        std::array<uint32_t, DMA_OUTPUT_BUFFER_LENGTH> dmaOutputBuffer;
     };
-    port_t& getPortA() { return _portA; }
-    port_t& getPortB() { return _portB; }
+    port_t& getPort(size_t portIndex) { return _ports[portIndex]; } // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
     static void IRQ_Handler(port_t& port);
+#if defined(FRAMEWORK_ARDUINO_STM32)
+    static void DMA_IRQ_Handler(size_t dmaStreamIndex);
+#endif
+// for testing
+    void presetDMA_outputBuffers(port_t& port) const;
+    void setDMA_outputBuffers(port_t& port, const uint16_t* frames) const;
+private:
+    void decodePort(const port_t& port);
 private:
-    std::array<int32_t, MOTOR_COUNT> _eRPMs {};
-    std::array<int32_t, MOTOR_COUNT> _motorErrors {};
-    port_t _portA {};
-    port_t _portB {};
+    std::array<port_pin_t, MAX_MOTOR_COUNT> _motorPins {};
+    size_t _motorCount {0};
+    std::array<port_t, MAX_PORT_COUNT> _ports {};
+    size_t _portCount {0};
+    std::array<int32_t, MAX_MOTOR_COUNT> _eRPMs {};
+    std::array<uint32_t, MAX_MOTOR_COUNT> _motorErrors {};
+    std::array<uint32_t, MAX_MOTOR_COUNT> _motorReadCounts {};
+    std::array<bool, MAX_MOTOR_COUNT> _telemetryReceived {};
+    std::array<ESC_TelemetryValidity, MAX_MOTOR_COUNT> _telemetryValidities {};
 #if defined(FRAMEWORK_ARDUINO_STM32)
+    std::array<port_t*, 8> _dmaStreamToPort {}; //!< used by the DMA interrupt handler to find the port using a DMA2 stream
     static void setupGPIO(GPIO_TypeDef*GPIO, uint32_t GPIOxEN, uint32_t GPIO_OSPEEDER_OSPEEDRn);
     static void setupDMA(DMA_Stream_TypeDef* TIM, uint32_t DMAxEN);
     static void setupTimers(TIM_TypeDef* TIM, uint32_t TIMxEN);
@@ -0,0 +1,265 @@
+#include "ESC_DShotEmulator.h"
+
+#if defined(FRAMEWORK_TEST)
+
+#include "DShotCodec.h"
+#include "DShotCommandQueue.h"
+#include "ESC_DShotBitbang.h"
+
+
+// NOLINTBEGIN(cppcoreguidelines-pro-bounds-constant-array-index,cppcoreguidelines-pro-bounds-pointer-arithmetic,hicpp-signed-bitwise)
+
+/*!
+xorshift32 pseudo random number generator, so that tests are repeatable.
+*/
+uint32_t ESC_DShotEmulator::random()
+{
+    _randomState ^= _randomState << 13;
+    _randomState ^= _randomState >> 17;
+    _randomState ^= _randomState << 5;
+    return _randomState;
+}
+
+int32_t ESC_DShotEmulator::randomJitter()
+{
+    if (_jitterSamples == 0) {
+        return 0;
+    }
+    return static_cast<int32_t>(random() % (2*_jitterSamples + 1)) - static_cast<int32_t>(_jitterSamples);
+}
+
+/*!
+Decodes the bit from a pulse: a short pulse is a 0, a long pulse is a 1.
+
+Returns false if the pulse is neither clearly short nor clearly long.
+*/
+bool ESC_DShotEmulator::decodePulse(uint32_t highTime, uint32_t period, uint16_t& frame)
+{
+    // nominal pulse widths are 37.5% of the period for a 0, and 75% of the period for a 1
+    const uint32_t percent = 100 * highTime;
+    frame <<= 1U;
+    if (percent >= 15*period && percent <= 45*period) {
+        return true;
+    }
+    if (percent >= 55*period && percent <= 85*period) {
+        frame |= 1U;
+        return true;
+    }
+    return false;
+}
+
+/*!
+Decodes the pulse widths written by ESC_DShot::write(), these are unidirectional DShot, ie not inverted.
+
+The pulse widths are taken from bits [shift, shift + 15] of each buffer item and must be followed by a zero item, which ends the frame.
+*/
+ESC_DShotEmulator::receive_result_e ESC_DShotEmulator::receivePulseWidths(const uint32_t* pulseWidths, size_t count, uint32_t periodCycles, uint32_t shift)
+{
+    uint16_t frame = 0;
+    bool timingOK = count > DSHOT_BIT_COUNT && ((pulseWidths[DSHOT_BIT_COUNT] >> shift) & 0xFFFFU) == 0;
+    for (size_t ii = 0; ii < DSHOT_BIT_COUNT && timingOK; ++ii) {
+        timingOK = decodePulse((pulseWidths[ii] >> shift) & 0xFFFFU, periodCycles, frame);
+    }
+    if (!timingOK) {
+        ++_timingErrorCount;
+        return FRAME_TIMING_ERROR;
+    }
+    return receiveFrame(frame, false);
+}
+
+/*!
+Decodes the BSRR words written by ESC_DShotBitbang::setDMA_outputBuffers(), these are bidirectional DShot, ie inverted.
+
+Each word is one section of a DShot bit: the level of the pin is tracked through the words and
+each bit must start with a falling edge exactly one bit period after the start of the previous bit.
+*/
+ESC_DShotEmulator::receive_result_e ESC_DShotEmulator::receiveBitbang(const uint32_t* bsrrWords, size_t count, uint32_t pin)
+{
+    const auto setBit = static_cast<uint32_t>(GPIO_BSRR_BS_0 << pin);
+    const auto resetBit = static_cast<uint32_t>(GPIO_BSRR_BR_0 << pin);
+
+    uint16_t frame = 0;
+    size_t bitCount = 0;
+    bool timingOK = true;
+    uint32_t level = 1; // line idles high
+    size_t fallingEdge = 0;
+    for (size_t ii = 0; ii < count && timingOK; ++ii) {
+        // on STM32, BS takes priority over BR if both are set
+        const uint32_t newLevel = (bsrrWords[ii] & setBit) ? 1 : (bsrrWords[ii] & resetBit) ? 0 : level;
+        if (newLevel == level) {
+            continue;
+        }
+        level = newLevel;
+        if (level == 0) {
+            // start of a bit
+            timingOK = bitCount < DSHOT_BIT_COUNT && (bitCount == 0 || ii - fallingEdge == DSHOT_BB_FRAME_SECTIONS);
+            fallingEdge = ii;
+        } else {
+            // inverted, so the low time is the pulse width
+            timingOK = decodePulse(static_cast<uint32_t>(ii - fallingEdge), DSHOT_BB_FRAME_SECTIONS, frame);
+            ++bitCount;
+        }
+    }
+    if (!timingOK || bitCount != DSHOT_BIT_COUNT || level == 0) {
+        ++_timingErrorCount;
+        return FRAME_TIMING_ERROR;
+    }
+    return receiveFrame(frame, true);
+}
+
+/*!
+Checks the frame's checksum and decodes the throttle value, telemetry request bit, and any special command.
+*/
+ESC_DShotEmulator::receive_result_e ESC_DShotEmulator::receiveFrame(uint16_t frame, bool bidirectional)
+{
+    const bool checksumOK = bidirectional ? DShotCodec::checksumBidirectionalIsOK(frame) : DShotCodec::checksumUnidirectionalIsOK(frame);
+    if (!checksumOK) {
+        ++_checksumErrorCount;
+        return FRAME_CHECKSUM_ERROR;
+    }
+    ++_frameCount;
+    // frame is of the form SSSSSSSSSSSTCCCC
+    _throttle = static_cast<uint16_t>(frame >> 5U);
+    _telemetryRequest = (frame & 0x0010U) != 0;
+    if (_throttle != 0 && _throttle <= DShotCommandQueue::DSHOT_CMD_MAX) {
+        _lastCommand = static_cast<uint8_t>(_throttle);
+        // commands are only acted upon if the telemetry request bit is set
+        if (_telemetryRequest && _throttle == DShotCommandQueue::DSHOT_CMD_EXTENDED_TELEMETRY_ENABLE) {
+            _extendedTelemetryEnabled = true;
+        } else if (_telemetryRequest && _throttle == DShotCommandQueue::DSHOT_CMD_EXTENDED_TELEMETRY_DISABLE) {
+            _extendedTelemetryEnabled = false;
+        }
+    }
+    return FRAME_OK;
+}
+
+/*!
+Encodes eRPM as a 12-bit telemetry value of the form eeemmmmmmmmm, where the eRPM period in microseconds is the mantissa shifted left by the exponent.
+
+The mantissa is normalized, so that it is not mistaken for an EDT frame.
+*/
+uint16_t ESC_DShotEmulator::eRPM_toTelemetryValue(uint32_t eRPM)
+{
+    if (eRPM == 0) {
+        return 0x0FFF;
+    }
+    enum { ONE_MINUTE_IN_MICROSECONDS = 60000000 };
+    uint32_t period = ONE_MINUTE_IN_MICROSECONDS / eRPM;
+    uint32_t exponent = 0;
+    while (period > 0x01FF) {
+        if (exponent == 7) {
+            return 0x0FFF;
+        }
+        period >>= 1U;
+        ++exponent;
+    }
+    return static_cast<uint16_t>((exponent << 9U) | period);
+}
+
+uint16_t ESC_DShotEmulator::nextTelemetryValue()
+{
+    ++_replyCount;
+    if (!_extendedTelemetryEnabled || (_replyCount % EDT_FRAME_INTERVAL) != 0) {
+        return eRPM_toTelemetryValue(_eRPM);
+    }
+    // EDT frames are of the form ppp0mmmmmmmm, where ppp is the telemetry type
+    uint32_t type {};
+    uint32_t value {};
+    switch (_edtIndex) {
+    case 0:
+        type = DShotCodec::TELEMETRY_TYPE_TEMPERATURE;
+        value = _temperatureCelsius;
+        break;
+    case 1:
+        type = DShotCodec::TELEMETRY_TYPE_VOLTAGE;
+        value = _voltageCentiVolts / 25U; // step size of 0.25V
+        break;
+    default:
+        type = DShotCodec::TELEMETRY_TYPE_CURRENT;
+        value = _currentCentiAmps / 100U; // step size of 1A
+        break;
+    }
+    _edtIndex = (_edtIndex + 1) % 3;
+    return static_cast<uint16_t>((type << 9U) | (value > 0xFF ? 0xFF : value));
+}
+
+/*!
+Returns the next reply as a 21-bit GCR value, with a bit error injected if so configured.
+*/
+uint32_t ESC_DShotEmulator::nextReplyGCR21()
+{
+    const uint16_t value = nextTelemetryValue();
+    const auto frame = static_cast<uint16_t>((value << 4U) | DShotCodec::checksumBidirectional(value));
+    uint32_t gcr21 = DShotCodec::GR20_to_GCR21(DShotCodec::eRPM_to_GCR20(frame));
+    if (_bitErrorInterval != 0 && random() % _bitErrorInterval == 0) {
+        ++_corruptedReplyCount;
+        // the start bit is left intact, so the reply is still detected
+        gcr21 ^= 1U << (random() % (BDSHOT_RESPONSE_LENGTH - 1));
+    }
+    return gcr21;
+}
+
+/*!
+Sets levels to the line levels of the reply, sampled oversampling times per bit, starting at startIndex.
+
+The line is high before and after the reply. Each edge, apart from the initial falling edge, is displaced by a random jitter.
+*/
+void ESC_DShotEmulator::synthesizeLevels(uint32_t gcr21, size_t startIndex, uint32_t oversampling, std::array<uint8_t, MAX_SAMPLE_COUNT>& levels)
+{
+    levels.fill(1);
+    size_t previousEdge = startIndex;
+    uint32_t level = 0; // the reply starts with a falling edge at startIndex
+    for (size_t bit = 1; bit <= BDSHOT_RESPONSE_LENGTH; ++bit) {
+        // after the last bit the line returns high
+        const uint32_t bitLevel = (bit == BDSHOT_RESPONSE_LENGTH) ? 1 : (gcr21 >> (BDSHOT_RESPONSE_LENGTH - 1 - bit)) & 1U;
+        if (bitLevel == level) {
+            continue;
+        }
+        const int32_t nominal = static_cast<int32_t>(startIndex + bit*oversampling);
+        int32_t edge = nominal + randomJitter();
+        if (edge <= static_cast<int32_t>(previousEdge)) {
+            edge = static_cast<int32_t>(previousEdge) + 1;
+        }
+        for (size_t ii = previousEdge; ii < static_cast<size_t>(edge) && ii < levels.size(); ++ii) {
+            levels[ii] = static_cast<uint8_t>(level);
+        }
+        previousEdge = static_cast<size_t>(edge);
+        level = bitLevel;
+    }
+}
+
+/*!
+Returns the next reply in the form captured by the PIO: 64 samples, MSB first, with 3 samples per bit and the first sample at the start of the reply.
+*/
+uint64_t ESC_DShotEmulator::nextReplyPIO_Samples()
+{
+    std::array<uint8_t, MAX_SAMPLE_COUNT> levels {};
+    synthesizeLevels(nextReplyGCR21(), 0, PIO_OVERSAMPLING, levels);
+    uint64_t samples = 0;
+    for (size_t ii = 0; ii < 64; ++ii) {
+        samples = (samples << 1U) | levels[ii];
+    }
+    return samples;
+}
+
+/*!
+Writes the next reply into the pinMask bits of a bit-bang DMA input buffer, the other bits are left unchanged.
+
+The reply starts at startIndex, so the delay between the end of the DShot frame and the reply can be varied.
+*/
+void ESC_DShotEmulator::nextReplyBitbangSamples(uint32_t* samples, size_t count, uint32_t pinMask, size_t startIndex)
+{
+    std::array<uint8_t, MAX_SAMPLE_COUNT> levels {};
+    synthesizeLevels(nextReplyGCR21(), startIndex, ESC_DShotBitbang::RESPONSE_OVERSAMPLING, levels);
+    for (size_t ii = 0; ii < count && ii < levels.size(); ++ii) {
+        if (levels[ii]) {
+            samples[ii] |= pinMask;
+        } else {
+            samples[ii] &= ~pinMask;
+        }
+    }
+}
+
+// NOLINTEND(cppcoreguidelines-pro-bounds-constant-array-index,cppcoreguidelines-pro-bounds-pointer-arithmetic,hicpp-signed-bitwise)
+
+#endif // FRAMEWORK_TEST
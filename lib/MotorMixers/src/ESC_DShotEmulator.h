@@ -0,0 +1,93 @@
+#pragma once
+
+#if defined(FRAMEWORK_TEST)
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+
+/*!
+Host emulation of a bidirectional DShot ESC, for testing.
+
+Consumes the output buffers produced by ESC_DShot::write() (PWM pulse widths) and ESC_DShotBitbang::setDMA_outputBuffers() (GPIO BSRR words),
+checks the pulse timing and the checksum of the frame, and decodes the throttle value or special command.
+
+Synthesizes the ESC's reply as GCR samples, either in the form captured by the Raspberry Pi PIO implementation (ie as passed to ESC_DShot::telemetryReceived())
+or into a bit-bang DMA input buffer. Once Extended DShot Telemetry (EDT) has been enabled, EDT frames are interleaved with the eRPM frames.
+
+Bit errors and edge jitter can be injected into the replies to test error handling.
+*/
+class ESC_DShotEmulator {
+public:
+    enum receive_result_e { FRAME_OK, FRAME_TIMING_ERROR, FRAME_CHECKSUM_ERROR };
+    enum { DSHOT_BIT_COUNT = 16 };
+    enum { DEFAULT_MOTOR_POLE_COUNT = 14 };
+    enum { EDT_FRAME_INTERVAL = 4 }; //!< once EDT is enabled, every fourth reply is an EDT frame
+    enum { PIO_OVERSAMPLING = 3 }; //!< the PIO samples each reply bit 3 times
+    enum { MAX_SAMPLE_COUNT = 128 };
+public:
+    explicit ESC_DShotEmulator(uint16_t motorPoleCount) : _motorPoleCount(motorPoleCount) {}
+    ESC_DShotEmulator() : ESC_DShotEmulator(DEFAULT_MOTOR_POLE_COUNT) {}
+public:
+    // frames sent to the ESC
+    receive_result_e receivePulseWidths(const uint32_t* pulseWidths, size_t count, uint32_t periodCycles, uint32_t shift);
+    receive_result_e receivePulseWidths(const uint32_t* pulseWidths, size_t count, uint32_t periodCycles) { return receivePulseWidths(pulseWidths, count, periodCycles, 0); }
+    receive_result_e receiveBitbang(const uint32_t* bsrrWords, size_t count, uint32_t pin);
+    receive_result_e receiveFrame(uint16_t frame, bool bidirectional);
+
+    // replies from the ESC
+    uint32_t nextReplyGCR21();
+    uint64_t nextReplyPIO_Samples();
+    void nextReplyBitbangSamples(uint32_t* samples, size_t count, uint32_t pinMask, size_t startIndex);
+    static uint16_t eRPM_toTelemetryValue(uint32_t eRPM);
+
+    // state of the emulated motor
+    void setMotorRPM(int32_t rpm) { _eRPM = static_cast<uint32_t>(rpm * _motorPoleCount / 2); }
+    void setTemperatureCelsius(uint8_t temperatureCelsius) { _temperatureCelsius = temperatureCelsius; }
+    void setVoltageCentiVolts(uint16_t voltageCentiVolts) { _voltageCentiVolts = voltageCentiVolts; }
+    void setCurrentCentiAmps(uint16_t currentCentiAmps) { _currentCentiAmps = currentCentiAmps; }
+
+    // error injection
+    void setSeed(uint32_t seed) { _randomState = seed == 0 ? 1 : seed; }
+    void setBitErrorInterval(uint32_t bitErrorInterval) { _bitErrorInterval = bitErrorInterval; } //!< on average one reply in bitErrorInterval has a flipped bit, 0 for no errors
+    void setJitterSamples(uint32_t jitterSamples) { _jitterSamples = jitterSamples; } //!< maximum displacement of each edge of the reply, at 3x oversampling 1 sample of jitter is enough to cause errors
+
+    uint16_t getThrottle() const { return _throttle; }
+    bool getTelemetryRequest() const { return _telemetryRequest; }
+    uint8_t getLastCommand() const { return _lastCommand; }
+    bool isExtendedTelemetryEnabled() const { return _extendedTelemetryEnabled; }
+    uint32_t getFrameCount() const { return _frameCount; }
+    uint32_t getTimingErrorCount() const { return _timingErrorCount; }
+    uint32_t getChecksumErrorCount() const { return _checksumErrorCount; }
+    uint32_t getReplyCount() const { return _replyCount; }
+    uint32_t getCorruptedReplyCount() const { return _corruptedReplyCount; }
+private:
+    uint32_t random();
+    int32_t randomJitter();
+    uint16_t nextTelemetryValue();
+    bool decodePulse(uint32_t highTime, uint32_t period, uint16_t& frame);
+    void synthesizeLevels(uint32_t gcr21, size_t startIndex, uint32_t oversampling, std::array<uint8_t, MAX_SAMPLE_COUNT>& levels);
+private:
+    uint16_t _motorPoleCount;
+    uint32_t _eRPM {};
+    uint8_t _temperatureCelsius {};
+    uint16_t _voltageCentiVolts {};
+    uint16_t _currentCentiAmps {};
+    uint32_t _randomState {1};
+    uint32_t _bitErrorInterval {};
+    uint32_t _jitterSamples {};
+
+    uint16_t _throttle {};
+    bool _telemetryRequest {false};
+    uint8_t _lastCommand {};
+    bool _extendedTelemetryEnabled {false};
+    uint32_t _edtIndex {}; //!< cycles through the EDT frame types
+    uint32_t _frameCount {};
+    uint32_t _timingErrorCount {};
+    uint32_t _checksumErrorCount {};
+    uint32_t _replyCount {};
+    uint32_t _corruptedReplyCount {};
+};
+
+#endif // FRAMEWORK_TEST
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+
+
+/*!
+Telemetry received from an ESC, including Extended DShot Telemetry (EDT) values.
+
+Values that have not been received from the ESC are zero.
+*/
+struct esc_telemetry_t {
+    int32_t rpm;
+    uint32_t readCount; //!< number of telemetry frames received
+    uint32_t errorCount; //!< number of telemetry frames that could not be decoded
+    uint32_t staleCount; //!< number of reads for which no new telemetry had been received
+    uint16_t voltageCentiVolts;
+    uint16_t currentCentiAmps;
+    uint8_t temperatureCelsius;
+    uint8_t stressLevel;
+    uint8_t stateEvents;
+    //! percentage of telemetry frames that could not be decoded, in units of 0.01%, ie in the range [0, 10000]
+    inline uint16_t invalidPercent() const { return readCount == 0 ? 0 : static_cast<uint16_t>((static_cast<uint64_t>(errorCount) * 10000) / readCount); }
+};
+
+/*!
+Tracks the validity and freshness of the eRPM telemetry from an ESC.
+
+The age is the number of reads since the last good eRPM frame, and the error rate is a smoothed fraction of the
+telemetry frames that could not be decoded.
+
+The weight is used to fade out consumers of the eRPM (such as the RPM notch filters) when the telemetry is lost or unreliable,
+rather than leaving them at a stale frequency. The weight is zero until the first eRPM frame is received.
+*/
+class ESC_TelemetryValidity {
+public:
+    enum { DEFAULT_FADE_START_AGE = 8, DEFAULT_FADE_END_AGE = 64 };
+    static constexpr float ERROR_RATE_SMOOTHING = 0.05F;
+    static constexpr float FADE_START_ERROR_RATE = 0.25F;
+    static constexpr float FADE_END_ERROR_RATE = 0.5F;
+public:
+    ESC_TelemetryValidity(uint32_t fadeStartAge, uint32_t fadeEndAge) : _fadeStartAge(fadeStartAge), _fadeEndAge(fadeEndAge) {}
+    ESC_TelemetryValidity() : ESC_TelemetryValidity(DEFAULT_FADE_START_AGE, DEFAULT_FADE_END_AGE) {}
+public:
+    //! called on every read of the ESC telemetry, received is true if a new eRPM frame was received since the previous read
+    inline void update(bool received, uint32_t readCount, uint32_t errorCount) {
+        if (received) {
+            _age = 0;
+            _received = true;
+        } else if (_age < _fadeEndAge) {
+            ++_age;
+        }
+        const uint32_t reads = readCount - _previousReadCount;
+        if (reads != 0) {
+            const uint32_t errors = errorCount - _previousErrorCount;
+            _errorRate += ERROR_RATE_SMOOTHING * (static_cast<float>(errors) / static_cast<float>(reads) - _errorRate);
+            _previousReadCount = readCount;
+            _previousErrorCount = errorCount;
+        }
+    }
+    uint32_t getAge() const { return _age; } //!< number of reads since the last good eRPM frame, saturates at fadeEndAge
+    float getErrorRate() const { return _errorRate; }
+    bool isValid() const { return getWeight() > 0.0F; }
+    //! returns a value in the range [0, 1], 1 if the telemetry is fresh and reliable, 0 if it is stale or unreliable
+    inline float getWeight() const {
+        if (!_received || _age >= _fadeEndAge || _errorRate >= FADE_END_ERROR_RATE) {
+            return 0.0F;
+        }
+        const float ageWeight = _age <= _fadeStartAge ? 1.0F : static_cast<float>(_fadeEndAge - _age) / static_cast<float>(_fadeEndAge - _fadeStartAge);
+        const float errorWeight = _errorRate <= FADE_START_ERROR_RATE ? 1.0F : (FADE_END_ERROR_RATE - _errorRate) / (FADE_END_ERROR_RATE - FADE_START_ERROR_RATE);
+        return ageWeight * errorWeight;
+    }
+    void reset() { _received = false; _age = 0; _errorRate = 0.0F; }
+private:
+    uint32_t _fadeStartAge;
+    uint32_t _fadeEndAge;
+    bool _received {false};
+    uint32_t _age {};
+    float _errorRate {};
+    uint32_t _previousReadCount {};
+    uint32_t _previousErrorCount {};
+};
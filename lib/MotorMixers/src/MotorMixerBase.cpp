@@ -0,0 +1,71 @@
+#include "MotorMixerBase.h"
+
+#include <Debug.h>
+#include <algorithm>
+#include <cstdint>
+
+
+namespace { // use anonymous namespace to make items local to this translation unit
+//! counts increase at the loop rate, so saturate rather than wrap negative when logged in a debug value
+inline int16_t saturatedCount(uint32_t count)
+{
+    return static_cast<int16_t>(std::min(count, static_cast<uint32_t>(INT16_MAX)));
+}
+} // END namespace
+
+/*!
+Set the ESC telemetry debug values, if one of the ESC debug modes is selected.
+
+Called by mixers that receive ESC telemetry, after the telemetry has been read.
+*/
+void MotorMixerBase::setESC_TelemetryDebug()
+{
+    const debug_type_e debugMode = _debug.getMode();
+    const size_t motorCount = std::min(_motorCount, static_cast<size_t>(Debug::VALUE_COUNT));
+
+    switch (debugMode) {
+    case DEBUG_ESC_SENSOR_RPM:
+        for (size_t ii = 0; ii < motorCount; ++ii) {
+            _debug.set(ii, static_cast<int16_t>(getMotorTelemetry(ii).rpm / 10));
+        }
+        break;
+    case DEBUG_ESC_SENSOR_TMP:
+        for (size_t ii = 0; ii < motorCount; ++ii) {
+            _debug.set(ii, static_cast<int16_t>(getMotorTelemetry(ii).temperatureCelsius));
+        }
+        break;
+    case DEBUG_DSHOT_RPM_ERRORS:
+        for (size_t ii = 0; ii < motorCount; ++ii) {
+            _debug.set(ii, static_cast<int16_t>(getMotorTelemetry(ii).invalidPercent()));
+        }
+        break;
+    case DEBUG_DSHOT_TELEMETRY_COUNTS:
+        for (size_t ii = 0; ii < motorCount; ++ii) {
+            _debug.set(ii, saturatedCount(getMotorTelemetry(ii).readCount));
+        }
+        break;
+    case DEBUG_ESC_SENSOR: {
+        // summary of the health of all the ESCs: hottest ESC, its temperature, and the total stale and error counts, saturated at INT16_MAX
+        size_t hottestMotorIndex = 0;
+        uint8_t maxTemperature = 0;
+        uint32_t staleCount = 0;
+        uint32_t errorCount = 0;
+        for (size_t ii = 0; ii < _motorCount; ++ii) {
+            const esc_telemetry_t telemetry = getMotorTelemetry(ii);
+            if (telemetry.temperatureCelsius > maxTemperature) {
+                maxTemperature = telemetry.temperatureCelsius;
+                hottestMotorIndex = ii;
+            }
+            staleCount += telemetry.staleCount;
+            errorCount += telemetry.errorCount;
+        }
+        _debug.set(0, static_cast<int16_t>(hottestMotorIndex));
+        _debug.set(1, static_cast<int16_t>(maxTemperature));
+        _debug.set(2, saturatedCount(staleCount));
+        _debug.set(3, saturatedCount(errorCount));
+        break;
+    }
+    default:
+        break;
+    }
+}
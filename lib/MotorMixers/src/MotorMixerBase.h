@@ -1,5 +1,7 @@
 #pragma once
 
+#include "ESC_Telemetry.h"
+
 #include <cstddef>
 #include <cstdint>
 
@@ -28,11 +30,18 @@ public:
 
     virtual void outputToMotors(const commands_t& commands, float deltaT, uint32_t tickCount) { (void)commands; (void)deltaT; (void)tickCount; }
     virtual float getMotorOutput(size_t motorIndex) const { (void)motorIndex; return 0.0F; }
+    virtual size_t getServoCount() const { return 0; }
+    virtual float getServoOutput(size_t servoIndex) const { (void)servoIndex; return 0.0F; }
 
     virtual int32_t getMotorRPM(size_t motorIndex) const { (void)motorIndex; return 0; }
     virtual float getMotorFrequencyHz(size_t motorIndex) const { (void)motorIndex; return 0; }
+    //! weight in the range [0, 1] given to the motor frequency, reduced when the RPM telemetry is stale or unreliable
+    virtual float getMotorFrequencyWeight(size_t motorIndex) const { (void)motorIndex; return 1.0F; }
+    virtual esc_telemetry_t getMotorTelemetry(size_t motorIndex) const { (void)motorIndex; return esc_telemetry_t {}; }
 
     virtual DynamicIdleController* getDynamicIdleController() const { return nullptr; }
+protected:
+    void setESC_TelemetryDebug();
 public:
     static inline float clip(float value, float min, float max) { return value < min ? min : value > max ? max : value; }
 protected:
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <MotorMixerBase.h>
+#include <array>
+#include <cstddef>
+
+
+/*!
+Mixing matrix for an aircraft with MOTOR_COUNT motors and SERVO_COUNT servos.
+
+Each motor output is the dot product of that motor's row of the matrix with the (throttle, roll, pitch, yaw) command vector.
+
+The matrix is defined row by row (one row per motor, as in Betaflight), but is stored column by column (structure of arrays).
+Since MOTOR_COUNT is a compile time constant, the compiler fully unrolls the matrix-vector product in mix()
+and the column layout means the unrolled product can be vectorized.
+
+Coefficients use the same conventions as the FlightController (NED):
+positive roll is left side up, positive pitch is nose up, positive yaw is nose right.
+Note this means the pitch coefficients have the opposite sign to those in Betaflight's mixer tables.
+
+Servo outputs are centered on zero and are in the range [-1.0, 1.0]. Servos have no throttle component.
+*/
+template <size_t MOTOR_COUNT_T, size_t SERVO_COUNT_T = 0>
+struct MotorMixMatrix {
+    enum { MOTOR_COUNT = MOTOR_COUNT_T, SERVO_COUNT = SERVO_COUNT_T };
+    struct mix_t {
+        float throttle;
+        float roll;
+        float pitch;
+        float yaw;
+    };
+    typedef std::array<mix_t, MOTOR_COUNT> motor_rows_t;
+    typedef std::array<mix_t, SERVO_COUNT> servo_rows_t;
+public:
+    constexpr explicit MotorMixMatrix(const motor_rows_t& motorRows) : MotorMixMatrix(motorRows, servo_rows_t {}) {}
+    constexpr MotorMixMatrix(const motor_rows_t& motorRows, const servo_rows_t& servoRows) {
+        for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+            throttle[ii] = motorRows[ii].throttle;
+            roll[ii] = motorRows[ii].roll;
+            pitch[ii] = motorRows[ii].pitch;
+            yaw[ii] = motorRows[ii].yaw;
+        }
+        for (size_t ii = 0; ii < SERVO_COUNT; ++ii) {
+            servoRoll[ii] = servoRows[ii].roll;
+            servoPitch[ii] = servoRows[ii].pitch;
+            servoYaw[ii] = servoRows[ii].yaw;
+        }
+    }
+    /*!
+    Calculate the motor outputs, this is called from within the main IMU/PID loop and so needs to be FAST.
+    */
+    inline void mix(std::array<float, MOTOR_COUNT>& outputs, const MotorMixerBase::commands_t& commands, float throttleCommand) const {
+        for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+            outputs[ii] = throttle[ii]*throttleCommand + roll[ii]*commands.roll + pitch[ii]*commands.pitch + yaw[ii]*commands.yaw; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+        }
+    }
+    inline void mixServos(std::array<float, SERVO_COUNT>& outputs, const MotorMixerBase::commands_t& commands) const {
+        for (size_t ii = 0; ii < SERVO_COUNT; ++ii) {
+            outputs[ii] = MotorMixerBase::clip(servoRoll[ii]*commands.roll + servoPitch[ii]*commands.pitch + servoYaw[ii]*commands.yaw, -1.0F, 1.0F); // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+        }
+    }
+public:
+    std::array<float, MOTOR_COUNT> throttle {};
+    std::array<float, MOTOR_COUNT> roll {};
+    std::array<float, MOTOR_COUNT> pitch {};
+    std::array<float, MOTOR_COUNT> yaw {};
+    std::array<float, SERVO_COUNT> servoRoll {};
+    std::array<float, SERVO_COUNT> servoPitch {};
+    std::array<float, SERVO_COUNT> servoYaw {};
+};
+
+/*!
+Mixing matrices for common frame types. Motor order is the same as Betaflight.
+*/
+namespace MotorMixMatrices {
+
+// 4 2
+// 3 1
+static constexpr MotorMixMatrix<4> QUAD_X({{
+//    throttle    roll     pitch      yaw
+    { 1.0F,     -1.0F,    -1.0F,     -1.0F }, // BR, rear right
+    { 1.0F,     -1.0F,     1.0F,      1.0F }, // FR, front right
+    { 1.0F,      1.0F,    -1.0F,      1.0F }, // BL, rear left
+    { 1.0F,      1.0F,     1.0F,     -1.0F }  // FL, front left
+}});
+
+//   4
+// 3   2
+//   1
+static constexpr MotorMixMatrix<4> QUAD_PLUS({{
+    { 1.0F,      0.0F,    -1.0F,     -1.0F }, // rear
+    { 1.0F,     -1.0F,     0.0F,      1.0F }, // right
+    { 1.0F,      1.0F,     0.0F,      1.0F }, // left
+    { 1.0F,      0.0F,     1.0F,     -1.0F }  // front
+}});
+
+// 4 2
+// 6   5
+// 3 1
+static constexpr MotorMixMatrix<6> HEX_X({{
+    { 1.0F,     -0.5F,    -0.866025F,  1.0F }, // rear right
+    { 1.0F,     -0.5F,     0.866025F,  1.0F }, // front right
+    { 1.0F,      0.5F,    -0.866025F, -1.0F }, // rear left
+    { 1.0F,      0.5F,     0.866025F, -1.0F }, // front left
+    { 1.0F,     -1.0F,     0.0F,      -1.0F }, // right
+    { 1.0F,      1.0F,     0.0F,       1.0F }  // left
+}});
+
+// 3 coaxial pairs, motors 4, 5, and 6 are underneath motors 1, 2, and 3
+// 3   2
+//   1
+static constexpr MotorMixMatrix<6> Y6({{
+    { 1.0F,      0.0F,    -1.333333F,  1.0F }, // rear
+    { 1.0F,     -1.0F,     0.666667F, -1.0F }, // right
+    { 1.0F,      1.0F,     0.666667F, -1.0F }, // left
+    { 1.0F,      0.0F,    -1.333333F, -1.0F }, // under rear
+    { 1.0F,     -1.0F,     0.666667F,  1.0F }, // under right
+    { 1.0F,      1.0F,     0.666667F,  1.0F }  // under left
+}});
+
+// 4 coaxial pairs, motors 5, 6, 7, and 8 are underneath motors 1, 2, 3, and 4
+static constexpr MotorMixMatrix<8> OCTO_X8({{
+    { 1.0F,     -1.0F,    -1.0F,     -1.0F }, // rear right
+    { 1.0F,     -1.0F,     1.0F,      1.0F }, // front right
+    { 1.0F,      1.0F,    -1.0F,      1.0F }, // rear left
+    { 1.0F,      1.0F,     1.0F,     -1.0F }, // front left
+    { 1.0F,     -1.0F,    -1.0F,      1.0F }, // under rear right
+    { 1.0F,     -1.0F,     1.0F,     -1.0F }, // under front right
+    { 1.0F,      1.0F,    -1.0F,     -1.0F }, // under rear left
+    { 1.0F,      1.0F,     1.0F,      1.0F }  // under front left
+}});
+
+static constexpr MotorMixMatrix<8> OCTO_FLAT_X({{
+    { 1.0F,      1.0F,      0.414178F,  1.0F }, // mid front left
+    { 1.0F,     -0.414178F, 1.0F,      -1.0F }, // front right
+    { 1.0F,     -1.0F,     -0.414178F,  1.0F }, // mid rear right
+    { 1.0F,      0.414178F,-1.0F,      -1.0F }, // rear left
+    { 1.0F,      0.414178F, 1.0F,       1.0F }, // front left
+    { 1.0F,     -1.0F,      0.414178F, -1.0F }, // mid front right
+    { 1.0F,     -0.414178F,-1.0F,       1.0F }, // rear right
+    { 1.0F,      1.0F,     -0.414178F, -1.0F }  // mid rear left
+}});
+
+// tricopter, yaw is provided by a servo tilting the rear motor
+// 3   2
+//   1
+static constexpr MotorMixMatrix<3, 1> TRI({{
+    { 1.0F,      0.0F,    -1.333333F,  0.0F }, // rear
+    { 1.0F,     -1.0F,     0.666667F,  0.0F }, // right
+    { 1.0F,      1.0F,     0.666667F,  0.0F }  // left
+}}, {{
+    { 0.0F,      0.0F,     0.0F,       1.0F }  // rear motor tilt servo
+}});
+
+} // END namespace
+
+
+/*!
+Generic motor mixer, driven by a mixing matrix.
+
+Calculates the motor and servo outputs, but does not write them to any hardware:
+derived classes override outputToMotors() to do this.
+*/
+template <size_t MOTOR_COUNT, size_t SERVO_COUNT = 0>
+class MotorMixerMatrixBase : public MotorMixerBase {
+public:
+    typedef MotorMixMatrix<MOTOR_COUNT, SERVO_COUNT> matrix_t;
+public:
+    MotorMixerMatrixBase(const matrix_t& matrix, Debug& debug) : MotorMixerBase(MOTOR_COUNT, debug), _matrix(matrix) {}
+public:
+    virtual void outputToMotors(const commands_t& commands, float deltaT, uint32_t tickCount) override { (void)deltaT; (void)tickCount; mix(commands, commands.throttle); }
+    virtual float getMotorOutput(size_t motorIndex) const override { return _motorOutputs[motorIndex]; } // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    virtual size_t getServoCount() const override { return SERVO_COUNT; }
+    virtual float getServoOutput(size_t servoIndex) const override { return _servoOutputs[servoIndex]; } // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    const matrix_t& getMatrix() const { return _matrix; }
+protected:
+    inline void mix(const commands_t& commands, float throttle) {
+        if (motorsIsOn()) {
+            _throttleCommand = throttle;
+            _matrix.mix(_motorOutputs, commands, throttle);
+            _matrix.mixServos(_servoOutputs, commands);
+        } else {
+            _throttleCommand = commands.throttle;
+            _motorOutputs.fill(0.0F);
+            _servoOutputs.fill(0.0F);
+        }
+    }
+protected:
+    const matrix_t _matrix;
+    std::array<float, MOTOR_COUNT> _motorOutputs {};
+    std::array<float, SERVO_COUNT> _servoOutputs {};
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <DShotMotorControl.h>
+#include <ESC_DShot.h>
+#include <ESC_DShotBatch.h>
+#include <MotorMixerMatrix.h>
+#include <RPM_Filters.h>
+
+
+/*!
+DShot Motor Mixer for any frame type, driven by a mixing matrix.
+
+The ESCs are driven in the same way as MotorMixerQuadX_DShot: each motor has its own ESC_DShot when USE_DSHOT_RPI_PICO_PIO
+or USE_DSHOT_ESP32_RMT is defined, otherwise unidirectional DShot is output by ESC_DShotBatch (RPI Pico only) without telemetry.
+
+For example, for a hexacopter:
+    static MotorMixerMatrixDShot<6> motorMixer(MotorMixMatrices::HEX_X, debug, pins, rpmFilters, dynamicIdleController);
+
+Hz is used for motor revolutions per second rather than RPS, since RPS is generally used for Radians Per Second.
+
+The dynamic idle, RPM limiter, RPM control, and DShot command handling is shared with the other DShot mixers, see DShotMotorControl.
+*/
+template <size_t MOTOR_COUNT, size_t SERVO_COUNT = 0>
+class MotorMixerMatrixDShot : public MotorMixerMatrixBase<MOTOR_COUNT, SERVO_COUNT> {
+public:
+    typedef MotorMixerMatrixBase<MOTOR_COUNT, SERVO_COUNT> base_t;
+    typedef std::array<uint8_t, MOTOR_COUNT> pins_t;
+    static constexpr float DEFAULT_MAX_MOTOR_HZ = DShotMotorControl<MOTOR_COUNT>::DEFAULT_MAX_MOTOR_HZ;
+    static_assert(MOTOR_COUNT <= ESC_DShotBatch::MAX_MOTOR_COUNT);
+    static_assert(MOTOR_COUNT <= RPM_Filters::MAX_MOTOR_COUNT, "RPM_Filters::MAX_MOTOR_COUNT exceeded, define USE_EIGHT_MOTORS");
+public:
+    MotorMixerMatrixDShot(const typename base_t::matrix_t& matrix, Debug& debug, const pins_t& pins, RPM_Filters& rpmFilters, DynamicIdleController& dynamicIdleController) :
+        base_t(matrix, debug),
+        _motorControl(rpmFilters, dynamicIdleController)
+    {
+#if defined(USE_DSHOT_RPI_PICO_PIO) || defined(USE_DSHOT_ESP32_RMT) || defined(FRAMEWORK_TEST)
+        for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+            _escs[ii].init(pins[ii]);
+        }
+#if defined(USE_DSHOT_RPI_PICO_PIO) || defined(USE_DSHOT_TELEMETRY)
+        // Extended DShot Telemetry (temperature, voltage, current etc) is only sent by the ESCs once it has been enabled
+        _motorControl.getCommandQueue().enqueue(DShotCommandQueue::DSHOT_CMD_EXTENDED_TELEMETRY_ENABLE);
+#endif
+#else
+        _escDShotBatch.init(&pins[0], MOTOR_COUNT);
+#endif
+    }
+public:
+    virtual int32_t getMotorRPM(size_t motorIndex) const override { return _escs[motorIndex].getMotorRPM(); } // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    virtual float getMotorFrequencyHz(size_t motorIndex) const override { return _escs[motorIndex].getMotorHz(); } // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    virtual float getMotorFrequencyWeight(size_t motorIndex) const override { return _escs[motorIndex].getTelemetryValidity().getWeight(); } // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    virtual DynamicIdleController* getDynamicIdleController() const override { return &_motorControl.getDynamicIdleController(); }
+    virtual esc_telemetry_t getMotorTelemetry(size_t motorIndex) const override { return _escs[motorIndex].getTelemetry(); } // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    ESC_DShot& getESC(size_t motorIndex) { return _escs[motorIndex]; } //!< for test code // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+
+    /*!
+    Queue a DShot special command, for example to make the motors beep or to set the spin direction.
+
+    Commands are only sent while the motors are switched off, so the command is rejected if the motors are on.
+    */
+    bool sendDShotCommand(DShotCommandQueue::command_e command, uint8_t motorIndex = DShotCommandQueue::ALL_MOTORS) {
+        if (this->motorsIsOn()) {
+            return false;
+        }
+        return _motorControl.getCommandQueue().enqueue(command, motorIndex);
+    }
+
+    float calculateSlowestMotorHz() const { return _motorControl.calculateSlowestMotorHz(); }
+    float calculateAverageMotorHz() const { return _motorControl.calculateAverageMotorHz(); }
+    void setRPM_ControlEnabled(bool rpmControlEnabled, float maxMotorHz) { _motorControl.setRPM_ControlEnabled(rpmControlEnabled, maxMotorHz); }
+    bool isRPM_ControlEnabled() const { return _motorControl.isRPM_ControlEnabled(); }
+    MotorRPM_Controller<MOTOR_COUNT>& getRPM_Controller() { return _motorControl.getRPM_Controller(); }
+    void setRPM_Limiter(RPM_Limiter* rpmLimiter) { _motorControl.setRPM_Limiter(rpmLimiter); } //!< optional, nullptr for no RPM limit
+    const MotorSpeedPredictor<MOTOR_COUNT>& getMotorSpeedPredictor() const { return _motorControl.getMotorSpeedPredictor(); }
+
+    virtual void outputToMotors(const typename base_t::commands_t& commands, float deltaT, uint32_t tickCount) override {
+        (void)tickCount;
+
+        const float throttle = _motorControl.calculateThrottle(commands.throttle, this->motorsIsOn(), deltaT);
+        this->mix(commands, throttle);
+
+        // and finally output to the motors, reading the motor RPM to set the RPM filters
+        std::array<uint16_t, MOTOR_COUNT> values {};
+        _motorControl.calculateValues(values, this->_motorOutputs, this->motorsIsOn(), this->_motorOutputMin, deltaT);
+#if defined(USE_DSHOT_RPI_PICO_PIO) || defined(USE_DSHOT_ESP32_RMT) || defined(FRAMEWORK_TEST)
+        // each motor has its own PIO state machine or RMT channel
+        for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+            _escs[ii].write(values[ii]);
+        }
+        // read() does not block, it picks up the latest telemetry, which is decoded in the background as it arrives
+        for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+            const bool received = _escs[ii].read();
+            _motorControl.setMotorTelemetry(ii, _escs[ii].getMotorHz(), _escs[ii].getTelemetryValidity().getWeight(), received);
+        }
+#else
+        _escDShotBatch.write(&values[0]);
+        // unidirectional DShot has no telemetry, so the RPM filters are faded out
+        for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+            _motorControl.setMotorTelemetry(ii, 0.0F, 0.0F, false);
+        }
+#endif
+        _motorControl.predict(deltaT);
+        this->setESC_TelemetryDebug();
+    }
+protected:
+    DShotMotorControl<MOTOR_COUNT> _motorControl;
+    std::array<ESC_DShot, MOTOR_COUNT> _escs {};
+#if !defined(USE_DSHOT_RPI_PICO_PIO) && !defined(USE_DSHOT_ESP32_RMT) && !defined(FRAMEWORK_TEST)
+    //! unidirectional DShot sends the frames for all the motors at once, the ESC_DShot objects are not used for output or telemetry
+    ESC_DShotBatch _escDShotBatch {ESC_DShot::ESC_PROTOCOL_DSHOT300};
+#endif
+};
@@ -1,6 +1,6 @@
 #pragma once
 
-#include <MotorMixerBase.h>
+#include <MotorMixerMatrix.h>
 #include <array>
 
 
@@ -1,77 +1,108 @@
-#include "DynamicIdleController.h"
 #include "MotorMixerQuadX_DShot.h"
 
-#include <RPM_Filters.h>
+#include <array>
 
 
 MotorMixerQuadX_DShot::MotorMixerQuadX_DShot(Debug& debug, const pins_t& pins, RPM_Filters& rpmFilters, DynamicIdleController& dynamicIdleController) :
     MotorMixerQuadX_Base(debug),
-    _rpmFilters(rpmFilters),
-    _dynamicIdleController(dynamicIdleController)
+    _motorControl(rpmFilters, dynamicIdleController)
 {
+#if defined(USE_DSHOT_RPI_PICO_PIO) || defined(USE_DSHOT_ESP32_RMT) || defined(FRAMEWORK_TEST)
     _motorBR.init(pins.br);
     _motorFR.init(pins.fr);
     _motorBL.init(pins.bl);
     _motorFL.init(pins.fl);
+#if defined(USE_DSHOT_RPI_PICO_PIO) || defined(USE_DSHOT_TELEMETRY)
+    // Extended DShot Telemetry (temperature, voltage, current etc) is only sent by the ESCs once it has been enabled
+    _motorControl.getCommandQueue().enqueue(DShotCommandQueue::DSHOT_CMD_EXTENDED_TELEMETRY_ENABLE);
+#endif
+#else
+    const std::array<uint8_t, MOTOR_COUNT> motorPins = { pins.br, pins.fr, pins.bl, pins.fl };
+    _escDShotBatch.init(&motorPins[0], MOTOR_COUNT);
+#endif
 }
 
-float MotorMixerQuadX_DShot::calculateSlowestMotorHz() const
+DynamicIdleController* MotorMixerQuadX_DShot::getDynamicIdleController() const
 {
-    float slowestMotorHz = _motorBR.getMotorHz();
-    float motorHz = _motorFR.getMotorHz();
-    if (motorHz < slowestMotorHz) {
-        slowestMotorHz = motorHz;
-    }
-    motorHz = _motorBL.getMotorHz();
-    if (motorHz < slowestMotorHz) {
-        slowestMotorHz = motorHz;
-    }
-    motorHz = _motorFL.getMotorHz();
-    if (motorHz < slowestMotorHz) {
-        slowestMotorHz = motorHz;
+    return &_motorControl.getDynamicIdleController();
+}
+
+/*!
+Queue a DShot special command, for example to make the motors beep or to set the spin direction.
+
+Commands are only sent while the motors are switched off, so the command is rejected if the motors are on.
+*/
+bool MotorMixerQuadX_DShot::sendDShotCommand(DShotCommandQueue::command_e command, uint8_t motorIndex)
+{
+    if (motorsIsOn()) {
+        return false;
     }
-    return slowestMotorHz;
+    return _motorControl.getCommandQueue().enqueue(command, motorIndex);
 }
 
-DynamicIdleController* MotorMixerQuadX_DShot::getDynamicIdleController() const
+const ESC_DShot& MotorMixerQuadX_DShot::getESC(size_t motorIndex) const
+{
+    return motorIndex == MOTOR_BR ? _motorBR : motorIndex == MOTOR_FR ? _motorFR : motorIndex == MOTOR_BL ? _motorBL : _motorFL;
+}
+
+ESC_DShot& MotorMixerQuadX_DShot::getESC(size_t motorIndex)
+{
+    return motorIndex == MOTOR_BR ? _motorBR : motorIndex == MOTOR_FR ? _motorFR : motorIndex == MOTOR_BL ? _motorBL : _motorFL;
+}
+
+esc_telemetry_t MotorMixerQuadX_DShot::getMotorTelemetry(size_t motorIndex) const
 {
-    return &_dynamicIdleController;
+    switch (motorIndex) {
+    case MOTOR_BR:
+        return _motorBR.getTelemetry();
+    case MOTOR_FR:
+        return _motorFR.getTelemetry();
+    case MOTOR_BL:
+        return _motorBL.getTelemetry();
+    case MOTOR_FL:
+        return _motorFL.getTelemetry();
+    default:
+        return esc_telemetry_t {};
+    }
 }
 
 void MotorMixerQuadX_DShot::outputToMotors(const commands_t& commands, float deltaT, uint32_t tickCount)
 {
     (void)tickCount;
 
+    const float throttle = _motorControl.calculateThrottle(commands.throttle, motorsIsOn(), deltaT);
+    _throttleCommand = throttle;
     if (motorsIsOn()) {
-        const float throttleIncrease = _dynamicIdleController.calculateSpeedIncrease(calculateSlowestMotorHz(), deltaT);
-        const float throttle = commands.throttle + throttleIncrease;
-        _throttleCommand = throttle;
-
-        // calculate the "mix" for the QuadX motor configuration
-        _motorOutputs[MOTOR_BR] = -commands.roll - commands.pitch - commands.yaw + throttle;
-        _motorOutputs[MOTOR_FR] = -commands.roll + commands.pitch + commands.yaw + throttle;
-        _motorOutputs[MOTOR_BL] =  commands.roll - commands.pitch + commands.yaw + throttle;
-        _motorOutputs[MOTOR_FL] =  commands.roll + commands.pitch - commands.yaw + throttle;
+        // calculate the "mix" for the QuadX motor configuration, when RPM control is enabled the mix gives RPM targets
+        MotorMixMatrices::QUAD_X.mix(_motorOutputs, commands, throttle);
     } else {
         _motorOutputs = { 0.0F, 0.0F, 0.0F, 0.0F };
-        _throttleCommand = commands.throttle;
     }
 
     // and finally output to the motors, reading the motor RPM to set the RPM filters
-    // motor outputs are converted to DShot range [47,2047]
-    _motorBR.write(static_cast<uint16_t>(std::lroundf(2000.0F*clip(_motorOutputs[MOTOR_BR], _motorOutputMin, 1.0F)) + 47)),
-    _motorBR.read();
-    _rpmFilters.setFrequencyHz(MOTOR_BR, _motorBR.getMotorHz());
-
-    _motorFR.write(static_cast<uint16_t>(std::lroundf(2000.0F*clip(_motorOutputs[MOTOR_FR], _motorOutputMin, 1.0F)) + 47)),
-    _motorFR.read();
-    _rpmFilters.setFrequencyHz(MOTOR_FR, _motorBR.getMotorHz());
+    std::array<uint16_t, MOTOR_COUNT> values {};
+    _motorControl.calculateValues(values, _motorOutputs, motorsIsOn(), _motorOutputMin, deltaT);
+#if defined(USE_DSHOT_RPI_PICO_PIO) || defined(USE_DSHOT_ESP32_RMT) || defined(FRAMEWORK_TEST)
+    // each motor has its own PIO state machine or RMT channel
+    _motorBR.write(values[MOTOR_BR]);
+    _motorFR.write(values[MOTOR_FR]);
+    _motorBL.write(values[MOTOR_BL]);
+    _motorFL.write(values[MOTOR_FL]);
 
-    _motorBL.write(static_cast<uint16_t>(std::lroundf(2000.0F*clip(_motorOutputs[MOTOR_BL], _motorOutputMin, 1.0F)) + 47)),
-    _motorBL.read();
-    _rpmFilters.setFrequencyHz(MOTOR_BL, _motorBR.getMotorHz());
+    // read() does not block, it picks up the latest telemetry, which is decoded in the background as it arrives
+    for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+        ESC_DShot& esc = getESC(ii);
+        const bool received = esc.read();
+        _motorControl.setMotorTelemetry(ii, esc.getMotorHz(), esc.getTelemetryValidity().getWeight(), received);
+    }
+#else
+    _escDShotBatch.write(&values[0]);
+    // unidirectional DShot has no telemetry, so the RPM filters are faded out
+    for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+        _motorControl.setMotorTelemetry(ii, 0.0F, 0.0F, false);
+    }
+#endif
+    _motorControl.predict(deltaT);
 
-    _motorFL.write(static_cast<uint16_t>(std::lroundf(2000.0F*clip(_motorOutputs[MOTOR_FL], _motorOutputMin, 1.0F)) + 47)),
-    _motorFL.read();
-    _rpmFilters.setFrequencyHz(MOTOR_FL, _motorBR.getMotorHz());
+    setESC_TelemetryDebug();
 }
@@ -1,29 +1,58 @@
 #pragma once
 
+#include <DShotMotorControl.h>
 #include <ESC_DShot.h>
+#include <ESC_DShotBatch.h>
 #include <MotorMixerQuadX_Base.h>
 #include <xyz_type.h>
 
-class RPM_Filters;
-
 /*!
 DShot Motor Mixer.
 
 Hz is used for motor revolutions per second rather than RPS, since RPS is generally used for Radians Per Second.
+
+When RPM control is enabled, the mixer outputs are RPM targets (as a fraction of maxMotorHz) and the per-motor RPM controller
+calculates the DShot values required to achieve them, using the motor speeds from bidirectional DShot telemetry.
+In this mode the DynamicIdleController is used only as a minimum RPM constraint.
+
+The dynamic idle, RPM limiter, RPM control, and DShot command handling is shared with the other DShot mixers, see DShotMotorControl.
+
+Each motor has its own ESC_DShot when USE_DSHOT_RPI_PICO_PIO or USE_DSHOT_ESP32_RMT is defined (and for the test build,
+so the telemetry path can be tested). Otherwise unidirectional DShot is output by ESC_DShotBatch, which is implemented only
+for the RPI Pico (see ESC_DShotBatch::OUTPUT_IMPLEMENTED), and there is no telemetry.
 */
 class MotorMixerQuadX_DShot : public MotorMixerQuadX_Base {
+public:
+    static constexpr float DEFAULT_MAX_MOTOR_HZ = DShotMotorControl<MOTOR_COUNT>::DEFAULT_MAX_MOTOR_HZ;
 public:
     MotorMixerQuadX_DShot(Debug& debug, const pins_t& pins, RPM_Filters& rpmFilters, DynamicIdleController& dynamicIdleController);
 public:
     virtual void outputToMotors(const commands_t& commands, float deltaT, uint32_t tickCount) override;
     virtual DynamicIdleController* getDynamicIdleController() const override;
-    float calculateSlowestMotorHz() const;
+    virtual int32_t getMotorRPM(size_t motorIndex) const override { return getESC(motorIndex).getMotorRPM(); }
+    virtual float getMotorFrequencyHz(size_t motorIndex) const override { return getESC(motorIndex).getMotorHz(); }
+    virtual float getMotorFrequencyWeight(size_t motorIndex) const override { return getESC(motorIndex).getTelemetryValidity().getWeight(); }
+    virtual esc_telemetry_t getMotorTelemetry(size_t motorIndex) const override;
+    const ESC_DShot& getESC(size_t motorIndex) const;
+    ESC_DShot& getESC(size_t motorIndex); //!< for test code
+    float calculateSlowestMotorHz() const { return _motorControl.calculateSlowestMotorHz(); }
+    float calculateAverageMotorHz() const { return _motorControl.calculateAverageMotorHz(); }
+    bool sendDShotCommand(DShotCommandQueue::command_e command, uint8_t motorIndex);
+    bool sendDShotCommand(DShotCommandQueue::command_e command) { return sendDShotCommand(command, DShotCommandQueue::ALL_MOTORS); }
+    void setRPM_ControlEnabled(bool rpmControlEnabled, float maxMotorHz) { _motorControl.setRPM_ControlEnabled(rpmControlEnabled, maxMotorHz); }
+    bool isRPM_ControlEnabled() const { return _motorControl.isRPM_ControlEnabled(); }
+    MotorRPM_Controller<MOTOR_COUNT>& getRPM_Controller() { return _motorControl.getRPM_Controller(); }
+    void setRPM_Limiter(RPM_Limiter* rpmLimiter) { _motorControl.setRPM_Limiter(rpmLimiter); } //!< optional, nullptr for no RPM limit
+    const MotorSpeedPredictor<MOTOR_COUNT>& getMotorSpeedPredictor() const { return _motorControl.getMotorSpeedPredictor(); }
 protected:
-    RPM_Filters& _rpmFilters;
-    DynamicIdleController& _dynamicIdleController;
+    DShotMotorControl<MOTOR_COUNT> _motorControl;
 
     ESC_DShot _motorBR {ESC_DShot::ESC_PROTOCOL_DSHOT300};
     ESC_DShot _motorFR {ESC_DShot::ESC_PROTOCOL_DSHOT300};
     ESC_DShot _motorBL {ESC_DShot::ESC_PROTOCOL_DSHOT300};
     ESC_DShot _motorFL {ESC_DShot::ESC_PROTOCOL_DSHOT300};
+#if !defined(USE_DSHOT_RPI_PICO_PIO) && !defined(USE_DSHOT_ESP32_RMT) && !defined(FRAMEWORK_TEST)
+    //! unidirectional DShot sends the frames for all the motors at once, the ESC_DShot objects are not used for output or telemetry
+    ESC_DShotBatch _escDShotBatch {ESC_DShot::ESC_PROTOCOL_DSHOT300};
+#endif
 };
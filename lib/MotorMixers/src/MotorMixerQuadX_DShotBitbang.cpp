@@ -1,72 +1,71 @@
 #include "DynamicIdleController.h"
 #include "MotorMixerQuadX_DShotBitbang.h"
 
-#include <cmath>
+#include <array>
 
 
-MotorMixerQuadX_DShotBitbang::MotorMixerQuadX_DShotBitbang(Debug& debug, const pins_t& pins, RPM_Filters& rpmFilters, DynamicIdleController& dynamicIdleController) :
+MotorMixerQuadX_DShotBitbang::MotorMixerQuadX_DShotBitbang(Debug& debug, const port_pins_t& pins, RPM_Filters& rpmFilters, DynamicIdleController& dynamicIdleController) :
     MotorMixerQuadX_Base(debug),
-    _rpmFilters(rpmFilters),
-    _dynamicIdleController(dynamicIdleController)
+    _motorControl(rpmFilters, dynamicIdleController)
 {
-    (void)pins; // !!TODO: set pins
+    const std::array<ESC_DShotBitbang::port_pin_t, MOTOR_COUNT> motorPins = {{
+        { pins.br.port, pins.br.pin },
+        { pins.fr.port, pins.fr.pin },
+        { pins.bl.port, pins.bl.pin },
+        { pins.fl.port, pins.fl.pin }
+    }};
+    _escDShot.init(&motorPins[0], MOTOR_COUNT);
     constexpr float SECONDS_PER_MINUTE = 60.0F;
-    _eRPMtoHz = 2.0F * (100.0F / SECONDS_PER_MINUTE) / static_cast<float>(_motorPoleCount);
+    _eRPMtoHz = 2.0F / (SECONDS_PER_MINUTE * static_cast<float>(_motorPoleCount)); // eRPM = RPM * poles/2
 }
 
-float MotorMixerQuadX_DShotBitbang::calculateSlowestMotorHz() const
+DynamicIdleController* MotorMixerQuadX_DShotBitbang::getDynamicIdleController() const
 {
-    float slowestMotorHz = _motorFrequenciesHz[0];
-    float motorHz = _motorFrequenciesHz[1];
-    if (motorHz < slowestMotorHz) {
-        slowestMotorHz = motorHz;
-    }
-    motorHz = _motorFrequenciesHz[2];
-    if (motorHz < slowestMotorHz) {
-        slowestMotorHz = motorHz;
-    }
-    motorHz = _motorFrequenciesHz[3];
-    if (motorHz < slowestMotorHz) {
-        slowestMotorHz = motorHz;
-    }
-    return slowestMotorHz;
+    return &_motorControl.getDynamicIdleController();
 }
 
-DynamicIdleController* MotorMixerQuadX_DShotBitbang::getDynamicIdleController() const
+int32_t MotorMixerQuadX_DShotBitbang::getMotorRPM(size_t motorIndex) const
 {
-    return &_dynamicIdleController;
+    return _escDShot.getMotorERPM(motorIndex) * 2 / _motorPoleCount; // eRPM = RPM * poles/2
+}
+
+/*!
+Queue a DShot special command, for example to make the motors beep or to set the spin direction.
+
+Commands are only sent while the motors are switched off, so the command is rejected if the motors are on.
+*/
+bool MotorMixerQuadX_DShotBitbang::sendDShotCommand(DShotCommandQueue::command_e command, uint8_t motorIndex)
+{
+    if (motorsIsOn()) {
+        return false;
+    }
+    return _motorControl.getCommandQueue().enqueue(command, motorIndex);
 }
 
 void MotorMixerQuadX_DShotBitbang::outputToMotors(const commands_t& commands, float deltaT, uint32_t tickCount)
 {
     (void)tickCount;
 
+    // dynamic idle uses the predicted motor speeds, so it reacts to throttle chops without waiting for the telemetry to catch up
+    const float throttle = _motorControl.calculateThrottle(commands.throttle, motorsIsOn(), deltaT);
+    _throttleCommand = throttle;
     if (motorsIsOn()) {
-        const float throttleIncrease = _dynamicIdleController.calculateSpeedIncrease(calculateSlowestMotorHz(), deltaT);
-        const float throttle = commands.throttle + throttleIncrease;
-        _throttleCommand = throttle;
-
-        // calculate the "mix" for the QuadX motor configuration
-        _motorOutputs[MOTOR_BR] = -commands.roll - commands.pitch - commands.yaw + throttle;
-        _motorOutputs[MOTOR_FR] = -commands.roll + commands.pitch + commands.yaw + throttle;
-        _motorOutputs[MOTOR_BL] =  commands.roll - commands.pitch + commands.yaw + throttle;
-        _motorOutputs[MOTOR_FL] =  commands.roll + commands.pitch - commands.yaw + throttle;
+        // calculate the "mix" for the QuadX motor configuration, when RPM control is enabled the mix gives RPM targets
+        MotorMixMatrices::QUAD_X.mix(_motorOutputs, commands, throttle);
     } else {
         _motorOutputs = { 0.0F, 0.0F, 0.0F, 0.0F };
-        _throttleCommand = commands.throttle;
     }
 
-    // convert motor output to DShot range [47, 2047]
-    _escDShot.outputToMotors(
-        static_cast<uint16_t>(std::lroundf(2000.0F*clip(_motorOutputs[MOTOR_BR], _motorOutputMin, 1.0F)) + 47),
-        static_cast<uint16_t>(std::lroundf(2000.0F*clip(_motorOutputs[MOTOR_FR], _motorOutputMin, 1.0F)) + 47),
-        static_cast<uint16_t>(std::lroundf(2000.0F*clip(_motorOutputs[MOTOR_BL], _motorOutputMin, 1.0F)) + 47),
-        static_cast<uint16_t>(std::lroundf(2000.0F*clip(_motorOutputs[MOTOR_FL], _motorOutputMin, 1.0F)) + 47)
-    );
+    // convert motor output to DShot range [47, 2047], when the motors are off send DSHOT_CMD_MOTOR_STOP or any queued command
+    std::array<uint16_t, MOTOR_COUNT> values {};
+    _motorControl.calculateValues(values, _motorOutputs, motorsIsOn(), _motorOutputMin, deltaT);
+    // outputToMotors() first decodes the replies to the previous frames
+    _escDShot.outputToMotors(&values[0]);
 
     // read the motor RPM, used to set the RPM filters
-    _motorFrequenciesHz[0] = static_cast<float>(_escDShot.getMotorERPM(0))*_eRPMtoHz;
-    _motorFrequenciesHz[1] = static_cast<float>(_escDShot.getMotorERPM(1))*_eRPMtoHz;
-    _motorFrequenciesHz[2] = static_cast<float>(_escDShot.getMotorERPM(2))*_eRPMtoHz;
-    _motorFrequenciesHz[3] = static_cast<float>(_escDShot.getMotorERPM(3))*_eRPMtoHz;
+    for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+        const float motorHz = static_cast<float>(_escDShot.getMotorERPM(ii))*_eRPMtoHz;
+        _motorControl.setMotorTelemetry(ii, motorHz, _escDShot.getTelemetryValidity(ii).getWeight(), _escDShot.isTelemetryReceived(ii));
+    }
+    _motorControl.predict(deltaT);
 }
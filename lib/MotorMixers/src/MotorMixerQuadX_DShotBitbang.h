@@ -1,29 +1,48 @@
 #pragma once
 
+#include <DShotMotorControl.h>
 #include <ESC_DShotBitbang.h>
 #include <MotorMixerQuadX_Base.h>
 
 class RPM_Filters;
 
 /*!
-DShot Motor Mixer.
+DShot Motor Mixer, using bit-banged bidirectional DShot.
 
 Hz is used for motor revolutions per second rather than RPS, since RPS is generally used for Radians Per Second.
+
+The motor speeds from the telemetry are passed to the RPM filters, weighted by the validity of each motor's telemetry,
+so that a motor's notches fade out if its replies are lost or corrupted.
+
+Dynamic idle, DShot command handling, and the telemetry fan-out are shared with the other DShot mixers, see DShotMotorControl.
+Dynamic idle uses the MotorSpeedPredictor, so it is not driven by telemetry that is a loop or more old.
 */
 class MotorMixerQuadX_DShotBitbang : public MotorMixerQuadX_Base {
 public:
-    MotorMixerQuadX_DShotBitbang(Debug& debug, const pins_t& pins, RPM_Filters& rpmFilters, DynamicIdleController& dynamicIdleController);
+    static constexpr float DEFAULT_MAX_MOTOR_HZ = DShotMotorControl<MOTOR_COUNT>::DEFAULT_MAX_MOTOR_HZ;
+public:
+    MotorMixerQuadX_DShotBitbang(Debug& debug, const port_pins_t& pins, RPM_Filters& rpmFilters, DynamicIdleController& dynamicIdleController);
 public:
     virtual void outputToMotors(const commands_t& commands, float deltaT, uint32_t tickCount) override;
     virtual DynamicIdleController* getDynamicIdleController() const override;
-    float calculateSlowestMotorHz() const;
+    virtual int32_t getMotorRPM(size_t motorIndex) const override;
+    virtual float getMotorFrequencyHz(size_t motorIndex) const override { return _motorControl.getMotorHz(motorIndex); }
+    virtual float getMotorFrequencyWeight(size_t motorIndex) const override { return _escDShot.getTelemetryValidity(motorIndex).getWeight(); }
+    float calculateSlowestMotorHz() const { return _motorControl.calculateSlowestMotorHz(); }
+    float calculateAverageMotorHz() const { return _motorControl.calculateAverageMotorHz(); }
+    bool sendDShotCommand(DShotCommandQueue::command_e command, uint8_t motorIndex);
+    bool sendDShotCommand(DShotCommandQueue::command_e command) { return sendDShotCommand(command, DShotCommandQueue::ALL_MOTORS); }
+    void setRPM_ControlEnabled(bool rpmControlEnabled, float maxMotorHz) { _motorControl.setRPM_ControlEnabled(rpmControlEnabled, maxMotorHz); }
+    bool isRPM_ControlEnabled() const { return _motorControl.isRPM_ControlEnabled(); }
+    MotorRPM_Controller<MOTOR_COUNT>& getRPM_Controller() { return _motorControl.getRPM_Controller(); }
+    void setRPM_Limiter(RPM_Limiter* rpmLimiter) { _motorControl.setRPM_Limiter(rpmLimiter); } //!< optional, nullptr for no RPM limit
+    const MotorSpeedPredictor<MOTOR_COUNT>& getMotorSpeedPredictor() const { return _motorControl.getMotorSpeedPredictor(); }
+    ESC_DShotBitbang& getESC() { return _escDShot; } //!< for test code
 protected:
     enum { DEFAULT_MOTOR_POLE_COUNT = 14 };
     uint16_t _motorPoleCount {DEFAULT_MOTOR_POLE_COUNT}; //!< number of poles the motor has, used to calculate RPM from telemetry data
     float _eRPMtoHz {};
-    RPM_Filters& _rpmFilters;
-    DynamicIdleController& _dynamicIdleController;
+    DShotMotorControl<MOTOR_COUNT> _motorControl;
 
     ESC_DShotBitbang _escDShot {};
-    std::array<float, MOTOR_COUNT> _motorFrequenciesHz {};
 };
@@ -2,6 +2,7 @@
 #include <cmath>
 
 #if defined(FRAMEWORK_RPI_PICO)
+#include <hardware/clocks.h>
 #include <hardware/gpio.h>
 #include <hardware/pwm.h>
 #elif defined(FRAMEWORK_ESPIDF)
@@ -10,10 +11,27 @@
 #else // defaults to FRAMEWORK_ARDUINO
 #include <Arduino.h>
 #if defined(FRAMEWORK_ARDUINO_ESP32)
+#include <driver/ledc.h>
 #include <esp32-hal-ledc.h>
+#include <soc/soc_caps.h>
 #endif
 #endif // FRAMEWORK
 
+#include <algorithm>
+#include <array>
+
+
+namespace { // use anonymous namespace to make items local to this translation unit
+const std::array<MotorMixerQuadX_PWM::pulse_range_t, MotorMixerQuadX_PWM::PROTOCOL_COUNT> pulseRanges {{
+    {      0,      0 }, // PWM
+    { 125000, 250000 }, // Oneshot125
+    {  42000,  84000 }, // Oneshot42
+    {   5000,  25000 }  // Multishot
+}};
+enum { ONESHOT_MIN_STEPS = 2000 }; // at least 11 bits of resolution over the pulse range
+enum { ONESHOT_MIN_LOW_NANOSECONDS = 4000 }; // minimum time the output is low between pulses, so the ESC sees the end of each pulse
+} // END namespace
+
 
 MotorMixerQuadX_PWM::MotorMixerQuadX_PWM(Debug& debug, const port_pins_t& pins) :
     MotorMixerQuadX_Base(debug),
@@ -23,10 +41,15 @@ MotorMixerQuadX_PWM::MotorMixerQuadX_PWM(Debug& debug, const port_pins_t& pins)
 #endif
 }
 
-MotorMixerQuadX_PWM::MotorMixerQuadX_PWM(Debug& debug, const pins_t& pins) :
+MotorMixerQuadX_PWM::MotorMixerQuadX_PWM(Debug& debug, const pins_t& pins, protocol_e protocol) :
     MotorMixerQuadX_Base(debug),
+    _protocol(protocol),
     _pins({{0,pins.br},{0,pins.fr},{0,pins.bl},{0,pins.fl}})
 {
+    if (_protocol != PROTOCOL_PWM) {
+        initOneshot(pins);
+        return;
+    }
 #if defined(FRAMEWORK_RPI_PICO)
 
     _pwmScale = 65535.0F;
@@ -87,9 +110,146 @@ MotorMixerQuadX_PWM::MotorMixerQuadX_PWM(Debug& debug, const pins_t& pins) :
 #endif // FRAMEWORK
 }
 
+MotorMixerQuadX_PWM::pulse_range_t MotorMixerQuadX_PWM::getPulseRange(protocol_e protocol)
+{
+    return pulseRanges[protocol]; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+}
+
+/*!
+Sets up the timers for Oneshot output.
+
+The timer resolution is chosen to give at least ONESHOT_MIN_STEPS over the pulse range, and the timer period is longer than the longest pulse
+(on ESP32 by at least ONESHOT_MIN_LOW_NANOSECONDS, since the LEDC period is only just longer than the Multishot pulse).
+The pulses are started by completeOneshotUpdate(), so if the timer period is shorter than the PID loop period the pulse is repeated,
+which is harmless since the ESC receives the same value.
+*/
+void MotorMixerQuadX_PWM::initOneshot(const pins_t& pins)
+{
+    const pulse_range_t range = getPulseRange(_protocol);
+#if defined(FRAMEWORK_RPI_PICO)
+    // use the largest clock divider that still gives the required resolution, 16-bit counter wraps after 65536 ticks
+    const uint32_t clockHz = clock_get_hz(clk_sys);
+    const uint64_t divider = static_cast<uint64_t>(clockHz) * (range.maxNanoSeconds - range.minNanoSeconds) / (1000000000ULL * ONESHOT_MIN_STEPS);
+    const uint32_t clockDivider = divider < 1 ? 1 : static_cast<uint32_t>(divider);
+    const uint64_t tickHz = clockHz / clockDivider;
+
+    pwm_config config = pwm_get_default_config();
+    pwm_config_set_clkdiv_int(&config, clockDivider);
+    pwm_config_set_wrap(&config, 0xFFFF);
+    const std::array<uint8_t, MOTOR_COUNT> motorPins = { pins.br, pins.fr, pins.bl, pins.fl };
+    for (const uint8_t pin : motorPins) {
+        if (pin != 0xFF) {
+            gpio_set_function(pin, GPIO_FUNC_PWM);
+            const uint32_t slice = pwm_gpio_to_slice_num(pin);
+            pwm_init(slice, &config, false);
+            pwm_set_gpio_level(pin, 0); // no pulse until the first call to outputToMotors
+            _sliceMask |= 1U << slice;
+        }
+    }
+#elif defined(FRAMEWORK_ESPIDF)
+    // Oneshot output not yet implemented for ESP-IDF, rejected at compile time, see ONESHOT_IMPLEMENTED
+    (void)pins;
+    const uint64_t tickHz = 0;
+#elif defined(FRAMEWORK_TEST)
+    (void)pins;
+    const uint64_t tickHz = 1000000000; // 1ns ticks, so pulse widths can be checked in nanoseconds
+#else // defaults to FRAMEWORK_ARDUINO
+#if defined(FRAMEWORK_ARDUINO_ESP32)
+    // LEDC is clocked from the 80MHz APB clock, so use the smallest resolution whose period at 80MHz is longer than the longest pulse
+    // by at least ONESHOT_MIN_LOW_NANOSECONDS, so there is always some low time between pulses (for Multishot a period of 25.6us
+    // would leave only 0.6us low after a 25us pulse, so its period is 51.2us).
+    // The resolution is limited by the width of the LEDC timer (14 bits on the ESP32-S3 and ESP32-C3), so for Oneshot125 the
+    // timer is clocked more slowly than 80MHz to give a period longer than the longest pulse.
+    // This gives about 8000 steps for Oneshot125 on ESP32-S3 (10000 on ESP32) and 3360 steps for Oneshot42.
+    // Multishot would get only 1600 steps, so it is rejected at compile time, see MULTISHOT_IMPLEMENTED.
+    constexpr uint64_t APB_CLOCK_HZ = 80000000;
+#if defined(SOC_LEDC_TIMER_BIT_WIDTH)
+    constexpr uint8_t LEDC_MAX_RESOLUTION = SOC_LEDC_TIMER_BIT_WIDTH;
+#else
+    constexpr uint8_t LEDC_MAX_RESOLUTION = SOC_LEDC_TIMER_BIT_WIDE_NUM; // ESP-IDF v4 name
+#endif
+    const uint64_t periodNanoSeconds = static_cast<uint64_t>(range.maxNanoSeconds) + ONESHOT_MIN_LOW_NANOSECONDS;
+    uint8_t resolution = 8;
+    while (resolution < LEDC_MAX_RESOLUTION && (1ULL << resolution) * 1000000000ULL < periodNanoSeconds * APB_CLOCK_HZ) {
+        ++resolution;
+    }
+    const auto frequency = static_cast<uint32_t>(std::min<uint64_t>(APB_CLOCK_HZ >> resolution, 1000000000ULL / periodNanoSeconds));
+    uint32_t frequencySet = frequency;
+    const std::array<uint8_t, MOTOR_COUNT> motorPins = { pins.br, pins.fr, pins.bl, pins.fl };
+    for (uint8_t channel = 0; channel < MOTOR_COUNT; ++channel) {
+        if (motorPins[channel] != 0xFF) {
+            // ledcSetup returns the frequency actually set, which may differ slightly from that requested, or zero on failure
+            frequencySet = static_cast<uint32_t>(ledcSetup(channel, frequency, resolution));
+            ledcAttachPin(motorPins[channel], channel);
+            ledcWrite(channel, 0); // no pulse until the first call to outputToMotors
+        }
+    }
+    const uint64_t tickHz = static_cast<uint64_t>(frequencySet) << resolution;
+#else
+    // Oneshot output not supported, rejected at compile time, see ONESHOT_IMPLEMENTED
+    (void)pins;
+    const uint64_t tickHz = 0;
+#endif
+#endif // FRAMEWORK
+    _pulseMinTicks = static_cast<uint32_t>(range.minNanoSeconds * tickHz / 1000000000ULL);
+    _pulseRangeTicks = static_cast<uint32_t>(range.maxNanoSeconds * tickHz / 1000000000ULL) - _pulseMinTicks;
+}
+
+/*!
+Returns the Oneshot pulse width, in timer ticks, for the given motor output.
+
+When the motors are off the motor output is zero, so the minimum pulse is sent, which the ESC requires to arm.
+*/
+uint32_t MotorMixerQuadX_PWM::calculatePulseTicks(float motorOutput) const
+{
+    return _pulseMinTicks + static_cast<uint32_t>(std::lroundf(static_cast<float>(_pulseRangeTicks)*clip(motorOutput, 0.0F, 1.0F)));
+}
+
+/*!
+Called before the pulse widths are written.
+*/
+void MotorMixerQuadX_PWM::beginOneshotUpdate() // NOLINT(readability-make-member-function-const)
+{
+#if defined(FRAMEWORK_RPI_PICO)
+    // the PWM compare values are double buffered and only latched on counter wrap, unless the slice is disabled,
+    // so disable the slices while the new pulse widths are written
+    pwm_set_mask_enabled(pwm_hw->en & ~_sliceMask);
+#endif
+}
+
+/*!
+Called after the pulse widths are written, restarts the timers so that the pulses start immediately.
+*/
+void MotorMixerQuadX_PWM::completeOneshotUpdate() // NOLINT(readability-make-member-function-const)
+{
+#if defined(FRAMEWORK_RPI_PICO)
+    for (uint32_t slice = 0; slice < NUM_PWM_SLICES; ++slice) {
+        if (_sliceMask & (1U << slice)) {
+            pwm_set_counter(slice, 0);
+        }
+    }
+    // enable all the slices at the same time, so the pulses are in phase
+    pwm_set_mask_enabled(pwm_hw->en | _sliceMask);
+#elif defined(FRAMEWORK_ESPIDF)
+#elif defined(FRAMEWORK_TEST)
+#else // defaults to FRAMEWORK_ARDUINO
+#if defined(FRAMEWORK_ARDUINO_ESP32)
+    // the Arduino core uses LEDC timer (channel/2) % 4 for each channel, so the four motor channels use timers 0 and 1
+    ledc_timer_rst(LEDC_LOW_SPEED_MODE, LEDC_TIMER_0);
+    ledc_timer_rst(LEDC_LOW_SPEED_MODE, LEDC_TIMER_1);
+#endif
+#endif // FRAMEWORK
+}
+
 void MotorMixerQuadX_PWM::writeMotorPWM(const port_pin_t& pin, uint8_t channel)
 {
 #if defined(FRAMEWORK_RPI_PICO)
+    if (_protocol != PROTOCOL_PWM) {
+        if (pin.pin != 0xFF) {
+            pwm_set_gpio_level(pin.pin, static_cast<uint16_t>(calculatePulseTicks(_motorOutputs[channel])));
+        }
+        return;
+    }
     // scale motor output to GPIO range [0, 65535] and write
     if (pin.pin != 0xFF) {
         const uint16_t motorOutput = static_cast<uint16_t>(roundf(_pwmScale*clip(_motorOutputs[channel], 0.0F, 1.0F)));
@@ -103,12 +263,21 @@ void MotorMixerQuadX_PWM::writeMotorPWM(const port_pin_t& pin, uint8_t channel)
     (void)channel;
 #else // defaults to FRAMEWORK_ARDUINO
 #if defined(FRAMEWORK_ARDUINO_ESP32)
+    if (_protocol != PROTOCOL_PWM) {
+        if (pin.pin != 0xFF) {
+            ledcWrite(channel, calculatePulseTicks(_motorOutputs[channel]));
+        }
+        return;
+    }
     // scale motor output to GPIO range [0, 255] and write
     if (pin.pin != 0xFF) {
         const uint32_t motorOutput = static_cast<uint32_t>(roundf(_pwmScale*clip(_motorOutputs[channel], 0.0F, 1.0F)));
         ledcWrite(channel, motorOutput);
     }
 #else
+    if (_protocol != PROTOCOL_PWM) {
+        return; // Oneshot output not supported
+    }
     // scale motor output to GPIO range [0, 255] and write
     if (pin.pin != 0xFF) {
         const uint32_t motorOutput = static_cast<uint32_t>(roundf(_pwmScale*clip(_motorOutputs[channel], 0.0F, 1.0F)));
@@ -127,16 +296,21 @@ void MotorMixerQuadX_PWM::outputToMotors(const commands_t& commands, float delta
 
     if (motorsIsOn()) {
         // calculate the "mix" for the QuadX motor configuration
-        _motorOutputs[MOTOR_BR] = -commands.roll - commands.pitch - commands.yaw + commands.throttle;
-        _motorOutputs[MOTOR_FR] = -commands.roll + commands.pitch + commands.yaw + commands.throttle;
-        _motorOutputs[MOTOR_BL] =  commands.roll - commands.pitch + commands.yaw + commands.throttle;
-        _motorOutputs[MOTOR_FL] =  commands.roll + commands.pitch - commands.yaw + commands.throttle;
+        MotorMixMatrices::QUAD_X.mix(_motorOutputs, commands, commands.throttle);
     } else {
         _motorOutputs = { 0.0F, 0.0F, 0.0F, 0.0F };
     }
 
+    const bool oneshot = _protocol != PROTOCOL_PWM;
+    if (oneshot) {
+        beginOneshotUpdate();
+    }
     writeMotorPWM(_pins.br, MOTOR_BR);
     writeMotorPWM(_pins.fr, MOTOR_FR);
     writeMotorPWM(_pins.bl, MOTOR_BL);
     writeMotorPWM(_pins.fl, MOTOR_FL);
+    if (oneshot) {
+        // trigger the pulses now, so the ESCs are updated in sync with the PID loop
+        completeOneshotUpdate();
+    }
 }
@@ -3,14 +3,63 @@
 #include <MotorMixerQuadX_Base.h>
 
 
+/*!
+QuadX motor mixer with PWM output.
+
+PROTOCOL_PWM is used for brushed motors: the motor output is written as the duty cycle of a free running PWM signal.
+
+The Oneshot protocols (Oneshot125, Oneshot42, and Multishot) are used for ESCs that do not support DShot.
+The motor output is encoded as the width of a single pulse, and the pulse is triggered at the end of outputToMotors(),
+so that the ESC is updated in sync with the PID loop.
+*/
 class MotorMixerQuadX_PWM : public MotorMixerQuadX_Base {
 public:
-    MotorMixerQuadX_PWM(Debug& debug, const pins_t& pins);
+#if defined(FRAMEWORK_RPI_PICO) || defined(FRAMEWORK_TEST)
+    static constexpr bool ONESHOT_IMPLEMENTED = true;
+    static constexpr bool MULTISHOT_IMPLEMENTED = true;
+#elif defined(FRAMEWORK_ARDUINO_ESP32)
+    static constexpr bool ONESHOT_IMPLEMENTED = true;
+    //! the LEDC timers are clocked at 80MHz, which gives only 1600 steps over the Multishot pulse range
+    static constexpr bool MULTISHOT_IMPLEMENTED = false;
+#else
+    //! Oneshot output is only implemented for the RPI Pico and for Arduino on ESP32
+    static constexpr bool ONESHOT_IMPLEMENTED = false;
+    static constexpr bool MULTISHOT_IMPLEMENTED = false;
+#endif
+    enum protocol_e {
+        PROTOCOL_PWM,
+        PROTOCOL_ONESHOT125, // 125us to 250us pulse
+        PROTOCOL_ONESHOT42, // 42us to 84us pulse
+        PROTOCOL_MULTISHOT, // 5us to 25us pulse
+        PROTOCOL_COUNT
+    };
+    struct pulse_range_t {
+        uint32_t minNanoSeconds;
+        uint32_t maxNanoSeconds;
+    };
+public:
+    MotorMixerQuadX_PWM(Debug& debug, const pins_t& pins, protocol_e protocol);
+    MotorMixerQuadX_PWM(Debug& debug, const pins_t& pins) : MotorMixerQuadX_PWM(debug, pins, PROTOCOL_PWM) {}
     MotorMixerQuadX_PWM(Debug& debug, const port_pins_t& pins);
 public:
     virtual void outputToMotors(const commands_t& commands, float deltaT, uint32_t tickCount) override;
     void writeMotorPWM(const port_pin_t& pin, uint8_t channel);
+    protocol_e getProtocol() const { return _protocol; }
+    static pulse_range_t getPulseRange(protocol_e protocol);
+    uint32_t calculatePulseTicks(float motorOutput) const;
+    uint32_t getPulseMinTicks() const { return _pulseMinTicks; }
+    uint32_t getPulseRangeTicks() const { return _pulseRangeTicks; } //!< the resolution of the Oneshot output, this is at least 2000 (11 bits)
+protected:
+    void initOneshot(const pins_t& pins);
+    void beginOneshotUpdate();
+    void completeOneshotUpdate();
 protected:
+    protocol_e _protocol {PROTOCOL_PWM};
     float _pwmScale {255.0F};
+    uint32_t _pulseMinTicks {};
+    uint32_t _pulseRangeTicks {};
+#if defined(FRAMEWORK_RPI_PICO)
+    uint32_t _sliceMask {}; //!< the PWM slices used for Oneshot output
+#endif
     port_pins_t _pins {};
 };
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+
+/*!
+Closed-loop per-motor RPM controller.
+
+Each motor has a PI controller with feedforward that calculates the motor output (in the range [outputMin, 1.0])
+required for the motor to spin at its target speed, using the motor speed reported by bidirectional DShot.
+This removes ESC, motor, and battery variation from the outer rate loop.
+
+Speeds are normalized by maxMotorHz, so the gains are dimensionless:
+feedforward of 1.0 means that an output of 1.0 is expected to give maxMotorHz.
+
+The feedback is weighted by the validity of each motor's telemetry: when a motor's telemetry is stale or unreliable (weight 0)
+its output falls back to the open-loop feedforward and its integral is frozen, so the loop does not chase a stale speed.
+
+The state is stored as arrays (structure of arrays) and the update has no branches,
+so since MOTOR_COUNT is a compile time constant the update is unrolled and can be vectorized across the motors.
+*/
+template <size_t MOTOR_COUNT>
+class MotorRPM_Controller {
+public:
+    struct config_t {
+        float kp; //!< proportional gain
+        float ki; //!< integral gain, per second
+        float kff; //!< feedforward gain
+        float integralMax; //!< the integral term is limited to [-integralMax, integralMax]
+    };
+    static constexpr config_t DEFAULT_CONFIG { .kp = 0.5F, .ki = 5.0F, .kff = 1.0F, .integralMax = 0.3F };
+    typedef std::array<float, MOTOR_COUNT> values_t;
+public:
+    explicit MotorRPM_Controller(float maxMotorHz) : MotorRPM_Controller(maxMotorHz, DEFAULT_CONFIG) {}
+    MotorRPM_Controller(float maxMotorHz, const config_t& config) : _config(config) { setMaxMotorHz(maxMotorHz); }
+public:
+    void setConfig(const config_t& config) { _config = config; }
+    const config_t& getConfig() const { return _config; }
+    void setMaxMotorHz(float maxMotorHz) { _maxMotorHz = maxMotorHz; _maxMotorHzReciprocal = 1.0F / maxMotorHz; }
+    float getMaxMotorHz() const { return _maxMotorHz; }
+    const values_t& getIntegrals() const { return _integrals; }
+    void reset() { _integrals.fill(0.0F); }
+
+    /*!
+    Calculate the motor outputs, called from the motor mixer every loop.
+
+    targets are in the range [0.0, 1.0], with 1.0 corresponding to maxMotorHz.
+    The target is raised to minimumMotorHz if it is below it, so that the slowest motor is kept above the dynamic idle speed.
+    weights are the telemetry validity weights, in the range [0.0, 1.0], see ESC_TelemetryValidity.
+    */
+    inline void update(values_t& outputs, const values_t& targets, const values_t& motorHz, const values_t& weights, float minimumMotorHz, float outputMin, float deltaT) {
+        const float minimumTarget = minimumMotorHz * _maxMotorHzReciprocal;
+        const float kiDeltaT = _config.ki * deltaT;
+        for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+            const float target = clip(targets[ii], minimumTarget, 1.0F);
+            // with no valid telemetry there is no error, so the integral is frozen
+            const float error = weights[ii] * (target - motorHz[ii] * _maxMotorHzReciprocal);
+            const float integral = clip(_integrals[ii] + kiDeltaT * error, -_config.integralMax, _config.integralMax);
+            const float unclipped = _config.kff * target + _config.kp * error + weights[ii] * integral;
+            const float output = clip(unclipped, outputMin, 1.0F);
+            // anti-windup: only accept the new integral if the output is not saturated
+            _integrals[ii] = (output == unclipped) ? integral : _integrals[ii];
+            outputs[ii] = output;
+        }
+    }
+    //! update with all the telemetry valid
+    inline void update(values_t& outputs, const values_t& targets, const values_t& motorHz, float minimumMotorHz, float outputMin, float deltaT) {
+        values_t weights; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init) initialized by fill
+        weights.fill(1.0F);
+        update(outputs, targets, motorHz, weights, minimumMotorHz, outputMin, deltaT);
+    }
+public:
+    static inline float clip(float value, float min, float max) { return value < min ? min : value > max ? max : value; }
+private:
+    config_t _config;
+    float _maxMotorHz {};
+    float _maxMotorHzReciprocal {};
+    values_t _integrals {};
+};
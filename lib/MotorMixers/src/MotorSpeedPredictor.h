@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+
+/*!
+Predicts the speed of each motor using a first-order motor model driven by the last motor output, corrected by telemetry.
+
+The RPM telemetry is up to a frame old when it is read, so a controller using it directly (eg the DynamicIdleController)
+reacts late to rapid changes such as throttle chops. The model is stepped forward every loop,
+so the prediction responds to a change in motor output within one loop.
+
+Model: the steady state motor speed is motorGainHz * output, and the motor approaches it with time constant timeConstantSeconds.
+When new telemetry is received, the prediction is pulled towards the measured speed and the motor gain is adapted,
+so the model tracks ESC, motor, and battery variation.
+
+The state is stored as arrays and the updates have no branches, so the loops can be vectorized across the motors.
+*/
+template <size_t MOTOR_COUNT>
+class MotorSpeedPredictor {
+public:
+    struct config_t {
+        float timeConstantSeconds; //!< motor time constant
+        float correctionGain; //!< fraction of the prediction error that is corrected when telemetry is received, in the range [0, 1]
+        float gainAdaptationRate; //!< rate at which the motor gain is adapted to the prediction error
+    };
+    static constexpr config_t DEFAULT_CONFIG { .timeConstantSeconds = 0.03F, .correctionGain = 0.5F, .gainAdaptationRate = 0.05F };
+    typedef std::array<float, MOTOR_COUNT> values_t;
+public:
+    explicit MotorSpeedPredictor(float motorGainHz) : MotorSpeedPredictor(motorGainHz, DEFAULT_CONFIG) {}
+    MotorSpeedPredictor(float motorGainHz, const config_t& config) : _config(config), _initialMotorGainHz(motorGainHz) { reset(); }
+public:
+    void setConfig(const config_t& config) { _config = config; }
+    const config_t& getConfig() const { return _config; }
+    float getPredictedHz(size_t motorIndex) const { return _predictedHz[motorIndex]; } // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    float getMotorGainHz(size_t motorIndex) const { return _motorGainsHz[motorIndex]; } // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    void reset() { _predictedHz.fill(0.0F); _outputs.fill(0.0F); _motorGainsHz.fill(_initialMotorGainHz); }
+    //! set the initial motor gain, ie the motor speed expected for an output of 1.0, and reset the model
+    void setMotorGainHz(float motorGainHz) { _initialMotorGainHz = motorGainHz; reset(); }
+
+    //! step the model forward by deltaT, using the motor outputs (in the range [0, 1]) most recently sent to the motors
+    inline void predict(const values_t& outputs, float deltaT) {
+        const float k = deltaT / (_config.timeConstantSeconds + deltaT);
+        for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+            _outputs[ii] = outputs[ii];
+            _predictedHz[ii] += k * (_motorGainsHz[ii] * outputs[ii] - _predictedHz[ii]);
+        }
+    }
+
+    //! correct the prediction for a motor, called when new telemetry has been received for that motor
+    inline void correct(size_t motorIndex, float measuredHz) {
+        // NOLINTBEGIN(cppcoreguidelines-pro-bounds-constant-array-index)
+        const float error = measuredHz - _predictedHz[motorIndex];
+        _predictedHz[motorIndex] += _config.correctionGain * error;
+        // adapt the gain in proportion to the output, so there is no adaptation when the motor is off
+        const float motorGainHz = _motorGainsHz[motorIndex] + _config.gainAdaptationRate * error * _outputs[motorIndex];
+        _motorGainsHz[motorIndex] = motorGainHz < MIN_MOTOR_GAIN_HZ ? MIN_MOTOR_GAIN_HZ : motorGainHz;
+        // NOLINTEND(cppcoreguidelines-pro-bounds-constant-array-index)
+    }
+
+    inline float calculateSlowestPredictedHz() const {
+        float slowestHz = _predictedHz[0];
+        for (size_t ii = 1; ii < MOTOR_COUNT; ++ii) {
+            slowestHz = _predictedHz[ii] < slowestHz ? _predictedHz[ii] : slowestHz;
+        }
+        return slowestHz;
+    }
+public:
+    static constexpr float MIN_MOTOR_GAIN_HZ = 1.0F;
+private:
+    config_t _config;
+    float _initialMotorGainHz;
+    values_t _predictedHz {};
+    values_t _outputs {};
+    values_t _motorGainsHz {};
+};
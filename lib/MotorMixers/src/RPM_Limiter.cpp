@@ -0,0 +1,67 @@
+#include "RPM_Limiter.h"
+#include <Debug.h>
+
+
+RPM_Limiter::RPM_Limiter(const config_t& config, uint32_t taskIntervalMicroSeconds, Debug& debug) :
+    _debug(debug)
+{
+    setConfig(config, taskIntervalMicroSeconds);
+}
+
+void RPM_Limiter::setConfig(const config_t& config, uint32_t taskIntervalMicroSeconds)
+{
+    _config = config;
+
+    _limitMotorHz = static_cast<float>(config.rpm_limit) / 60.0F;
+    _PID.setSetpoint(_limitMotorHz);
+
+    // use the same multipliers as the DynamicIdleController
+    _PID.setP(static_cast<float>(config.rpm_limit_p_gain) * 0.00015F);
+
+    const float deltaT = static_cast<float>(taskIntervalMicroSeconds) * 0.000001F;
+
+    _PID.setI(static_cast<float>(config.rpm_limit_i_gain) * 0.01F * deltaT);
+    // the PID output is negative when the limit is exceeded, so limit I-term to range [-1, 0]
+    _PID.setIntegralMax(0.0F);
+    _PID.setIntegralMin(-1.0F);
+
+    _PID.setD(static_cast<float>(config.rpm_limit_d_gain) * 0.0000003F / deltaT);
+    _DTermFilter.init(800.0F * deltaT / 20.0F); //approx 20ms D delay
+}
+
+/*!
+Returns the factor, in the range [0, 1], by which the throttle should be multiplied to keep the average motor speed below the limit.
+
+telemetryWeight is the validity of the telemetry used to calculate averageMotorHz, in the range [0, 1].
+With no valid telemetry the throttle is not reduced and the I-term is reset, rather than integrating a stale motor speed.
+*/
+float RPM_Limiter::calculateThrottleScale(float averageMotorHz, float telemetryWeight, float deltaT)
+{
+    if (_limitMotorHz == 0.0F) {
+        return 1.0F;
+    }
+    if (telemetryWeight <= 0.0F) {
+        _PID.resetIntegral();
+        return 1.0F;
+    }
+
+    const float averageMotorHzDeltaFiltered = _DTermFilter.filter(averageMotorHz - _PID.getPreviousMeasurement());
+    const float output = _PID.updateDelta(averageMotorHz, averageMotorHzDeltaFiltered, deltaT);
+
+    const float throttleScale = 1.0F - telemetryWeight * clip(-output, 0.0F, 1.0F);
+
+    if (_debug.getMode() == DEBUG_RPM_LIMIT) {
+        const PIDF::error_t error = _PID.getError();
+        _debug.set(0, static_cast<int16_t>(std::lroundf(averageMotorHz * 6.0F))); // RPM/10, as for DEBUG_ESC_SENSOR_RPM, so it does not overflow
+        _debug.set(1, static_cast<int16_t>(std::lroundf(throttleScale * 1000)));
+        _debug.set(2, static_cast<int16_t>(std::lroundf(error.P * 10000)));
+        _debug.set(3, static_cast<int16_t>(std::lroundf(error.I * 10000)));
+    }
+
+    return throttleScale;
+}
+
+void RPM_Limiter::resetPID()
+{
+    _PID.resetIntegral();
+}
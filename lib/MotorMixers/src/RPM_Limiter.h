@@ -0,0 +1,45 @@
+#pragma once
+
+#include <Filters.h>
+#include <PIDF.h>
+#include <cstdint>
+
+class Debug;
+
+
+/*!
+RPM Limiter: use PID controller to scale back the throttle so that the average motor RPM does not exceed a configured limit.
+
+Used for spec classes with RPM caps. Requires bidirectional DShot, since the average motor RPM is calculated from the ESC telemetry.
+
+The limiter only ever reduces the throttle: the throttle is multiplied by a scale factor in the range [0, 1],
+which is 1 while the average motor RPM is below the limit.
+The D-term is calculated on the filtered change in the average motor speed, in the same way as the DynamicIdleController.
+
+The reduction is weighted by the validity of the telemetry, so the limiter does not act on stale or unreliable motor speeds.
+*/
+class RPM_Limiter {
+public:
+    struct config_t {
+        uint16_t rpm_limit; // 0 to disable
+        uint8_t rpm_limit_p_gain;
+        uint8_t rpm_limit_i_gain;
+        uint8_t rpm_limit_d_gain;
+    };
+public:
+    RPM_Limiter(const config_t& config, uint32_t taskIntervalMicroSeconds, Debug& debug);
+    void setConfig(const config_t& config, uint32_t taskIntervalMicroseconds);
+    const config_t& getConfig() const { return _config; }
+    float getLimitMotorHz() const { return _limitMotorHz; }
+    float calculateThrottleScale(float averageMotorHz, float telemetryWeight, float deltaT);
+    float calculateThrottleScale(float averageMotorHz, float deltaT) { return calculateThrottleScale(averageMotorHz, 1.0F, deltaT); }
+    void resetPID(); //!< for test code
+public:
+    static inline float clip(float value, float min, float max) { return value < min ? min : value > max ? max : value; }
+private:
+    float _limitMotorHz {}; // maximum average motor Hz, 0 if the limiter is disabled
+    PIDF _PID {}; // PID to limit average motor Hz
+    PowerTransferFilter1 _DTermFilter {};
+    Debug& _debug;
+    config_t _config {};
+};
@@ -4,6 +4,7 @@
 #include <FlightController.h>
 #include <IMU_Filters.h>
 #include <RPM_Filters.h>
+#include <RPM_Limiter.h>
 #include <RadioController.h>
 
 
@@ -30,6 +31,13 @@ static const DynamicIdleController::config_t dynamicIdleControllerConfig = {
     .dyn_idle_max_increase = 150,
 };
 
+static const RPM_Limiter::config_t rpmLimiterConfig = {
+    .rpm_limit = 0,
+    .rpm_limit_p_gain = 25,
+    .rpm_limit_i_gain = 10,
+    .rpm_limit_d_gain = 8,
+};
+
 static const FlightController::filters_config_t flightControllerFiltersConfig = {
     .dterm_lpf1_hz = 100,
     .dterm_lpf2_hz = 0,
@@ -19,6 +19,7 @@ const std::array<std::string, FlightController::PID_COUNT> NonVolatileStorage::P
 const char* NonVolatileStorage::FlightControllerFiltersConfigKey = "FCF";
 const char* NonVolatileStorage::ImuFiltersConfigKey = "IF";
 const char* NonVolatileStorage::DynamicIdleControllerConfigKey = "DIC";
+const char* NonVolatileStorage::RPM_LimiterConfigKey = "RPL";
 const char* NonVolatileStorage::RadioControllerRatesKey = "RCR";
 const char* NonVolatileStorage::AccOffsetKey = "ACC";
 const char* NonVolatileStorage::GyroOffsetKey = "GYR";
@@ -106,6 +107,34 @@ void  NonVolatileStorage::DynamicIdleControllerConfigStore(const DynamicIdleCont
 #endif
 }
 
+RPM_Limiter::config_t NonVolatileStorage::RPM_LimiterConfigLoad() const
+{
+#if defined(USE_ARDUINO_ESP32_PREFERENCES)
+    if (_preferences.begin(nonVolatileStorageNamespace, READ_ONLY)) {
+        if (_preferences.isKey(RPM_LimiterConfigKey)) {
+            RPM_Limiter::config_t config {};
+            _preferences.getBytes(RPM_LimiterConfigKey, &config, sizeof(config));
+            _preferences.end();
+            return config;
+        }
+        _preferences.end();
+    }
+#endif
+    return DEFAULTS::rpmLimiterConfig;
+}
+
+void NonVolatileStorage::RPM_LimiterConfigStore(const RPM_Limiter::config_t& config)
+{
+#if defined(USE_ARDUINO_ESP32_PREFERENCES)
+    if (_preferences.begin(nonVolatileStorageNamespace, READ_WRITE)) {
+        _preferences.putBytes(RPM_LimiterConfigKey, &config, sizeof(config));
+        _preferences.end();
+    }
+#else
+    (void)config;
+#endif
+}
+
 FlightController::filters_config_t NonVolatileStorage::FlightControllerFiltersConfigLoad() const
 {
 #if defined(USE_ARDUINO_ESP32_PREFERENCES)
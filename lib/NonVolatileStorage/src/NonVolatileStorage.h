@@ -60,6 +60,10 @@ public:
     DynamicIdleController::config_t DynamicIdleControllerConfigLoad() const;
     void  DynamicIdleControllerConfigStore(const DynamicIdleController::config_t& config);
 
+    static const char* RPM_LimiterConfigKey;
+    RPM_Limiter::config_t RPM_LimiterConfigLoad() const;
+    void RPM_LimiterConfigStore(const RPM_Limiter::config_t& config);
+
     static const char* FlightControllerFiltersConfigKey;
     FlightController::filters_config_t FlightControllerFiltersConfigLoad() const;
     void FlightControllerFiltersConfigStore(const FlightController::filters_config_t& config);
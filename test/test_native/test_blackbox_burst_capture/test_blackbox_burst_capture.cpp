@@ -0,0 +1,129 @@
+#include <BlackboxBurstCapture.h>
+#include <cstring>
+#include <unity.h>
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,cppcoreguidelines-init-variables,readability-magic-numbers)
+static constexpr float degreesToRadians {static_cast<float>(M_PI) / 180.0F};
+
+void test_blackbox_burst_capture_throttle_punch()
+{
+    static BlackboxBurstCapture burstCapture(8000, 4);
+    TEST_ASSERT_EQUAL(3, burstCapture.getSampleWordCount());
+    const size_t capacity = burstCapture.getCapacity();
+    TEST_ASSERT_EQUAL(BlackboxBurstCapture::WORD_COUNT / 3, capacity);
+
+    const xyz_t acc {};
+    const BlackboxBurstCapture::motor_frequencies_t motorFrequencies {};
+    // fill the buffer several times over at hover throttle, sample number is encoded in gyro x
+    size_t sample = 0;
+    for (; sample < 3 * capacity; ++sample) {
+        const xyz_t gyro { .x = static_cast<float>(sample % 1000) * degreesToRadians / 10.0F, .y = 0.0F, .z = 0.0F };
+        burstCapture.capture(gyro, acc, motorFrequencies, 0.3F);
+    }
+    TEST_ASSERT_EQUAL(BlackboxBurstCapture::STATE_CAPTURING, burstCapture.getState());
+
+    // a slow throttle rise does not trigger
+    float throttle = 0.3F;
+    for (size_t ii = 0; ii < 8000; ++ii, ++sample) {
+        throttle += 0.2F / 8000.0F;
+        const xyz_t gyro { .x = static_cast<float>(sample % 1000) * degreesToRadians / 10.0F, .y = 0.0F, .z = 0.0F };
+        burstCapture.capture(gyro, acc, motorFrequencies, throttle);
+    }
+    TEST_ASSERT_EQUAL(BlackboxBurstCapture::STATE_CAPTURING, burstCapture.getState());
+
+    // a punch triggers
+    const size_t triggerSample = sample;
+    const size_t postTriggerCount = capacity * 75 / 100;
+    for (size_t ii = 0; ii < postTriggerCount + 10; ++ii, ++sample) {
+        const xyz_t gyro { .x = static_cast<float>(sample % 1000) * degreesToRadians / 10.0F, .y = 0.0F, .z = 0.0F };
+        burstCapture.capture(gyro, acc, motorFrequencies, 1.0F);
+        if (ii == 0) {
+            TEST_ASSERT_EQUAL(BlackboxBurstCapture::STATE_TRIGGERED, burstCapture.getState());
+        }
+    }
+    TEST_ASSERT_TRUE(burstCapture.isComplete());
+    TEST_ASSERT_EQUAL(capacity, burstCapture.getSampleCount());
+    TEST_ASSERT_EQUAL(capacity - postTriggerCount, burstCapture.getTriggerIndex());
+    // samples after completion are discarded, so the window ends postTriggerCount samples after the trigger
+    TEST_ASSERT_EQUAL(static_cast<int16_t>(triggerSample % 1000), burstCapture.getSample(burstCapture.getTriggerIndex())[0]);
+    TEST_ASSERT_EQUAL(static_cast<int16_t>((triggerSample + postTriggerCount - 1) % 1000), burstCapture.getSample(capacity - 1)[0]);
+
+    TEST_ASSERT_TRUE(burstCapture.beginWrite());
+    TEST_ASSERT_FALSE(burstCapture.beginWrite());
+    TEST_ASSERT_EQUAL(BlackboxBurstCapture::STATE_WRITING, burstCapture.getState());
+
+    burstCapture.restart();
+    TEST_ASSERT_EQUAL(BlackboxBurstCapture::STATE_CAPTURING, burstCapture.getState());
+    TEST_ASSERT_EQUAL(0, burstCapture.getSampleCount());
+}
+
+void test_blackbox_burst_capture_manual_trigger_csv()
+{
+    static constexpr BlackboxBurstCapture::config_t config {
+        .preTriggerPercent = 50,
+        .captureAcc = true,
+        .captureMotorFrequencies = true,
+        .throttlePunchTriggerEnabled = false,
+        .throttlePunchThreshold = 0.4F,
+        .throttlePunchSeconds = 0.2F
+    };
+    static BlackboxBurstCapture burstCapture(4000, 4, config);
+    TEST_ASSERT_EQUAL(10, burstCapture.getSampleWordCount());
+    const size_t capacity = burstCapture.getCapacity();
+
+    const xyz_t gyro { .x = 100.0F * degreesToRadians, .y = -20.0F * degreesToRadians, .z = 0.5F * degreesToRadians };
+    const xyz_t acc { .x = 0.0F, .y = 0.5F, .z = 1.0F };
+    const BlackboxBurstCapture::motor_frequencies_t motorFrequencies { 100.0F, 200.5F, 300.0F, 400.0F };
+
+    // punch does not trigger, since throttle punch trigger disabled
+    for (size_t ii = 0; ii < 10; ++ii) {
+        burstCapture.capture(gyro, acc, motorFrequencies, ii < 5 ? 0.0F : 1.0F);
+    }
+    TEST_ASSERT_EQUAL(BlackboxBurstCapture::STATE_CAPTURING, burstCapture.getState());
+
+    burstCapture.trigger();
+    for (size_t ii = 0; ii < capacity; ++ii) {
+        burstCapture.capture(gyro, acc, motorFrequencies, 0.0F);
+    }
+    TEST_ASSERT_TRUE(burstCapture.isComplete());
+    // buffer not filled before trigger, so the window is shorter than the capacity
+    const size_t postTriggerCount = capacity / 2;
+    TEST_ASSERT_EQUAL(10 + postTriggerCount, burstCapture.getSampleCount());
+    TEST_ASSERT_EQUAL(10, burstCapture.getTriggerIndex());
+    TEST_ASSERT_EQUAL(BlackboxBurstCapture::CSV_HEADER_LINE_COUNT + 10 + postTriggerCount, burstCapture.getCSV_LineCount());
+
+    std::array<char, BlackboxBurstCapture::CSV_MAX_LINE_LENGTH> line {};
+    size_t length = burstCapture.formatCSV_Line(&line[0], line.size(), 0);
+    TEST_ASSERT_EQUAL(strlen(&line[0]), length);
+    TEST_ASSERT_NOT_NULL(strstr(&line[0], "sample_rate_hz=4000, trigger_index=10,"));
+
+    length = burstCapture.formatCSV_Line(&line[0], line.size(), 1);
+    TEST_ASSERT_EQUAL_STRING("sample,gyroX,gyroY,gyroZ,accX,accY,accZ,motorHz0,motorHz1,motorHz2,motorHz3\n", &line[0]);
+    TEST_ASSERT_EQUAL(strlen(&line[0]), length);
+
+    length = burstCapture.formatCSV_Line(&line[0], line.size(), 2 + 3);
+    TEST_ASSERT_EQUAL_STRING("3,1000,-200,5,0,2048,4096,1000,2005,3000,4000\n", &line[0]);
+    TEST_ASSERT_EQUAL(strlen(&line[0]), length);
+
+    // line beyond the end of the capture is empty
+    TEST_ASSERT_EQUAL(0, burstCapture.formatCSV_Line(&line[0], line.size(), burstCapture.getCSV_LineCount()));
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,cppcoreguidelines-init-variables,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_blackbox_burst_capture_throttle_punch);
+    RUN_TEST(test_blackbox_burst_capture_manual_trigger_csv);
+
+    UNITY_END();
+}
@@ -0,0 +1,436 @@
+#include <BlackboxDecoder.h>
+#include <BlackboxExporterCSV.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unity.h>
+#include <vector>
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,cppcoreguidelines-init-variables,readability-magic-numbers,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+class LogWriter {
+public:
+    void text(const char* s) { while (*s) { data.push_back(static_cast<uint8_t>(*s++)); } }
+    void byte(uint8_t value) { data.push_back(value); }
+    void uvb(uint32_t value) {
+        while (value > 127) {
+            data.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        data.push_back(static_cast<uint8_t>(value));
+    }
+    void svb(int32_t value) { uvb((static_cast<uint32_t>(value) << 1U) ^ static_cast<uint32_t>(value >> 31)); }
+public:
+    std::vector<uint8_t> data;
+};
+
+class RecordingSink : public BlackboxDecoderSink {
+public:
+    virtual void mainFrame(const int64_t* values, size_t valueCount, bool isIntraFrame) override {
+        mainFrames.emplace_back(values, values + valueCount);
+        intraFlags.push_back(isIntraFrame);
+    }
+    virtual void slowFrame(const int64_t* values, size_t valueCount) override { slowFrames.emplace_back(values, values + valueCount); }
+    virtual void event(const BlackboxDecoder::event_t& event) override { events.push_back(event); }
+public:
+    std::vector<std::vector<int64_t>> mainFrames;
+    std::vector<bool> intraFlags;
+    std::vector<std::vector<int64_t>> slowFrames;
+    std::vector<BlackboxDecoder::event_t> events;
+};
+
+static void writeHeader(LogWriter& log)
+{
+    log.text("H Product:Blackbox flight data recorder by Nicholas Sherlock\n");
+    log.text("H Data version:2\n");
+    log.text("H I interval:32\n");
+    log.text("H P interval:2\n");
+    log.text("H Field I name:loopIteration,time,axisP[0],axisP[1],axisP[2],motor[0],motor[1],vbatLatest\n");
+    log.text("H Field I signed:0,0,1,1,1,0,0,0\n");
+    log.text("H Field I predictor:0,0,0,0,0,11,5,9\n");
+    log.text("H Field I encoding:1,1,0,0,0,1,0,3\n");
+    log.text("H Field P predictor:6,2,1,1,1,3,3,3\n");
+    log.text("H Field P encoding:9,0,7,7,7,6,6,6\n");
+    log.text("H Field S name:flightModeFlags,failsafePhase\n");
+    log.text("H Field S signed:0,0\n");
+    log.text("H Field S predictor:0,0\n");
+    log.text("H Field S encoding:1,1\n");
+    log.text("H Firmware type:ProtoFlight\n");
+    log.text("H vbatref:1650\n");
+    log.text("H motorOutput:158,2047\n");
+    log.text("H pid_scale:10\n");
+}
+
+static void writeLogEnd(LogWriter& log)
+{
+    log.byte('E');
+    log.byte(BlackboxDecoder::EVENT_LOG_END);
+    log.text("End of log");
+    log.byte(0);
+}
+
+void test_blackbox_decoder_encodings()
+{
+    std::array<int32_t, 8> values {};
+
+    const std::array<uint8_t, 3> vb { 0xAC, 0x02, 0x01 };
+    BlackboxDecoderStream stream(&vb[0], &vb[0] + vb.size());
+    TEST_ASSERT_EQUAL(300, stream.readUnsignedVB());
+    TEST_ASSERT_EQUAL(-1, stream.readSignedVB());
+    TEST_ASSERT_TRUE(stream.atEnd());
+    TEST_ASSERT_FALSE(stream.eof());
+    stream.readByte();
+    TEST_ASSERT_TRUE(stream.eof());
+
+    // 2, 4, 6 bit, and byte selector forms
+    const std::array<uint8_t, 13> tag2_3S32 { 0x1E, 0x47, 0x83, 0x9F, 0x20, 0x3F, 0xE4, 0x64, 0x18, 0xFC, 0xA0, 0x86, 0x01 };
+    stream = BlackboxDecoderStream(&tag2_3S32[0], &tag2_3S32[0] + tag2_3S32.size());
+    stream.readTag2_3S32(&values[0]);
+    TEST_ASSERT_EQUAL(1, values[0]);
+    TEST_ASSERT_EQUAL(-1, values[1]);
+    TEST_ASSERT_EQUAL(-2, values[2]);
+    stream.readTag2_3S32(&values[0]);
+    TEST_ASSERT_EQUAL(7, values[0]);
+    TEST_ASSERT_EQUAL(-8, values[1]);
+    TEST_ASSERT_EQUAL(3, values[2]);
+    stream.readTag2_3S32(&values[0]);
+    TEST_ASSERT_EQUAL(31, values[0]);
+    TEST_ASSERT_EQUAL(-32, values[1]);
+    TEST_ASSERT_EQUAL(-1, values[2]);
+    stream.readTag2_3S32(&values[0]);
+    TEST_ASSERT_EQUAL(100, values[0]);
+    TEST_ASSERT_EQUAL(-1000, values[1]);
+    TEST_ASSERT_EQUAL(100000, values[2]);
+    TEST_ASSERT_TRUE(stream.atEnd());
+
+    // 5,5,4 bit and 8,7,7 bit forms
+    const std::array<uint8_t, 5> tag2_3SVariable { 0x5F, 0x07, 0xA0, 0x1F, 0xC0 };
+    stream = BlackboxDecoderStream(&tag2_3SVariable[0], &tag2_3SVariable[0] + tag2_3SVariable.size());
+    stream.readTag2_3SVariable(&values[0]);
+    TEST_ASSERT_EQUAL(15, values[0]);
+    TEST_ASSERT_EQUAL(-16, values[1]);
+    TEST_ASSERT_EQUAL(7, values[2]);
+    stream.readTag2_3SVariable(&values[0]);
+    TEST_ASSERT_EQUAL(-128, values[0]);
+    TEST_ASSERT_EQUAL(63, values[1]);
+    TEST_ASSERT_EQUAL(-64, values[2]);
+    TEST_ASSERT_TRUE(stream.atEnd());
+
+    // zero, 4 bit, 8 bit, and 16 bit values, with the 8 and 16 bit values starting half way through a byte
+    const std::array<uint8_t, 5> tag8_4S16 { 0xE4, 0x59, 0xC0, 0x3E, 0x80 };
+    stream = BlackboxDecoderStream(&tag8_4S16[0], &tag8_4S16[0] + tag8_4S16.size());
+    stream.readTag8_4S16(&values[0]);
+    TEST_ASSERT_EQUAL(0, values[0]);
+    TEST_ASSERT_EQUAL(5, values[1]);
+    TEST_ASSERT_EQUAL(-100, values[2]);
+    TEST_ASSERT_EQUAL(1000, values[3]);
+    TEST_ASSERT_TRUE(stream.atEnd());
+
+    const std::array<uint8_t, 4> tag8_8SVB { 0x0A, 0x06, 0x03, 0x05 };
+    stream = BlackboxDecoderStream(&tag8_8SVB[0], &tag8_8SVB[0] + tag8_8SVB.size());
+    stream.readTag8_8SVB(&values[0], 4);
+    TEST_ASSERT_EQUAL(0, values[0]);
+    TEST_ASSERT_EQUAL(3, values[1]);
+    TEST_ASSERT_EQUAL(0, values[2]);
+    TEST_ASSERT_EQUAL(-2, values[3]);
+    // a single value has no header byte
+    stream.readTag8_8SVB(&values[0], 1);
+    TEST_ASSERT_EQUAL(-3, values[0]);
+    TEST_ASSERT_TRUE(stream.atEnd());
+}
+
+void test_blackbox_decoder_log()
+{
+    LogWriter log;
+    writeHeader(log);
+
+    // I frame: iteration 0, time 1000, axisP {10,-20,30}, motors {1200,1250}, vbat 1600
+    log.byte('I');
+    log.uvb(0);
+    log.uvb(1000);
+    log.svb(10);
+    log.svb(-20);
+    log.svb(30);
+    log.uvb(1200 - 158);
+    log.svb(50);
+    log.uvb(1650 - 1600);
+
+    log.byte('S');
+    log.uvb(1);
+    log.uvb(0);
+
+    // P frame: iteration 2 (one frame skipped, since P interval is 2), time 1250
+    log.byte('P');
+    log.svb(250);
+    log.byte(0x1E); // axisP deltas {1,-1,-2}
+    log.byte(0x05); // motor[0] and vbat differ from prediction
+    log.svb(10);
+    log.svb(-5);
+
+    log.byte('E');
+    log.byte(BlackboxDecoder::EVENT_INFLIGHT_ADJUSTMENT);
+    log.byte(127);
+    log.svb(3);
+
+    // P frame: iteration 4, time 1500, motor[0] and vbat predicted by average of previous two frames
+    log.byte('P');
+    log.svb(0);
+    log.byte(0x00);
+    log.byte(0x05);
+    log.svb(10);
+    log.svb(-2);
+
+    writeLogEnd(log);
+    // data after the end of the log is ignored
+    log.byte(0xFF);
+
+    const std::vector<size_t> logs = BlackboxDecoder::findLogs(&log.data[0], log.data.size());
+    TEST_ASSERT_EQUAL(1, logs.size());
+    TEST_ASSERT_EQUAL(0, logs[0]);
+
+    BlackboxDecoder decoder;
+    TEST_ASSERT_TRUE(decoder.parseHeader(&log.data[0], &log.data[0] + log.data.size()));
+    TEST_ASSERT_TRUE(decoder.getHeaderValue("Firmware type") == "ProtoFlight");
+    TEST_ASSERT_EQUAL(1650, decoder.getSysConfig().vbatref);
+    TEST_ASSERT_EQUAL(158, decoder.getSysConfig().minmotor);
+    TEST_ASSERT_EQUAL(2047, decoder.getSysConfig().maxmotor);
+    TEST_ASSERT_EQUAL(10, decoder.getSysConfig().pidScale);
+    TEST_ASSERT_EQUAL(2, decoder.getSysConfig().PIntervalDenom);
+    TEST_ASSERT_EQUAL(8, decoder.getFrameDef(BlackboxDecoder::DEF_INTER).fieldCount());
+    TEST_ASSERT_EQUAL(5, decoder.getMainFieldIndex("motor[0]"));
+
+    RecordingSink sink;
+    const BlackboxDecoder::stats_t stats = decoder.decode(sink);
+    TEST_ASSERT_EQUAL(1, stats.intraFrameCount);
+    TEST_ASSERT_EQUAL(2, stats.interFrameCount);
+    TEST_ASSERT_EQUAL(1, stats.slowFrameCount);
+    TEST_ASSERT_EQUAL(2, stats.eventCount);
+    TEST_ASSERT_EQUAL(0, stats.corruptFrameCount);
+    TEST_ASSERT_TRUE(stats.logEndFound);
+    TEST_ASSERT_EQUAL(0, stats.decimationChangeCount); // the adjustment event records a queue overflow, not a rate change
+    TEST_ASSERT_EQUAL(1, stats.maxDecimation);
+
+    TEST_ASSERT_EQUAL(3, sink.mainFrames.size());
+    const std::vector<int64_t> expected0 { 0, 1000, 10, -20, 30, 1200, 1250, 1600 };
+    const std::vector<int64_t> expected1 { 2, 1250, 11, -21, 28, 1210, 1250, 1595 };
+    const std::vector<int64_t> expected2 { 4, 1500, 11, -21, 28, 1215, 1250, 1595 };
+    for (size_t ii = 0; ii < expected0.size(); ++ii) {
+        TEST_ASSERT_EQUAL(expected0[ii], sink.mainFrames[0][ii]);
+        TEST_ASSERT_EQUAL(expected1[ii], sink.mainFrames[1][ii]);
+        TEST_ASSERT_EQUAL(expected2[ii], sink.mainFrames[2][ii]);
+    }
+    TEST_ASSERT_TRUE(sink.intraFlags[0]);
+    TEST_ASSERT_FALSE(sink.intraFlags[1]);
+
+    TEST_ASSERT_EQUAL(1, sink.slowFrames.size());
+    TEST_ASSERT_EQUAL(1, sink.slowFrames[0][0]);
+
+    TEST_ASSERT_EQUAL(BlackboxDecoder::EVENT_INFLIGHT_ADJUSTMENT, sink.events[0].type);
+    TEST_ASSERT_EQUAL(127, sink.events[0].data0);
+    TEST_ASSERT_EQUAL(3, sink.events[0].value);
+    // with no preceding total, the total is accumulated from the dropped counts
+    TEST_ASSERT_EQUAL(3, sink.events[0].data1);
+    TEST_ASSERT_EQUAL(3, stats.droppedSampleCount);
+    TEST_ASSERT_EQUAL(BlackboxDecoder::EVENT_LOG_END, sink.events[1].type);
+}
+
+void test_blackbox_decoder_timed_events()
+{
+    LogWriter log;
+    writeHeader(log);
+
+    log.byte('I');
+    log.uvb(0);
+    log.uvb(1000);
+    log.svb(0);
+    log.svb(0);
+    log.svb(0);
+    log.uvb(0);
+    log.svb(0);
+    log.uvb(0);
+
+    // timed event: failsafe phase 1 at time 1234567, written as an event time adjustment followed by the event
+    log.byte('E');
+    log.byte(BlackboxDecoder::EVENT_INFLIGHT_ADJUSTMENT);
+    log.byte(BlackboxDecoder::ADJUSTMENT_BLACKBOX_EVENT_TIME);
+    log.svb(1234567);
+    log.byte('E');
+    log.byte(BlackboxDecoder::EVENT_INFLIGHT_ADJUSTMENT);
+    log.byte(BlackboxDecoder::ADJUSTMENT_BLACKBOX_EVENT_BASE + 3);
+    log.svb(1);
+
+    // the log rate is reduced to one sample in every 2
+    log.byte('E');
+    log.byte(BlackboxDecoder::EVENT_INFLIGHT_ADJUSTMENT);
+    log.byte(BlackboxDecoder::ADJUSTMENT_BLACKBOX_DECIMATION);
+    log.svb(2);
+
+    // queue overflow: 5 samples dropped, 40 dropped in total, written as the total followed by the overflow event
+    log.byte('E');
+    log.byte(BlackboxDecoder::EVENT_INFLIGHT_ADJUSTMENT);
+    log.byte(BlackboxDecoder::ADJUSTMENT_BLACKBOX_QUEUE_OVERFLOW_TOTAL);
+    log.svb(40);
+    log.byte('E');
+    log.byte(BlackboxDecoder::EVENT_INFLIGHT_ADJUSTMENT);
+    log.byte(BlackboxDecoder::ADJUSTMENT_BLACKBOX_QUEUE_OVERFLOW);
+    log.svb(5);
+
+    writeLogEnd(log);
+
+    BlackboxDecoder decoder;
+    TEST_ASSERT_TRUE(decoder.parseHeader(&log.data[0], &log.data[0] + log.data.size()));
+    RecordingSink sink;
+    const BlackboxDecoder::stats_t stats = decoder.decode(sink);
+    TEST_ASSERT_EQUAL(0, stats.corruptFrameCount);
+    TEST_ASSERT_EQUAL(4, stats.eventCount);
+    TEST_ASSERT_EQUAL(1, stats.timedEventCount);
+    TEST_ASSERT_EQUAL(1, stats.decimationChangeCount);
+    TEST_ASSERT_EQUAL(2, stats.maxDecimation);
+    TEST_ASSERT_EQUAL(40, stats.droppedSampleCount);
+
+    // the event time adjustment is merged into the event that follows it
+    TEST_ASSERT_EQUAL(4, sink.events.size());
+    TEST_ASSERT_EQUAL(BlackboxDecoder::ADJUSTMENT_BLACKBOX_EVENT_BASE + 3, sink.events[0].data0);
+    TEST_ASSERT_EQUAL(1234567, sink.events[0].data1);
+    TEST_ASSERT_EQUAL(1, sink.events[0].value);
+    TEST_ASSERT_EQUAL(BlackboxDecoder::ADJUSTMENT_BLACKBOX_DECIMATION, sink.events[1].data0);
+    TEST_ASSERT_EQUAL(0, sink.events[1].data1);
+    // the total is merged into the queue overflow event
+    TEST_ASSERT_EQUAL(BlackboxDecoder::ADJUSTMENT_BLACKBOX_QUEUE_OVERFLOW, sink.events[2].data0);
+    TEST_ASSERT_EQUAL(5, sink.events[2].value);
+    TEST_ASSERT_EQUAL(40, sink.events[2].data1);
+    TEST_ASSERT_EQUAL(BlackboxDecoder::EVENT_LOG_END, sink.events[3].type);
+}
+
+void test_blackbox_decoder_corrupt()
+{
+    LogWriter log;
+    writeHeader(log);
+
+    // I frame: iteration 0, time 1000, all other values zero, except vbat of 1650
+    log.byte('I');
+    log.uvb(0);
+    log.uvb(1000);
+    log.svb(0);
+    log.svb(0);
+    log.svb(0);
+    log.uvb(0);
+    log.svb(0);
+    log.uvb(0);
+
+    // P frame followed by junk, so is corrupt
+    log.byte('P');
+    log.svb(250);
+    log.byte(0x00);
+    log.byte(0x00);
+    log.byte(0x00);
+    log.byte(0x00);
+
+    // valid P frame, but discarded since there is no valid I frame to base it on
+    log.byte('P');
+    log.svb(250);
+    log.byte(0x00);
+    log.byte(0x00);
+
+    // I frame: iteration 8, time 2000
+    log.byte('I');
+    log.uvb(8);
+    log.uvb(2000);
+    log.svb(0);
+    log.svb(0);
+    log.svb(0);
+    log.uvb(1300 - 158);
+    log.svb(0);
+    log.uvb(0);
+
+    // P frame: iteration 10, time 2250
+    log.byte('P');
+    log.svb(250);
+    log.byte(0x00);
+    log.byte(0x00);
+
+    // truncated P frame
+    log.byte('P');
+    log.svb(250);
+
+    BlackboxDecoder decoder;
+    TEST_ASSERT_TRUE(decoder.parseHeader(&log.data[0], &log.data[0] + log.data.size()));
+    RecordingSink sink;
+    const BlackboxDecoder::stats_t stats = decoder.decode(sink);
+    TEST_ASSERT_EQUAL(2, stats.intraFrameCount);
+    TEST_ASSERT_EQUAL(1, stats.interFrameCount);
+    TEST_ASSERT_EQUAL(2, stats.corruptFrameCount);
+    TEST_ASSERT_EQUAL(1, stats.skippedInterFrameCount);
+    TEST_ASSERT_FALSE(stats.logEndFound);
+
+    TEST_ASSERT_EQUAL(3, sink.mainFrames.size());
+    TEST_ASSERT_EQUAL(0, sink.mainFrames[0][0]);
+    TEST_ASSERT_EQUAL(1650, sink.mainFrames[0][7]);
+    TEST_ASSERT_EQUAL(8, sink.mainFrames[1][0]);
+    TEST_ASSERT_EQUAL(10, sink.mainFrames[2][0]);
+    TEST_ASSERT_EQUAL(2250, sink.mainFrames[2][1]);
+    TEST_ASSERT_EQUAL(1300, sink.mainFrames[2][5]);
+    TEST_ASSERT_EQUAL(1300, sink.mainFrames[2][6]);
+}
+
+void test_blackbox_decoder_csv()
+{
+    LogWriter log;
+    writeHeader(log);
+    log.byte('I');
+    log.uvb(0);
+    log.uvb(1000);
+    log.svb(-1);
+    log.svb(0);
+    log.svb(1);
+    log.uvb(0);
+    log.svb(0);
+    log.uvb(0);
+    log.byte('S');
+    log.uvb(4);
+    log.uvb(1);
+    log.byte('P');
+    log.svb(0);
+    log.byte(0x00);
+    log.byte(0x00);
+    writeLogEnd(log);
+
+    BlackboxDecoder decoder;
+    TEST_ASSERT_TRUE(decoder.parseHeader(&log.data[0], &log.data[0] + log.data.size()));
+    std::FILE* file = std::tmpfile();
+    TEST_ASSERT_NOT_NULL(file);
+    BlackboxExporterCSV exporter(file);
+    decoder.decode(exporter);
+
+    std::rewind(file);
+    std::array<char, 256> line {};
+    TEST_ASSERT_NOT_NULL(std::fgets(&line[0], line.size(), file));
+    TEST_ASSERT_EQUAL(0, std::strcmp("loopIteration,time,axisP[0],axisP[1],axisP[2],motor[0],motor[1],vbatLatest,flightModeFlags,failsafePhase\n", &line[0]));
+    TEST_ASSERT_NOT_NULL(std::fgets(&line[0], line.size(), file));
+    TEST_ASSERT_EQUAL(0, std::strcmp("0,1000,-1,0,1,158,158,1650,,\n", &line[0]));
+    TEST_ASSERT_NOT_NULL(std::fgets(&line[0], line.size(), file));
+    TEST_ASSERT_EQUAL(0, std::strcmp("2,1000,-1,0,1,158,158,1650,4,1\n", &line[0]));
+    TEST_ASSERT_NULL(std::fgets(&line[0], line.size(), file));
+    std::fclose(file);
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,cppcoreguidelines-init-variables,readability-magic-numbers,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_blackbox_decoder_encodings);
+    RUN_TEST(test_blackbox_decoder_log);
+    RUN_TEST(test_blackbox_decoder_timed_events);
+    RUN_TEST(test_blackbox_decoder_corrupt);
+    RUN_TEST(test_blackbox_decoder_csv);
+
+    UNITY_END();
+}
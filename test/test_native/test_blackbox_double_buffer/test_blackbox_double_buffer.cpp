@@ -0,0 +1,117 @@
+#include <BlackboxDoubleBuffer.h>
+#include <array>
+#include <unity.h>
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,cppcoreguidelines-init-variables,readability-magic-numbers)
+void test_blackbox_double_buffer()
+{
+    static BlackboxDoubleBuffer<1024> doubleBuffer;
+    TEST_ASSERT_TRUE(doubleBuffer.isEmpty());
+    TEST_ASSERT_EQUAL(2048, doubleBuffer.getFreeSpace());
+
+    size_t length {};
+    TEST_ASSERT_NULL(doubleBuffer.acquireFullBuffer(length));
+    TEST_ASSERT_EQUAL(0, length);
+
+    std::array<uint8_t, 100> data {};
+    for (size_t ii = 0; ii < data.size(); ++ii) {
+        data[ii] = static_cast<uint8_t>(ii);
+    }
+    // partially filled buffers are not handed to the writer
+    TEST_ASSERT_EQUAL(100, doubleBuffer.write(&data[0], data.size()));
+    TEST_ASSERT_NULL(doubleBuffer.acquireFullBuffer(length));
+    TEST_ASSERT_FALSE(doubleBuffer.isEmpty());
+
+    // fill the first buffer, it is handed to the writer and encoding continues into the second buffer
+    for (size_t ii = 0; ii < 10; ++ii) {
+        TEST_ASSERT_EQUAL(100, doubleBuffer.write(&data[0], data.size()));
+    }
+    TEST_ASSERT_EQUAL(2048 - 1100, doubleBuffer.getFreeSpace()); // writer has not yet released the first buffer
+    const uint8_t* buffer = doubleBuffer.acquireFullBuffer(length);
+    TEST_ASSERT_NOT_NULL(buffer);
+    TEST_ASSERT_EQUAL(1024, length);
+    TEST_ASSERT_EQUAL(0, buffer[0]);
+    TEST_ASSERT_EQUAL(99, buffer[99]);
+    TEST_ASSERT_EQUAL(0, buffer[100]);
+    TEST_ASSERT_EQUAL(23, buffer[1023]);
+    TEST_ASSERT_EQUAL(1100, doubleBuffer.getStats().highWaterMark);
+    TEST_ASSERT_EQUAL(54, doubleBuffer.getFillPercent());
+
+    doubleBuffer.releaseBuffer(300);
+    TEST_ASSERT_NULL(doubleBuffer.acquireFullBuffer(length));
+    TEST_ASSERT_EQUAL(2048 - 76, doubleBuffer.getFreeSpace());
+
+    // at the end of the log the partially filled buffer is handed to the writer
+    TEST_ASSERT_TRUE(doubleBuffer.commitPartialBuffer());
+    buffer = doubleBuffer.acquireFullBuffer(length);
+    TEST_ASSERT_NOT_NULL(buffer);
+    TEST_ASSERT_EQUAL(76, length);
+    TEST_ASSERT_EQUAL(24, buffer[0]);
+    doubleBuffer.releaseBuffer(50);
+    TEST_ASSERT_TRUE(doubleBuffer.isEmpty());
+
+    const BlackboxDoubleBuffer<1024>::stats_t& stats = doubleBuffer.getStats();
+    TEST_ASSERT_EQUAL(2, stats.bufferWriteCount);
+    TEST_ASSERT_EQUAL(300, stats.maxLatencyMicroSeconds);
+    TEST_ASSERT_EQUAL(50, stats.lastLatencyMicroSeconds);
+    TEST_ASSERT_EQUAL(1, stats.latencyHistogram[0]); // [0, 128us)
+    TEST_ASSERT_EQUAL(1, stats.latencyHistogram[2]); // [256us, 512us)
+    TEST_ASSERT_EQUAL(0, stats.droppedByteCount);
+}
+
+void test_blackbox_double_buffer_overflow()
+{
+    static BlackboxDoubleBuffer<512> doubleBuffer;
+    std::array<uint8_t, 256> data {};
+
+    // the writer is stalled, so both buffers fill and then data is dropped
+    for (size_t ii = 0; ii < 4; ++ii) {
+        TEST_ASSERT_EQUAL(256, doubleBuffer.write(&data[0], data.size()));
+    }
+    TEST_ASSERT_EQUAL(0, doubleBuffer.getFreeSpace());
+    TEST_ASSERT_EQUAL(0, doubleBuffer.write(&data[0], data.size()));
+    TEST_ASSERT_EQUAL(0, doubleBuffer.write(data[0]));
+    TEST_ASSERT_EQUAL(257, doubleBuffer.getStats().droppedByteCount);
+    TEST_ASSERT_EQUAL(1024, doubleBuffer.getStats().highWaterMark);
+    TEST_ASSERT_FALSE(doubleBuffer.commitPartialBuffer());
+
+    // a very slow write goes in the last histogram bucket
+    size_t length {};
+    TEST_ASSERT_NOT_NULL(doubleBuffer.acquireFullBuffer(length));
+    doubleBuffer.releaseBuffer(1000000);
+    TEST_ASSERT_EQUAL(1, doubleBuffer.getStats().latencyHistogram[BlackboxDoubleBuffer<512>::LATENCY_HISTOGRAM_BUCKET_COUNT - 1]);
+
+    // once the writer catches up, writes are accepted again
+    TEST_ASSERT_EQUAL(256, doubleBuffer.write(&data[0], data.size()));
+    TEST_ASSERT_NOT_NULL(doubleBuffer.acquireFullBuffer(length));
+    TEST_ASSERT_EQUAL(512, length);
+    doubleBuffer.releaseBuffer(100);
+    TEST_ASSERT_NULL(doubleBuffer.acquireFullBuffer(length));
+    TEST_ASSERT_TRUE(doubleBuffer.commitPartialBuffer());
+    TEST_ASSERT_NOT_NULL(doubleBuffer.acquireFullBuffer(length));
+    TEST_ASSERT_EQUAL(256, length);
+
+    // bytes the device did not accept are counted as dropped
+    doubleBuffer.releaseBuffer(100, 56);
+    TEST_ASSERT_EQUAL(257 + 56, doubleBuffer.getStats().droppedByteCount);
+    TEST_ASSERT_EQUAL(3, doubleBuffer.getStats().bufferWriteCount);
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,cppcoreguidelines-init-variables,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_blackbox_double_buffer);
+    RUN_TEST(test_blackbox_double_buffer_overflow);
+
+    UNITY_END();
+}
@@ -0,0 +1,68 @@
+#include <BlackboxEventQueue.h>
+#include <unity.h>
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,cppcoreguidelines-init-variables,readability-magic-numbers)
+void test_blackbox_event_queue()
+{
+    static BlackboxEventQueue eventQueue;
+    BlackboxEventQueue::event_t event {};
+    TEST_ASSERT_FALSE(eventQueue.pop(event));
+
+    TEST_ASSERT_TRUE(eventQueue.post(BlackboxEventQueue::EVENT_LOOP_OVERRUN, 2500, 1000));
+    TEST_ASSERT_TRUE(eventQueue.post(BlackboxEventQueue::EVENT_FAILSAFE, 1, 2000));
+    TEST_ASSERT_TRUE(eventQueue.pop(event));
+    TEST_ASSERT_EQUAL(BlackboxEventQueue::EVENT_LOOP_OVERRUN, event.type);
+    TEST_ASSERT_EQUAL(2500, event.value);
+    TEST_ASSERT_EQUAL(1000, event.timeMicroSeconds);
+    TEST_ASSERT_TRUE(eventQueue.pop(event));
+    TEST_ASSERT_EQUAL(BlackboxEventQueue::EVENT_FAILSAFE, event.type);
+    TEST_ASSERT_EQUAL(1, event.value);
+    TEST_ASSERT_EQUAL(2000, event.timeMicroSeconds);
+    TEST_ASSERT_FALSE(eventQueue.pop(event));
+
+    // fill the queue, which has wrapped, further events are dropped and counted
+    for (uint32_t ii = 0; ii < BlackboxEventQueue::QUEUE_LENGTH; ++ii) {
+        TEST_ASSERT_TRUE(eventQueue.post(BlackboxEventQueue::EVENT_CONTROL_MODE, static_cast<int32_t>(ii), ii));
+    }
+    TEST_ASSERT_FALSE(eventQueue.post(BlackboxEventQueue::EVENT_CONTROL_MODE, -1, 0));
+    TEST_ASSERT_EQUAL(1, eventQueue.getOverflowCount());
+
+    // events are read in the order they were posted, and reading frees slots for further events
+    TEST_ASSERT_TRUE(eventQueue.pop(event));
+    TEST_ASSERT_EQUAL(0, event.value);
+    TEST_ASSERT_TRUE(eventQueue.post(BlackboxEventQueue::EVENT_RATES_CHANGE, 3, 5000));
+    for (uint32_t ii = 1; ii < BlackboxEventQueue::QUEUE_LENGTH; ++ii) {
+        TEST_ASSERT_TRUE(eventQueue.pop(event));
+        TEST_ASSERT_EQUAL(ii, event.value);
+    }
+    TEST_ASSERT_TRUE(eventQueue.pop(event));
+    TEST_ASSERT_EQUAL(BlackboxEventQueue::EVENT_RATES_CHANGE, event.type);
+    TEST_ASSERT_FALSE(eventQueue.pop(event));
+}
+
+void test_blackbox_event_queue_pid_change()
+{
+    const int32_t value = BlackboxEventQueue::pidChangeValue(2, BlackboxEventQueue::PID_TERM_D, 45);
+    TEST_ASSERT_EQUAL(2, static_cast<uint32_t>(value) >> 24U);
+    TEST_ASSERT_EQUAL(BlackboxEventQueue::PID_TERM_D, (static_cast<uint32_t>(value) >> 16U) & 0xFFU);
+    TEST_ASSERT_EQUAL(45, static_cast<uint32_t>(value) & 0xFFFFU);
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,cppcoreguidelines-init-variables,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_blackbox_event_queue);
+    RUN_TEST(test_blackbox_event_queue_pid_change);
+
+    UNITY_END();
+}
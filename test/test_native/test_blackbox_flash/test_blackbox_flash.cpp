@@ -0,0 +1,228 @@
+#include <BlackboxFlashLog.h>
+#include <FlashEmulatorFile.h>
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <unity.h>
+
+static const char* const flashFileName = "test_blackbox_flash.bin";
+// small flash, so tests cover sector boundaries and running out of space: 16 sectors of 1kB, 64 byte pages
+static constexpr FlashBase::geometry_t geometry { .pageSize = 64, .sectorSize = 1024, .sectorCount = 16 };
+
+void setUp()
+{
+    std::remove(flashFileName);
+}
+
+void tearDown()
+{
+    std::remove(flashFileName);
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,cppcoreguidelines-init-variables,readability-magic-numbers)
+static uint8_t testByte(uint32_t logNumber, size_t index)
+{
+    // avoid 0xFF, since trailing 0xFF bytes cannot be recovered after power loss
+    return static_cast<uint8_t>((index * 7 + logNumber) % 251);
+}
+
+static void writeLog(BlackboxFlashLog& flashLog, uint32_t logNumber, size_t length)
+{
+    size_t written = 0;
+    while (written < length) {
+        const uint8_t value = testByte(logNumber, written);
+        if (flashLog.write(value) == 1) {
+            ++written;
+        } else {
+            flashLog.update();
+        }
+    }
+}
+
+static void checkLog(BlackboxFlashLog& flashLog, size_t index, uint32_t logNumber, size_t length)
+{
+    const BlackboxFlashLog::log_info_t logInfo = flashLog.getLogInfo(index);
+    TEST_ASSERT_EQUAL(logNumber, logInfo.logNumber);
+    TEST_ASSERT_EQUAL(length, logInfo.size);
+    std::array<uint8_t, 100> buf {};
+    for (uint32_t offset = 0; offset < length; offset += static_cast<uint32_t>(buf.size())) {
+        const size_t count = flashLog.readLog(index, offset, &buf[0], buf.size());
+        for (size_t ii = 0; ii < count; ++ii) {
+            TEST_ASSERT_EQUAL(testByte(logNumber, offset + ii), buf[ii]);
+        }
+    }
+}
+
+void test_blackbox_flash_logs()
+{
+    {
+        FlashEmulatorFile flash(flashFileName, geometry);
+        TEST_ASSERT_TRUE(flash.isOpen());
+        flash.setBusyCounts(20, 2);
+        BlackboxFlashLog flashLog(flash);
+        TEST_ASSERT_TRUE(flashLog.init());
+        TEST_ASSERT_EQUAL(0, flashLog.getLogCount());
+
+        for (uint32_t logNumber = 1; logNumber <= 3; ++logNumber) {
+            while (!flashLog.beginLog()) {}
+            TEST_ASSERT_EQUAL(BlackboxFlashLog::STATE_LOGGING, flashLog.getState());
+            writeLog(flashLog, logNumber, 1000 + logNumber * 10);
+            while (!flashLog.endLog()) {}
+            TEST_ASSERT_EQUAL(BlackboxFlashLog::STATE_IDLE, flashLog.getState());
+        }
+        TEST_ASSERT_EQUAL(3, flashLog.getLogCount());
+        TEST_ASSERT_EQUAL(0, flashLog.getDroppedByteCount());
+        TEST_ASSERT_EQUAL(0, flash.getProgramErrorCount());
+        TEST_ASSERT_EQUAL(0, flash.getBusyErrorCount());
+        // logs are stored contiguously, each starting on a page boundary after the index sector
+        TEST_ASSERT_EQUAL(1024, flashLog.getLogInfo(0).startAddress);
+        TEST_ASSERT_EQUAL(1024 + 1024, flashLog.getLogInfo(1).startAddress);
+        TEST_ASSERT_EQUAL(2048 + 1024, flashLog.getLogInfo(2).startAddress);
+    }
+    {
+        // power cycle, the logs are read back from the index
+        FlashEmulatorFile flash(flashFileName, geometry);
+        BlackboxFlashLog flashLog(flash);
+        TEST_ASSERT_TRUE(flashLog.init());
+        TEST_ASSERT_EQUAL(3, flashLog.getLogCount());
+        checkLog(flashLog, 0, 1, 1010);
+        checkLog(flashLog, 1, 2, 1020);
+        checkLog(flashLog, 2, 3, 1030);
+
+        // append a fourth log
+        while (!flashLog.beginLog()) {}
+        writeLog(flashLog, 4, 500);
+        while (!flashLog.endLog()) {}
+        TEST_ASSERT_EQUAL(4, flashLog.getLogCount());
+        checkLog(flashLog, 3, 4, 500);
+        TEST_ASSERT_EQUAL(0, flash.getProgramErrorCount());
+
+        // erasing removes all the logs
+        while (!flashLog.eraseAll()) {}
+        TEST_ASSERT_EQUAL(0, flashLog.getLogCount());
+        TEST_ASSERT_TRUE(flashLog.init());
+        TEST_ASSERT_EQUAL(0, flashLog.getLogCount());
+    }
+}
+
+void test_blackbox_flash_erase_ahead()
+{
+    FlashEmulatorFile flash(flashFileName, geometry);
+    // a sector erase takes much longer than a page program
+    flash.setBusyCounts(100, 2);
+    BlackboxFlashLog flashLog(flash);
+    TEST_ASSERT_TRUE(flashLog.init());
+
+    while (!flashLog.beginLog()) {}
+    // the Blackbox calls update() regularly, writing a few bytes each time
+    size_t written = 0;
+    uint32_t maxFillPercent = 0;
+    for (size_t ii = 0; ii < 1000; ++ii) {
+        flashLog.update();
+        for (size_t jj = 0; jj < 8; ++jj) {
+            TEST_ASSERT_EQUAL(1, flashLog.write(testByte(1, written)));
+            ++written;
+        }
+        maxFillPercent = std::max(maxFillPercent, flashLog.getBufferFillPercent());
+    }
+    // writes were never refused, even though sectors were being erased
+    TEST_ASSERT_EQUAL(0, flashLog.getDroppedByteCount());
+    // the page buffers filled while sectors were being erased, this is an input to the BlackboxRateController
+    TEST_ASSERT_TRUE(maxFillPercent > 0);
+    TEST_ASSERT_TRUE(maxFillPercent <= 100);
+    TEST_ASSERT_TRUE(flash.getEraseCount() > 4);
+    // sectors have been erased ahead of the write address
+    TEST_ASSERT_TRUE(flashLog.getErasedEndAddress() > flashLog.getWriteAddress());
+    while (!flashLog.endLog()) {}
+    TEST_ASSERT_EQUAL(0, flashLog.getBufferFillPercent());
+    checkLog(flashLog, 0, 1, written);
+    TEST_ASSERT_EQUAL(0, flash.getProgramErrorCount());
+    TEST_ASSERT_EQUAL(0, flash.getBusyErrorCount());
+}
+
+void test_blackbox_flash_power_loss()
+{
+    {
+        FlashEmulatorFile flash(flashFileName, geometry);
+        BlackboxFlashLog flashLog(flash);
+        TEST_ASSERT_TRUE(flashLog.init());
+        while (!flashLog.beginLog()) {}
+        writeLog(flashLog, 1, 2000);
+        while (!flashLog.endLog()) {}
+
+        // fill the flash with stale data, so recovery cannot rely on the flash being erased beyond the log
+        while (!flashLog.beginLog()) {}
+        writeLog(flashLog, 2, 12000);
+        while (!flashLog.endLog()) {}
+        while (!flashLog.eraseAll()) {}
+
+        while (!flashLog.beginLog()) {}
+        writeLog(flashLog, 1, 2000);
+        while (!flashLog.endLog()) {}
+        while (!flashLog.beginLog()) {}
+        writeLog(flashLog, 2, 1500);
+        while (!flashLog.flush()) {}
+        // power is lost before the log is ended
+    }
+    {
+        FlashEmulatorFile flash(flashFileName, geometry);
+        BlackboxFlashLog flashLog(flash);
+        TEST_ASSERT_TRUE(flashLog.init());
+        TEST_ASSERT_EQUAL(2, flashLog.getLogCount());
+        checkLog(flashLog, 0, 1, 2000);
+        checkLog(flashLog, 1, 2, 1500);
+        TEST_ASSERT_EQUAL(0, flash.getProgramErrorCount());
+    }
+}
+
+void test_blackbox_flash_full()
+{
+    FlashEmulatorFile flash(flashFileName, geometry);
+    BlackboxFlashLog flashLog(flash);
+    TEST_ASSERT_TRUE(flashLog.init());
+    while (!flashLog.beginLog()) {}
+    const uint32_t dataCapacity = flash.getCapacity() - geometry.sectorSize;
+    size_t written = 0;
+    for (size_t ii = 0; ii < dataCapacity + 1000; ++ii) {
+        written += flashLog.write(testByte(1, written));
+        flashLog.update();
+    }
+    TEST_ASSERT_EQUAL(dataCapacity, written);
+    TEST_ASSERT_EQUAL(1000, flashLog.getDroppedByteCount());
+    TEST_ASSERT_TRUE(flashLog.isFull());
+    while (!flashLog.endLog()) {}
+    checkLog(flashLog, 0, 1, dataCapacity);
+    TEST_ASSERT_FALSE(flashLog.beginLog());
+    TEST_ASSERT_EQUAL(0, flash.getProgramErrorCount());
+}
+
+void test_blackbox_flash_corrupt_index()
+{
+    {
+        FlashEmulatorFile flash(flashFileName, geometry);
+        const std::array<uint8_t, 4> garbage = { 0x12, 0x34, 0x56, 0x78 };
+        flash.programPage(0, &garbage[0], garbage.size());
+    }
+    FlashEmulatorFile flash(flashFileName, geometry);
+    BlackboxFlashLog flashLog(flash);
+    TEST_ASSERT_FALSE(flashLog.init());
+    TEST_ASSERT_FALSE(flashLog.isIndexValid());
+    TEST_ASSERT_FALSE(flashLog.beginLog());
+    while (!flashLog.eraseAll()) {}
+    TEST_ASSERT_TRUE(flashLog.init());
+    TEST_ASSERT_TRUE(flashLog.isIndexValid());
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,cppcoreguidelines-init-variables,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_blackbox_flash_logs);
+    RUN_TEST(test_blackbox_flash_erase_ahead);
+    RUN_TEST(test_blackbox_flash_power_loss);
+    RUN_TEST(test_blackbox_flash_full);
+    RUN_TEST(test_blackbox_flash_corrupt_index);
+
+    UNITY_END();
+}
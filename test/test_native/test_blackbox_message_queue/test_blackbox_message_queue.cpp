@@ -0,0 +1,60 @@
+#include <BlackboxMessageQueue.h>
+#include <unity.h>
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,cppcoreguidelines-init-variables,readability-magic-numbers)
+void test_blackbox_message_queue_field_scale_standard()
+{
+    static BlackboxMessageQueue messageQueue;
+    const BlackboxMessageQueue::field_scale_t& fieldScale = messageQueue.getFieldScale();
+    TEST_ASSERT_EQUAL(1, fieldScale.pid);
+    TEST_ASSERT_EQUAL(2047, fieldScale.motorOutputHigh);
+
+    TEST_ASSERT_EQUAL(12, BlackboxMessageQueue::scalePID(12.4F, fieldScale));
+    TEST_ASSERT_EQUAL(-13, BlackboxMessageQueue::scalePID(-12.6F, fieldScale));
+    TEST_ASSERT_EQUAL(INT16_MAX, BlackboxMessageQueue::scalePID(100000.0F, fieldScale));
+    TEST_ASSERT_EQUAL(INT16_MIN, BlackboxMessageQueue::scalePID(-100000.0F, fieldScale));
+
+    // motor outputs are not truncated to 0 or 1
+    TEST_ASSERT_EQUAL(158, BlackboxMessageQueue::scaleMotorOutput(0.0F, fieldScale));
+    TEST_ASSERT_EQUAL(1103, BlackboxMessageQueue::scaleMotorOutput(0.5F, fieldScale));
+    TEST_ASSERT_EQUAL(2047, BlackboxMessageQueue::scaleMotorOutput(1.0F, fieldScale));
+    // outputs outside the range [0, 1] are clamped
+    TEST_ASSERT_EQUAL(158, BlackboxMessageQueue::scaleMotorOutput(-0.1F, fieldScale));
+    TEST_ASSERT_EQUAL(2047, BlackboxMessageQueue::scaleMotorOutput(1.1F, fieldScale));
+}
+
+void test_blackbox_message_queue_field_scale_high_precision()
+{
+    static BlackboxMessageQueue messageQueue;
+    messageQueue.setFieldScale(BlackboxMessageQueue::FIELD_SCALE_HIGH_PRECISION);
+    const BlackboxMessageQueue::field_scale_t& fieldScale = messageQueue.getFieldScale();
+    TEST_ASSERT_EQUAL(10, fieldScale.pid);
+    TEST_ASSERT_EQUAL(32767, fieldScale.motorOutputHigh);
+
+    TEST_ASSERT_EQUAL(124, BlackboxMessageQueue::scalePID(12.4F, fieldScale));
+    TEST_ASSERT_EQUAL(-126, BlackboxMessageQueue::scalePID(-12.6F, fieldScale));
+    TEST_ASSERT_EQUAL(3, BlackboxMessageQueue::scalePID(0.25F, fieldScale));
+
+    TEST_ASSERT_EQUAL(158, BlackboxMessageQueue::scaleMotorOutput(0.0F, fieldScale));
+    TEST_ASSERT_EQUAL(16463, BlackboxMessageQueue::scaleMotorOutput(0.5F, fieldScale));
+    TEST_ASSERT_EQUAL(32767, BlackboxMessageQueue::scaleMotorOutput(1.0F, fieldScale));
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,cppcoreguidelines-init-variables,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_blackbox_message_queue_field_scale_standard);
+    RUN_TEST(test_blackbox_message_queue_field_scale_high_precision);
+
+    UNITY_END();
+}
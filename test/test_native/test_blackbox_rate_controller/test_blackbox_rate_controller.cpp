@@ -0,0 +1,96 @@
+#include <BlackboxRateController.h>
+#include <unity.h>
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,cppcoreguidelines-init-variables,readability-magic-numbers)
+void test_blackbox_rate_controller()
+{
+    BlackboxRateController rateController;
+    const BlackboxRateController::config_t& config = rateController.getConfig();
+    const BlackboxRateController::input_t calm { .queueFillPercent = 0, .deviceFillPercent = 10, .writeLatencyMicroSeconds = 1000, .droppedCount = 0 };
+    const BlackboxRateController::input_t busy { .queueFillPercent = 30, .deviceFillPercent = 60, .writeLatencyMicroSeconds = 10000, .droppedCount = 0 };
+    const BlackboxRateController::input_t slowWrite { .queueFillPercent = 0, .deviceFillPercent = 10, .writeLatencyMicroSeconds = 30000, .droppedCount = 0 };
+    const BlackboxRateController::input_t queueFull { .queueFillPercent = 60, .deviceFillPercent = 0, .writeLatencyMicroSeconds = 0, .droppedCount = 0 };
+    const BlackboxRateController::input_t dropped { .queueFillPercent = 0, .deviceFillPercent = 0, .writeLatencyMicroSeconds = 0, .droppedCount = 1 };
+
+    // with no backpressure the log runs at the full rate
+    uint32_t time = 1000;
+    for (size_t ii = 0; ii < 100; ++ii, time += 1000) {
+        TEST_ASSERT_FALSE(rateController.update(time, calm));
+    }
+    TEST_ASSERT_EQUAL(1, rateController.getDecimation());
+
+    // a write latency spike doubles the decimation
+    TEST_ASSERT_TRUE(rateController.update(time, slowWrite));
+    TEST_ASSERT_EQUAL(2, rateController.getDecimation());
+    // further backpressure during the hold off does not increase it again
+    const uint32_t increaseTime = time;
+    time += 1000;
+    TEST_ASSERT_FALSE(rateController.update(time, queueFull));
+    TEST_ASSERT_EQUAL(2, rateController.getDecimation());
+    time = increaseTime + config.holdOffMicroSeconds;
+    TEST_ASSERT_TRUE(rateController.update(time, dropped));
+    TEST_ASSERT_EQUAL(4, rateController.getDecimation());
+
+    // between the low and high levels the decimation is held
+    for (size_t ii = 0; ii < 3000; ++ii, time += 1000) {
+        TEST_ASSERT_FALSE(rateController.update(time, busy));
+    }
+    TEST_ASSERT_EQUAL(4, rateController.getDecimation());
+
+    // the decimation is halved only after the inputs have been low for decreaseDelayMicroSeconds
+    const uint32_t calmStartTime = time;
+    TEST_ASSERT_FALSE(rateController.update(time, calm));
+    time = calmStartTime + config.decreaseDelayMicroSeconds - 1;
+    TEST_ASSERT_FALSE(rateController.update(time, calm));
+    time = calmStartTime + config.decreaseDelayMicroSeconds;
+    TEST_ASSERT_TRUE(rateController.update(time, calm));
+    TEST_ASSERT_EQUAL(2, rateController.getDecimation());
+    // and each further halving needs another period of low inputs
+    time += config.decreaseDelayMicroSeconds / 2;
+    TEST_ASSERT_FALSE(rateController.update(time, calm));
+    time += config.decreaseDelayMicroSeconds / 2;
+    TEST_ASSERT_TRUE(rateController.update(time, calm));
+    TEST_ASSERT_EQUAL(1, rateController.getDecimation());
+
+    const BlackboxRateController::stats_t& stats = rateController.getStats();
+    TEST_ASSERT_EQUAL(2, stats.increaseCount);
+    TEST_ASSERT_EQUAL(2, stats.decreaseCount);
+    TEST_ASSERT_EQUAL(4, stats.maxDecimation);
+}
+
+void test_blackbox_rate_controller_limit()
+{
+    BlackboxRateController rateController;
+    const BlackboxRateController::input_t dropped { .queueFillPercent = 100, .deviceFillPercent = 100, .writeLatencyMicroSeconds = 0, .droppedCount = 10 };
+
+    // sustained backpressure raises the decimation to the maximum, and no further, even when time wraps
+    uint32_t time = 0xFFFF0000U;
+    for (size_t ii = 0; ii < 100; ++ii, time += rateController.getConfig().holdOffMicroSeconds) {
+        rateController.update(time, dropped);
+    }
+    TEST_ASSERT_EQUAL(BlackboxRateController::MAX_DECIMATION, rateController.getDecimation());
+    TEST_ASSERT_EQUAL(4, rateController.getStats().increaseCount);
+
+    rateController.reset();
+    TEST_ASSERT_EQUAL(1, rateController.getDecimation());
+    TEST_ASSERT_EQUAL(0, rateController.getStats().increaseCount);
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,cppcoreguidelines-init-variables,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_blackbox_rate_controller);
+    RUN_TEST(test_blackbox_rate_controller_limit);
+
+    UNITY_END();
+}
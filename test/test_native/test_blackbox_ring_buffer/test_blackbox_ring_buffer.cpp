@@ -0,0 +1,93 @@
+#include <BlackboxRingBuffer.h>
+#include <unity.h>
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,cppcoreguidelines-init-variables,readability-magic-numbers)
+void test_blackbox_ring_buffer()
+{
+    static BlackboxRingBuffer<uint32_t, 8> ringBuffer;
+    TEST_ASSERT_EQUAL(8, ringBuffer.capacity());
+    TEST_ASSERT_TRUE(ringBuffer.isEmpty());
+
+    uint32_t item {};
+    uint32_t droppedCount {};
+    TEST_ASSERT_FALSE(ringBuffer.pop(item));
+    TEST_ASSERT_FALSE(ringBuffer.peek(item));
+
+    TEST_ASSERT_TRUE(ringBuffer.push(1));
+    TEST_ASSERT_TRUE(ringBuffer.push(2));
+    TEST_ASSERT_EQUAL(2, ringBuffer.size());
+    TEST_ASSERT_TRUE(ringBuffer.peek(item));
+    TEST_ASSERT_EQUAL(1, item);
+    TEST_ASSERT_EQUAL(2, ringBuffer.size());
+    TEST_ASSERT_TRUE(ringBuffer.pop(item, droppedCount));
+    TEST_ASSERT_EQUAL(1, item);
+    TEST_ASSERT_EQUAL(0, droppedCount);
+    TEST_ASSERT_TRUE(ringBuffer.pop(item));
+    TEST_ASSERT_EQUAL(2, item);
+    TEST_ASSERT_TRUE(ringBuffer.isEmpty());
+
+    // items are returned in order as the indices wrap around
+    for (uint32_t ii = 0; ii < 100; ++ii) {
+        TEST_ASSERT_TRUE(ringBuffer.push(ii));
+        TEST_ASSERT_TRUE(ringBuffer.push(ii + 1000));
+        TEST_ASSERT_TRUE(ringBuffer.pop(item));
+        TEST_ASSERT_EQUAL(ii, item);
+        TEST_ASSERT_TRUE(ringBuffer.pop(item));
+        TEST_ASSERT_EQUAL(ii + 1000, item);
+    }
+    TEST_ASSERT_EQUAL(0, ringBuffer.getOverflowCount());
+}
+
+void test_blackbox_ring_buffer_overflow()
+{
+    static BlackboxRingBuffer<uint32_t, 4> ringBuffer;
+    uint32_t item {};
+    uint32_t droppedCount {};
+
+    for (uint32_t ii = 0; ii < 4; ++ii) {
+        TEST_ASSERT_TRUE(ringBuffer.push(ii));
+    }
+    // buffer full, so the next 3 items are dropped
+    TEST_ASSERT_FALSE(ringBuffer.push(4));
+    TEST_ASSERT_FALSE(ringBuffer.push(5));
+    TEST_ASSERT_FALSE(ringBuffer.push(6));
+    TEST_ASSERT_EQUAL(3, ringBuffer.getOverflowCount());
+    TEST_ASSERT_EQUAL(4, ringBuffer.size());
+
+    // the items in the buffer are unaffected
+    for (uint32_t ii = 0; ii < 4; ++ii) {
+        TEST_ASSERT_TRUE(ringBuffer.pop(item, droppedCount));
+        TEST_ASSERT_EQUAL(ii, item);
+        TEST_ASSERT_EQUAL(0, droppedCount);
+    }
+
+    // the next item pushed reports the number dropped before it
+    TEST_ASSERT_TRUE(ringBuffer.push(7));
+    TEST_ASSERT_TRUE(ringBuffer.push(8));
+    TEST_ASSERT_TRUE(ringBuffer.pop(item, droppedCount));
+    TEST_ASSERT_EQUAL(7, item);
+    TEST_ASSERT_EQUAL(3, droppedCount);
+    TEST_ASSERT_TRUE(ringBuffer.pop(item, droppedCount));
+    TEST_ASSERT_EQUAL(8, item);
+    TEST_ASSERT_EQUAL(0, droppedCount);
+    TEST_ASSERT_EQUAL(3, ringBuffer.getOverflowCount());
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,cppcoreguidelines-init-variables,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_blackbox_ring_buffer);
+    RUN_TEST(test_blackbox_ring_buffer_overflow);
+
+    UNITY_END();
+}
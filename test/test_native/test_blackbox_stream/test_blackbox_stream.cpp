@@ -0,0 +1,108 @@
+#include <BlackboxSerialDeviceStream.h>
+#include <algorithm>
+#include <array>
+#include <unity.h>
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+/*!
+Stream device with a port that accepts a limited number of bytes per flush, to simulate a slow link.
+*/
+class BlackboxSerialDeviceStreamTest : public BlackboxSerialDeviceStream {
+public:
+    BlackboxSerialDeviceStreamTest() : BlackboxSerialDeviceStream(PORT_UART1, uart_pins_t{.tx=8,.cts=10}, DEFAULT_BAUD_RATE) {}
+    void setPortBudget(size_t portBudget) { _portBudget = portBudget; }
+    size_t getSentCount() const { return _sentCount; }
+    uint8_t getLastSent() const { return _lastSent; }
+protected:
+    virtual size_t writeToPort(const uint8_t* data, size_t length) override {
+        const size_t count = std::min(length, _portBudget);
+        for (size_t ii = 0; ii < count; ++ii) {
+            _lastSent = data[ii]; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        }
+        _portBudget -= count;
+        _sentCount += count;
+        return count;
+    }
+private:
+    size_t _portBudget {0};
+    size_t _sentCount {0};
+    uint8_t _lastSent {0};
+};
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,cppcoreguidelines-init-variables,readability-magic-numbers)
+void test_blackbox_stream()
+{
+    static BlackboxSerialDeviceStreamTest stream;
+    TEST_ASSERT_EQUAL(BlackboxSerialDeviceStream::PORT_UART1, stream.getPort());
+    TEST_ASSERT_EQUAL(0, stream.init());
+    TEST_ASSERT_TRUE(stream.isDeviceReady());
+    TEST_ASSERT_TRUE(stream.beginLog());
+    TEST_ASSERT_EQUAL(0, stream.getFillPercent());
+
+    std::array<uint8_t, 100> data {};
+    for (size_t ii = 0; ii < data.size(); ++ii) {
+        data[ii] = static_cast<uint8_t>(ii);
+    }
+    // a fast link sends everything on each flush, in order
+    stream.setPortBudget(1000);
+    TEST_ASSERT_EQUAL(100, stream.write(&data[0], data.size()));
+    TEST_ASSERT_EQUAL(100, stream.getBufferedByteCount());
+    TEST_ASSERT_TRUE(stream.flush());
+    TEST_ASSERT_EQUAL(0, stream.getBufferedByteCount());
+    TEST_ASSERT_EQUAL(100, stream.getSentCount());
+    TEST_ASSERT_EQUAL(99, stream.getLastSent());
+    TEST_ASSERT_EQUAL(0, stream.getFillPercent());
+
+    // the link stalls, so the buffer fills, and the fill level (an input to the BlackboxRateController) rises
+    stream.setPortBudget(0);
+    while (stream.getBufferedByteCount() < BlackboxSerialDeviceStream::BUFFER_SIZE / 2) {
+        TEST_ASSERT_EQUAL(100, stream.write(&data[0], data.size()));
+    }
+    TEST_ASSERT_EQUAL(BlackboxSerialDeviceStream::BLACKBOX_RESERVE_SUCCESS, stream.reserveBufferSpace(100));
+    stream.flush();
+    TEST_ASSERT_EQUAL(stream.getBufferedByteCount() * 100 / BlackboxSerialDeviceStream::BUFFER_SIZE, stream.getFillPercent());
+    TEST_ASSERT_TRUE(stream.getFillPercent() >= 50);
+
+    // when the buffer is full data is dropped and counted, the write never blocks
+    while (stream.write(&data[0], data.size()) == data.size()) {}
+    TEST_ASSERT_EQUAL(BlackboxSerialDeviceStream::BUFFER_SIZE, stream.getBufferedByteCount());
+    TEST_ASSERT_EQUAL(100, stream.getFillPercent());
+    TEST_ASSERT_EQUAL(BlackboxSerialDeviceStream::BLACKBOX_RESERVE_TEMPORARY_FAILURE, stream.reserveBufferSpace(1));
+    TEST_ASSERT_EQUAL(BlackboxSerialDeviceStream::BLACKBOX_RESERVE_PERMANENT_FAILURE, stream.reserveBufferSpace(BlackboxSerialDeviceStream::BUFFER_SIZE + 1));
+    TEST_ASSERT_EQUAL(0, stream.write(data[0]));
+    const uint32_t droppedByteCount = stream.getStats().droppedByteCount;
+    TEST_ASSERT_TRUE(droppedByteCount > 0);
+    TEST_ASSERT_EQUAL(100, stream.getStats().byteCount);
+
+    // the log cannot end until the buffer has been sent
+    TEST_ASSERT_FALSE(stream.endLog(true));
+
+    // the link recovers, the buffer (which has wrapped) is sent, and the log ends
+    stream.setPortBudget(BlackboxSerialDeviceStream::BUFFER_SIZE);
+    TEST_ASSERT_TRUE(stream.endLog(true));
+    TEST_ASSERT_EQUAL(0, stream.getBufferedByteCount());
+    TEST_ASSERT_EQUAL(100 + BlackboxSerialDeviceStream::BUFFER_SIZE, stream.getSentCount());
+    TEST_ASSERT_EQUAL(BlackboxSerialDeviceStream::BUFFER_SIZE, stream.getStats().highWaterMark);
+    TEST_ASSERT_EQUAL(0, stream.getFillPercent());
+
+    // a new log resets the statistics, including the dropped byte count
+    TEST_ASSERT_TRUE(stream.beginLog());
+    TEST_ASSERT_EQUAL(0, stream.getStats().droppedByteCount);
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,cppcoreguidelines-init-variables,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_blackbox_stream);
+
+    UNITY_END();
+}
@@ -1,5 +1,7 @@
 #include <DShotCodec.h>
 #include <IMU_Filters.h> // test code won't build if this not included
+#include <array>
+#include <random>
 #include <unity.h>
 
 void setUp()
@@ -89,8 +91,112 @@ void test_dshot_codec()
     //TEST_ASSERT_EQUAL(1, DShotCodec::frameUnidirectional(2048));
     //TEST_ASSERT_EQUAL(35, DShotCodec::frameUnidirectional(2049));
     //TEST_ASSERT_EQUAL(69, DShotCodec::frameUnidirectional(2050));
+
+    // special commands with the telemetry request bit set
+    TEST_ASSERT_EQUAL(340, DShotCodec::frameUnidirectional(DShotCodec::TELEMETRY_REQUEST | 10)); // 0x154
+    TEST_ASSERT_EQUAL(0x01BA, DShotCodec::frameUnidirectional(DShotCodec::TELEMETRY_REQUEST | 13));
+    TEST_ASSERT_TRUE(DShotCodec::checksumUnidirectionalIsOK(DShotCodec::frameUnidirectional(DShotCodec::TELEMETRY_REQUEST | 13)));
+    TEST_ASSERT_TRUE(DShotCodec::checksumBidirectionalIsOK(DShotCodec::frameBidirectional(DShotCodec::TELEMETRY_REQUEST | 13)));
 }
 
+
+/*!
+Original bit by bit implementation of DShotCodec::decodeSamples(uint64_t), used as a reference for testing.
+*/
+static uint32_t decodeSamplesReference(uint64_t value, DShotCodec::telemetry_type_e& telemetryType)
+{
+    if (value & 0x8000000000000000L) {
+        telemetryType = DShotCodec::TELEMETRY_INVALID;
+        return 0;
+    }
+    uint32_t consecutiveBitCount = 1;
+    uint32_t currentBit = 0;
+    uint32_t bitCount = 0;
+    uint32_t gcr_result = 0;
+    for (uint64_t mask = 0x4000000000000000; mask != 0; mask >>= 1) {
+        if (((value & mask) != 0) != currentBit) {
+            gcr_result = gcr_result << DShotCodec::gcrBitLengths[consecutiveBitCount];
+            if (currentBit) {
+                gcr_result |= DShotCodec::gcrSetBits[DShotCodec::gcrBitLengths[consecutiveBitCount]];
+            }
+            bitCount += DShotCodec::gcrBitLengths[consecutiveBitCount];
+            currentBit = !currentBit;
+            consecutiveBitCount = 1;
+        } else {
+            ++consecutiveBitCount;
+            if (consecutiveBitCount > 16) {
+                telemetryType = DShotCodec::TELEMETRY_INVALID;
+                return 0;
+            }
+        }
+    }
+    gcr_result <<= DShotCodec::gcrBitLengths[consecutiveBitCount];
+    if (currentBit) {
+        gcr_result |= DShotCodec::gcrSetBits[DShotCodec::gcrBitLengths[consecutiveBitCount]];
+    }
+    bitCount += DShotCodec::gcrBitLengths[consecutiveBitCount];
+    if (bitCount < 21) {
+        telemetryType = DShotCodec::TELEMETRY_INVALID;
+        return 0;
+    }
+    gcr_result = gcr_result >> (bitCount - 21);
+    const uint16_t result = DShotCodec::GCR20_to_eRPM(DShotCodec::GCR21_to_GCR20(gcr_result));
+    if (!DShotCodec::checksumBidirectionalIsOK(result)) {
+        telemetryType = DShotCodec::TELEMETRY_INVALID;
+        return 0;
+    }
+    return DShotCodec::decodeTelemetryFrame(result >> 4, telemetryType);
+}
+
+static uint64_t samplesFromTelemetryValue(uint16_t value)
+{
+    const auto frame = static_cast<uint16_t>((value << 4U) | DShotCodec::checksumBidirectional(value));
+    return DShotCodec::GCR21_to_samples(DShotCodec::GR20_to_GCR21(DShotCodec::eRPM_to_GCR20(frame)));
+}
+
+void test_dshot_codec_round_trip()
+{
+    // encode and decode all 4096 telemetry values
+    for (uint16_t value = 0; value < 4096; ++value) {
+        const auto frame = static_cast<uint16_t>((value << 4U) | DShotCodec::checksumBidirectional(value));
+        const uint32_t gcr20 = DShotCodec::eRPM_to_GCR20(frame);
+        TEST_ASSERT_EQUAL(frame, DShotCodec::GCR20_to_eRPM(gcr20));
+        const uint32_t gcr21 = DShotCodec::GR20_to_GCR21(gcr20);
+        TEST_ASSERT_EQUAL(gcr20, DShotCodec::GCR21_to_GCR20(gcr21));
+
+        const uint64_t samples = DShotCodec::GCR21_to_samples(gcr21);
+        DShotCodec::telemetry_type_e expectedType {};
+        const uint32_t expected = DShotCodec::decodeTelemetryFrame(value, expectedType);
+        DShotCodec::telemetry_type_e telemetryType {};
+        TEST_ASSERT_EQUAL(expected, DShotCodec::decodeSamples(samples, telemetryType));
+        TEST_ASSERT_EQUAL(expectedType, telemetryType);
+    }
+}
+
+void test_dshot_codec_decode_samples_reference()
+{
+    // the run length decoder must give the same results as the bit by bit decoder, including for corrupted samples
+    std::mt19937_64 generator(1234); // NOLINT(cert-msc32-c,cert-msc51-cpp) deterministic seed for repeatable tests
+    for (uint16_t value = 0; value < 4096; ++value) {
+        const uint64_t samples = samplesFromTelemetryValue(value);
+        std::array<uint64_t, 4> testSamples = {
+            samples,
+            samples ^ (1ULL << (generator() % 63)), // single sample flipped
+            samples >> 1, // early start
+            generator() >> 1 // noise
+        };
+        for (const uint64_t sample : testSamples) {
+            DShotCodec::telemetry_type_e expectedType {};
+            const uint32_t expected = decodeSamplesReference(sample, expectedType);
+            DShotCodec::telemetry_type_e telemetryType {};
+            const uint32_t result = DShotCodec::decodeSamples(sample, telemetryType);
+            TEST_ASSERT_EQUAL(expectedType, telemetryType);
+            if (expectedType != DShotCodec::TELEMETRY_INVALID) {
+                TEST_ASSERT_EQUAL(expected, result);
+            }
+        }
+    }
+}
 // NOLINTEND(cppcoreguidelines-avoid-magic-numbers,cppcoreguidelines-init-variables,cppcoreguidelines-pro-bounds-pointer-arithmetic,hicpp-signed-bitwise,readability-magic-numbers)
 
 // See for example for testing GCR encoding https://github.com/betaflight/betaflight/pull/8554#issuecomment-512507625
@@ -103,6 +209,8 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
     RUN_TEST(test_dshot_codec_checksum);
     RUN_TEST(test_dshot_codec_mappings);
     RUN_TEST(test_dshot_codec);
+    RUN_TEST(test_dshot_codec_round_trip);
+    RUN_TEST(test_dshot_codec_decode_samples_reference);
 
     UNITY_END();
 }
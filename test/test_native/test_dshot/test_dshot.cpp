@@ -1,6 +1,10 @@
 #include <DShotCodec.h>
+#include <DShotCommandQueue.h>
 #include <ESC_DShot.h>
+#include <ESC_DShotBatch.h>
+#include <ESC_DShotBitbang.h>
 #include <IMU_Filters.h> // test code won't build if this not included
+#include <array>
 #include <unity.h>
 
 void setUp()
@@ -203,6 +207,351 @@ void test_dshot_write_channel_b()
     TEST_ASSERT_EQUAL(LO, esc.getBufferItem(15));
     TEST_ASSERT_EQUAL(0, esc.getBufferItem(16));
 }
+
+void test_dshot_batch_init()
+{
+    static ESC_DShotBatch escs(ESC_DShot::ESC_PROTOCOL_DSHOT300);
+    TEST_ASSERT_EQUAL(375, escs.getDataHighPulseWidth());
+    TEST_ASSERT_EQUAL(187, escs.getDataLowPulseWidth());
+
+    // pins 2 and 3 are on the same PWM slice, as are pins 4 and 5
+    const std::array<uint8_t, 4> pins = { 2, 3, 4, 5 };
+    escs.init(&pins[0], pins.size());
+    TEST_ASSERT_EQUAL(4, escs.getMotorCount());
+    TEST_ASSERT_EQUAL(2, escs.getSliceCount());
+
+    // pins 2 and 5 are on different slices
+    const std::array<uint8_t, 2> pins2 = { 2, 5 };
+    escs.init(&pins2[0], pins2.size());
+    TEST_ASSERT_EQUAL(2, escs.getMotorCount());
+    TEST_ASSERT_EQUAL(2, escs.getSliceCount());
+}
+
+void test_dshot_batch_write()
+{
+    // check the batch encoding gives the same result as encoding each motor individually
+    static ESC_DShotBatch escs(ESC_DShot::ESC_PROTOCOL_DSHOT300);
+    const std::array<uint8_t, 4> pins = { 2, 3, 4, 5 };
+    escs.init(&pins[0], pins.size());
+
+    static ESC_DShot escA(ESC_DShot::ESC_PROTOCOL_DSHOT300);
+    static ESC_DShot escB(ESC_DShot::ESC_PROTOCOL_DSHOT300);
+    escB.setUseHighOrderBits(true);
+
+    const std::array<std::array<uint16_t, 4>, 4> valuesList = {{
+        { DShotCodec::pwmToDShotClipped(1000), DShotCodec::pwmToDShot(1500), DShotCodec::pwmToDShot(2000), DShotCodec::pwmToDShot(1250) },
+        { DShotCodec::pwmToDShot(1500), DShotCodec::pwmToDShot(1500), DShotCodec::pwmToDShot(1500), DShotCodec::pwmToDShot(1500) },
+        { 47, 48, 1047, 2047 },
+        { 2047, 1024, 512, 100 }
+    }};
+    for (const auto& values : valuesList) {
+        escs.write(&values[0]);
+        for (size_t slice = 0; slice < 2; ++slice) {
+            escA.write(values[slice*2]);
+            escB.write(values[slice*2 + 1]);
+            for (size_t ii = 0; ii < ESC_DShotBatch::DMA_BLOCK_SIZE; ++ii) {
+                TEST_ASSERT_EQUAL(escA.getBufferItem(ii) | escB.getBufferItem(ii), escs.getBufferItem(slice, ii));
+            }
+        }
+    }
+    // check the terminating zero value
+    TEST_ASSERT_EQUAL(0, escs.getBufferItem(0, 16));
+    TEST_ASSERT_EQUAL(0, escs.getBufferItem(1, 16));
+}
+
+static uint64_t samplesFromTelemetryValue(uint16_t value)
+{
+    const auto frame = static_cast<uint16_t>((value << 4U) | DShotCodec::checksumBidirectional(value));
+    return DShotCodec::GCR21_to_samples(DShotCodec::GR20_to_GCR21(DShotCodec::eRPM_to_GCR20(frame)));
+}
+
+void test_dshot_telemetry_received()
+{
+    static ESC_DShot esc(ESC_DShot::ESC_PROTOCOL_DSHOT300);
+    esc.init(4);
+
+    // no telemetry received yet
+    TEST_ASSERT_FALSE(esc.read());
+    TEST_ASSERT_EQUAL(0, esc.getMotorRPM());
+
+    // eRPM period of 200 microseconds, ie 300000 eRPM
+    const uint16_t value = 200;
+    const uint16_t frame = static_cast<uint16_t>((value << 4U) | DShotCodec::checksumBidirectional(value));
+    const uint32_t gcr21 = DShotCodec::GR20_to_GCR21(DShotCodec::eRPM_to_GCR20(frame));
+    const uint64_t samples = DShotCodec::GCR21_to_samples(gcr21);
+    DShotCodec::telemetry_type_e telemetryType {};
+    TEST_ASSERT_EQUAL(200, DShotCodec::decodeSamples(samples, telemetryType));
+    TEST_ASSERT_EQUAL(DShotCodec::TELEMETRY_TYPE_ERPM, telemetryType);
+
+    // telemetry is received in the background, and published by read()
+    esc.telemetryReceived(samples, 1234);
+    TEST_ASSERT_EQUAL(1, esc.getTelemetryReadCount());
+    TEST_ASSERT_EQUAL(0, esc.getMotorRPM());
+    TEST_ASSERT_TRUE(esc.read());
+    TEST_ASSERT_EQUAL(1234, esc.getTelemetryTimeMicroSeconds());
+    TEST_ASSERT_EQUAL(2 * 300000 / ESC_DShot::DEFAULT_MOTOR_POLE_COUNT, esc.getMotorRPM());
+    // no new telemetry, so read returns false and values are unchanged
+    TEST_ASSERT_FALSE(esc.read());
+    TEST_ASSERT_EQUAL(2 * 300000 / ESC_DShot::DEFAULT_MOTOR_POLE_COUNT, esc.getMotorRPM());
+
+    // invalid samples (first sample high) are counted as errors and not published
+    esc.telemetryReceived(0xFFFFFFFFFFFFFFFFU, 2000);
+    TEST_ASSERT_EQUAL(2, esc.getTelemetryReadCount());
+    TEST_ASSERT_EQUAL(1, esc.getTelemetryErrorCount());
+    TEST_ASSERT_FALSE(esc.read());
+    TEST_ASSERT_EQUAL(1234, esc.getTelemetryTimeMicroSeconds());
+}
+
+void test_dshot_extended_telemetry()
+{
+    static ESC_DShot esc(ESC_DShot::ESC_PROTOCOL_DSHOT300);
+    esc.init(4);
+
+    esc_telemetry_t telemetry = esc.getTelemetry();
+    TEST_ASSERT_EQUAL(0, telemetry.temperatureCelsius);
+    TEST_ASSERT_EQUAL(0, telemetry.invalidPercent());
+
+    // EDT frames are of the form ppp0mmmmmmmm, where ppp is the telemetry type
+    esc.telemetryReceived(samplesFromTelemetryValue(0x200 | 75), 100); // temperature 75C
+    esc.telemetryReceived(samplesFromTelemetryValue(0x400 | 66), 200); // voltage 16.5V
+    esc.telemetryReceived(samplesFromTelemetryValue(0x600 | 12), 300); // current 12A
+    esc.telemetryReceived(samplesFromTelemetryValue(0xC00 | 3), 400); // stress level
+    esc.telemetryReceived(samplesFromTelemetryValue(0xE00 | 0x05), 500); // state events
+
+    telemetry = esc.getTelemetry();
+    TEST_ASSERT_EQUAL(75, telemetry.temperatureCelsius);
+    TEST_ASSERT_EQUAL(1650, telemetry.voltageCentiVolts);
+    TEST_ASSERT_EQUAL(1200, telemetry.currentCentiAmps);
+    TEST_ASSERT_EQUAL(3, telemetry.stressLevel);
+    TEST_ASSERT_EQUAL(5, telemetry.stateEvents);
+    TEST_ASSERT_EQUAL(5, telemetry.readCount);
+    TEST_ASSERT_EQUAL(0, telemetry.errorCount);
+
+    // EDT frames do not publish eRPM
+    TEST_ASSERT_FALSE(esc.read());
+    TEST_ASSERT_EQUAL(1, esc.getTelemetry().staleCount);
+
+    // one invalid frame in 8
+    esc.telemetryReceived(0xFFFFFFFFFFFFFFFFU, 600);
+    esc.telemetryReceived(samplesFromTelemetryValue(200), 700);
+    esc.telemetryReceived(samplesFromTelemetryValue(200), 800);
+    TEST_ASSERT_TRUE(esc.read());
+    telemetry = esc.getTelemetry();
+    TEST_ASSERT_EQUAL(8, telemetry.readCount);
+    TEST_ASSERT_EQUAL(1, telemetry.errorCount);
+    TEST_ASSERT_EQUAL(1250, telemetry.invalidPercent()); // 12.5%
+    TEST_ASSERT_EQUAL(2 * 300000 / ESC_DShot::DEFAULT_MOTOR_POLE_COUNT, telemetry.rpm);
+}
+
+void test_dshot_command_queue()
+{
+    enum { CYCLE_MICROSECONDS = 1000 }; // 1kHz output loop
+    DShotCommandQueue queue;
+
+    TEST_ASSERT_TRUE(queue.isEmpty());
+    TEST_ASSERT_FALSE(queue.update(CYCLE_MICROSECONDS));
+
+    TEST_ASSERT_TRUE(queue.enqueue(DShotCommandQueue::DSHOT_CMD_EXTENDED_TELEMETRY_ENABLE));
+    TEST_ASSERT_TRUE(queue.enqueue(DShotCommandQueue::DSHOT_CMD_BEACON1, 2));
+    TEST_ASSERT_EQUAL(2, queue.getCount());
+
+    // motors must be stopped for INITIAL_DELAY_MICROSECONDS before the first command
+    for (size_t ii = 0; ii < DShotCommandQueue::INITIAL_DELAY_MICROSECONDS / CYCLE_MICROSECONDS; ++ii) {
+        TEST_ASSERT_FALSE(queue.update(CYCLE_MICROSECONDS));
+    }
+    // settings commands are repeated on consecutive output cycles
+    for (size_t ii = 0; ii < DShotCommandQueue::SETTINGS_COMMAND_REPEATS; ++ii) {
+        TEST_ASSERT_TRUE(queue.update(CYCLE_MICROSECONDS));
+        TEST_ASSERT_EQUAL(DShotCommandQueue::DSHOT_CMD_EXTENDED_TELEMETRY_ENABLE, queue.getCommand());
+        TEST_ASSERT_TRUE(queue.isCommandForMotor(0));
+        TEST_ASSERT_TRUE(queue.isCommandForMotor(3));
+    }
+    TEST_ASSERT_EQUAL(1, queue.getCount());
+    // then a delay before the next command
+    TEST_ASSERT_FALSE(queue.update(CYCLE_MICROSECONDS / 2));
+    TEST_ASSERT_TRUE(queue.update(CYCLE_MICROSECONDS / 2));
+    TEST_ASSERT_EQUAL(DShotCommandQueue::DSHOT_CMD_BEACON1, queue.getCommand());
+    TEST_ASSERT_FALSE(queue.isCommandForMotor(0));
+    TEST_ASSERT_TRUE(queue.isCommandForMotor(2));
+    TEST_ASSERT_TRUE(queue.isEmpty());
+
+    // beacon is sent once, followed by a long delay
+    for (size_t ii = 0; ii < DShotCommandQueue::BEACON_DELAY_MICROSECONDS / CYCLE_MICROSECONDS; ++ii) {
+        TEST_ASSERT_FALSE(queue.update(CYCLE_MICROSECONDS));
+    }
+    TEST_ASSERT_FALSE(queue.update(CYCLE_MICROSECONDS));
+    TEST_ASSERT_TRUE(queue.isEmpty());
+
+    // queue rejects commands when full
+    for (size_t ii = 0; ii < DShotCommandQueue::QUEUE_LENGTH; ++ii) {
+        TEST_ASSERT_TRUE(queue.enqueue(DShotCommandQueue::DSHOT_CMD_BEACON2));
+    }
+    TEST_ASSERT_FALSE(queue.enqueue(DShotCommandQueue::DSHOT_CMD_BEACON3));
+    queue.clear();
+    TEST_ASSERT_TRUE(queue.isEmpty());
+}
+
+void test_dshot_bitbang_init()
+{
+    static ESC_DShotBitbang esc;
+
+    // octocopter with the motors on ports A and B
+    const std::array<ESC_DShotBitbang::port_pin_t, 8> pins = {{ {0,3}, {1,0}, {1,1}, {0,2}, {0,8}, {0,9}, {1,4}, {1,5} }};
+    TEST_ASSERT_TRUE(esc.init(&pins[0], pins.size()));
+    TEST_ASSERT_EQUAL(8, esc.getMotorCount());
+    TEST_ASSERT_EQUAL(2, esc.getPortCount());
+
+    const ESC_DShotBitbang::port_t& portA = esc.getPort(0);
+    TEST_ASSERT_EQUAL(0, portA.gpioPort);
+    TEST_ASSERT_EQUAL(4, portA.motorCount);
+    TEST_ASSERT_EQUAL_HEX32((1U << 2) | (1U << 3) | (1U << 8) | (1U << 9), portA.pinMask);
+    TEST_ASSERT_EQUAL(0, portA.motorIndices[0]);
+    TEST_ASSERT_EQUAL(3, portA.motorIndices[1]);
+    TEST_ASSERT_EQUAL(4, portA.motorIndices[2]);
+    TEST_ASSERT_EQUAL(5, portA.motorIndices[3]);
+
+    const ESC_DShotBitbang::port_t& portB = esc.getPort(1);
+    TEST_ASSERT_EQUAL(1, portB.gpioPort);
+    TEST_ASSERT_EQUAL(4, portB.motorCount);
+    TEST_ASSERT_EQUAL_HEX32((1U << 0) | (1U << 1) | (1U << 4) | (1U << 5), portB.pinMask);
+    TEST_ASSERT_EQUAL(1, portB.motorIndices[0]);
+    TEST_ASSERT_EQUAL(2, portB.motorIndices[1]);
+    TEST_ASSERT_EQUAL(6, portB.motorIndices[2]);
+    TEST_ASSERT_EQUAL(7, portB.motorIndices[3]);
+
+    // motors on too many ports are rejected
+    const std::array<ESC_DShotBitbang::port_pin_t, 3> threePorts = {{ {0,1}, {1,1}, {2,1} }};
+    TEST_ASSERT_FALSE(esc.init(&threePorts[0], threePorts.size()));
+}
+
+void test_dshot_bitbang_output_buffers()
+{
+    static ESC_DShotBitbang esc;
+
+    const std::array<ESC_DShotBitbang::port_pin_t, 2> pins = {{ {0,3}, {0,2} }};
+    TEST_ASSERT_TRUE(esc.init(&pins[0], pins.size()));
+    ESC_DShotBitbang::port_t& port = esc.getPort(0);
+
+    // preset values: each bit starts with a falling edge on all the pins
+    TEST_ASSERT_EQUAL_HEX32(((1U << 3) | (1U << 2)) << 16, port.dmaOutputBuffer[0]);
+
+    const std::array<uint16_t, 2> frames = { 0x8000, 0x0001 };
+    esc.setDMA_outputBuffers(port, &frames[0]);
+    // bidirectional DShot is inverted, the early rising edge is set for 0 bits
+    // for a 0 bit the line is low for DSHOT_BB_0_LENGTH - 1 sections, and for a 1 bit for DSHOT_BB_1_LENGTH - 1 sections
+    const size_t offset = DSHOT_BB_0_LENGTH - 1;
+    TEST_ASSERT_EQUAL_HEX32(1U << 2, port.dmaOutputBuffer[offset]);
+    for (size_t ii = 1; ii < 15; ++ii) {
+        TEST_ASSERT_EQUAL_HEX32((1U << 3) | (1U << 2), port.dmaOutputBuffer[offset + ii*DSHOT_BB_FRAME_SECTIONS]);
+    }
+    TEST_ASSERT_EQUAL_HEX32(1U << 3, port.dmaOutputBuffer[offset + 15*DSHOT_BB_FRAME_SECTIONS]);
+    // the early rising edge for 1 bits is preset
+    TEST_ASSERT_EQUAL_HEX32((1U << 3) | (1U << 2), port.dmaOutputBuffer[DSHOT_BB_1_LENGTH - 1]);
+}
+static uint32_t gcr21FromValue(uint16_t value)
+{
+    const auto frame = static_cast<uint16_t>((value << 4) | DShotCodec::checksumBidirectional(value));
+    return DShotCodec::GR20_to_GCR21(DShotCodec::eRPM_to_GCR20(frame));
+}
+
+void test_dshot_bitbang_samples_to_gcr21s()
+{
+    // four motors on the same port, with responses starting at different times
+    const std::array<uint32_t, 4> pins = { 2, 3, 8, 9 };
+    const std::array<uint16_t, 4> values = { 0x0123, 0x0FFF, 0x0456, 0x0A5A };
+    const std::array<size_t, 4> startIndices = { 12, 13, 20, 30 };
+
+    std::array<uint32_t, ESC_DShotBitbang::DMA_INPUT_BUFFER_LENGTH> samples {};
+    samples.fill(0xFFFF); // lines are idle high
+    uint32_t pinMask = 0;
+    for (size_t ii = 0; ii < pins.size(); ++ii) {
+        ESC_DShotBitbang::GCR21_to_samples(&samples[0], 1U << pins[ii], gcr21FromValue(values[ii]), startIndices[ii]);
+        pinMask |= 1U << pins[ii];
+    }
+    // pin 5 is part of the port, but its ESC has not responded
+    pinMask |= 1U << 5;
+
+    ESC_DShotBitbang::gcr21s_t gcr21s {};
+    ESC_DShotBitbang::samples_to_GCR21s(&samples[0], samples.size(), pinMask, gcr21s);
+    for (size_t ii = 0; ii < pins.size(); ++ii) {
+        TEST_ASSERT_EQUAL_HEX32(gcr21FromValue(values[ii]), gcr21s[pins[ii]]);
+        TEST_ASSERT_EQUAL_HEX32(ESC_DShotBitbang::samples_to_GCR21(&samples[0], 1U << pins[ii]), gcr21s[pins[ii]]);
+        TEST_ASSERT_EQUAL_HEX16(values[ii] << 4 | DShotCodec::checksumBidirectional(values[ii]), DShotCodec::GCR20_to_eRPM(DShotCodec::GCR21_to_GCR20(gcr21s[pins[ii]])));
+    }
+    TEST_ASSERT_EQUAL_HEX32(0xFFFFFFFF, gcr21s[5]);
+    TEST_ASSERT_EQUAL_HEX32(ESC_DShotBitbang::samples_to_GCR21(&samples[0], 1U << 5), gcr21s[5]);
+    // pins not in the mask are not decoded
+    TEST_ASSERT_EQUAL_HEX32(0xFFFFFFFF, gcr21s[0]);
+
+    // all values, 8 motors on the port
+    for (uint16_t value = 0; value < 4096; value += 8) {
+        samples.fill(0xFFFF);
+        for (uint32_t pin = 0; pin < 8; ++pin) {
+            ESC_DShotBitbang::GCR21_to_samples(&samples[0], 1U << pin, gcr21FromValue(static_cast<uint16_t>(value + pin)), 12 + pin);
+        }
+        ESC_DShotBitbang::samples_to_GCR21s(&samples[0], samples.size(), 0xFF, gcr21s);
+        for (uint32_t pin = 0; pin < 8; ++pin) {
+            TEST_ASSERT_EQUAL_HEX32(ESC_DShotBitbang::samples_to_GCR21(&samples[0], 1U << pin), gcr21s[pin]);
+            TEST_ASSERT_EQUAL_HEX32(gcr21FromValue(static_cast<uint16_t>(value + pin)), gcr21s[pin]);
+        }
+    }
+}
+
+static void assertDecodes(const std::array<uint32_t, ESC_DShotBitbang::DMA_INPUT_BUFFER_LENGTH>& samples, uint32_t pin, uint32_t expected)
+{
+    ESC_DShotBitbang::gcr21s_t gcr21s {};
+    ESC_DShotBitbang::samples_to_GCR21s(&samples[0], samples.size(), 1U << pin, gcr21s);
+    TEST_ASSERT_EQUAL_HEX32(expected, gcr21s[pin]);
+    TEST_ASSERT_EQUAL_HEX32(expected, ESC_DShotBitbang::samples_to_GCR21(&samples[0], 1U << pin));
+}
+
+void test_dshot_bitbang_decode_shifted_edges()
+{
+    // the ESC clock is not synchronized with the sampling, so any edge may be sampled one sample early or late
+    enum { PIN = 4, START_INDEX = ESC_DShotBitbang::RESPONSE_START_INDEX };
+    const size_t endIndex = START_INDEX + BDSHOT_RESPONSE_LENGTH * ESC_DShotBitbang::RESPONSE_OVERSAMPLING;
+    std::array<uint32_t, ESC_DShotBitbang::DMA_INPUT_BUFFER_LENGTH> samples {};
+    for (uint16_t value = 0; value < 4096; value += 3) {
+        const uint32_t gcr21 = gcr21FromValue(value);
+        samples.fill(0xFFFF);
+        ESC_DShotBitbang::GCR21_to_samples(&samples[0], 1U << PIN, gcr21, START_INDEX);
+        for (size_t edge = START_INDEX + 1; edge < endIndex; ++edge) {
+            if (samples[edge] == samples[edge - 1]) {
+                continue;
+            }
+            // edge one sample late
+            std::array<uint32_t, ESC_DShotBitbang::DMA_INPUT_BUFFER_LENGTH> shifted = samples;
+            shifted[edge] = shifted[edge - 1];
+            assertDecodes(shifted, PIN, gcr21);
+            // edge one sample early
+            shifted = samples;
+            shifted[edge - 1] = shifted[edge];
+            assertDecodes(shifted, PIN, gcr21);
+        }
+    }
+}
+
+void test_dshot_bitbang_decode_glitches()
+{
+    // a single sample with the wrong value, anywhere in the response or in the idle period before it, is ignored
+    enum { PIN = 7, START_INDEX = 20 };
+    const size_t endIndex = START_INDEX + BDSHOT_RESPONSE_LENGTH * ESC_DShotBitbang::RESPONSE_OVERSAMPLING;
+    std::array<uint32_t, ESC_DShotBitbang::DMA_INPUT_BUFFER_LENGTH> samples {};
+    for (uint16_t value = 0; value < 4096; value += 5) {
+        const uint32_t gcr21 = gcr21FromValue(value);
+        samples.fill(0xFFFF);
+        ESC_DShotBitbang::GCR21_to_samples(&samples[0], 1U << PIN, gcr21, START_INDEX);
+        for (size_t index = 1; index < endIndex; ++index) {
+            std::array<uint32_t, ESC_DShotBitbang::DMA_INPUT_BUFFER_LENGTH> glitched = samples;
+            glitched[index] ^= 1U << PIN;
+            assertDecodes(glitched, PIN, gcr21);
+        }
+    }
+    // a glitch on the idle line, with no response, is not taken as the start of a response
+    samples.fill(0xFFFF);
+    samples[START_INDEX] &= ~(1U << PIN);
+    assertDecodes(samples, PIN, 0xFFFFFFFF);
+}
 // NOLINTEND(cppcoreguidelines-avoid-magic-numbers,cppcoreguidelines-init-variables,cppcoreguidelines-pro-bounds-pointer-arithmetic,hicpp-signed-bitwise,readability-magic-numbers)
 
 // See for example for testing GCR encoding https://github.com/betaflight/betaflight/pull/8554#issuecomment-512507625
@@ -215,6 +564,16 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
     RUN_TEST(test_dshot_init);
     RUN_TEST(test_dshot_write);
     RUN_TEST(test_dshot_write_channel_b);
+    RUN_TEST(test_dshot_batch_init);
+    RUN_TEST(test_dshot_batch_write);
+    RUN_TEST(test_dshot_telemetry_received);
+    RUN_TEST(test_dshot_extended_telemetry);
+    RUN_TEST(test_dshot_command_queue);
+    RUN_TEST(test_dshot_bitbang_init);
+    RUN_TEST(test_dshot_bitbang_output_buffers);
+    RUN_TEST(test_dshot_bitbang_samples_to_gcr21s);
+    RUN_TEST(test_dshot_bitbang_decode_shifted_edges);
+    RUN_TEST(test_dshot_bitbang_decode_glitches);
 
     UNITY_END();
 }
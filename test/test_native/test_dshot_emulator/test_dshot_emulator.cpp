@@ -0,0 +1,547 @@
+#include <DShotCodec.h>
+#include <DShotCommandQueue.h>
+#include <Debug.h>
+#include <DynamicIdleController.h>
+#include <ESC_DShot.h>
+#include <ESC_DShotBitbang.h>
+#include <ESC_DShotEmulator.h>
+#include <IMU_Filters.h> // test code won't build if this not included
+#include <MotorMixerMatrixDShot.h>
+#include <MotorMixerQuadX_DShot.h>
+#include <MotorMixerQuadX_DShotBitbang.h>
+#include <RPM_Filters.h>
+#include <RPM_Limiter.h>
+#include <array>
+#include <unity.h>
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,cppcoreguidelines-init-variables,cppcoreguidelines-pro-bounds-constant-array-index,cppcoreguidelines-pro-bounds-pointer-arithmetic,hicpp-signed-bitwise,readability-magic-numbers)
+void test_emulator_telemetry_value()
+{
+    TEST_ASSERT_EQUAL_HEX16(0x0FFF, ESC_DShotEmulator::eRPM_toTelemetryValue(0));
+    // 60000000 / 300000 = 200us, fits in the mantissa
+    TEST_ASSERT_EQUAL_HEX16(200, ESC_DShotEmulator::eRPM_toTelemetryValue(300000));
+    // 60000000 / 84000 = 714us = 357 << 1
+    TEST_ASSERT_EQUAL_HEX16((1U << 9) | 357, ESC_DShotEmulator::eRPM_toTelemetryValue(84000));
+
+    DShotCodec::telemetry_type_e telemetryType {};
+    TEST_ASSERT_EQUAL(714, DShotCodec::decodeTelemetryFrame(ESC_DShotEmulator::eRPM_toTelemetryValue(84000), telemetryType));
+    TEST_ASSERT_EQUAL(DShotCodec::TELEMETRY_TYPE_ERPM, telemetryType);
+}
+
+void test_emulator_pulse_widths()
+{
+    ESC_DShot esc(ESC_DShot::ESC_PROTOCOL_DSHOT300);
+    ESC_DShotEmulator emulator;
+
+    esc.write(1000);
+    TEST_ASSERT_EQUAL(ESC_DShotEmulator::FRAME_OK, emulator.receivePulseWidths(esc.getBuffer(), esc.getBufferSize(), esc.getWrapCycleCount()));
+    TEST_ASSERT_EQUAL(1000, emulator.getThrottle());
+    TEST_ASSERT_FALSE(emulator.getTelemetryRequest());
+    TEST_ASSERT_EQUAL(1, emulator.getFrameCount());
+
+    esc.setUseHighOrderBits(true);
+    esc.write(2047);
+    TEST_ASSERT_EQUAL(ESC_DShotEmulator::FRAME_OK, emulator.receivePulseWidths(esc.getBuffer(), esc.getBufferSize(), esc.getWrapCycleCount(), 16));
+    TEST_ASSERT_EQUAL(2047, emulator.getThrottle());
+    esc.setUseHighOrderBits(false);
+
+    // special command, sent with the telemetry request bit set
+    TEST_ASSERT_FALSE(emulator.isExtendedTelemetryEnabled());
+    esc.write(DShotCommandQueue::DSHOT_CMD_EXTENDED_TELEMETRY_ENABLE | DShotCodec::TELEMETRY_REQUEST);
+    TEST_ASSERT_EQUAL(ESC_DShotEmulator::FRAME_OK, emulator.receivePulseWidths(esc.getBuffer(), esc.getBufferSize(), esc.getWrapCycleCount()));
+    TEST_ASSERT_TRUE(emulator.getTelemetryRequest());
+    TEST_ASSERT_EQUAL(DShotCommandQueue::DSHOT_CMD_EXTENDED_TELEMETRY_ENABLE, emulator.getLastCommand());
+    TEST_ASSERT_TRUE(emulator.isExtendedTelemetryEnabled());
+
+    // pulse that is neither a 0 nor a 1
+    esc.write(1000);
+    std::array<uint32_t, 17> buffer {};
+    for (size_t ii = 0; ii < buffer.size(); ++ii) {
+        buffer[ii] = esc.getBufferItem(ii);
+    }
+    buffer[3] = esc.getWrapCycleCount() / 2;
+    TEST_ASSERT_EQUAL(ESC_DShotEmulator::FRAME_TIMING_ERROR, emulator.receivePulseWidths(&buffer[0], buffer.size(), esc.getWrapCycleCount()));
+    // missing terminating zero
+    buffer[3] = esc.getBufferItem(3);
+    buffer[16] = esc.getDataLowPulseWidth();
+    TEST_ASSERT_EQUAL(ESC_DShotEmulator::FRAME_TIMING_ERROR, emulator.receivePulseWidths(&buffer[0], buffer.size(), esc.getWrapCycleCount()));
+    TEST_ASSERT_EQUAL(2, emulator.getTimingErrorCount());
+    // flipped bit
+    buffer[16] = 0;
+    buffer[3] = buffer[3] == esc.getDataLowPulseWidth() ? esc.getDataHighPulseWidth() : esc.getDataLowPulseWidth();
+    TEST_ASSERT_EQUAL(ESC_DShotEmulator::FRAME_CHECKSUM_ERROR, emulator.receivePulseWidths(&buffer[0], buffer.size(), esc.getWrapCycleCount()));
+    TEST_ASSERT_EQUAL(1, emulator.getChecksumErrorCount());
+    TEST_ASSERT_EQUAL(3, emulator.getFrameCount());
+}
+
+void test_emulator_bitbang_output()
+{
+    static ESC_DShotBitbang esc;
+    const std::array<ESC_DShotBitbang::port_pin_t, 2> pins = {{ {0,3}, {0,2} }};
+    TEST_ASSERT_TRUE(esc.init(&pins[0], pins.size()));
+    ESC_DShotBitbang::port_t& port = esc.getPort(0);
+    std::array<ESC_DShotEmulator, 2> emulators {};
+
+    const std::array<uint16_t, 2> values = { 48, 1500 | DShotCodec::TELEMETRY_REQUEST };
+    esc.outputToMotors(&values[0]);
+    for (size_t ii = 0; ii < emulators.size(); ++ii) {
+        TEST_ASSERT_EQUAL(ESC_DShotEmulator::FRAME_OK, emulators[ii].receiveBitbang(&port.dmaOutputBuffer[0], port.dmaOutputBuffer.size(), pins[ii].pin));
+    }
+    TEST_ASSERT_EQUAL(48, emulators[0].getThrottle());
+    TEST_ASSERT_FALSE(emulators[0].getTelemetryRequest());
+    TEST_ASSERT_EQUAL(1500, emulators[1].getThrottle());
+    TEST_ASSERT_TRUE(emulators[1].getTelemetryRequest());
+
+    // a pin that is not driven has no frame
+    ESC_DShotEmulator emulator;
+    TEST_ASSERT_EQUAL(ESC_DShotEmulator::FRAME_TIMING_ERROR, emulator.receiveBitbang(&port.dmaOutputBuffer[0], port.dmaOutputBuffer.size(), 4));
+}
+
+void test_emulator_pio_telemetry_loop()
+{
+    ESC_DShot esc(ESC_DShot::ESC_PROTOCOL_DSHOT300);
+    ESC_DShotEmulator emulator;
+    emulator.setMotorRPM(12000);
+    emulator.setTemperatureCelsius(45);
+    emulator.setVoltageCentiVolts(1625);
+    emulator.setCurrentCentiAmps(1200);
+
+    for (uint32_t ii = 0; ii < 100; ++ii) {
+        esc.write(1000);
+        TEST_ASSERT_EQUAL(ESC_DShotEmulator::FRAME_OK, emulator.receivePulseWidths(esc.getBuffer(), esc.getBufferSize(), esc.getWrapCycleCount()));
+        esc.telemetryReceived(emulator.nextReplyPIO_Samples(), ii*1000);
+        TEST_ASSERT_TRUE(esc.read());
+    }
+    TEST_ASSERT_EQUAL(0, esc.getTelemetryErrorCount());
+    TEST_ASSERT_EQUAL(100, esc.getTelemetryReadCount());
+    // eRPM period is quantized to 2us at this speed
+    TEST_ASSERT_INT32_WITHIN(10, 12000, esc.getMotorRPM());
+    TEST_ASSERT_FLOAT_WITHIN(0.2F, 200.0F, esc.getMotorHz());
+    // no EDT until it has been enabled
+    TEST_ASSERT_EQUAL(0, esc.getTelemetry().temperatureCelsius);
+
+    esc.write(DShotCommandQueue::DSHOT_CMD_EXTENDED_TELEMETRY_ENABLE | DShotCodec::TELEMETRY_REQUEST);
+    emulator.receivePulseWidths(esc.getBuffer(), esc.getBufferSize(), esc.getWrapCycleCount());
+    for (uint32_t ii = 0; ii < 3*ESC_DShotEmulator::EDT_FRAME_INTERVAL; ++ii) {
+        esc.telemetryReceived(emulator.nextReplyPIO_Samples(), ii*1000);
+        esc.read();
+    }
+    const esc_telemetry_t telemetry = esc.getTelemetry();
+    TEST_ASSERT_EQUAL(45, telemetry.temperatureCelsius);
+    TEST_ASSERT_EQUAL(1625, telemetry.voltageCentiVolts);
+    TEST_ASSERT_EQUAL(1200, telemetry.currentCentiAmps);
+    TEST_ASSERT_INT32_WITHIN(10, 12000, telemetry.rpm);
+    TEST_ASSERT_EQUAL(0, telemetry.errorCount);
+
+    // corrupted replies are counted as errors, and do not change the RPM
+    emulator.setBitErrorInterval(4);
+    uint32_t readCount = esc.getTelemetryReadCount();
+    for (uint32_t ii = 0; ii < 200; ++ii) {
+        esc.telemetryReceived(emulator.nextReplyPIO_Samples(), ii*1000);
+        esc.read();
+        TEST_ASSERT_INT32_WITHIN(10, 12000, esc.getMotorRPM());
+    }
+    TEST_ASSERT_EQUAL(readCount + 200, esc.getTelemetryReadCount());
+    TEST_ASSERT_TRUE(emulator.getCorruptedReplyCount() > 0);
+    TEST_ASSERT_TRUE(esc.getTelemetryErrorCount() > 0);
+    TEST_ASSERT_TRUE(esc.getTelemetryErrorCount() <= emulator.getCorruptedReplyCount());
+
+    // edge jitter also causes errors
+    emulator.setBitErrorInterval(0);
+    emulator.setJitterSamples(1);
+    readCount = esc.getTelemetryReadCount();
+    const uint32_t errorCount = esc.getTelemetryErrorCount();
+    for (uint32_t ii = 0; ii < 200; ++ii) {
+        esc.telemetryReceived(emulator.nextReplyPIO_Samples(), ii*1000);
+        esc.read();
+    }
+    TEST_ASSERT_EQUAL(readCount + 200, esc.getTelemetryReadCount());
+    TEST_ASSERT_TRUE(esc.getTelemetryErrorCount() > errorCount);
+}
+
+void test_emulator_bitbang_telemetry_loop()
+{
+    static ESC_DShotBitbang esc;
+    const std::array<ESC_DShotBitbang::port_pin_t, 4> pins = {{ {0,3}, {0,2}, {0,8}, {0,9} }};
+    TEST_ASSERT_TRUE(esc.init(&pins[0], pins.size()));
+    ESC_DShotBitbang::port_t& port = esc.getPort(0);
+
+    std::array<ESC_DShotEmulator, 4> emulators {};
+    const std::array<int32_t, 4> rpms = { 6000, 12000, 18000, 24000 };
+    for (size_t ii = 0; ii < emulators.size(); ++ii) {
+        emulators[ii].setMotorRPM(rpms[ii]);
+        emulators[ii].setSeed(static_cast<uint32_t>(ii + 1));
+    }
+
+    const std::array<uint16_t, 4> values = { 1000, 1000, 1000, 1000 };
+    for (uint32_t loop = 0; loop < 50; ++loop) {
+        // outputToMotors decodes the replies to the previous frames, and then writes the new frames
+        esc.outputToMotors(&values[0]);
+        port.dmaInputBuffer.fill(0xFFFF);
+        for (size_t ii = 0; ii < emulators.size(); ++ii) {
+            TEST_ASSERT_EQUAL(ESC_DShotEmulator::FRAME_OK, emulators[ii].receiveBitbang(&port.dmaOutputBuffer[0], port.dmaOutputBuffer.size(), pins[ii].pin));
+            // the delay before each motor's reply varies
+            const size_t startIndex = ESC_DShotBitbang::RESPONSE_START_INDEX + (loop + 3*ii) % 8;
+            emulators[ii].nextReplyBitbangSamples(&port.dmaInputBuffer[0], port.dmaInputBuffer.size(), 1U << pins[ii].pin, startIndex);
+        }
+    }
+    esc.update_motors_rpm();
+    for (size_t ii = 0; ii < emulators.size(); ++ii) {
+        TEST_ASSERT_EQUAL(1000, emulators[ii].getThrottle());
+        // the first call to outputToMotors decoded the empty input buffer, so each motor has one error for the missing reply
+        TEST_ASSERT_EQUAL(1, esc.getMotorErrorCount(ii));
+        // eRPM = RPM * 7 for a 14 pole motor
+        TEST_ASSERT_INT32_WITHIN(rpms[ii]*7/100, rpms[ii]*7, esc.getMotorERPM(ii));
+    }
+
+    // bit errors on one motor are detected and do not affect the other motors
+    emulators[1].setBitErrorInterval(2);
+    for (uint32_t loop = 0; loop < 50; ++loop) {
+        port.dmaInputBuffer.fill(0xFFFF);
+        for (size_t ii = 0; ii < emulators.size(); ++ii) {
+            emulators[ii].nextReplyBitbangSamples(&port.dmaInputBuffer[0], port.dmaInputBuffer.size(), 1U << pins[ii].pin, ESC_DShotBitbang::RESPONSE_START_INDEX);
+        }
+        esc.update_motors_rpm();
+    }
+    TEST_ASSERT_TRUE(esc.getMotorErrorCount(1) > 1);
+    TEST_ASSERT_TRUE(esc.getMotorErrorCount(1) <= emulators[1].getCorruptedReplyCount() + 1);
+    TEST_ASSERT_EQUAL(1, esc.getMotorErrorCount(0));
+    TEST_ASSERT_EQUAL(1, esc.getMotorErrorCount(2));
+    TEST_ASSERT_EQUAL(1, esc.getMotorErrorCount(3));
+    TEST_ASSERT_INT32_WITHIN(12000*7/100, 12000*7, esc.getMotorERPM(1));
+}
+
+void test_emulator_mixer_rpm_filters()
+{
+    enum { MOTOR_COUNT = 4 };
+    enum { TASK_INTERVAL_MICROSECONDS = 1000 };
+    const DynamicIdleController::config_t dynamicIdleControllerConfig = {
+        .dyn_idle_min_rpm_100 = 0,
+        .dyn_idle_p_gain = 50,
+        .dyn_idle_i_gain = 50,
+        .dyn_idle_d_gain = 50,
+        .dyn_idle_max_increase = 150,
+    };
+    static Debug debug;
+    static RPM_Filters rpmFilters(MOTOR_COUNT, TASK_INTERVAL_MICROSECONDS);
+    rpmFilters.init(RPM_Filters::USE_FUNDAMENTAL_ONLY, 500.0F);
+    static DynamicIdleController dynamicIdleController(dynamicIdleControllerConfig, TASK_INTERVAL_MICROSECONDS, debug);
+    static MotorMixerQuadX_DShot mixer(debug, MotorMixerQuadX_Base::pins_t{.br=0,.fr=1,.bl=2,.fl=3}, rpmFilters, dynamicIdleController);
+    const float deltaT = static_cast<float>(TASK_INTERVAL_MICROSECONDS) * 0.000001F;
+    const MotorMixerBase::commands_t commands { .throttle = 0.0F, .roll = 0.0F, .pitch = 0.0F, .yaw = 0.0F };
+
+    // each motor spins at a different speed: 150Hz, 200Hz, 250Hz, 300Hz
+    const std::array<int32_t, MOTOR_COUNT> motorRPMs = { 9000, 12000, 15000, 18000 };
+    std::array<ESC_DShotEmulator, MOTOR_COUNT> emulators {};
+    for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+        emulators[ii].setMotorRPM(motorRPMs[ii]);
+    }
+
+    // no telemetry received yet, so the notches are faded out
+    mixer.outputToMotors(commands, deltaT, 0);
+    for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+        TEST_ASSERT_EQUAL_FLOAT(0.0F, rpmFilters.getWeight(ii));
+    }
+
+    // each notch tracks its own motor
+    for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+        mixer.getESC(ii).telemetryReceived(emulators[ii].nextReplyPIO_Samples(), 0);
+    }
+    mixer.outputToMotors(commands, deltaT, 0);
+    for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+        const float motorHz = static_cast<float>(motorRPMs[ii]) / 60.0F;
+        TEST_ASSERT_FLOAT_WITHIN(1.0F, motorHz, mixer.getMotorFrequencyHz(ii));
+        TEST_ASSERT_FLOAT_WITHIN(1.0F, motorHz, rpmFilters.getFrequencyHz(ii));
+        TEST_ASSERT_EQUAL_FLOAT(1.0F, rpmFilters.getWeight(ii));
+        TEST_ASSERT_INT32_WITHIN(100, motorRPMs[ii], mixer.getMotorRPM(ii));
+    }
+
+    // telemetry from MOTOR_FL is lost: its notch fades out, rather than sitting on a stale frequency
+    const size_t lostMotor = MotorMixerQuadX_Base::MOTOR_FL;
+    for (uint32_t loop = 1; loop <= ESC_TelemetryValidity::DEFAULT_FADE_END_AGE; ++loop) {
+        for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+            if (ii != lostMotor) {
+                mixer.getESC(ii).telemetryReceived(emulators[ii].nextReplyPIO_Samples(), 0);
+            }
+        }
+        mixer.outputToMotors(commands, deltaT, 0);
+        if (loop == ESC_TelemetryValidity::DEFAULT_FADE_START_AGE) {
+            TEST_ASSERT_EQUAL_FLOAT(1.0F, rpmFilters.getWeight(lostMotor));
+        } else if (loop == ESC_TelemetryValidity::DEFAULT_FADE_START_AGE + 1) {
+            TEST_ASSERT_TRUE(rpmFilters.getWeight(lostMotor) < 1.0F);
+            TEST_ASSERT_TRUE(rpmFilters.getWeight(lostMotor) > 0.0F);
+        }
+    }
+    TEST_ASSERT_EQUAL(ESC_TelemetryValidity::DEFAULT_FADE_END_AGE, mixer.getESC(lostMotor).getTelemetryValidity().getAge());
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, rpmFilters.getWeight(lostMotor));
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, mixer.getMotorFrequencyWeight(lostMotor));
+    for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+        if (ii != lostMotor) {
+            TEST_ASSERT_EQUAL_FLOAT(1.0F, rpmFilters.getWeight(ii));
+            TEST_ASSERT_FLOAT_WITHIN(1.0F, static_cast<float>(motorRPMs[ii]) / 60.0F, rpmFilters.getFrequencyHz(ii));
+        }
+    }
+
+    // telemetry recovers
+    mixer.getESC(lostMotor).telemetryReceived(emulators[lostMotor].nextReplyPIO_Samples(), 0);
+    mixer.outputToMotors(commands, deltaT, 0);
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, rpmFilters.getWeight(lostMotor));
+
+    // MOTOR_BR has a high telemetry error rate: a frame that cannot be decoded is interleaved with every good frame
+    const size_t noisyMotor = MotorMixerQuadX_Base::MOTOR_BR;
+    for (int loop = 0; loop < 100; ++loop) {
+        mixer.getESC(noisyMotor).telemetryReceived(0, 0);
+        mixer.getESC(noisyMotor).telemetryReceived(0, 0);
+        for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+            mixer.getESC(ii).telemetryReceived(emulators[ii].nextReplyPIO_Samples(), 0);
+        }
+        mixer.outputToMotors(commands, deltaT, 0);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.05F, 2.0F / 3.0F, mixer.getESC(noisyMotor).getTelemetryValidity().getErrorRate());
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, rpmFilters.getWeight(noisyMotor));
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, rpmFilters.getWeight(MotorMixerQuadX_Base::MOTOR_FR));
+}
+
+void test_emulator_matrix_mixer_rpm_limiter()
+{
+    enum { MOTOR_COUNT = 4 };
+    enum { TASK_INTERVAL_MICROSECONDS = 1000 };
+    const DynamicIdleController::config_t dynamicIdleControllerConfig = {
+        .dyn_idle_min_rpm_100 = 0,
+        .dyn_idle_p_gain = 50,
+        .dyn_idle_i_gain = 50,
+        .dyn_idle_d_gain = 50,
+        .dyn_idle_max_increase = 150,
+    };
+    const RPM_Limiter::config_t rpmLimiterConfig = {
+        .rpm_limit = 12000, // 200Hz
+        .rpm_limit_p_gain = 50,
+        .rpm_limit_i_gain = 0,
+        .rpm_limit_d_gain = 0,
+    };
+    static Debug debug;
+    static RPM_Filters rpmFilters(MOTOR_COUNT, TASK_INTERVAL_MICROSECONDS);
+    rpmFilters.init(RPM_Filters::USE_FUNDAMENTAL_ONLY, 500.0F);
+    static DynamicIdleController dynamicIdleController(dynamicIdleControllerConfig, TASK_INTERVAL_MICROSECONDS, debug);
+    static RPM_Limiter rpmLimiter(rpmLimiterConfig, TASK_INTERVAL_MICROSECONDS, debug);
+    typedef MotorMixerMatrixDShot<MOTOR_COUNT> motor_mixer_t;
+    static motor_mixer_t mixer(MotorMixMatrices::QUAD_X, debug, motor_mixer_t::pins_t{0, 1, 2, 3}, rpmFilters, dynamicIdleController);
+    mixer.setRPM_Limiter(&rpmLimiter);
+    const float deltaT = static_cast<float>(TASK_INTERVAL_MICROSECONDS) * 0.000001F;
+    const MotorMixerBase::commands_t commands { .throttle = 0.5F, .roll = 0.0F, .pitch = 0.0F, .yaw = 0.0F };
+
+    // all motors at 15000 RPM, ie 250Hz
+    std::array<ESC_DShotEmulator, MOTOR_COUNT> emulators {};
+    for (auto& emulator : emulators) {
+        emulator.setMotorRPM(15000);
+    }
+
+    mixer.motorsSwitchOn();
+    for (int loop = 0; loop < 2; ++loop) {
+        for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+            mixer.getESC(ii).telemetryReceived(emulators[ii].nextReplyPIO_Samples(), 0);
+        }
+        mixer.outputToMotors(commands, deltaT, 0);
+    }
+    // the telemetry is passed to the RPM filters, as for the QuadX mixer
+    for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+        TEST_ASSERT_FLOAT_WITHIN(1.0F, 250.0F, rpmFilters.getFrequencyHz(ii));
+        TEST_ASSERT_EQUAL_FLOAT(1.0F, rpmFilters.getWeight(ii));
+        TEST_ASSERT_TRUE(mixer.getMotorSpeedPredictor().getPredictedHz(ii) > 0.0F);
+    }
+    // average motor speed 50Hz over the limit, so throttle scaled by 1 - 50*0.0075
+    TEST_ASSERT_FLOAT_WITHIN(0.01F, 0.5F * 0.625F, mixer.getThrottleCommand());
+
+    // motors off: the throttle is not scaled
+    mixer.motorsSwitchOff();
+    mixer.outputToMotors(commands, deltaT, 0);
+    TEST_ASSERT_EQUAL_FLOAT(0.5F, mixer.getThrottleCommand());
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, mixer.getMotorOutput(0));
+}
+
+void test_emulator_bitbang_mixer_rpm_filters()
+{
+    enum { MOTOR_COUNT = 4 };
+    enum { TASK_INTERVAL_MICROSECONDS = 1000 };
+    const DynamicIdleController::config_t dynamicIdleControllerConfig = {
+        .dyn_idle_min_rpm_100 = 0,
+        .dyn_idle_p_gain = 50,
+        .dyn_idle_i_gain = 50,
+        .dyn_idle_d_gain = 50,
+        .dyn_idle_max_increase = 150,
+    };
+    static Debug debug;
+    static RPM_Filters rpmFilters(MOTOR_COUNT, TASK_INTERVAL_MICROSECONDS);
+    rpmFilters.init(RPM_Filters::USE_FUNDAMENTAL_ONLY, 500.0F);
+    static DynamicIdleController dynamicIdleController(dynamicIdleControllerConfig, TASK_INTERVAL_MICROSECONDS, debug);
+    // all the motors on GPIOA
+    const MotorMixerQuadX_Base::port_pins_t pins = { .br={0,3}, .fr={0,2}, .bl={0,8}, .fl={0,9} };
+    static MotorMixerQuadX_DShotBitbang mixer(debug, pins, rpmFilters, dynamicIdleController);
+    ESC_DShotBitbang::port_t& port = mixer.getESC().getPort(0);
+    const std::array<uint32_t, MOTOR_COUNT> motorPins = { pins.br.pin, pins.fr.pin, pins.bl.pin, pins.fl.pin };
+    const float deltaT = static_cast<float>(TASK_INTERVAL_MICROSECONDS) * 0.000001F;
+    const MotorMixerBase::commands_t commands { .throttle = 0.0F, .roll = 0.0F, .pitch = 0.0F, .yaw = 0.0F };
+
+    const std::array<int32_t, MOTOR_COUNT> motorRPMs = { 9000, 12000, 15000, 18000 };
+    std::array<ESC_DShotEmulator, MOTOR_COUNT> emulators {};
+    for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+        emulators[ii].setMotorRPM(motorRPMs[ii]);
+    }
+    const size_t lostMotor = MotorMixerQuadX_Base::MOTOR_FL;
+    auto reply = [&](bool lostMotorReplies) {
+        port.dmaInputBuffer.fill(0xFFFF);
+        for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+            if (ii != lostMotor || lostMotorReplies) {
+                emulators[ii].nextReplyBitbangSamples(&port.dmaInputBuffer[0], port.dmaInputBuffer.size(), 1U << motorPins[ii], ESC_DShotBitbang::RESPONSE_START_INDEX);
+            }
+        }
+    };
+
+    // no replies yet, so the notches are faded out
+    port.dmaInputBuffer.fill(0xFFFF);
+    mixer.outputToMotors(commands, deltaT, 0);
+    for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+        TEST_ASSERT_EQUAL_FLOAT(0.0F, rpmFilters.getWeight(ii));
+        TEST_ASSERT_EQUAL_FLOAT(0.0F, mixer.getMotorFrequencyWeight(ii));
+    }
+
+    // the replies are decoded by the next call to outputToMotors, and each notch tracks its own motor
+    reply(true);
+    mixer.outputToMotors(commands, deltaT, 0);
+    for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+        const float motorHz = static_cast<float>(motorRPMs[ii]) / 60.0F;
+        TEST_ASSERT_TRUE(mixer.getESC().isTelemetryReceived(ii));
+        TEST_ASSERT_FLOAT_WITHIN(1.0F, motorHz, mixer.getMotorFrequencyHz(ii));
+        TEST_ASSERT_FLOAT_WITHIN(1.0F, motorHz, rpmFilters.getFrequencyHz(ii));
+        TEST_ASSERT_EQUAL_FLOAT(1.0F, rpmFilters.getWeight(ii));
+        TEST_ASSERT_EQUAL_FLOAT(1.0F, mixer.getMotorFrequencyWeight(ii));
+        TEST_ASSERT_INT32_WITHIN(100, motorRPMs[ii], mixer.getMotorRPM(ii));
+    }
+
+    // MOTOR_FL stops replying: its notch fades out, rather than sitting on a stale frequency
+    for (uint32_t loop = 0; loop < ESC_TelemetryValidity::DEFAULT_FADE_END_AGE; ++loop) {
+        reply(false);
+        mixer.outputToMotors(commands, deltaT, 0);
+    }
+    TEST_ASSERT_FALSE(mixer.getESC().isTelemetryReceived(lostMotor));
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, rpmFilters.getWeight(lostMotor));
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, mixer.getMotorFrequencyWeight(lostMotor));
+    for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+        if (ii != lostMotor) {
+            TEST_ASSERT_EQUAL_FLOAT(1.0F, rpmFilters.getWeight(ii));
+        }
+    }
+
+    // telemetry recovers: each missing reply counted as an error, so the notch fades back in as the error rate falls
+    reply(true);
+    mixer.outputToMotors(commands, deltaT, 0);
+    TEST_ASSERT_TRUE(mixer.getESC().isTelemetryReceived(lostMotor));
+    TEST_ASSERT_FLOAT_WITHIN(1.0F, static_cast<float>(motorRPMs[lostMotor]) / 60.0F, rpmFilters.getFrequencyHz(lostMotor));
+    float previousWeight = rpmFilters.getWeight(lostMotor);
+    for (uint32_t loop = 0; loop < 50; ++loop) {
+        reply(true);
+        mixer.outputToMotors(commands, deltaT, 0);
+        TEST_ASSERT_TRUE(rpmFilters.getWeight(lostMotor) >= previousWeight);
+        previousWeight = rpmFilters.getWeight(lostMotor);
+    }
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, rpmFilters.getWeight(lostMotor));
+
+    // with the motors on, the MotorSpeedPredictor used by dynamic idle tracks the telemetry
+    const MotorMixerBase::commands_t hoverCommands { .throttle = 0.5F, .roll = 0.0F, .pitch = 0.0F, .yaw = 0.0F };
+    mixer.motorsSwitchOn();
+    for (uint32_t loop = 0; loop < 20; ++loop) {
+        reply(true);
+        mixer.outputToMotors(hoverCommands, deltaT, 0);
+    }
+    for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+        const float motorHz = static_cast<float>(motorRPMs[ii]) / 60.0F;
+        TEST_ASSERT_FLOAT_WITHIN(motorHz * 0.1F, motorHz, mixer.getMotorSpeedPredictor().getPredictedHz(ii));
+    }
+    // throttle chop: the predicted speeds fall before the telemetry, which lags the motor output, does
+    reply(true);
+    mixer.outputToMotors(commands, deltaT, 0);
+    for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+        TEST_ASSERT_TRUE(mixer.getMotorSpeedPredictor().getPredictedHz(ii) < mixer.getMotorFrequencyHz(ii));
+    }
+    mixer.motorsSwitchOff();
+}
+
+void test_emulator_bitbang_mixer_dshot_commands()
+{
+    enum { MOTOR_COUNT = 4 };
+    enum { TASK_INTERVAL_MICROSECONDS = 1000 };
+    const DynamicIdleController::config_t dynamicIdleControllerConfig = {
+        .dyn_idle_min_rpm_100 = 0,
+        .dyn_idle_p_gain = 50,
+        .dyn_idle_i_gain = 50,
+        .dyn_idle_d_gain = 50,
+        .dyn_idle_max_increase = 150,
+    };
+    static Debug debug;
+    static RPM_Filters rpmFilters(MOTOR_COUNT, TASK_INTERVAL_MICROSECONDS);
+    static DynamicIdleController dynamicIdleController(dynamicIdleControllerConfig, TASK_INTERVAL_MICROSECONDS, debug);
+    const MotorMixerQuadX_Base::port_pins_t pins = { .br={0,3}, .fr={0,2}, .bl={0,8}, .fl={0,9} };
+    static MotorMixerQuadX_DShotBitbang mixer(debug, pins, rpmFilters, dynamicIdleController);
+    const ESC_DShotBitbang::port_t& port = mixer.getESC().getPort(0);
+    const std::array<uint32_t, MOTOR_COUNT> motorPins = { pins.br.pin, pins.fr.pin, pins.bl.pin, pins.fl.pin };
+    const float deltaT = static_cast<float>(TASK_INTERVAL_MICROSECONDS) * 0.000001F;
+    const MotorMixerBase::commands_t commands { .throttle = 0.0F, .roll = 0.0F, .pitch = 0.0F, .yaw = 0.0F };
+    std::array<ESC_DShotEmulator, MOTOR_COUNT> emulators {};
+    auto output = [&]() {
+        mixer.outputToMotors(commands, deltaT, 0);
+        for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+            TEST_ASSERT_EQUAL(ESC_DShotEmulator::FRAME_OK, emulators[ii].receiveBitbang(&port.dmaOutputBuffer[0], port.dmaOutputBuffer.size(), motorPins[ii]));
+        }
+    };
+
+    // while disarmed the motors are sent DSHOT_CMD_MOTOR_STOP, not the minimum throttle
+    output();
+    for (const auto& emulator : emulators) {
+        TEST_ASSERT_EQUAL(DShotCommandQueue::DSHOT_CMD_MOTOR_STOP, emulator.getThrottle());
+    }
+
+    // a queued command is sent, with the telemetry request bit set, only to the motor it is for
+    TEST_ASSERT_TRUE(mixer.sendDShotCommand(DShotCommandQueue::DSHOT_CMD_SPIN_DIRECTION_REVERSED, MotorMixerQuadX_Base::MOTOR_FR));
+    for (uint32_t loop = 0; loop <= DShotCommandQueue::INITIAL_DELAY_MICROSECONDS / TASK_INTERVAL_MICROSECONDS; ++loop) {
+        output();
+    }
+    TEST_ASSERT_EQUAL(DShotCommandQueue::DSHOT_CMD_SPIN_DIRECTION_REVERSED, emulators[MotorMixerQuadX_Base::MOTOR_FR].getThrottle());
+    TEST_ASSERT_TRUE(emulators[MotorMixerQuadX_Base::MOTOR_FR].getTelemetryRequest());
+    TEST_ASSERT_EQUAL(DShotCommandQueue::DSHOT_CMD_MOTOR_STOP, emulators[MotorMixerQuadX_Base::MOTOR_BR].getThrottle());
+    TEST_ASSERT_EQUAL(0, emulators[MotorMixerQuadX_Base::MOTOR_BR].getLastCommand());
+
+    // commands are rejected while the motors are on, and the motors are sent at least the minimum throttle
+    mixer.motorsSwitchOn();
+    TEST_ASSERT_FALSE(mixer.sendDShotCommand(DShotCommandQueue::DSHOT_CMD_BEACON1));
+    output();
+    for (const auto& emulator : emulators) {
+        TEST_ASSERT_TRUE(emulator.getThrottle() >= 47);
+    }
+    mixer.motorsSwitchOff();
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,cppcoreguidelines-init-variables,cppcoreguidelines-pro-bounds-constant-array-index,cppcoreguidelines-pro-bounds-pointer-arithmetic,hicpp-signed-bitwise,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_emulator_telemetry_value);
+    RUN_TEST(test_emulator_pulse_widths);
+    RUN_TEST(test_emulator_bitbang_output);
+    RUN_TEST(test_emulator_pio_telemetry_loop);
+    RUN_TEST(test_emulator_bitbang_telemetry_loop);
+    RUN_TEST(test_emulator_mixer_rpm_filters);
+    RUN_TEST(test_emulator_matrix_mixer_rpm_limiter);
+    RUN_TEST(test_emulator_bitbang_mixer_rpm_filters);
+    RUN_TEST(test_emulator_bitbang_mixer_dshot_commands);
+
+    UNITY_END();
+}
@@ -1,5 +1,6 @@
 #include <Debug.h>
 #include <DynamicIdleController.h>
+#include <MotorSpeedPredictor.h>
 #include <unity.h>
 
 void setUp()
@@ -66,6 +67,66 @@ void test_dynamic_idle_controller_p_only()
     TEST_ASSERT_EQUAL_FLOAT(0.03125F, dynamicIdleController.calculateSpeedIncrease(motorHz750RPM, deltaT));
 }
 
+void test_dynamic_idle_controller_d_gain()
+{
+    enum { TASK_INTERVAL_MICROSECONDS = 1000 };
+    const DynamicIdleController::config_t dynamicIdleControllerConfig = {
+        .dyn_idle_min_rpm_100 = 10,
+        .dyn_idle_p_gain = 0,
+        .dyn_idle_i_gain = 50,
+        .dyn_idle_d_gain = 0,
+        .dyn_idle_max_increase = 150,
+    };
+    static Debug debug;
+    static DynamicIdleController dynamicIdleController(dynamicIdleControllerConfig, TASK_INTERVAL_MICROSECONDS, debug);
+    const float deltaT = static_cast<float>(TASK_INTERVAL_MICROSECONDS) * 0.000001F;
+
+    debug.setMode(DEBUG_DYN_IDLE);
+
+    // D-term is set from dyn_idle_d_gain, so there is no D-term even though the I-gain is non-zero and the motor speed is changing
+    dynamicIdleController.calculateSpeedIncrease(1000.0F / 60.0F, deltaT);
+    dynamicIdleController.calculateSpeedIncrease(500.0F / 60.0F, 600.0F / 60.0F, deltaT);
+    TEST_ASSERT_EQUAL(0, debug.get(2));
+    // predicted and measured speeds are logged
+    TEST_ASSERT_EQUAL(83, debug.get(3));
+    TEST_ASSERT_EQUAL(100, debug.get(4));
+}
+
+void test_motor_speed_predictor()
+{
+    enum { MOTOR_COUNT = 4 };
+    const float deltaT = 0.001F;
+    MotorSpeedPredictor<MOTOR_COUNT> predictor(500.0F);
+    const MotorSpeedPredictor<MOTOR_COUNT>::values_t hoverOutputs = { 0.4F, 0.4F, 0.4F, 0.4F };
+
+    // first order response to the motor outputs
+    for (int ii = 0; ii < 1000; ++ii) {
+        predictor.predict(hoverOutputs, deltaT);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.1F, 200.0F, predictor.getPredictedHz(0));
+    TEST_ASSERT_FLOAT_WITHIN(0.1F, 200.0F, predictor.calculateSlowestPredictedHz());
+
+    // throttle chop: the predicted speed drops within one loop, without waiting for telemetry
+    const MotorSpeedPredictor<MOTOR_COUNT>::values_t chopOutputs = { 0.4F, 0.4F, 0.0F, 0.4F };
+    predictor.predict(chopOutputs, deltaT);
+    TEST_ASSERT_TRUE(predictor.getPredictedHz(2) < 200.0F - 5.0F);
+    TEST_ASSERT_EQUAL_FLOAT(predictor.getPredictedHz(2), predictor.calculateSlowestPredictedHz());
+    TEST_ASSERT_FLOAT_WITHIN(0.1F, 200.0F, predictor.getPredictedHz(0));
+
+    // motor 1 is weaker than the model: telemetry corrects the prediction and adapts the motor gain
+    predictor.reset();
+    const float motorGainHz = 400.0F;
+    float motorHz = 0.0F;
+    for (int ii = 0; ii < 10000; ++ii) {
+        predictor.predict(hoverOutputs, deltaT);
+        motorHz += (motorGainHz * hoverOutputs[1] - motorHz) * deltaT / (0.03F + deltaT);
+        predictor.correct(1, motorHz);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(1.0F, motorHz, predictor.getPredictedHz(1));
+    TEST_ASSERT_FLOAT_WITHIN(10.0F, motorGainHz, predictor.getMotorGainHz(1));
+    TEST_ASSERT_EQUAL_FLOAT(500.0F, predictor.getMotorGainHz(0));
+}
+
 // NOLINTEND(cppcoreguidelines-avoid-magic-numbers,cppcoreguidelines-init-variables,cppcoreguidelines-pro-bounds-pointer-arithmetic,hicpp-signed-bitwise,readability-magic-numbers)
 
 int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
@@ -74,6 +135,8 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
 
     RUN_TEST(test_dynamic_idle_controller);
     RUN_TEST(test_dynamic_idle_controller_p_only);
+    RUN_TEST(test_dynamic_idle_controller_d_gain);
+    RUN_TEST(test_motor_speed_predictor);
 
     UNITY_END();
 }
@@ -0,0 +1,324 @@
+#include <DShotMotorControl.h>
+#include <Debug.h>
+#include <DynamicIdleController.h>
+#include <IMU_Filters.h> // test code won't build if this not included
+#include <MotorMixerMatrix.h>
+#include <MotorMixerQuadX_PWM.h>
+#include <MotorRPM_Controller.h>
+#include <RPM_Filters.h>
+#include <unity.h>
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,cppcoreguidelines-init-variables,cppcoreguidelines-pro-bounds-constant-array-index,readability-magic-numbers)
+template <size_t MOTOR_COUNT, size_t SERVO_COUNT>
+static void test_matrix_balanced(const MotorMixMatrix<MOTOR_COUNT, SERVO_COUNT>& matrix)
+{
+    // every motor has full throttle, and roll, pitch, and yaw commands produce no net thrust
+    float rollSum = 0.0F;
+    float pitchSum = 0.0F;
+    float yawSum = 0.0F;
+    for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+        TEST_ASSERT_EQUAL_FLOAT(1.0F, matrix.throttle[ii]);
+        rollSum += matrix.roll[ii];
+        pitchSum += matrix.pitch[ii];
+        yawSum += matrix.yaw[ii];
+    }
+    TEST_ASSERT_FLOAT_WITHIN(1e-5F, 0.0F, rollSum);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5F, 0.0F, pitchSum);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5F, 0.0F, yawSum);
+}
+
+void test_motor_mixer_quad_x()
+{
+    static Debug debug;
+    static MotorMixerMatrixBase<4> mixer(MotorMixMatrices::QUAD_X, debug);
+    TEST_ASSERT_EQUAL(4, mixer.getMotorCount());
+    TEST_ASSERT_EQUAL(0, mixer.getServoCount());
+
+    const MotorMixerBase::commands_t commands { .throttle = 0.5F, .roll = 0.1F, .pitch = 0.2F, .yaw = 0.3F };
+
+    // motors off, so outputs are zero
+    mixer.outputToMotors(commands, 0.0F, 0);
+    for (size_t ii = 0; ii < 4; ++ii) {
+        TEST_ASSERT_EQUAL_FLOAT(0.0F, mixer.getMotorOutput(ii));
+    }
+
+    mixer.motorsSwitchOn();
+    mixer.outputToMotors(commands, 0.0F, 0);
+    TEST_ASSERT_EQUAL_FLOAT(0.5F, mixer.getThrottleCommand());
+    // check against the explicit QuadX formulae
+    TEST_ASSERT_EQUAL_FLOAT(-commands.roll - commands.pitch - commands.yaw + commands.throttle, mixer.getMotorOutput(0)); // BR
+    TEST_ASSERT_EQUAL_FLOAT(-commands.roll + commands.pitch + commands.yaw + commands.throttle, mixer.getMotorOutput(1)); // FR
+    TEST_ASSERT_EQUAL_FLOAT( commands.roll - commands.pitch + commands.yaw + commands.throttle, mixer.getMotorOutput(2)); // BL
+    TEST_ASSERT_EQUAL_FLOAT( commands.roll + commands.pitch - commands.yaw + commands.throttle, mixer.getMotorOutput(3)); // FL
+
+    mixer.motorsSwitchOff();
+    mixer.outputToMotors(commands, 0.0F, 0);
+    for (size_t ii = 0; ii < 4; ++ii) {
+        TEST_ASSERT_EQUAL_FLOAT(0.0F, mixer.getMotorOutput(ii));
+    }
+}
+
+void test_motor_mixer_matrices()
+{
+    test_matrix_balanced(MotorMixMatrices::QUAD_X);
+    test_matrix_balanced(MotorMixMatrices::QUAD_PLUS);
+    test_matrix_balanced(MotorMixMatrices::HEX_X);
+    test_matrix_balanced(MotorMixMatrices::Y6);
+    test_matrix_balanced(MotorMixMatrices::OCTO_X8);
+    test_matrix_balanced(MotorMixMatrices::OCTO_FLAT_X);
+    test_matrix_balanced(MotorMixMatrices::TRI);
+}
+
+void test_motor_mixer_hex_x()
+{
+    static Debug debug;
+    static MotorMixerMatrixBase<6> mixer(MotorMixMatrices::HEX_X, debug);
+    TEST_ASSERT_EQUAL(6, mixer.getMotorCount());
+
+    mixer.motorsSwitchOn();
+    // positive roll raises left side, so left motors speed up and right motors slow down
+    mixer.outputToMotors(MotorMixerBase::commands_t { .throttle = 0.5F, .roll = 0.2F, .pitch = 0.0F, .yaw = 0.0F }, 0.0F, 0);
+    TEST_ASSERT_EQUAL_FLOAT(0.4F, mixer.getMotorOutput(0)); // rear right
+    TEST_ASSERT_EQUAL_FLOAT(0.4F, mixer.getMotorOutput(1)); // front right
+    TEST_ASSERT_EQUAL_FLOAT(0.6F, mixer.getMotorOutput(2)); // rear left
+    TEST_ASSERT_EQUAL_FLOAT(0.6F, mixer.getMotorOutput(3)); // front left
+    TEST_ASSERT_EQUAL_FLOAT(0.3F, mixer.getMotorOutput(4)); // right
+    TEST_ASSERT_EQUAL_FLOAT(0.7F, mixer.getMotorOutput(5)); // left
+}
+
+void test_motor_mixer_tri()
+{
+    static Debug debug;
+    static MotorMixerMatrixBase<3, 1> mixer(MotorMixMatrices::TRI, debug);
+    TEST_ASSERT_EQUAL(3, mixer.getMotorCount());
+    TEST_ASSERT_EQUAL(1, mixer.getServoCount());
+
+    mixer.motorsSwitchOn();
+    mixer.outputToMotors(MotorMixerBase::commands_t { .throttle = 0.5F, .roll = 0.0F, .pitch = 0.0F, .yaw = 0.3F }, 0.0F, 0);
+    // yaw is provided solely by the servo
+    TEST_ASSERT_EQUAL_FLOAT(0.5F, mixer.getMotorOutput(0));
+    TEST_ASSERT_EQUAL_FLOAT(0.5F, mixer.getMotorOutput(1));
+    TEST_ASSERT_EQUAL_FLOAT(0.5F, mixer.getMotorOutput(2));
+    TEST_ASSERT_EQUAL_FLOAT(0.3F, mixer.getServoOutput(0));
+
+    // servo output is clipped
+    mixer.outputToMotors(MotorMixerBase::commands_t { .throttle = 0.5F, .roll = 0.0F, .pitch = 0.0F, .yaw = -1.5F }, 0.0F, 0);
+    TEST_ASSERT_EQUAL_FLOAT(-1.0F, mixer.getServoOutput(0));
+}
+
+void test_motor_mixer_quad_x_oneshot()
+{
+    static Debug debug;
+    const MotorMixerQuadX_Base::pins_t pins {.br=0xFF,.fr=0xFF,.bl=0xFF,.fl=0xFF};
+
+    // ticks are nanoseconds in the test framework
+    static MotorMixerQuadX_PWM oneshot125(debug, pins, MotorMixerQuadX_PWM::PROTOCOL_ONESHOT125);
+    TEST_ASSERT_EQUAL(MotorMixerQuadX_PWM::PROTOCOL_ONESHOT125, oneshot125.getProtocol());
+    TEST_ASSERT_EQUAL(125000, oneshot125.getPulseMinTicks());
+    TEST_ASSERT_EQUAL(125000, oneshot125.getPulseRangeTicks());
+    TEST_ASSERT_EQUAL(125000, oneshot125.calculatePulseTicks(0.0F));
+    TEST_ASSERT_EQUAL(187500, oneshot125.calculatePulseTicks(0.5F));
+    TEST_ASSERT_EQUAL(250000, oneshot125.calculatePulseTicks(1.0F));
+    // outputs are clipped to the pulse range
+    TEST_ASSERT_EQUAL(125000, oneshot125.calculatePulseTicks(-0.1F));
+    TEST_ASSERT_EQUAL(250000, oneshot125.calculatePulseTicks(1.1F));
+
+    static MotorMixerQuadX_PWM oneshot42(debug, pins, MotorMixerQuadX_PWM::PROTOCOL_ONESHOT42);
+    TEST_ASSERT_EQUAL(42000, oneshot42.calculatePulseTicks(0.0F));
+    TEST_ASSERT_EQUAL(84000, oneshot42.calculatePulseTicks(1.0F));
+
+    static MotorMixerQuadX_PWM multishot(debug, pins, MotorMixerQuadX_PWM::PROTOCOL_MULTISHOT);
+    TEST_ASSERT_EQUAL(5000, multishot.calculatePulseTicks(0.0F));
+    TEST_ASSERT_EQUAL(15000, multishot.calculatePulseTicks(0.5F));
+    TEST_ASSERT_EQUAL(25000, multishot.calculatePulseTicks(1.0F));
+
+    // PWM has no pulse range
+    static MotorMixerQuadX_PWM pwm(debug, pins);
+    TEST_ASSERT_EQUAL(MotorMixerQuadX_PWM::PROTOCOL_PWM, pwm.getProtocol());
+    TEST_ASSERT_EQUAL(0, MotorMixerQuadX_PWM::getPulseRange(MotorMixerQuadX_PWM::PROTOCOL_PWM).maxNanoSeconds);
+
+    // when the motors are off the minimum pulse is sent
+    oneshot125.outputToMotors(MotorMixerBase::commands_t { .throttle = 0.5F, .roll = 0.0F, .pitch = 0.0F, .yaw = 0.0F }, 0.0F, 0);
+    TEST_ASSERT_EQUAL(125000, oneshot125.calculatePulseTicks(oneshot125.getMotorOutput(MotorMixerQuadX_Base::MOTOR_FL)));
+    oneshot125.motorsSwitchOn();
+    oneshot125.outputToMotors(MotorMixerBase::commands_t { .throttle = 0.5F, .roll = 0.0F, .pitch = 0.0F, .yaw = 0.0F }, 0.0F, 0);
+    TEST_ASSERT_EQUAL(187500, oneshot125.calculatePulseTicks(oneshot125.getMotorOutput(MotorMixerQuadX_Base::MOTOR_FL)));
+}
+
+void test_motor_rpm_controller()
+{
+    // simulate motors with different gains (eg due to ESC, motor, and battery variation) and first order response
+    enum { MOTOR_COUNT = 4 };
+    const float maxMotorHz = 500.0F;
+    const std::array<float, MOTOR_COUNT> motorGains = { 0.7F, 0.9F, 1.0F, 1.2F };
+    const float motorTimeConstant = 0.03F;
+    const float deltaT = 0.001F;
+    const float outputMin = 0.05F;
+
+    MotorRPM_Controller<MOTOR_COUNT> rpmController(maxMotorHz);
+    TEST_ASSERT_EQUAL_FLOAT(maxMotorHz, rpmController.getMaxMotorHz());
+
+    MotorRPM_Controller<MOTOR_COUNT>::values_t motorHz {};
+    MotorRPM_Controller<MOTOR_COUNT>::values_t outputs {};
+    const MotorRPM_Controller<MOTOR_COUNT>::values_t targets = { 0.5F, 0.5F, 0.3F, 0.3F };
+    for (int ii = 0; ii < 2000; ++ii) {
+        rpmController.update(outputs, targets, motorHz, 0.0F, outputMin, deltaT);
+        for (size_t jj = 0; jj < MOTOR_COUNT; ++jj) {
+            motorHz[jj] += (outputs[jj] * motorGains[jj] * maxMotorHz - motorHz[jj]) * deltaT / motorTimeConstant;
+        }
+    }
+    // every motor reaches its target speed, regardless of its gain
+    TEST_ASSERT_FLOAT_WITHIN(2.0F, 250.0F, motorHz[0]);
+    TEST_ASSERT_FLOAT_WITHIN(2.0F, 250.0F, motorHz[1]);
+    TEST_ASSERT_FLOAT_WITHIN(2.0F, 150.0F, motorHz[2]);
+    TEST_ASSERT_FLOAT_WITHIN(2.0F, 150.0F, motorHz[3]);
+    // the weaker motor requires the larger output
+    TEST_ASSERT_TRUE(outputs[0] > outputs[1]);
+    TEST_ASSERT_TRUE(outputs[2] > outputs[3]);
+
+    // with no valid telemetry the outputs fall back to the open-loop feedforward, and the integrals are frozen
+    const MotorRPM_Controller<MOTOR_COUNT>::values_t integrals = rpmController.getIntegrals();
+    const MotorRPM_Controller<MOTOR_COUNT>::values_t noTelemetryWeights {};
+    const MotorRPM_Controller<MOTOR_COUNT>::values_t staleMotorHz {};
+    for (int ii = 0; ii < 10; ++ii) {
+        rpmController.update(outputs, targets, staleMotorHz, noTelemetryWeights, 0.0F, outputMin, deltaT);
+    }
+    for (size_t jj = 0; jj < MOTOR_COUNT; ++jj) {
+        TEST_ASSERT_EQUAL_FLOAT(MotorRPM_Controller<MOTOR_COUNT>::DEFAULT_CONFIG.kff * targets[jj], outputs[jj]);
+        TEST_ASSERT_EQUAL_FLOAT(integrals[jj], rpmController.getIntegrals()[jj]);
+    }
+
+    // targets below the minimum motor speed are raised to the minimum
+    const MotorRPM_Controller<MOTOR_COUNT>::values_t zeroTargets {};
+    for (int ii = 0; ii < 2000; ++ii) {
+        rpmController.update(outputs, zeroTargets, motorHz, 100.0F, outputMin, deltaT);
+        for (size_t jj = 0; jj < MOTOR_COUNT; ++jj) {
+            motorHz[jj] += (outputs[jj] * motorGains[jj] * maxMotorHz - motorHz[jj]) * deltaT / motorTimeConstant;
+        }
+    }
+    for (size_t jj = 0; jj < MOTOR_COUNT; ++jj) {
+        TEST_ASSERT_FLOAT_WITHIN(2.0F, 100.0F, motorHz[jj]);
+    }
+
+    // outputs are limited to [outputMin, 1.0]
+    const MotorRPM_Controller<MOTOR_COUNT>::values_t fullTargets = { 1.0F, 1.0F, 1.0F, 1.0F };
+    rpmController.update(outputs, fullTargets, zeroTargets, 0.0F, outputMin, deltaT);
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, outputs[0]);
+    const MotorRPM_Controller<MOTOR_COUNT>::values_t maxMotorHzs = { maxMotorHz, maxMotorHz, maxMotorHz, maxMotorHz };
+    rpmController.update(outputs, zeroTargets, maxMotorHzs, 0.0F, outputMin, deltaT);
+    TEST_ASSERT_EQUAL_FLOAT(outputMin, outputs[0]);
+
+    rpmController.reset();
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, rpmController.getIntegrals()[0]);
+}
+
+void test_dshot_motor_control_rpm_control()
+{
+    enum { MOTOR_COUNT = 4 };
+    enum { TASK_INTERVAL_MICROSECONDS = 1000 };
+    const DynamicIdleController::config_t dynamicIdleControllerConfig = {
+        .dyn_idle_min_rpm_100 = 0,
+        .dyn_idle_p_gain = 50,
+        .dyn_idle_i_gain = 50,
+        .dyn_idle_d_gain = 50,
+        .dyn_idle_max_increase = 150,
+    };
+    static Debug debug;
+    static RPM_Filters rpmFilters(MOTOR_COUNT, TASK_INTERVAL_MICROSECONDS);
+    static DynamicIdleController dynamicIdleController(dynamicIdleControllerConfig, TASK_INTERVAL_MICROSECONDS, debug);
+    DShotMotorControl<MOTOR_COUNT> motorControl(rpmFilters, dynamicIdleController);
+    const float deltaT = static_cast<float>(TASK_INTERVAL_MICROSECONDS) * 0.000001F;
+    const float outputMin = 0.05F;
+
+    // the MotorSpeedPredictor uses the same motor gain as the RPM controller
+    motorControl.setRPM_ControlEnabled(true, 400.0F);
+    TEST_ASSERT_EQUAL_FLOAT(400.0F, motorControl.getRPM_Controller().getMaxMotorHz());
+    for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+        TEST_ASSERT_EQUAL_FLOAT(400.0F, motorControl.getMotorSpeedPredictor().getMotorGainHz(ii));
+    }
+
+    // motor speeds of 100Hz, below the 200Hz target
+    const DShotMotorControl<MOTOR_COUNT>::values_t targets = { 0.5F, 0.5F, 0.5F, 0.5F };
+    DShotMotorControl<MOTOR_COUNT>::dshot_values_t values {};
+
+    // no valid telemetry: open-loop output, and the integrals are not wound up
+    for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+        motorControl.setMotorTelemetry(ii, 100.0F, 0.0F, false);
+    }
+    for (int loop = 0; loop < 10; ++loop) {
+        motorControl.calculateValues(values, targets, true, outputMin, deltaT);
+    }
+    for (size_t ii = 0; ii < MOTOR_COUNT; ++ii) {
+        TEST_ASSERT_EQUAL(1000 + 47, values[ii]);
+        TEST_ASSERT_EQUAL_FLOAT(0.0F, motorControl.getRPM_Controller().getIntegrals()[ii]);
+    }
+
+    // valid telemetry on MOTOR 0 only: it is closed-loop, so its output is raised to speed it up
+    motorControl.setMotorTelemetry(0, 100.0F, 1.0F, true);
+    motorControl.calculateValues(values, targets, true, outputMin, deltaT);
+    TEST_ASSERT_TRUE(values[0] > 1000 + 47);
+    TEST_ASSERT_TRUE(motorControl.getRPM_Controller().getIntegrals()[0] > 0.0F);
+    TEST_ASSERT_EQUAL(1000 + 47, values[1]);
+
+    // disabling RPM control with a different maximum speed keeps the predictor consistent
+    motorControl.setRPM_ControlEnabled(false, 600.0F);
+    TEST_ASSERT_EQUAL_FLOAT(600.0F, motorControl.getMotorSpeedPredictor().getMotorGainHz(0));
+}
+
+class MotorMixerTelemetryTest : public MotorMixerBase {
+public:
+    MotorMixerTelemetryTest(Debug& debug, const esc_telemetry_t& telemetry) : MotorMixerBase(4, debug), _telemetry(telemetry) {}
+    virtual esc_telemetry_t getMotorTelemetry(size_t motorIndex) const override { (void)motorIndex; return _telemetry; }
+    void setDebug() { setESC_TelemetryDebug(); }
+private:
+    esc_telemetry_t _telemetry;
+};
+
+void test_motor_mixer_esc_telemetry_debug()
+{
+    static Debug debug;
+    esc_telemetry_t telemetry {};
+    telemetry.readCount = 100000;
+    telemetry.staleCount = 9000; // 36000 over four motors
+    telemetry.errorCount = 2000;
+    telemetry.temperatureCelsius = 60;
+    MotorMixerTelemetryTest mixer(debug, telemetry);
+
+    debug.setMode(DEBUG_ESC_SENSOR);
+    mixer.setDebug();
+    TEST_ASSERT_EQUAL(0, debug.get(0));
+    TEST_ASSERT_EQUAL(60, debug.get(1));
+    // counts saturate rather than wrapping negative
+    TEST_ASSERT_EQUAL(INT16_MAX, debug.get(2));
+    TEST_ASSERT_EQUAL(8000, debug.get(3));
+
+    debug.setMode(DEBUG_DSHOT_TELEMETRY_COUNTS);
+    mixer.setDebug();
+    TEST_ASSERT_EQUAL(INT16_MAX, debug.get(0));
+    TEST_ASSERT_EQUAL(INT16_MAX, debug.get(3));
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,cppcoreguidelines-init-variables,cppcoreguidelines-pro-bounds-constant-array-index,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_motor_mixer_quad_x);
+    RUN_TEST(test_motor_mixer_matrices);
+    RUN_TEST(test_motor_mixer_hex_x);
+    RUN_TEST(test_motor_mixer_tri);
+    RUN_TEST(test_motor_mixer_quad_x_oneshot);
+    RUN_TEST(test_motor_rpm_controller);
+    RUN_TEST(test_dshot_motor_control_rpm_control);
+    RUN_TEST(test_motor_mixer_esc_telemetry_debug);
+
+    UNITY_END();
+}
@@ -1,4 +1,5 @@
 #include "RadioController.h"
+#include <BlackboxEventQueue.h>
 #include <ReceiverNull.h>
 
 
@@ -190,6 +191,35 @@ void test_radio_controller_throttle()
     throttle = radioController.mapThrottle(1.0F);
     TEST_ASSERT_EQUAL_FLOAT(1.0F, throttle);
 }
+
+void test_radio_controller_rates_change_event()
+{
+    static ReceiverNull receiver;
+    static RadioController radioController(receiver, radioControllerRates);
+    static BlackboxEventQueue eventQueue;
+    radioController.setBlackboxEventQueue(&eventQueue);
+    BlackboxEventQueue::event_t event {};
+
+    // setting the rates to their current values is not a change
+    radioController.setRates(radioController.getRates());
+    TEST_ASSERT_FALSE(eventQueue.pop(event));
+
+    RadioController::rates_t rates = radioController.getRates();
+    rates.ratesType = RadioController::RATES_TYPE_BETAFLIGHT;
+    radioController.setRates(rates);
+    TEST_ASSERT_TRUE(eventQueue.pop(event));
+    TEST_ASSERT_EQUAL(BlackboxEventQueue::EVENT_RATES_CHANGE, event.type);
+    TEST_ASSERT_EQUAL(RadioController::RATES_TYPE_BETAFLIGHT, event.value);
+    TEST_ASSERT_FALSE(eventQueue.pop(event));
+
+    // pass through is also a rates change, but only the first time it is set
+    radioController.setRatesToPassThrough();
+    TEST_ASSERT_TRUE(eventQueue.pop(event));
+    TEST_ASSERT_EQUAL(BlackboxEventQueue::EVENT_RATES_CHANGE, event.type);
+    TEST_ASSERT_EQUAL(RadioController::RATES_TYPE_ACTUAL, event.value);
+    radioController.setRatesToPassThrough();
+    TEST_ASSERT_FALSE(eventQueue.pop(event));
+}
 // NOLINTEND(misc-const-correctness)
 
 int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
@@ -201,6 +231,7 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
     RUN_TEST(test_radio_controller_defaults);
     RUN_TEST(test_radio_controller_constrain);
     RUN_TEST(test_radio_controller_throttle);
+    RUN_TEST(test_radio_controller_rates_change_event);
 
     UNITY_END();
 }
@@ -0,0 +1,210 @@
+#include <Debug.h>
+#include <RPM_Limiter.h>
+#include <unity.h>
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,cppcoreguidelines-init-variables,readability-magic-numbers)
+void test_rpm_limiter_disabled()
+{
+    enum { TASK_INTERVAL_MICROSECONDS = 1000 };
+    const RPM_Limiter::config_t rpmLimiterConfig = {
+        .rpm_limit = 0,
+        .rpm_limit_p_gain = 25,
+        .rpm_limit_i_gain = 10,
+        .rpm_limit_d_gain = 8,
+    };
+    static Debug debug;
+    static RPM_Limiter rpmLimiter(rpmLimiterConfig, TASK_INTERVAL_MICROSECONDS, debug);
+    const float deltaT = static_cast<float>(TASK_INTERVAL_MICROSECONDS) * 0.000001F;
+
+    TEST_ASSERT_EQUAL(0, rpmLimiter.getConfig().rpm_limit);
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, rpmLimiter.getLimitMotorHz());
+
+    // limiter disabled, so throttle is never scaled
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, rpmLimiter.calculateThrottleScale(0.0F, deltaT));
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, rpmLimiter.calculateThrottleScale(40000.0F / 60.0F, deltaT));
+}
+
+void test_rpm_limiter_p_only()
+{
+    const float motorHz10000RPM = 10000.0F / 60.0F;
+    const float motorHz20000RPM = 20000.0F / 60.0F;
+    const float motorHz21000RPM = 21000.0F / 60.0F;
+    const float motorHz22000RPM = 22000.0F / 60.0F;
+
+    enum { TASK_INTERVAL_MICROSECONDS = 1000 };
+    const RPM_Limiter::config_t rpmLimiterConfig = {
+        .rpm_limit = 20000,
+        .rpm_limit_p_gain = 50,
+        .rpm_limit_i_gain = 0,
+        .rpm_limit_d_gain = 0,
+    };
+    static Debug debug;
+    static RPM_Limiter rpmLimiter(rpmLimiterConfig, TASK_INTERVAL_MICROSECONDS, debug);
+    const float deltaT = static_cast<float>(TASK_INTERVAL_MICROSECONDS) * 0.000001F;
+
+    TEST_ASSERT_EQUAL(20000, rpmLimiter.getConfig().rpm_limit);
+    TEST_ASSERT_EQUAL_FLOAT(motorHz20000RPM, rpmLimiter.getLimitMotorHz());
+
+    // average motor speed at or below the limit, so no throttle reduction
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, rpmLimiter.calculateThrottleScale(motorHz10000RPM, deltaT));
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, rpmLimiter.calculateThrottleScale(motorHz20000RPM, deltaT));
+
+    // average motor speed above the limit, throttle reduced in proportion to the excess
+    TEST_ASSERT_EQUAL_FLOAT(1.0F - 0.125F, rpmLimiter.calculateThrottleScale(motorHz21000RPM, deltaT));
+    TEST_ASSERT_EQUAL_FLOAT(1.0F - 0.125F, rpmLimiter.calculateThrottleScale(motorHz21000RPM, deltaT));
+    TEST_ASSERT_EQUAL_FLOAT(1.0F - 0.25F, rpmLimiter.calculateThrottleScale(motorHz22000RPM, deltaT));
+}
+
+void test_rpm_limiter_i_term()
+{
+    const float motorHz19000RPM = 19000.0F / 60.0F;
+    const float motorHz21000RPM = 21000.0F / 60.0F;
+    const float motorHz40000RPM = 40000.0F / 60.0F;
+
+    enum { TASK_INTERVAL_MICROSECONDS = 1000 };
+    const RPM_Limiter::config_t rpmLimiterConfig = {
+        .rpm_limit = 20000,
+        .rpm_limit_p_gain = 0,
+        .rpm_limit_i_gain = 50,
+        .rpm_limit_d_gain = 0,
+    };
+    static Debug debug;
+    static RPM_Limiter rpmLimiter(rpmLimiterConfig, TASK_INTERVAL_MICROSECONDS, debug);
+    const float deltaT = static_cast<float>(TASK_INTERVAL_MICROSECONDS) * 0.000001F;
+    debug.setMode(DEBUG_RPM_LIMIT);
+
+    // below the limit the I-term is clamped at zero, so it does not wind up and the throttle is not reduced
+    for (int ii = 0; ii < 1000; ++ii) {
+        TEST_ASSERT_EQUAL_FLOAT(1.0F, rpmLimiter.calculateThrottleScale(motorHz19000RPM, deltaT));
+    }
+    TEST_ASSERT_EQUAL(0, debug.get(3));
+
+    // above the limit the I-term accumulates, so the throttle is reduced more each loop, starting with the first loop
+    float previousScale = rpmLimiter.calculateThrottleScale(motorHz21000RPM, deltaT);
+    TEST_ASSERT_TRUE(previousScale < 1.0F);
+    for (int ii = 0; ii < 10; ++ii) {
+        const float throttleScale = rpmLimiter.calculateThrottleScale(motorHz21000RPM, deltaT);
+        TEST_ASSERT_TRUE(throttleScale < previousScale);
+        previousScale = throttleScale;
+    }
+
+    // a sustained large excess saturates the I-term at -1, so the throttle scale reaches zero but no further
+    float throttleScale = previousScale;
+    for (int ii = 0; ii < 1000000 && throttleScale > 0.0F; ++ii) {
+        throttleScale = rpmLimiter.calculateThrottleScale(motorHz40000RPM, deltaT);
+        TEST_ASSERT_TRUE(throttleScale >= 0.0F);
+    }
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, throttleScale);
+    for (int ii = 0; ii < 1000; ++ii) {
+        TEST_ASSERT_EQUAL_FLOAT(0.0F, rpmLimiter.calculateThrottleScale(motorHz40000RPM, deltaT));
+    }
+    TEST_ASSERT_EQUAL(-10000, debug.get(3));
+    // the average RPM is logged divided by 10, so speeds above 32767 RPM do not overflow
+    TEST_ASSERT_EQUAL(4000, debug.get(0));
+
+    // once below the limit the I-term unwinds, so the throttle scale rises
+    previousScale = rpmLimiter.calculateThrottleScale(motorHz19000RPM, deltaT);
+    TEST_ASSERT_TRUE(previousScale > 0.0F);
+    for (int ii = 0; ii < 10; ++ii) {
+        throttleScale = rpmLimiter.calculateThrottleScale(motorHz19000RPM, deltaT);
+        TEST_ASSERT_TRUE(throttleScale > previousScale);
+        previousScale = throttleScale;
+    }
+
+    // resetting the PID clears the I-term
+    rpmLimiter.resetPID();
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, rpmLimiter.calculateThrottleScale(motorHz19000RPM, deltaT));
+}
+
+void test_rpm_limiter_d_term()
+{
+    const float motorHz10000RPM = 10000.0F / 60.0F;
+    const float motorHz15000RPM = 15000.0F / 60.0F;
+    const float motorHz16000RPM = 16000.0F / 60.0F;
+    const float motorHz17000RPM = 17000.0F / 60.0F;
+
+    enum { TASK_INTERVAL_MICROSECONDS = 1000 };
+    const RPM_Limiter::config_t rpmLimiterConfig = {
+        .rpm_limit = 20000,
+        .rpm_limit_p_gain = 0,
+        .rpm_limit_i_gain = 0,
+        .rpm_limit_d_gain = 50,
+    };
+    static Debug debug;
+    static RPM_Limiter rpmLimiter(rpmLimiterConfig, TASK_INTERVAL_MICROSECONDS, debug);
+    const float deltaT = static_cast<float>(TASK_INTERVAL_MICROSECONDS) * 0.000001F;
+
+    // steady speed below the limit, so no D-term once the D-term filter has settled after the first measurement
+    for (int ii = 0; ii < 1000; ++ii) {
+        rpmLimiter.calculateThrottleScale(motorHz15000RPM, deltaT);
+    }
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, rpmLimiter.calculateThrottleScale(motorHz15000RPM, deltaT));
+
+    // the D-term anticipates the limit: a rising motor speed reduces the throttle, even while still below the limit
+    const float throttleScale16000 = rpmLimiter.calculateThrottleScale(motorHz16000RPM, deltaT);
+    TEST_ASSERT_TRUE(throttleScale16000 < 1.0F);
+    // a faster rise gives a larger reduction
+    const float throttleScale17000 = rpmLimiter.calculateThrottleScale(motorHz17000RPM + (motorHz17000RPM - motorHz16000RPM), deltaT);
+    TEST_ASSERT_TRUE(throttleScale17000 < throttleScale16000);
+
+    // a falling motor speed does not reduce the throttle, and never increases it
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, rpmLimiter.calculateThrottleScale(motorHz10000RPM, deltaT));
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, rpmLimiter.calculateThrottleScale(motorHz10000RPM - (motorHz15000RPM - motorHz10000RPM), deltaT));
+}
+
+void test_rpm_limiter_telemetry_weight()
+{
+    const float motorHz21000RPM = 21000.0F / 60.0F;
+
+    enum { TASK_INTERVAL_MICROSECONDS = 1000 };
+    const RPM_Limiter::config_t rpmLimiterConfig = {
+        .rpm_limit = 20000,
+        .rpm_limit_p_gain = 50,
+        .rpm_limit_i_gain = 50,
+        .rpm_limit_d_gain = 0,
+    };
+    static Debug debug;
+    static RPM_Limiter rpmLimiter(rpmLimiterConfig, TASK_INTERVAL_MICROSECONDS, debug);
+    const float deltaT = static_cast<float>(TASK_INTERVAL_MICROSECONDS) * 0.000001F;
+    debug.setMode(DEBUG_RPM_LIMIT);
+
+    // build up an I-term
+    for (int ii = 0; ii < 10; ++ii) {
+        rpmLimiter.calculateThrottleScale(motorHz21000RPM, 1.0F, deltaT);
+    }
+    TEST_ASSERT_TRUE(debug.get(3) < 0);
+    const float fullWeightScale = rpmLimiter.calculateThrottleScale(motorHz21000RPM, 1.0F, deltaT);
+
+    // no valid telemetry: the throttle is not reduced and the I-term is reset
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, rpmLimiter.calculateThrottleScale(motorHz21000RPM, 0.0F, deltaT));
+    const float restartScale = rpmLimiter.calculateThrottleScale(motorHz21000RPM, 1.0F, deltaT);
+    TEST_ASSERT_TRUE(restartScale > fullWeightScale);
+
+    // partially valid telemetry scales the reduction
+    rpmLimiter.resetPID();
+    const float halfWeightScale = rpmLimiter.calculateThrottleScale(motorHz21000RPM, 0.5F, deltaT);
+    rpmLimiter.resetPID();
+    TEST_ASSERT_FLOAT_WITHIN(1e-6F, 1.0F - 0.5F * (1.0F - rpmLimiter.calculateThrottleScale(motorHz21000RPM, 1.0F, deltaT)), halfWeightScale);
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,cppcoreguidelines-init-variables,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_rpm_limiter_disabled);
+    RUN_TEST(test_rpm_limiter_p_only);
+    RUN_TEST(test_rpm_limiter_i_term);
+    RUN_TEST(test_rpm_limiter_d_term);
+    RUN_TEST(test_rpm_limiter_telemetry_weight);
+
+    UNITY_END();
+}
@@ -0,0 +1,137 @@
+/*!
+Command line Blackbox log decoder.
+
+Usage: blackbox_decode [--columnar] [--index <n>] [--stdout] <log file>
+
+Each log in the file is written to <log file>.<nn>.csv (or .bbcol if --columnar is given).
+--index decodes only the given log (numbered from 1), --stdout writes to standard output rather than to files.
+Decoding statistics are written to standard error.
+
+Build with: pio run -e blackbox-decode
+*/
+#include <BlackboxDecoder.h>
+#include <BlackboxExporterCSV.h>
+#include <BlackboxExporterColumnar.h>
+#include <BlackboxMappedFile.h>
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+
+namespace { // use anonymous namespace to make items local to this translation unit
+
+void printUsage()
+{
+    std::fprintf(stderr, "Usage: blackbox_decode [--columnar] [--index <n>] [--stdout] <log file>\n"); // NOLINT(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+}
+
+void printStats(size_t logNumber, const BlackboxDecoder::stats_t& stats, double seconds)
+{
+    // NOLINTBEGIN(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+    std::fprintf(stderr, "Log %zu: %zu bytes, decoded in %.3fs (%.1fMB/s)\n", logNumber, stats.byteCount, seconds, seconds > 0.0 ? static_cast<double>(stats.byteCount) / seconds / 1.0e6 : 0.0);
+    std::fprintf(stderr, "    I frames %u, P frames %u, S frames %u, G frames %u, H frames %u, events %u\n",
+        stats.intraFrameCount, stats.interFrameCount, stats.slowFrameCount, stats.gpsFrameCount, stats.gpsHomeFrameCount, stats.eventCount);
+    if (stats.corruptFrameCount > 0 || stats.skippedInterFrameCount > 0) {
+        std::fprintf(stderr, "    corrupt frames %u, corrupt bytes %zu, P frames skipped %u\n", stats.corruptFrameCount, stats.corruptByteCount, stats.skippedInterFrameCount);
+    }
+    if (stats.timedEventCount > 0) {
+        std::fprintf(stderr, "    timed events (loop overruns, failsafe, mode and PID changes) %u\n", stats.timedEventCount);
+    }
+    if (stats.decimationChangeCount > 0) {
+        std::fprintf(stderr, "    log rate changed %u times, lowest rate one sample in %u\n", stats.decimationChangeCount, stats.maxDecimation);
+    }
+    if (!stats.logEndFound) {
+        std::fprintf(stderr, "    log end not found, log is truncated\n");
+    }
+    // NOLINTEND(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+}
+
+} // end namespace
+
+int main(int argc, char** argv)
+{
+    bool columnar = false;
+    bool toStdout = false;
+    size_t logIndex = 0;
+    const char* path = nullptr;
+
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    for (int ii = 1; ii < argc; ++ii) {
+        if (std::strcmp(argv[ii], "--columnar") == 0) {
+            columnar = true;
+        } else if (std::strcmp(argv[ii], "--stdout") == 0) {
+            toStdout = true;
+        } else if (std::strcmp(argv[ii], "--index") == 0 && ii + 1 < argc) {
+            logIndex = static_cast<size_t>(std::strtoul(argv[++ii], nullptr, 10));
+        } else if (argv[ii][0] != '-' && path == nullptr) {
+            path = argv[ii];
+        } else {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+    }
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    if (path == nullptr) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    const BlackboxMappedFile file(path);
+    if (!file.isOpen()) {
+        std::fprintf(stderr, "Cannot open %s\n", path); // NOLINT(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+        return EXIT_FAILURE;
+    }
+    const std::vector<size_t> logOffsets = BlackboxDecoder::findLogs(file.data(), file.size());
+    if (logOffsets.empty()) {
+        std::fprintf(stderr, "No logs found in %s\n", path); // NOLINT(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+        return EXIT_FAILURE;
+    }
+
+    BlackboxDecoder decoder;
+    for (size_t ii = 0; ii < logOffsets.size(); ++ii) {
+        const size_t logNumber = ii + 1;
+        if (logIndex != 0 && logIndex != logNumber) {
+            continue;
+        }
+        const uint8_t* begin = file.data() + logOffsets[ii]; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        const uint8_t* end = file.data() + (ii + 1 < logOffsets.size() ? logOffsets[ii + 1] : file.size()); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        if (!decoder.parseHeader(begin, end)) {
+            std::fprintf(stderr, "Log %zu: invalid header\n", logNumber); // NOLINT(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+            continue;
+        }
+
+        std::FILE* output = stdout;
+        if (!toStdout) {
+            std::array<char, 32> suffix {};
+            std::snprintf(&suffix[0], suffix.size(), ".%02zu.%s", logNumber, columnar ? "bbcol" : "csv"); // NOLINT(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+            const std::string outputPath = std::string(path) + &suffix[0];
+            output = std::fopen(outputPath.c_str(), "wb"); // NOLINT(cppcoreguidelines-owning-memory)
+            if (output == nullptr) {
+                std::fprintf(stderr, "Cannot create %s\n", outputPath.c_str()); // NOLINT(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+                return EXIT_FAILURE;
+            }
+        }
+        // the exporters hold large buffers, so are allocated on the heap
+        std::unique_ptr<BlackboxDecoderSink> exporter;
+        if (columnar) {
+            exporter = std::make_unique<BlackboxExporterColumnar>(output);
+        } else {
+            exporter = std::make_unique<BlackboxExporterCSV>(output);
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        const BlackboxDecoder::stats_t stats = decoder.decode(*exporter);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        printStats(logNumber, stats, elapsed.count());
+
+        if (output != stdout) {
+            std::fclose(output); // NOLINT(cppcoreguidelines-owning-memory)
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,163 @@
+/*!
+Host benchmark for the DShot telemetry decoders.
+
+Usage: dshot_bench
+
+Times DShotCodec::decodeSamples() against the bit by bit reference decoder it replaced, over all 4096 telemetry values,
+and ESC_DShotBitbang::samples_to_GCR21s(), which decodes all the motors on a port in one pass, against calling
+ESC_DShotBitbang::samples_to_GCR21() for each motor. The times are written to standard output.
+Equivalence of the decoders is checked by the unit tests, see test_codec_dshot and test_dshot.
+
+Build with: pio run -e dshot-bench
+*/
+#include <DShotCodec.h>
+#include <ESC_DShotBitbang.h>
+#include <IMU_Filters.h> // won't build if this not included
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+
+
+namespace { // use anonymous namespace to make items local to this translation unit
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,hicpp-signed-bitwise,readability-magic-numbers)
+//! The bit by bit decoder that DShotCodec::decodeSamples() replaced, copied from test_codec_dshot.
+uint32_t decodeSamplesReference(uint64_t value, DShotCodec::telemetry_type_e& telemetryType)
+{
+    if (value & 0x8000000000000000L) {
+        telemetryType = DShotCodec::TELEMETRY_INVALID;
+        return 0;
+    }
+    uint32_t consecutiveBitCount = 1;
+    uint32_t currentBit = 0;
+    uint32_t bitCount = 0;
+    uint32_t gcr_result = 0;
+    for (uint64_t mask = 0x4000000000000000; mask != 0; mask >>= 1) {
+        if (((value & mask) != 0) != currentBit) {
+            gcr_result = gcr_result << DShotCodec::gcrBitLengths[consecutiveBitCount];
+            if (currentBit) {
+                gcr_result |= DShotCodec::gcrSetBits[DShotCodec::gcrBitLengths[consecutiveBitCount]];
+            }
+            bitCount += DShotCodec::gcrBitLengths[consecutiveBitCount];
+            currentBit = !currentBit;
+            consecutiveBitCount = 1;
+        } else {
+            ++consecutiveBitCount;
+            if (consecutiveBitCount > 16) {
+                telemetryType = DShotCodec::TELEMETRY_INVALID;
+                return 0;
+            }
+        }
+    }
+    gcr_result <<= DShotCodec::gcrBitLengths[consecutiveBitCount];
+    if (currentBit) {
+        gcr_result |= DShotCodec::gcrSetBits[DShotCodec::gcrBitLengths[consecutiveBitCount]];
+    }
+    bitCount += DShotCodec::gcrBitLengths[consecutiveBitCount];
+    if (bitCount < 21) {
+        telemetryType = DShotCodec::TELEMETRY_INVALID;
+        return 0;
+    }
+    gcr_result = gcr_result >> (bitCount - 21);
+    const uint16_t result = DShotCodec::GCR20_to_eRPM(DShotCodec::GCR21_to_GCR20(gcr_result));
+    if (!DShotCodec::checksumBidirectionalIsOK(result)) {
+        telemetryType = DShotCodec::TELEMETRY_INVALID;
+        return 0;
+    }
+    return DShotCodec::decodeTelemetryFrame(result >> 4, telemetryType);
+}
+
+uint32_t gcr21FromValue(uint16_t value)
+{
+    const auto frame = static_cast<uint16_t>((value << 4U) | DShotCodec::checksumBidirectional(value));
+    return DShotCodec::GR20_to_GCR21(DShotCodec::eRPM_to_GCR20(frame));
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,hicpp-signed-bitwise,readability-magic-numbers)
+
+//! Returns the time per call, in nanoseconds, of decode over all the samples, accumulating the results into sum so the calls are not optimized away.
+template <typename T>
+double timeDecoder(T decode, const std::array<uint64_t, 4096>& samples, uint32_t& sum)
+{
+    enum { ITERATIONS = 1000 };
+    DShotCodec::telemetry_type_e telemetryType {};
+    const auto start = std::chrono::steady_clock::now();
+    for (int ii = 0; ii < ITERATIONS; ++ii) {
+        for (const uint64_t sample : samples) {
+            sum += decode(sample, telemetryType);
+        }
+    }
+    const auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    return static_cast<double>(time.count()) / (static_cast<double>(ITERATIONS) * static_cast<double>(samples.size()));
+}
+
+bool benchmarkDecodeSamples()
+{
+    static std::array<uint64_t, 4096> samples {};
+    for (uint16_t value = 0; value < samples.size(); ++value) {
+        samples[value] = DShotCodec::GCR21_to_samples(gcr21FromValue(value));
+    }
+
+    uint32_t referenceSum = 0;
+    const double referenceTime = timeDecoder(
+        [](uint64_t sample, DShotCodec::telemetry_type_e& telemetryType) { return decodeSamplesReference(sample, telemetryType); },
+        samples, referenceSum);
+    uint32_t sum = 0;
+    const double time = timeDecoder(
+        [](uint64_t sample, DShotCodec::telemetry_type_e& telemetryType) { return DShotCodec::decodeSamples(sample, telemetryType); },
+        samples, sum);
+
+    std::printf("decodeSamples: %.1fns, bit by bit reference: %.1fns\n", time, referenceTime); // NOLINT(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+    return sum == referenceSum;
+}
+
+bool benchmarkBitbangDecode()
+{
+    // NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+    enum { MOTOR_COUNT = 8, ITERATIONS = 20000 };
+    std::array<uint32_t, ESC_DShotBitbang::DMA_INPUT_BUFFER_LENGTH> samples {};
+    samples.fill(0xFFFF);
+    for (uint32_t pin = 0; pin < MOTOR_COUNT; ++pin) {
+        // responses with different values, starting at different times
+        ESC_DShotBitbang::GCR21_to_samples(&samples[0], 1U << pin, gcr21FromValue(static_cast<uint16_t>(0x0123 + 0x0111*pin)), 12 + pin);
+    }
+    // NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+    uint32_t perMotorSum = 0; // accumulate results so the calls are not optimized away
+    const auto perMotorStart = std::chrono::steady_clock::now();
+    for (int ii = 0; ii < ITERATIONS; ++ii) {
+        for (uint32_t pin = 0; pin < MOTOR_COUNT; ++pin) {
+            perMotorSum += ESC_DShotBitbang::samples_to_GCR21(&samples[0], 1U << pin);
+        }
+    }
+    const auto perMotorTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - perMotorStart);
+
+    uint32_t sum = 0;
+    ESC_DShotBitbang::gcr21s_t gcr21s {};
+    const auto start = std::chrono::steady_clock::now();
+    for (int ii = 0; ii < ITERATIONS; ++ii) {
+        ESC_DShotBitbang::samples_to_GCR21s(&samples[0], samples.size(), (1U << MOTOR_COUNT) - 1, gcr21s);
+        for (uint32_t pin = 0; pin < MOTOR_COUNT; ++pin) {
+            sum += gcr21s[pin];
+        }
+    }
+    const auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+    std::printf("decode %d motors, samples_to_GCR21s: %.1fns, samples_to_GCR21 per motor: %.1fns\n", MOTOR_COUNT,
+        static_cast<double>(time.count()) / ITERATIONS, static_cast<double>(perMotorTime.count()) / ITERATIONS);
+    return sum == perMotorSum;
+}
+
+} // end namespace
+
+int main()
+{
+    bool ok = benchmarkDecodeSamples();
+    ok = benchmarkBitbangDecode() && ok;
+    if (!ok) {
+        std::printf("decoder results differ\n"); // NOLINT(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+        return 1;
+    }
+    return 0;
+}